@@ -0,0 +1,148 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Linux C++ example. Runs the C++ front-end (ee_pmw3901mb.hpp) and the C API side by side
+ * against the PMW3901MB simulator of the Linux host simulator example, checks they put the
+ * same transactions on the bus, and compares the host time per motion read.
+ */
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include "hal.h"
+#include "ee_pmw3901mb.hpp"
+#include "ee_pmw3901mb_sim.h"
+
+namespace pmw = ee::pmw3901mb;
+
+constexpr ioline_t c_cs_line = 1U;      // Chip select of the sensor driven by the C API
+constexpr ioline_t cpp_cs_line = 2U;    // Chip select of the sensor driven by the C++ front-end
+constexpr uint32_t bench_reads = 200000U;
+constexpr uint32_t bench_rounds = 5U;
+constexpr std::size_t max_log = 256U;
+
+static SPIConfig c_spi_cfg = { false, false, ee_pmw3901mb_spi_data_cb, nullptr, c_cs_line, 0, 0 };
+static SPIConfig cpp_spi_cfg = { false, false, ee_pmw3901mb_spi_data_cb, nullptr, cpp_cs_line, 0, 0 };
+
+static ee_pmw3901mb_sim_t c_sensor;
+static ee_pmw3901mb_sim_t cpp_sensor;
+static ee_pmw3901mb_dev_t c_dev;
+static ee_pmw3901mb_spi_bus_t cpp_bus;
+
+// Transactions seen by each simulated sensor
+struct transaction_log {
+    ee_pmw3901mb_sim_transaction_t trans[max_log];
+    std::size_t n;
+};
+
+static transaction_log c_log;
+static transaction_log cpp_log;
+
+static void log_transaction(const ee_pmw3901mb_sim_t* sim, const ee_pmw3901mb_sim_transaction_t* trans, void* arg){
+    (void) sim;
+    transaction_log* log = static_cast<transaction_log*>(arg);
+    if(log->n < max_log) log->trans[log->n] = *trans;
+    log->n++;
+}
+
+static bool same_transactions(const transaction_log& a, const transaction_log& b){
+    if(a.n != b.n || a.n > max_log) return false;
+    for(std::size_t i = 0; i < a.n; i++){
+        const ee_pmw3901mb_sim_transaction_t& x = a.trans[i];
+        const ee_pmw3901mb_sim_transaction_t& y = b.trans[i];
+        if(x.addr != y.addr || x.bank != y.bank || x.write != y.write || x.n != y.n) return false;
+    }
+    return true;
+}
+
+static uint64_t host_ns(){
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000U + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+int main(){
+    ee_pmw3901mb_sim_reset_all();
+    ee_pmw3901mb_sim_init(&c_sensor);
+    ee_pmw3901mb_sim_init(&cpp_sensor);
+    ee_pmw3901mb_sim_attach(&c_sensor, c_cs_line);
+    ee_pmw3901mb_sim_attach(&cpp_sensor, cpp_cs_line);
+    c_sensor.on_transaction = log_transaction;
+    c_sensor.on_transaction_arg = &c_log;
+    cpp_sensor.on_transaction = log_transaction;
+    cpp_sensor.on_transaction_arg = &cpp_log;
+
+    // Initialization through both APIs
+    if(ee_pmw3901mb_dev_init_driver(&c_dev, &SPID1, &c_spi_cfg) != 0) return 1;
+    ee_pmw3901mb_spi_bus_init(&cpp_bus, &SPID1, &cpp_spi_cfg);
+    pmw::sensor<pmw::bus_transport> flow{pmw::bus_transport{cpp_bus}};
+    if(flow.init() != 0) return 1;
+    c_sensor.on_transaction = nullptr;
+    cpp_sensor.on_transaction = nullptr;
+    bool same_init = same_transactions(c_log, cpp_log);
+
+    uint8_t product_id = 0;
+    uint8_t inv_product_id = 0;
+    flow.get_product_id(product_id);
+    flow.get_inverse_product_id(inv_product_id);
+    std::printf("C++ init: %zu transactions, %s the C API, Product ID 0x%02X, Inverse Product ID 0x%02X\r\n",
+        cpp_log.n, same_init ? "same as" : "DIFFERENT from", product_id, inv_product_id);
+
+    // Same motion on both sensors, the reads must agree
+    ee_pmw3901mb_motion_burst_t c_burst{};
+    ee_pmw3901mb_motion_burst_t cpp_burst{};
+    uint32_t mismatches = 0;
+    for(int32_t i = 0; i < 1000; i++){
+        ee_pmw3901mb_sim_add_motion(&c_sensor, i % 7 - 3, i % 5 - 2);
+        ee_pmw3901mb_sim_add_motion(&cpp_sensor, i % 7 - 3, i % 5 - 2);
+        if(ee_pmw3901mb_dev_get_motion_burst(&c_dev, &c_burst) != 0) return 1;
+        if(flow.get_motion_burst(cpp_burst) != 0) return 1;
+        if(c_burst.delta_x != cpp_burst.delta_x || c_burst.delta_y != cpp_burst.delta_y ||
+           c_burst.squal != cpp_burst.squal || c_burst.shutter != cpp_burst.shutter) mismatches++;
+    }
+    std::printf("motion bursts: %" PRIu32 " of 1000 differ between the C API and the C++ front-end\r\n", mismatches);
+
+    // Host time per motion read, fastest of the rounds
+    uint64_t best_c = UINT64_MAX;
+    uint64_t best_cpp = UINT64_MAX;
+    for(uint32_t r = 0; r < bench_rounds; r++){
+        uint64_t t0 = host_ns();
+        for(uint32_t i = 0; i < bench_reads; i++){
+            if(ee_pmw3901mb_dev_get_motion_burst(&c_dev, &c_burst) != 0) return 1;
+        }
+        uint64_t t1 = host_ns();
+        for(uint32_t i = 0; i < bench_reads; i++){
+            if(flow.get_motion_burst(cpp_burst) != 0) return 1;
+        }
+        uint64_t t2 = host_ns();
+        if(t1 - t0 < best_c) best_c = t1 - t0;
+        if(t2 - t1 < best_cpp) best_cpp = t2 - t1;
+    }
+    std::printf("motion burst read, host time per read: C API %.1f ns, C++ front-end %.1f ns\r\n",
+        static_cast<double>(best_c) / bench_reads, static_cast<double>(best_cpp) / bench_reads);
+
+    return (mismatches == 0U && same_init) ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Code size probe of the C API, initialization and motion burst read of a device.
+ * Linked with the driver by "make size", the platform layer is left out.
+ */
+
+#include "ee_pmw3901mb_driver.h"
+
+uint8_t probe_init(ee_pmw3901mb_dev_t* dev, SPIDriver* spid_p, SPIConfig* spic_p);
+uint8_t probe_read(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_t* burst);
+
+uint8_t probe_init(ee_pmw3901mb_dev_t* dev, SPIDriver* spid_p, SPIConfig* spic_p){
+    return ee_pmw3901mb_dev_init_driver(dev, spid_p, spic_p);
+}
+
+uint8_t probe_read(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_t* burst){
+    return ee_pmw3901mb_dev_get_motion_burst(dev, burst);
+}
@@ -0,0 +1,42 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Code size probe of the C++ front-end, initialization and motion burst read of a sensor.
+ * Built by "make size", the platform layer is left out.
+ */
+
+#include "ee_pmw3901mb.hpp"
+
+namespace pmw = ee::pmw3901mb;
+
+extern "C" uint8_t probe_init(ee_pmw3901mb_spi_bus_t* bus){
+    pmw::sensor<pmw::bus_transport> flow{pmw::bus_transport{*bus}};
+    return flow.init();
+}
+
+extern "C" uint8_t probe_read(ee_pmw3901mb_spi_bus_t* bus, ee_pmw3901mb_motion_burst_t* burst){
+    pmw::sensor<pmw::bus_transport> flow{pmw::bus_transport{*bus}};
+    return flow.get_motion_burst(*burst);
+}
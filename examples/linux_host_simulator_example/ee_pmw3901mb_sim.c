@@ -0,0 +1,871 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _XOPEN_SOURCE 700   // ucontext, the stand-in RT threads
+
+#include <assert.h>
+#include <string.h>
+#include <ucontext.h>
+#include "ee_pmw3901mb_sim.h"
+
+// R/W bit in the MSB-bit of the address byte
+#define SIM_RW_BIT_WRITE_MASK   0x80
+#define SIM_ADDR_MASK           0x7F
+
+// Bank 0 registers with behaviour in the simulator
+#define SIM_REG_PRODUCT_ID          0x00
+#define SIM_REG_REVISION_ID         0x01
+#define SIM_REG_MOTION              0x02
+#define SIM_REG_DELTA_X_L           0x03
+#define SIM_REG_DELTA_X_H           0x04
+#define SIM_REG_DELTA_Y_L           0x05
+#define SIM_REG_DELTA_Y_H           0x06
+#define SIM_REG_SQUAL               0x07
+#define SIM_REG_RAWDATA_SUM         0x08
+#define SIM_REG_MAXIMUM_RAWDATA     0x09
+#define SIM_REG_MINIMUM_RAWDATA     0x0A
+#define SIM_REG_SHUTTER_LOWER       0x0B
+#define SIM_REG_SHUTTER_UPPER       0x0C
+#define SIM_REG_OBSERVATION         0x15
+#define SIM_REG_MOTION_BURST        0x16
+#define SIM_REG_POWER_UP_RESET      0x3A
+#define SIM_REG_SHUTDOWN            0x3B
+#define SIM_REG_RAWDATA_GRAB        0x58
+#define SIM_REG_RAWDATA_GRAB_STATUS 0x59
+#define SIM_REG_INVERSE_PRODUCT_ID  0x5F
+#define SIM_REG_BANK_SELECT         0x7F
+
+#define SIM_PRODUCT_ID              0x49
+#define SIM_REVISION_ID             0x00
+#define SIM_INVERSE_PRODUCT_ID      0xB6
+#define SIM_POWER_UP_RESET_VALUE    0x5A
+#define SIM_MOTION_MOT_BIT          0x80
+#define SIM_OBSERVATION_FRAME       0x3F // Bits set by every frame
+
+
+#define SIM_GRAB_TRIGGER            0xFF
+#define SIM_GRAB_STATUS_READY       0xC0
+#define SIM_GRAB_UPPER              0x40 // Pixel bits [7:2] in bits [5:0]
+#define SIM_GRAB_LOWER              0x80 // Pixel bits [1:0] in bits [3:2]
+
+// Default timing: example SPI clock and PMW3901MB datasheet delays
+#define SIM_DEF_SPI_CLOCK_HZ        1250000U
+#define SIM_DEF_T_SRAD_US           35U
+#define SIM_DEF_T_SWW_US            45U
+#define SIM_DEF_T_SWR_US            45U
+#define SIM_DEF_T_START_US          5U
+#define SIM_DEF_T_STOP_US           5U
+#define SIM_DEF_T_BOOT_US           2000U // Assumed, the datasheet gives no boot time
+#define SIM_DEF_T_FRAME_US          8265U // 121 frames per second
+
+SPIDriver SPID1 = { NULL, false, NULL };
+SPIDriver SPID2 = { NULL, false, NULL };
+
+static const ee_pmw3901mb_sim_timing_t default_timing = {
+    .spi_clock_hz   = SIM_DEF_SPI_CLOCK_HZ,
+    .t_srad_us      = SIM_DEF_T_SRAD_US,
+    .t_sww_us       = SIM_DEF_T_SWW_US,
+    .t_swr_us       = SIM_DEF_T_SWR_US,
+    .t_start_us     = SIM_DEF_T_START_US,
+    .t_stop_us      = SIM_DEF_T_STOP_US,
+    .t_boot_us      = SIM_DEF_T_BOOT_US,
+    .t_frame_us     = SIM_DEF_T_FRAME_US,
+};
+
+static ee_pmw3901mb_sim_timing_t timing = {
+    .spi_clock_hz   = SIM_DEF_SPI_CLOCK_HZ,
+    .t_srad_us      = SIM_DEF_T_SRAD_US,
+    .t_sww_us       = SIM_DEF_T_SWW_US,
+    .t_swr_us       = SIM_DEF_T_SWR_US,
+    .t_start_us     = SIM_DEF_T_START_US,
+    .t_stop_us      = SIM_DEF_T_STOP_US,
+    .t_boot_us      = SIM_DEF_T_BOOT_US,
+    .t_frame_us     = SIM_DEF_T_FRAME_US,
+};
+
+// Simulated time in nanoseconds, so byte times at any SPI clock add up without drift
+static uint64_t now_ns = 0;
+
+static struct {
+    ioline_t ssline;
+    ee_pmw3901mb_sim_t* sim;
+} devs[EE_PMW3901MB_SIM_MAX_DEVS];
+static size_t devs_n = 0;
+
+
+static ee_pmw3901mb_sim_t* find_dev(const SPIConfig* config){
+    if(config == NULL) return NULL;
+    for(size_t i = 0; i < devs_n; i++){
+        if(devs[i].ssline == config->ssline) return devs[i].sim;
+    }
+    return NULL;
+}
+
+// PAL line events and stand-in RT threads
+#define SIM_MAX_LINE_EVENTS     4U
+#define SIM_MAX_THREADS         4U
+
+static struct {
+    ioline_t line;
+    palcallback_t cb;
+    void* arg;
+    bool enabled;
+} line_events[SIM_MAX_LINE_EVENTS];
+static size_t line_events_n = 0;
+
+struct sim_thread {
+    ucontext_t ctx;
+    tfunc_t pf;
+    void* arg;
+    bool used;
+    bool ready;
+    bool done;
+    bool terminate;
+    binary_semaphore_t* waiting;
+    uint64_t wake_ns;               // Timeout of the wait, 0 for none
+    msg_t msg;                      // Wakeup message, MSG_OK when signalled, MSG_TIMEOUT
+};
+
+// Exchange running in the background, completed when the simulated time passes its end
+static bool exchange_deferred = false;
+static SPIDriver* exchange_spip = NULL;
+static uint64_t exchange_end_ns = 0;
+
+static thread_t threads[SIM_MAX_THREADS];
+static thread_t* current = NULL;    // Running thread, NULL in the main context
+static ucontext_t main_ctx;
+
+static void run_ready(void);
+
+static void advance_bytes(size_t n){
+    now_ns += ((uint64_t) n * 8U * 1000000000U) / timing.spi_clock_hz;
+}
+
+static int16_t clamp_int16(int32_t v){
+    if(v > INT16_MAX) return INT16_MAX;
+    if(v < INT16_MIN) return INT16_MIN;
+    return (int16_t) v;
+}
+
+static void power_up(ee_pmw3901mb_sim_t* sim){
+    memset(sim->regs, 0, sizeof(sim->regs));
+    sim->boot_done_us = now_ns / 1000U;
+    sim->observation_clear_us = 0;
+    sim->bank = 0;
+    sim->shutdown = false;
+    sim->motion_x = 0;
+    sim->motion_y = 0;
+    sim->grab_armed = false;
+    sim->grab_streaming = false;
+    sim->frozen = false;
+    sim->regs[0][SIM_REG_PRODUCT_ID] = SIM_PRODUCT_ID;
+    sim->regs[0][SIM_REG_REVISION_ID] = SIM_REVISION_ID;
+    sim->regs[0][SIM_REG_INVERSE_PRODUCT_ID] = SIM_INVERSE_PRODUCT_ID;
+}
+
+static bool booting(const ee_pmw3901mb_sim_t* sim){
+    return now_ns / 1000U < sim->boot_done_us;
+}
+
+// Observation bits are set by the first frame after the last write of the register, frames
+// complete every frame period after the boot
+static uint8_t observation(const ee_pmw3901mb_sim_t* sim){
+    uint64_t now_us = now_ns / 1000U;
+    uint64_t frame_us = sim->boot_done_us + timing.t_frame_us;
+    if(sim->observation_clear_us >= sim->boot_done_us){
+        uint64_t frames = (sim->observation_clear_us - sim->boot_done_us) / timing.t_frame_us + 1U;
+        frame_us = sim->boot_done_us + frames * timing.t_frame_us;
+    }
+    return (now_us >= frame_us) ? SIM_OBSERVATION_FRAME : 0x00;
+}
+
+static void latch_motion(ee_pmw3901mb_sim_t* sim){
+    uint8_t* r = sim->regs[0];
+    int16_t dx = clamp_int16(sim->motion_x);
+    int16_t dy = clamp_int16(sim->motion_y);
+
+    r[SIM_REG_MOTION] = (sim->motion_x != 0 || sim->motion_y != 0) ? SIM_MOTION_MOT_BIT : 0x00;
+    r[SIM_REG_DELTA_X_L] = (uint8_t) ((uint16_t) dx & 0xFF);
+    r[SIM_REG_DELTA_X_H] = (uint8_t) ((uint16_t) dx >> 8);
+    r[SIM_REG_DELTA_Y_L] = (uint8_t) ((uint16_t) dy & 0xFF);
+    r[SIM_REG_DELTA_Y_H] = (uint8_t) ((uint16_t) dy >> 8);
+
+    sim->motion_x = 0;
+    sim->motion_y = 0;
+}
+
+static void fill_burst(ee_pmw3901mb_sim_t* sim){
+    const uint8_t* r = sim->regs[0];
+    uint8_t* burst_buf = sim->burst;
+    if(sim->frozen) return; // Repeats the last frame
+    latch_motion(sim);
+    burst_buf[0] = r[SIM_REG_MOTION];
+    burst_buf[1] = observation(sim);
+    burst_buf[2] = r[SIM_REG_DELTA_X_L];
+    burst_buf[3] = r[SIM_REG_DELTA_X_H];
+    burst_buf[4] = r[SIM_REG_DELTA_Y_L];
+    burst_buf[5] = r[SIM_REG_DELTA_Y_H];
+    burst_buf[6] = r[SIM_REG_SQUAL];
+    burst_buf[7] = r[SIM_REG_RAWDATA_SUM];
+    burst_buf[8] = r[SIM_REG_MAXIMUM_RAWDATA];
+    burst_buf[9] = r[SIM_REG_MINIMUM_RAWDATA];
+    burst_buf[10] = r[SIM_REG_SHUTTER_UPPER];
+    burst_buf[11] = r[SIM_REG_SHUTTER_LOWER];
+}
+
+static uint8_t read_grab(ee_pmw3901mb_sim_t* sim){
+    if(!sim->grab_streaming || sim->grab_pixel >= EE_PMW3901MB_SIM_FRAME_SIZE) return 0x00; // No data
+    uint8_t pixel = sim->frame[sim->grab_pixel];
+    if(!sim->grab_lower){
+        sim->grab_lower = true;
+        return (uint8_t) (SIM_GRAB_UPPER | (pixel >> 2));
+    }
+    sim->grab_lower = false;
+    sim->grab_pixel++;
+    if(sim->grab_pixel >= EE_PMW3901MB_SIM_FRAME_SIZE) sim->grab_streaming = false;
+    return (uint8_t) (SIM_GRAB_LOWER | ((pixel & 0x03) << 2));
+}
+
+static void write_grab(ee_pmw3901mb_sim_t* sim, uint8_t value){
+    if(value == SIM_GRAB_TRIGGER){
+        sim->grab_armed = true;
+        sim->grab_streaming = false;
+        sim->grab_ready_us = now_ns / 1000U + EE_PMW3901MB_SIM_GRAB_US;
+        sim->frames_grabbed++;
+        return;
+    }
+    if(sim->grab_armed && now_ns / 1000U >= sim->grab_ready_us){
+        sim->grab_armed = false;
+        sim->grab_streaming = true;
+        sim->grab_pixel = 0;
+        sim->grab_lower = false;
+    }
+}
+
+static bool is_read_only(uint8_t bank, uint8_t reg){
+    if(bank != 0) return false;
+    return reg <= SIM_REG_SHUTTER_UPPER || reg == SIM_REG_MOTION_BURST || reg == SIM_REG_INVERSE_PRODUCT_ID;
+}
+
+static void write_reg(ee_pmw3901mb_sim_t* sim, uint8_t reg, uint8_t value){
+    if(reg == SIM_REG_POWER_UP_RESET && sim->bank == 0){
+        if(value == SIM_POWER_UP_RESET_VALUE){
+            power_up(sim);
+            sim->boot_done_us += timing.t_boot_us;
+            sim->resets++;
+        }
+        return;
+    }
+    if(sim->shutdown || booting(sim)) return;
+    if(reg == SIM_REG_BANK_SELECT){
+        sim->bank = value;
+        return;
+    }
+    if(reg == SIM_REG_SHUTDOWN && sim->bank == 0){
+        sim->shutdown = true;
+        return;
+    }
+    if(reg == SIM_REG_RAWDATA_GRAB && sim->bank == 0){
+        write_grab(sim, value);
+        return;
+    }
+    if(reg == SIM_REG_OBSERVATION && sim->bank == 0){
+        sim->observation_clear_us = now_ns / 1000U;
+        return;
+    }
+    if(is_read_only(sim->bank, reg)) return;
+    sim->regs[sim->bank][reg] = value;
+}
+
+static uint8_t read_reg(ee_pmw3901mb_sim_t* sim, uint8_t reg, size_t index){
+    if(sim->shutdown || booting(sim)) return 0x00;
+    if(sim->bank == 0 && reg == SIM_REG_MOTION_BURST){
+        if(index == 0) fill_burst(sim);
+        return (index < EE_PMW3901MB_SIM_BURST_SIZE) ? sim->burst[index] : 0x00;
+    }
+    uint8_t r = (uint8_t) ((reg + index) & SIM_ADDR_MASK);
+    if(sim->bank == 0 && r == SIM_REG_MOTION) latch_motion(sim);
+    if(sim->bank == 0 && r == SIM_REG_OBSERVATION) return observation(sim);
+    if(sim->bank == 0 && r == SIM_REG_RAWDATA_GRAB) return read_grab(sim);
+    if(sim->bank == 0 && r == SIM_REG_RAWDATA_GRAB_STATUS){
+        return (sim->grab_armed && now_ns / 1000U >= sim->grab_ready_us) ? SIM_GRAB_STATUS_READY : 0x00;
+    }
+    if(r == SIM_REG_BANK_SELECT) return sim->bank;
+    return sim->regs[sim->bank][r];
+}
+
+
+void ee_pmw3901mb_sim_init(ee_pmw3901mb_sim_t* sim){
+    if(sim == NULL) return;
+    memset(sim, 0, sizeof(ee_pmw3901mb_sim_t));
+    power_up(sim);
+}
+
+uint8_t ee_pmw3901mb_sim_attach(ee_pmw3901mb_sim_t* sim, ioline_t ssline){
+    if(sim == NULL) return 1;
+    if(devs_n >= EE_PMW3901MB_SIM_MAX_DEVS) return 2;
+    devs[devs_n].ssline = ssline;
+    devs[devs_n].sim = sim;
+    devs_n++;
+    return 0;
+}
+
+void ee_pmw3901mb_sim_reset_all(void){
+    devs_n = 0;
+    line_events_n = 0;
+    exchange_deferred = false;
+    exchange_spip = NULL;
+    now_ns = 0;
+    timing = default_timing;
+    SPID1 = (SPIDriver) { NULL, false, NULL };
+    SPID2 = (SPIDriver) { NULL, false, NULL };
+}
+
+void ee_pmw3901mb_sim_set_timing(const ee_pmw3901mb_sim_timing_t* t){
+    if(t == NULL || t->spi_clock_hz == 0U || t->t_frame_us == 0U) return;
+    timing = *t;
+}
+
+void ee_pmw3901mb_sim_get_timing(ee_pmw3901mb_sim_timing_t* t){
+    if(t == NULL) return;
+    *t = timing;
+}
+
+uint64_t ee_pmw3901mb_sim_now_us(void){
+    return now_ns / 1000U;
+}
+
+// Waiting thread with the earliest timeout, NULL for none
+static thread_t* next_timeout(void){
+    thread_t* next = NULL;
+    for(size_t i = 0; i < SIM_MAX_THREADS; i++){
+        thread_t* tp = &threads[i];
+        if(!tp->used || tp->done || tp->ready || tp->wake_ns == 0U) continue;
+        if(next == NULL || tp->wake_ns < next->wake_ns) next = tp;
+    }
+    return next;
+}
+
+void ee_pmw3901mb_sim_advance_us(uint64_t us){
+    uint64_t target_ns = now_ns + us * 1000U;
+    // Exchange completions and thread timeouts in time order, both can start the next exchange
+    for(;;){
+        thread_t* tp = next_timeout();
+        bool exchange = exchange_spip != NULL && exchange_end_ns <= target_ns &&
+                        (tp == NULL || exchange_end_ns <= tp->wake_ns);
+        if(exchange){
+            SPIDriver* spip = exchange_spip;
+            exchange_spip = NULL;
+            if(exchange_end_ns > now_ns) now_ns = exchange_end_ns;
+            if(spip->config->data_cb != NULL) spip->config->data_cb(spip);
+        }else if(tp != NULL && tp->wake_ns <= target_ns && current == NULL){
+            if(tp->wake_ns > now_ns) now_ns = tp->wake_ns;
+            tp->wake_ns = 0U;
+            tp->waiting = NULL;
+            tp->msg = MSG_TIMEOUT;
+            tp->ready = true;
+            run_ready();
+        }else{
+            break;
+        }
+    }
+    if(target_ns > now_ns) now_ns = target_ns;
+}
+
+void ee_pmw3901mb_sim_set_async(bool deferred){
+    exchange_deferred = deferred;
+}
+
+void ee_pmw3901mb_sim_add_motion(ee_pmw3901mb_sim_t* sim, int32_t dx, int32_t dy){
+    if(sim == NULL || sim->shutdown || booting(sim)) return; // Not seen without frames
+    bool pending = sim->motion_x != 0 || sim->motion_y != 0;
+    sim->motion_x += dx;
+    sim->motion_y += dy;
+    if(!sim->has_motion_line || pending || (sim->motion_x == 0 && sim->motion_y == 0)) return;
+
+    // Falling edge of the motion line, the woken threads run before returning
+    for(size_t i = 0; i < line_events_n; i++){
+        if(line_events[i].line == sim->motion_line && line_events[i].enabled) line_events[i].cb(line_events[i].arg);
+    }
+    run_ready();
+}
+
+void ee_pmw3901mb_sim_set_motion_line(ee_pmw3901mb_sim_t* sim, ioline_t line){
+    if(sim == NULL) return;
+    sim->has_motion_line = true;
+    sim->motion_line = line;
+}
+
+void ee_pmw3901mb_sim_set_surface(ee_pmw3901mb_sim_t* sim, uint8_t squal, uint8_t rawdata_sum,
+                                  uint8_t max_rawdata, uint8_t min_rawdata, uint16_t shutter){
+    if(sim == NULL) return;
+    uint8_t* r = sim->regs[0];
+    r[SIM_REG_SQUAL] = squal;
+    r[SIM_REG_RAWDATA_SUM] = rawdata_sum;
+    r[SIM_REG_MAXIMUM_RAWDATA] = max_rawdata;
+    r[SIM_REG_MINIMUM_RAWDATA] = min_rawdata;
+    r[SIM_REG_SHUTTER_LOWER] = (uint8_t) (shutter & 0xFF);
+    r[SIM_REG_SHUTTER_UPPER] = (uint8_t) (shutter >> 8);
+}
+
+void ee_pmw3901mb_sim_set_frame(ee_pmw3901mb_sim_t* sim, const uint8_t* pixels){
+    if(sim == NULL || pixels == NULL) return;
+    memcpy(sim->frame, pixels, EE_PMW3901MB_SIM_FRAME_SIZE);
+}
+
+void ee_pmw3901mb_sim_brown_out(ee_pmw3901mb_sim_t* sim){
+    if(sim == NULL) return;
+    power_up(sim);
+    sim->boot_done_us += timing.t_boot_us;
+}
+
+void ee_pmw3901mb_sim_float_miso(ee_pmw3901mb_sim_t* sim, uint32_t bytes){
+    if(sim == NULL) return;
+    sim->float_bytes = bytes;
+}
+
+void ee_pmw3901mb_sim_freeze(ee_pmw3901mb_sim_t* sim){
+    if(sim == NULL) return;
+    sim->frozen = true;
+}
+
+uint8_t ee_pmw3901mb_sim_peek(const ee_pmw3901mb_sim_t* sim, uint8_t bank, uint8_t reg){
+    if(sim == NULL) return 0x00;
+    return sim->regs[bank][reg & SIM_ADDR_MASK];
+}
+
+void ee_pmw3901mb_sim_clear_stats(ee_pmw3901mb_sim_t* sim){
+    if(sim == NULL) return;
+    memset(&sim->stats, 0, sizeof(ee_pmw3901mb_sim_stats_t));
+}
+
+
+/* Stand-in hal.h functions */
+
+void spiStart(SPIDriver* spip, const SPIConfig* config){
+    assert(spip != NULL && config != NULL);
+    spip->config = config;
+    ee_pmw3901mb_sim_t* sim = find_dev(config);
+    now_ns += (uint64_t) timing.t_start_us * 1000U;
+    if(sim != NULL){
+        sim->stats.starts++;
+        sim->stats.start_stop_time_us += timing.t_start_us;
+    }
+}
+
+void spiStop(SPIDriver* spip){
+    assert(spip != NULL && spip->config != NULL);
+    assert(exchange_spip != spip); // Exchange still running
+    ee_pmw3901mb_sim_t* sim = find_dev(spip->config);
+    now_ns += (uint64_t) timing.t_stop_us * 1000U;
+    if(sim != NULL){
+        sim->stats.stops++;
+        sim->stats.start_stop_time_us += timing.t_stop_us;
+    }
+    spip->config = NULL;
+}
+
+void spiSelect(SPIDriver* spip){
+    assert(spip != NULL && spip->config != NULL); // Must be started
+    assert(exchange_spip != spip); // Exchange still running
+    assert(spip->selected == NULL);
+    ee_pmw3901mb_sim_t* sim = find_dev(spip->config);
+    spip->selected = sim;
+    if(sim == NULL) return; // Nothing on this chip select line
+    sim->addr_phase = true;
+    sim->trans.n = 0;
+    sim->trans.start_us = now_ns / 1000U;
+}
+
+void spiUnselect(SPIDriver* spip){
+    assert(spip != NULL);
+    ee_pmw3901mb_sim_t* sim = spip->selected;
+    spip->selected = NULL;
+    if(sim == NULL || sim->addr_phase) return;
+
+    sim->trans.end_us = now_ns / 1000U;
+    sim->last_write = sim->trans.write;
+    sim->last_end_us = sim->trans.end_us;
+
+    sim->stats.transactions++;
+    if(sim->trans.write) sim->stats.writes++;
+    else sim->stats.reads++;
+    sim->stats.bytes += (uint32_t) (1U + sim->trans.n);
+    sim->stats.bus_time_us += sim->trans.end_us - sim->trans.start_us;
+
+    if(sim->on_transaction != NULL) sim->on_transaction(sim, &sim->trans, sim->on_transaction_arg);
+}
+
+static void spi_send(SPIDriver* spip, size_t n, const void* txbuf){
+    assert(spip != NULL && txbuf != NULL);
+    ee_pmw3901mb_sim_t* sim = spip->selected;
+    const uint8_t* tx = txbuf;
+
+    for(size_t i = 0; i < n; i++){
+        if(sim != NULL && sim->addr_phase){
+            sim->addr_phase = false;
+            sim->trans.write = (tx[i] & SIM_RW_BIT_WRITE_MASK) != 0;
+            sim->trans.addr = tx[i] & SIM_ADDR_MASK;
+            sim->trans.bank = sim->bank;
+
+            // Hold off until the write to write / write to read delay has passed
+            if(sim->last_write && sim->stats.transactions > 0){
+                uint64_t t_min = sim->last_end_us + (sim->trans.write ? timing.t_sww_us : timing.t_swr_us);
+                if(now_ns < t_min * 1000U) now_ns = t_min * 1000U;
+                sim->trans.start_us = now_ns / 1000U;
+            }
+            advance_bytes(1U);
+            if(!sim->trans.write) now_ns += (uint64_t) timing.t_srad_us * 1000U;
+            continue;
+        }
+        advance_bytes(1U);
+        if(sim != NULL && sim->trans.write){
+            write_reg(sim, (uint8_t) (sim->trans.addr + sim->trans.n), tx[i]);
+            sim->trans.n++;
+        }
+    }
+}
+
+static void spi_receive(SPIDriver* spip, size_t n, void* rxbuf){
+    assert(spip != NULL && rxbuf != NULL);
+    ee_pmw3901mb_sim_t* sim = spip->selected;
+    uint8_t* rx = rxbuf;
+
+    for(size_t i = 0; i < n; i++){
+        advance_bytes(1U);
+        if(sim == NULL || sim->addr_phase || sim->trans.write){
+            rx[i] = 0xFF; // Floating MISO (pull-up)
+            continue;
+        }
+        rx[i] = read_reg(sim, sim->trans.addr, sim->trans.n);
+        sim->trans.n++;
+        if(sim->float_bytes > 0U){
+            sim->float_bytes--;
+            rx[i] = 0xFF;
+        }
+    }
+}
+
+void spiSend(SPIDriver* spip, size_t n, const void* txbuf){
+    spi_send(spip, n, txbuf);
+    // Blocking transfers also complete through the data callback, as on target
+    if(spip->config->data_cb != NULL) spip->config->data_cb(spip);
+}
+
+void spiReceive(SPIDriver* spip, size_t n, void* rxbuf){
+    spi_receive(spip, n, rxbuf);
+    if(spip->config->data_cb != NULL) spip->config->data_cb(spip);
+}
+
+void spiStartExchange(SPIDriver* spip, size_t n, const void* txbuf, void* rxbuf){
+    assert(spip != NULL && spip->config != NULL && txbuf != NULL && rxbuf != NULL);
+    ee_pmw3901mb_sim_t* sim = spip->selected;
+    const uint8_t* tx = txbuf;
+    uint8_t* rx = rxbuf;
+
+    assert(exchange_spip == NULL);
+    uint64_t start_ns = now_ns;
+
+    // Full duplex, the simulated transfer runs to its end before returning
+    for(size_t i = 0; i < n; i++){
+        if(sim != NULL && !sim->addr_phase && !sim->trans.write){
+            spi_receive(spip, 1U, &rx[i]);
+        }else{
+            spi_send(spip, 1U, &tx[i]);
+            rx[i] = 0xFF;
+        }
+    }
+
+    // In the background, the caller continues at the start and the data callback runs at the end
+    if(exchange_deferred){
+        exchange_spip = spip;
+        exchange_end_ns = now_ns;
+        now_ns = start_ns;
+        return;
+    }
+    if(spip->config->data_cb != NULL) spip->config->data_cb(spip);
+}
+
+void spiUnselectI(SPIDriver* spip){
+    spiUnselect(spip);
+}
+
+void spiAcquireBus(SPIDriver* spip){
+    assert(spip != NULL && !spip->locked); // Single threaded simulation, never contended
+    spip->locked = true;
+}
+
+void spiReleaseBus(SPIDriver* spip){
+    assert(spip != NULL && spip->locked);
+    spip->locked = false;
+}
+
+/* Single threaded simulation, nothing to lock */
+void osalSysLock(void){}
+void osalSysUnlock(void){}
+void osalSysLockFromISR(void){}
+void osalSysUnlockFromISR(void){}
+
+// Single threaded: the bus is never running in another thread, so nothing suspends
+msg_t osalThreadSuspendS(thread_reference_t* trp){
+    (void) trp;
+    assert(false);
+    return MSG_RESET;
+}
+void osalThreadResumeI(thread_reference_t* trp, msg_t msg){ (void) msg; *trp = NULL; }
+void osalThreadResumeS(thread_reference_t* trp, msg_t msg){ (void) msg; *trp = NULL; }
+void osalOsRescheduleS(void){}
+
+syssts_t chSysGetStatusAndLockX(void){ return 0; }
+void chSysRestoreStatusX(syssts_t sts){ (void) sts; }
+
+systimestamp_t chVTGetTimeStampI(void){
+    return now_ns / (1000000000U / CH_CFG_ST_FREQUENCY);
+}
+
+rtcnt_t chSysGetRealtimeCounterX(void){
+    return (rtcnt_t) ((now_ns * (STM32_SYSCLK / 1000000U)) / 1000U); // Wraps like the 32 bit cycle counter
+}
+
+void chThdSleepMilliseconds(uint32_t msec){
+    ee_pmw3901mb_sim_advance_us((uint64_t) msec * 1000U);
+}
+
+void palSetLineCallback(ioline_t line, palcallback_t cb, void* arg){
+    size_t i = 0;
+    while(i < line_events_n && line_events[i].line != line) i++;
+    if(i == line_events_n){
+        assert(line_events_n < SIM_MAX_LINE_EVENTS);
+        line_events_n++;
+    }
+    line_events[i].line = line;
+    line_events[i].cb = cb;
+    line_events[i].arg = arg;
+    line_events[i].enabled = false;
+}
+
+void palEnableLineEvent(ioline_t line, uint32_t mode){
+    assert(mode == PAL_EVENT_MODE_FALLING_EDGE); // The only edge simulated
+    for(size_t i = 0; i < line_events_n; i++){
+        if(line_events[i].line == line) line_events[i].enabled = true;
+    }
+}
+
+void palDisableLineEvent(ioline_t line){
+    for(size_t i = 0; i < line_events_n; i++){
+        if(line_events[i].line == line) line_events[i].enabled = false;
+    }
+}
+
+uint32_t palReadLine(ioline_t line){
+    for(size_t i = 0; i < devs_n; i++){
+        const ee_pmw3901mb_sim_t* sim = devs[i].sim;
+        if(sim->has_motion_line && sim->motion_line == line){
+            return (sim->motion_x != 0 || sim->motion_y != 0) ? PAL_LOW : PAL_HIGH;
+        }
+    }
+    return PAL_HIGH; // Pull-up
+}
+
+/* Cooperative threads, nothing to lock */
+void chSysLock(void){}
+void chSysUnlock(void){}
+void chSysLockFromISR(void){}
+void chSysUnlockFromISR(void){}
+
+systime_t chVTGetSystemTime(void){
+    return (systime_t) chVTGetTimeStampI();
+}
+
+systime_t chVTGetSystemTimeX(void){
+    return (systime_t) chVTGetTimeStampI();
+}
+
+static void thread_entry(void){
+    current->pf(current->arg);
+    current->done = true;
+    // Returns to the main context through uc_link
+}
+
+// Runs the ready threads until all wait, only from the main context
+static void run_ready(void){
+    if(current != NULL) return;
+    bool ran = true;
+    while(ran){
+        ran = false;
+        for(size_t i = 0; i < SIM_MAX_THREADS; i++){
+            thread_t* tp = &threads[i];
+            if(!tp->used || !tp->ready || tp->done) continue;
+            tp->ready = false;
+            current = tp;
+            swapcontext(&main_ctx, &tp->ctx);
+            current = NULL;
+            ran = true;
+        }
+    }
+}
+
+thread_t* chThdCreateStatic(void* wa, size_t size, tprio_t prio, tfunc_t pf, void* arg){
+    (void) prio; // Woken threads run before the main context resumes
+    assert(wa != NULL && current == NULL);
+    thread_t* tp = NULL;
+    for(size_t i = 0; i < SIM_MAX_THREADS && tp == NULL; i++){
+        if(!threads[i].used) tp = &threads[i];
+    }
+    assert(tp != NULL);
+
+    memset(tp, 0, sizeof(thread_t));
+    tp->used = true;
+    tp->ready = true;
+    tp->pf = pf;
+    tp->arg = arg;
+    getcontext(&tp->ctx);
+    tp->ctx.uc_stack.ss_sp = wa;
+    tp->ctx.uc_stack.ss_size = size;
+    tp->ctx.uc_link = &main_ctx;
+    makecontext(&tp->ctx, thread_entry, 0);
+    run_ready();
+    return tp;
+}
+
+void chThdTerminate(thread_t* tp){
+    tp->terminate = true;
+}
+
+bool chThdShouldTerminateX(void){
+    return current != NULL && current->terminate;
+}
+
+msg_t chThdWait(thread_t* tp){
+    run_ready();
+    // A sleeping thread exits at its wakeup, e.g. at the end of a polling period
+    while(!tp->done && tp->wake_ns != 0U && current == NULL){
+        ee_pmw3901mb_sim_advance_us((tp->wake_ns > now_ns) ? (tp->wake_ns - now_ns + 999U) / 1000U : 0U);
+    }
+    assert(tp->done); // A thread still waiting would block the caller forever
+    tp->used = false;
+    return MSG_OK;
+}
+
+systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next){
+    assert(current != NULL); // The main context never waits
+    systime_t time = chVTGetSystemTimeX();
+    if((systime_t) (time - prev) < (systime_t) (next - prev)){
+        const uint64_t tick_ns = 1000000000U / CH_CFG_ST_FREQUENCY;
+        current->waiting = NULL;
+        current->wake_ns = (now_ns / tick_ns + (systime_t) (next - time)) * tick_ns;
+        swapcontext(&current->ctx, &main_ctx);
+    }
+    return next;
+}
+
+systime_t chTimeAddX(systime_t systime, sysinterval_t interval){
+    return (systime_t) (systime + interval);
+}
+
+void chRegSetThreadName(const char* name){
+    (void) name;
+}
+
+void chBSemObjectInit(binary_semaphore_t* bsp, bool taken){
+    bsp->taken = taken;
+}
+
+msg_t chBSemWait(binary_semaphore_t* bsp){
+    return chBSemWaitTimeout(bsp, TIME_INFINITE);
+}
+
+// A timed out thread runs when ee_pmw3901mb_sim_advance_us() passes the timeout
+msg_t chBSemWaitTimeout(binary_semaphore_t* bsp, sysinterval_t timeout){
+    if(!bsp->taken){
+        bsp->taken = true;
+        return MSG_OK;
+    }
+    if(timeout == TIME_IMMEDIATE) return MSG_TIMEOUT;
+    assert(current != NULL); // The main context never waits
+    current->waiting = bsp;
+    current->wake_ns = (timeout == TIME_INFINITE) ? 0U : now_ns + (uint64_t) timeout * (1000000000U / CH_CFG_ST_FREQUENCY);
+    swapcontext(&current->ctx, &main_ctx);
+    return current->msg;
+}
+
+void chBSemSignalI(binary_semaphore_t* bsp){
+    for(size_t i = 0; i < SIM_MAX_THREADS; i++){
+        if(threads[i].used && threads[i].waiting == bsp){
+            threads[i].waiting = NULL;
+            threads[i].wake_ns = 0U;
+            threads[i].msg = MSG_OK;
+            threads[i].ready = true;
+            return;
+        }
+    }
+    bsp->taken = false;
+}
+
+void chBSemSignal(binary_semaphore_t* bsp){
+    chBSemSignalI(bsp);
+    run_ready();
+}
+
+void chFifoObjectInit(objects_fifo_t* ofp, size_t objsize, size_t objn, void* objbuf, msg_t* msgbuf){
+    assert(objn <= 32U);
+    ofp->objsize = objsize;
+    ofp->n = objn;
+    ofp->objs = objbuf;
+    ofp->msgs = msgbuf;
+    ofp->head = 0;
+    ofp->count = 0;
+    ofp->used = 0;
+}
+
+void* chFifoTakeObjectTimeout(objects_fifo_t* ofp, sysinterval_t timeout){
+    assert(timeout == TIME_IMMEDIATE); // Nothing else runs to return an object
+    for(size_t i = 0; i < ofp->n; i++){
+        if((ofp->used & (1UL << i)) == 0U){
+            ofp->used |= 1UL << i;
+            return &ofp->objs[i * ofp->objsize];
+        }
+    }
+    return NULL;
+}
+
+void chFifoSendObject(objects_fifo_t* ofp, void* objp){
+    size_t i = (size_t) ((uint8_t*) objp - ofp->objs) / ofp->objsize;
+    ofp->msgs[(ofp->head + ofp->count) % ofp->n] = (msg_t) i;
+    ofp->count++;
+}
+
+msg_t chFifoReceiveObjectTimeout(objects_fifo_t* ofp, void** objpp, sysinterval_t timeout){
+    (void) timeout; // Nothing else runs to send an object, an empty FIFO times out at once
+    if(ofp->count == 0U) return MSG_TIMEOUT;
+    *objpp = &ofp->objs[(size_t) ofp->msgs[ofp->head] * ofp->objsize];
+    ofp->head = (ofp->head + 1U) % ofp->n;
+    ofp->count--;
+    return MSG_OK;
+}
+
+void chFifoReturnObject(objects_fifo_t* ofp, void* objp){
+    size_t i = (size_t) ((uint8_t*) objp - ofp->objs) / ofp->objsize;
+    ofp->used &= ~(1UL << i);
+}
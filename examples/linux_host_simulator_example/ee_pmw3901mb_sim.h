@@ -0,0 +1,291 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_sim.h
+ * 
+ * @brief EngEmil PMW3901MB register-level simulator for Linux host builds.
+ * 
+ * Simulates the PMW3901MB behind the stand-in hal.h SPI functions:
+ * - Register banks selected through register 0x7F
+ * - Motion accumulated by the simulator and latched into the delta registers on MOTION read
+ * - Motion burst read from register 0x16
+ * - Product ID, revision ID and inverse product ID
+ * - Power up reset and shutdown, registers read 0x00 and ignore writes (and motion) while
+ *   booting or shut down
+ * - Frames at a fixed frame period, setting bits of the observation register (0x15)
+ * - Raw data grab of a 35x35 frame set by the host, through registers 0x58 and 0x59
+ * - Injected faults: brown-out reset, floating MISO and a frozen motion pipeline
+ * 
+ * Time is simulated in microseconds. Each transaction costs its SPI clock time plus the
+ * configured tSRAD/tSWW/tSWR delays, and spiStart()/spiStop() cost a configurable time.
+ */
+
+#ifndef _EE_PMW3901MB_SIM_
+#define _EE_PMW3901MB_SIM_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "hal.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define EE_PMW3901MB_SIM_BANKS      256U    /**< Register banks, selected by register 0x7F */
+#define EE_PMW3901MB_SIM_REGS       128U    /**< Registers per bank */
+#define EE_PMW3901MB_SIM_MAX_DEVS   8U      /**< Max simulated devices attached to chip select lines */
+#define EE_PMW3901MB_SIM_FRAME_SIZE 1225U   /**< Raw data grab frame, 35x35 pixels */
+#define EE_PMW3901MB_SIM_GRAB_US    500U    /**< Time from grab trigger to grab status ready */
+#define EE_PMW3901MB_SIM_BURST_SIZE 12U     /**< Motion burst frame */
+
+/**
+ * @brief Simulated timing.
+ */
+typedef struct {
+    uint32_t spi_clock_hz;  /**< SPI clock */
+    uint32_t t_srad_us;     /**< Read, address to data delay */
+    uint32_t t_sww_us;      /**< Write to write delay */
+    uint32_t t_swr_us;      /**< Write to read delay */
+    uint32_t t_start_us;    /**< Cost of spiStart() */
+    uint32_t t_stop_us;     /**< Cost of spiStop() */
+    uint32_t t_boot_us;     /**< Boot time after power up reset */
+    uint32_t t_frame_us;    /**< Frame period */
+} ee_pmw3901mb_sim_timing_t;
+
+/**
+ * @brief One chip select frame.
+ */
+typedef struct {
+    uint8_t addr;           /**< Register address (without R/W bit) */
+    uint8_t bank;           /**< Selected bank during the transaction */
+    bool write;             /**< true for write, false for read */
+    size_t n;               /**< Number of data bytes */
+    uint64_t start_us;      /**< Chip select assert time */
+    uint64_t end_us;        /**< Chip select deassert time */
+} ee_pmw3901mb_sim_transaction_t;
+
+/**
+ * @brief Bus statistics.
+ */
+typedef struct {
+    uint32_t transactions;          /**< Chip select frames */
+    uint32_t reads;                 /**< Read frames */
+    uint32_t writes;                /**< Write frames */
+    uint32_t bytes;                 /**< Bytes on the bus, including address bytes */
+    uint32_t starts;                /**< spiStart() calls */
+    uint32_t stops;                 /**< spiStop() calls */
+    uint64_t bus_time_us;           /**< Time with chip select asserted */
+    uint64_t start_stop_time_us;    /**< Time spent in spiStart()/spiStop() */
+} ee_pmw3901mb_sim_stats_t;
+
+/**
+ * @brief Simulated sensor.
+ */
+typedef struct ee_pmw3901mb_sim {
+    uint8_t regs[EE_PMW3901MB_SIM_BANKS][EE_PMW3901MB_SIM_REGS];
+    uint8_t bank;                   /**< Bank selected by register 0x7F */
+    bool shutdown;                  /**< Set after a write to the shutdown register */
+    int32_t motion_x;               /**< Motion not yet latched into the delta registers */
+    int32_t motion_y;
+    uint32_t resets;                /**< Power up resets */
+    uint64_t boot_done_us;          /**< End of the boot after the last power up reset */
+    uint64_t observation_clear_us;  /**< Last write to the observation register */
+    uint8_t burst[EE_PMW3901MB_SIM_BURST_SIZE];     /**< Motion burst frame of the last burst read */
+    /* Injected faults */
+    bool frozen;                    /**< Motion bursts repeat the last frame, cleared by power up reset */
+    uint32_t float_bytes;           /**< Bytes still read as 0xFF (floating MISO) */
+    uint8_t frame[EE_PMW3901MB_SIM_FRAME_SIZE];    /**< Pixels returned by the raw data grab */
+    uint32_t frames_grabbed;        /**< Raw data grabs triggered */
+    /* Raw data grab state */
+    bool grab_armed;
+    bool grab_streaming;
+    uint64_t grab_ready_us;
+    size_t grab_pixel;
+    bool grab_lower;
+    ee_pmw3901mb_sim_stats_t stats;
+    /* Transaction state */
+    ee_pmw3901mb_sim_transaction_t trans;
+    bool addr_phase;
+    bool last_write;
+    uint64_t last_end_us;
+    /* Motion (MOT) line, low while motion is not yet read */
+    bool has_motion_line;
+    ioline_t motion_line;
+    /* Transaction hook, called at chip select deassert */
+    void (*on_transaction)(const struct ee_pmw3901mb_sim* sim, const ee_pmw3901mb_sim_transaction_t* trans, void* arg);
+    void* on_transaction_arg;
+} ee_pmw3901mb_sim_t;
+
+
+/**
+ * @brief Initialize a simulated sensor in its power up state.
+ * 
+ * @param[out] sim pointer to the simulated sensor
+ */
+void ee_pmw3901mb_sim_init(ee_pmw3901mb_sim_t* sim);
+
+/**
+ * @brief Attach a simulated sensor to a chip select line.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] ssline chip select line (SPIConfig.ssline)
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_sim_attach(ee_pmw3901mb_sim_t* sim, ioline_t ssline);
+
+/**
+ * @brief Detach all simulated sensors and reset time and timing to defaults.
+ */
+void ee_pmw3901mb_sim_reset_all(void);
+
+/**
+ * @brief Set simulated timing, shared by all simulated sensors.
+ * 
+ * @param[in] timing pointer to the timing
+ */
+void ee_pmw3901mb_sim_set_timing(const ee_pmw3901mb_sim_timing_t* timing);
+
+/**
+ * @brief Get simulated timing.
+ * 
+ * @param[out] timing pointer to the timing
+ */
+void ee_pmw3901mb_sim_get_timing(ee_pmw3901mb_sim_timing_t* timing);
+
+/**
+ * @brief Get simulated time in microseconds.
+ * 
+ * @return uint64_t simulated time
+ */
+uint64_t ee_pmw3901mb_sim_now_us(void);
+
+/**
+ * @brief Advance simulated time.
+ * 
+ * @param[in] us microseconds
+ */
+void ee_pmw3901mb_sim_advance_us(uint64_t us);
+
+/**
+ * @brief Run spiStartExchange() transfers in the background.
+ * @note When deferred, spiStartExchange() returns at the start of the transfer, and its
+ *       data callback runs when ee_pmw3901mb_sim_advance_us() passes the end of the transfer.
+ *       Otherwise the transfer and its callback complete before spiStartExchange() returns.
+ * 
+ * @param[in] deferred true to run the transfers in the background
+ */
+void ee_pmw3901mb_sim_set_async(bool deferred);
+
+/**
+ * @brief Add motion to be latched on the next MOTION (or motion burst) read.
+ * @note Motion while shut down or booting is not seen and dropped.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] dx motion along X
+ * @param[in] dy motion along Y
+ */
+void ee_pmw3901mb_sim_add_motion(ee_pmw3901mb_sim_t* sim, int32_t dx, int32_t dy);
+
+/**
+ * @brief Connect the motion (MOT) line of a simulated sensor to a PAL line.
+ * @note The line falls when motion is added while none is pending, and rises when the
+ *       motion is latched by a read, firing the PAL line event of the falling edge.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] line PAL line read by palReadLine()
+ */
+void ee_pmw3901mb_sim_set_motion_line(ee_pmw3901mb_sim_t* sim, ioline_t line);
+
+/**
+ * @brief Set surface quality, raw data statistics and shutter reported by the sensor.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] squal surface quality
+ * @param[in] rawdata_sum sum of raw pixel data
+ * @param[in] max_rawdata max of raw pixel data
+ * @param[in] min_rawdata min of raw pixel data
+ * @param[in] shutter shutter value
+ */
+void ee_pmw3901mb_sim_set_surface(ee_pmw3901mb_sim_t* sim, uint8_t squal, uint8_t rawdata_sum,
+                                  uint8_t max_rawdata, uint8_t min_rawdata, uint16_t shutter);
+
+/**
+ * @brief Set the pixels returned by the next raw data grabs.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] pixels pointer to EE_PMW3901MB_SIM_FRAME_SIZE pixels, row major
+ */
+void ee_pmw3901mb_sim_set_frame(ee_pmw3901mb_sim_t* sim, const uint8_t* pixels);
+
+/**
+ * @brief Inject a brown-out, the sensor resets on its own and boots into its power up state.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ */
+void ee_pmw3901mb_sim_brown_out(ee_pmw3901mb_sim_t* sim);
+
+/**
+ * @brief Inject a floating MISO line, the next bytes read as 0xFF.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] bytes number of bytes
+ */
+void ee_pmw3901mb_sim_float_miso(ee_pmw3901mb_sim_t* sim, uint32_t bytes);
+
+/**
+ * @brief Freeze the motion pipeline, motion bursts repeat the last frame until power up reset.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ */
+void ee_pmw3901mb_sim_freeze(ee_pmw3901mb_sim_t* sim);
+
+/**
+ * @brief Read a register of a bank directly (no bus traffic).
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ * @param[in] bank register bank
+ * @param[in] reg register address
+ * @return uint8_t register value
+ */
+uint8_t ee_pmw3901mb_sim_peek(const ee_pmw3901mb_sim_t* sim, uint8_t bank, uint8_t reg);
+
+/**
+ * @brief Clear bus statistics of a simulated sensor.
+ * 
+ * @param[in] sim pointer to the simulated sensor
+ */
+void ee_pmw3901mb_sim_clear_stats(ee_pmw3901mb_sim_t* sim);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_SIM_ */
@@ -0,0 +1,208 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file hal.h
+ * 
+ * @brief Stand-in for the ChibiOS hal.h on a Linux host.
+ * 
+ * Provides the subset of the ChibiOS HAL/RT API used by the driver. The SPI functions are
+ * served by the PMW3901MB register-level simulator (ee_pmw3901mb_sim.c), and time is
+ * simulated, so every run is deterministic.
+ */
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define TRUE    1
+#define FALSE   0
+
+#define SPI_USE_MUTUAL_EXCLUSION    TRUE
+
+#define PORT_SUPPORTS_RT            TRUE        /**< Realtime counter available */
+#define CH_CFG_ST_FREQUENCY         10000       /**< System tick frequency */
+#define STM32_SYSCLK                80000000U   /**< Realtime counter frequency */
+
+typedef uint32_t ioline_t;
+typedef uint32_t syssts_t;
+typedef uint32_t rtcnt_t;
+typedef uint64_t systimestamp_t;
+typedef int32_t msg_t;
+typedef void* thread_reference_t;
+
+#define MSG_OK                      ((msg_t) 0)
+#define MSG_RESET                   ((msg_t) -2)
+
+typedef struct hal_spi_driver SPIDriver;
+
+typedef void (*spicb_t)(SPIDriver* spip);
+
+/**
+ * @brief SPI configuration, same fields as the ChibiOS STM32 SPI v2 driver.
+ */
+typedef struct {
+    bool circular;
+    bool slave;
+    spicb_t data_cb;
+    spicb_t error_cb;
+    ioline_t ssline;    /**< Chip select line, selects the simulated device */
+    uint16_t cr1;
+    uint16_t cr2;
+} SPIConfig;
+
+/**
+ * @brief SPI driver.
+ */
+struct hal_spi_driver {
+    const SPIConfig* config;    /**< Config passed to spiStart(), NULL when stopped */
+    bool locked;                /**< Set while acquired with spiAcquireBus() */
+    void* selected;             /**< Simulated device selected by spiSelect() */
+};
+
+extern SPIDriver SPID1;
+extern SPIDriver SPID2;
+
+void spiStart(SPIDriver* spip, const SPIConfig* config);
+void spiStop(SPIDriver* spip);
+void spiSelect(SPIDriver* spip);
+void spiUnselect(SPIDriver* spip);
+void spiSend(SPIDriver* spip, size_t n, const void* txbuf);
+void spiReceive(SPIDriver* spip, size_t n, void* rxbuf);
+void spiStartExchange(SPIDriver* spip, size_t n, const void* txbuf, void* rxbuf);
+void spiUnselectI(SPIDriver* spip);
+void spiAcquireBus(SPIDriver* spip);
+void spiReleaseBus(SPIDriver* spip);
+
+void osalSysLock(void);
+void osalSysUnlock(void);
+void osalSysLockFromISR(void);
+void osalSysUnlockFromISR(void);
+msg_t osalThreadSuspendS(thread_reference_t* trp);
+void osalThreadResumeI(thread_reference_t* trp, msg_t msg);
+void osalThreadResumeS(thread_reference_t* trp, msg_t msg);
+void osalOsRescheduleS(void);
+
+syssts_t chSysGetStatusAndLockX(void);
+void chSysRestoreStatusX(syssts_t sts);
+systimestamp_t chVTGetTimeStampI(void);
+rtcnt_t chSysGetRealtimeCounterX(void);
+
+void chThdSleepMilliseconds(uint32_t msec);
+
+/*
+ * PAL line events and RT threads, semaphores and object FIFOs for the motion event acquisition.
+ * Threads are cooperative on the simulated clock: a thread runs when created or woken from
+ * the main context, until it waits, and takes no simulated time besides its bus transfers.
+ * Wait timeouts and sleeps expire when the main context advances the simulated time past
+ * them, and chThdWait() advances the time to the exit of a sleeping thread.
+ */
+
+#define PAL_USE_CALLBACKS           TRUE
+#define CH_CFG_USE_OBJ_FIFOS        TRUE
+#define CH_CFG_USE_WAITEXIT         TRUE
+
+#define PAL_LOW                     0U
+#define PAL_HIGH                    1U
+#define PAL_EVENT_MODE_FALLING_EDGE 2U
+
+#define MSG_TIMEOUT                 ((msg_t) -1)
+#define NORMALPRIO                  128U
+#define TIME_IMMEDIATE              ((sysinterval_t) 0)
+#define TIME_INFINITE               ((sysinterval_t) -1)
+#define TIME_US2I(usecs)            ((sysinterval_t) (((uint64_t) (usecs) * CH_CFG_ST_FREQUENCY + 999999U) / 1000000U))
+
+#define THD_FUNCTION(tname, arg)    void tname(void* arg)
+#define THD_WORKING_AREA(s, n)      _Alignas(16) uint8_t s[(n) + 32768U]  /**< Host stack on top of the target size */
+
+typedef uint32_t systime_t;
+typedef uint32_t sysinterval_t;
+typedef uint32_t tprio_t;
+typedef void (*palcallback_t)(void* arg);
+typedef void (*tfunc_t)(void* arg);
+typedef struct sim_thread thread_t;
+
+typedef struct {
+    bool taken;
+} binary_semaphore_t;
+
+typedef struct {
+    size_t objsize;
+    size_t n;
+    uint8_t* objs;
+    msg_t* msgs;        /**< Indices of the sent objects, in send order */
+    size_t head;
+    size_t count;
+    uint32_t used;      /**< Objects taken, one bit each */
+} objects_fifo_t;
+
+void palSetLineCallback(ioline_t line, palcallback_t cb, void* arg);
+void palEnableLineEvent(ioline_t line, uint32_t mode);
+void palDisableLineEvent(ioline_t line);
+uint32_t palReadLine(ioline_t line);
+
+void chSysLock(void);
+void chSysUnlock(void);
+void chSysLockFromISR(void);
+void chSysUnlockFromISR(void);
+systime_t chVTGetSystemTime(void);
+systime_t chVTGetSystemTimeX(void);
+
+thread_t* chThdCreateStatic(void* wa, size_t size, tprio_t prio, tfunc_t pf, void* arg);
+void chThdTerminate(thread_t* tp);
+bool chThdShouldTerminateX(void);
+msg_t chThdWait(thread_t* tp);
+systime_t chThdSleepUntilWindowed(systime_t prev, systime_t next);
+systime_t chTimeAddX(systime_t systime, sysinterval_t interval);
+void chRegSetThreadName(const char* name);
+
+void chBSemObjectInit(binary_semaphore_t* bsp, bool taken);
+msg_t chBSemWait(binary_semaphore_t* bsp);
+msg_t chBSemWaitTimeout(binary_semaphore_t* bsp, sysinterval_t timeout);
+void chBSemSignal(binary_semaphore_t* bsp);
+void chBSemSignalI(binary_semaphore_t* bsp);
+
+void chFifoObjectInit(objects_fifo_t* ofp, size_t objsize, size_t objn, void* objbuf, msg_t* msgbuf);
+void* chFifoTakeObjectTimeout(objects_fifo_t* ofp, sysinterval_t timeout);
+void chFifoSendObject(objects_fifo_t* ofp, void* objp);
+msg_t chFifoReceiveObjectTimeout(objects_fifo_t* ofp, void** objpp, sysinterval_t timeout);
+void chFifoReturnObject(objects_fifo_t* ofp, void* objp);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _HAL_H_ */
@@ -0,0 +1,2563 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Linux host example. Runs the driver against the PMW3901MB register-level simulator
+ * and prints the bus cost of driver initialization, of polling motion and of raw frame capture.
+ */
+
+#define _POSIX_C_SOURCE 200112L  // clock_gettime(), pthreads
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "hal.h"
+#include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_frame_capture.h"
+#include "ee_pmw3901mb_quality.h"
+#include "ee_pmw3901mb_poll.h"
+#include "ee_pmw3901mb_ring.h"
+#include "ee_pmw3901mb_motion_event.h"
+#include "ee_pmw3901mb_odometry.h"
+#include "ee_pmw3901mb_trace.h"
+#include "ee_pmw3901mb_health.h"
+#include "ee_pmw3901mb_power.h"
+#include "ee_pmw3901mb_fusion.h"
+#include "ee_pmw3901mb_derotate.h"
+#include "ee_pmw3901mb_estimator.h"
+#include "ee_pmw3901mb_velocity.h"
+#include "ee_pmw3901mb_sim.h"
+#include "ee_pmw3901mb_sequences.inc"
+
+#define SIM_CS_LINE     1U      // Chip select line of the simulated sensor
+#define COLD_CS_LINE    2U      // Chip select line of the cold started sensor
+#define FAULT_CS_LINE   3U      // Chip select line of the fault injected sensor
+#define DUTY_CS_LINE    4U      // Chip select line of the duty-cycled sensor
+#define DUTY_HOUR_US    3600000000ULL   // Simulated time of a duty cycle run
+#define DUTY_READ_US    10000U  // Read period of the application while the sensor is active
+#define FAULT_WARMUP    50U     // Healthy reads before a fault is injected
+#define FAULT_MAX_READS 500U    // Reads after the injection until a valid sample
+#define HEALTHY_READS   2000U   // Reads of the false positive run
+#define SAMPLES         1000U   // Samples per polling run
+#define FRAMES          20U     // Frames per frame capture run
+#define TRACE_SEGMENT   50U     // Samples per surface segment of the quality trace
+#define BENCH_READS     200000U // Motion reads per benchmark round
+#define BENCH_ROUNDS    5U      // Benchmark rounds, the fastest is reported
+#define TRACE_READS     20000U  // Motion reads of the recorded session
+
+static SPIConfig my_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = ee_pmw3901mb_spi_data_cb,  // Completes asynchronous reads
+    .error_cb   = NULL,
+    .ssline     = SIM_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static SPIConfig cold_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = ee_pmw3901mb_spi_data_cb,
+    .error_cb   = NULL,
+    .ssline     = COLD_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static SPIConfig fault_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = ee_pmw3901mb_spi_data_cb,
+    .error_cb   = NULL,
+    .ssline     = FAULT_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static SPIConfig duty_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = ee_pmw3901mb_spi_data_cb,
+    .error_cb   = NULL,
+    .ssline     = DUTY_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static ee_pmw3901mb_sim_t sensor;
+static ee_pmw3901mb_sim_t cold;
+static ee_pmw3901mb_dev_t cold_dev;
+static ee_pmw3901mb_sim_t faulty;
+static ee_pmw3901mb_dev_t fault_dev;
+static ee_pmw3901mb_health_t health;
+static ee_pmw3901mb_sim_t duty;
+static ee_pmw3901mb_dev_t duty_dev;
+static ee_pmw3901mb_power_t power;
+
+static uint8_t frame_bufs[2][EE_PMW3901MB_FRAME_SIZE];
+static uint8_t frame_pixels[EE_PMW3901MB_FRAME_SIZE];
+static ee_pmw3901mb_frame_capture_t capture;
+
+static uint32_t async_done = 0;
+static int32_t async_sum_x = 0;
+static int32_t async_sum_y = 0;
+
+static void motion_burst_done(ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_motion_burst_t* burst, void* arg){
+    (void) dev;
+    (void) arg;
+    async_done++;
+    async_sum_x += burst->delta_x;
+    async_sum_y += burst->delta_y;
+}
+
+// Recorded motion profile segment, constant speed in counts per second
+typedef struct {
+    uint32_t duration_ms;
+    int32_t vx;
+    int32_t vy;
+} profile_segment_t;
+
+typedef struct {
+    const char* name;
+    const profile_segment_t* segments;
+    size_t n;
+} profile_t;
+
+static const profile_segment_t stop_and_go[] = {
+    { 2000, 0, 0 }, { 1000, 400, 0 }, { 3000, 0, 0 }, { 500, 0, -800 }, { 5000, 0, 0 },
+    { 2000, 200, 200 }, { 300, 0, 0 }, { 2000, -300, 100 }, { 1500, 0, 0 },
+};
+static const profile_segment_t mostly_parked[] = {
+    { 20000, 0, 0 }, { 400, 500, 0 }, { 20000, 0, 0 }, { 400, 0, 500 }, { 20000, 0, 0 },
+};
+static const profile_segment_t continuous[] = {
+    { 5000, 300, -100 }, { 5000, 100, 300 },
+};
+static const profile_t profiles[] = {
+    { "stop-and-go", stop_and_go, sizeof(stop_and_go) / sizeof(stop_and_go[0]) },
+    { "mostly parked", mostly_parked, sizeof(mostly_parked) / sizeof(mostly_parked[0]) },
+    { "continuous", continuous, sizeof(continuous) / sizeof(continuous[0]) },
+};
+
+// Counts moved from the start of the profile up to t_us
+static void profile_position(const profile_t* pr, uint64_t t_us, int64_t* x, int64_t* y){
+    uint64_t start = 0;
+    *x = 0;
+    *y = 0;
+    for(size_t i = 0; i < pr->n && t_us > start; i++){
+        uint64_t len = (uint64_t) pr->segments[i].duration_ms * 1000U;
+        uint64_t dt = (t_us - start < len) ? t_us - start : len;
+        *x += (int64_t) pr->segments[i].vx * (int64_t) dt / 1000000;
+        *y += (int64_t) pr->segments[i].vy * (int64_t) dt / 1000000;
+        start += len;
+    }
+}
+
+static uint64_t profile_duration_us(const profile_t* pr){
+    uint64_t d = 0;
+    for(size_t i = 0; i < pr->n; i++) d += (uint64_t) pr->segments[i].duration_ms * 1000U;
+    return d;
+}
+
+// Start of segment i when it starts motion from standstill
+static bool segment_onset(const profile_t* pr, size_t i, uint64_t* start){
+    const profile_segment_t* seg = pr->segments;
+    if(seg[i].vx == 0 && seg[i].vy == 0) return false;
+    if(i > 0 && (seg[i - 1].vx != 0 || seg[i - 1].vy != 0)) return false;
+    *start = 0;
+    for(size_t k = 0; k < i; k++) *start += (uint64_t) seg[k].duration_ms * 1000U;
+    return true;
+}
+
+// Polls the profile with a rate controller, or a fixed period when min equals max
+static void poll_profile(const profile_t* pr, const char* policy, uint32_t min_period_us, uint32_t max_period_us){
+    ee_pmw3901mb_poll_rate_t rate;
+    ee_pmw3901mb_poll_rate_init(&rate, min_period_us, max_period_us, EE_PMW3901MB_POLL_IDLE_HOLD);
+    ee_pmw3901mb_motion_burst_t burst;
+
+    uint64_t t_start = ee_pmw3901mb_sim_now_us();
+    uint64_t duration = profile_duration_us(pr);
+    int64_t px = 0, py = 0, last_x = 0, last_y = 0, sum_x = 0, sum_y = 0;
+    uint64_t onset_latency = 0;
+    uint32_t onsets = 0;
+    uint64_t sample_latency = 0;
+    uint32_t samples = 0;
+    uint64_t next = 0;
+    uint64_t last_read = 0;
+    uint64_t onset = 0;
+    size_t next_onset = 0;
+    while(next_onset < pr->n && !segment_onset(pr, next_onset, &onset)) next_onset++;
+
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    while(next < duration){
+        uint64_t now = ee_pmw3901mb_sim_now_us() - t_start;
+        if(next > now) ee_pmw3901mb_sim_advance_us(next - now);
+        now = ee_pmw3901mb_sim_now_us() - t_start;
+        if(now > duration) now = duration;
+
+        profile_position(pr, now, &px, &py);
+        ee_pmw3901mb_sim_add_motion(&sensor, (int32_t) (px - last_x), (int32_t) (py - last_y));
+        last_x = px;
+        last_y = py;
+
+        if(ee_pmw3901mb_get_motion_burst(&burst) != 0) break;
+        sum_x += burst.delta_x;
+        sum_y += burst.delta_y;
+
+        // Latency of each motion onset to the first read reporting motion after it, and the
+        // sample latency, the mean age of the motion counts in a read (half the read interval)
+        if((burst.motion & EE_PMW3901MB_MOTION_MOT) != 0U){
+            while(next_onset < pr->n && segment_onset(pr, next_onset, &onset) && onset <= now){
+                onset_latency += now - onset;
+                onsets++;
+                next_onset++;
+            }
+            while(next_onset < pr->n && !segment_onset(pr, next_onset, &onset)) next_onset++;
+            sample_latency += (now - last_read) / 2U;
+            samples++;
+        }
+        last_read = now;
+
+        next = now + ee_pmw3901mb_poll_rate_update(&rate, &burst);
+    }
+
+    printf("%-14s %-12s %6" PRIu32 " trans %7" PRIu32 " bytes | latency: onset %6.1f ms, sample %6.1f ms | moved %" PRId64 ", %" PRId64 " (read %" PRId64 ", %" PRId64 ")\r\n",
+        pr->name, policy, sensor.stats.transactions, sensor.stats.bytes,
+        (onsets > 0) ? (double) onset_latency / onsets / 1000.0 : 0.0,
+        (samples > 0) ? (double) sample_latency / samples / 1000.0 : 0.0, px, py, sum_x, sum_y);
+}
+
+#define JITTER_READS        200U
+#define JITTER_PERIOD_US    10000U
+#define JITTER_SPREAD_US    1500U
+#define JITTER_GAP_US       100000000U  // Longer than the 2^32 cycle wrap (53.7 s) of the 80 MHz counter
+
+static uint64_t burst_start_us[JITTER_READS];
+static uint32_t burst_starts = 0;
+
+static void record_burst(const ee_pmw3901mb_sim_t* sim, const ee_pmw3901mb_sim_transaction_t* trans, void* arg){
+    (void) sim;
+    (void) arg;
+    if(!trans->write && trans->addr == 0x16 && burst_starts < JITTER_READS) burst_start_us[burst_starts++] = trans->start_us;
+}
+
+static uint32_t lcg_state = 1U;
+
+static uint32_t lcg_range(uint32_t lo, uint32_t hi){
+    lcg_state = lcg_state * 1103515245U + 12345U;
+    return lo + ((lcg_state >> 16) % (hi - lo + 1U));
+}
+
+static void print_stats(const char* name, uint64_t time_us, uint32_t samples){
+    const ee_pmw3901mb_sim_stats_t* st = &sensor.stats;
+    if(samples == 0) samples = 1;
+    printf("%-24s %8" PRIu64 " us %7" PRIu32 " trans %7" PRIu32 " bytes %8" PRIu64 " us bus %8" PRIu64 " us start/stop",
+        name, time_us, st->transactions, st->bytes, st->bus_time_us, st->start_stop_time_us);
+    if(samples > 1){
+        printf(" | per sample: %.2f trans %.2f bytes %.1f us", (double) st->transactions / samples,
+            (double) st->bytes / samples, (double) time_us / samples);
+    }
+    printf("\r\n");
+}
+
+// Delta read of the driver before the motion burst: MOTION, then the four delta registers,
+// each its own transaction
+static uint8_t five_read_delta_x_y(int16_t* delta_x, int16_t* delta_y){
+    static const uint8_t regs[] = { 0x02, 0x03, 0x04, 0x05, 0x06 };
+    uint8_t values[sizeof(regs)];
+    for(size_t i = 0; i < sizeof(regs); i++){
+        uint8_t status_code = ee_pmw3901mb_spi_read(regs[i], &values[i], 1U);
+        if(status_code != 0) return status_code;
+    }
+    *delta_x = (int16_t) ((values[2] << 8) | values[1]);
+    *delta_y = (int16_t) ((values[4] << 8) | values[3]);
+    return 0;
+}
+
+static uint64_t host_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+// Performance optimization sequence written step by step, each write starting and stopping
+// the SPI driver, as before the bus sessions
+#define SEQ_STEP(reg, value, delay_ms)  { reg, value, delay_ms },
+static const ee_pmw3901mb_reg_write_t perf_opt_v2_steps[] = {
+    EE_PMW3901MB_SEQ_PERF_OPT_V2(SEQ_STEP)
+};
+static const ee_pmw3901mb_reg_write_t perf_opt_steps[] = {
+    EE_PMW3901MB_SEQ_PERF_OPT(SEQ_STEP)
+};
+#define PERF_OPT_V2_STEPS   (sizeof(perf_opt_v2_steps) / sizeof(perf_opt_v2_steps[0]))
+#define PERF_OPT_STEPS      (sizeof(perf_opt_steps) / sizeof(perf_opt_steps[0]))
+#define SEQ_BANK_SELECT     0x7F
+
+static uint8_t write_per_transfer(const ee_pmw3901mb_reg_write_t* seq, size_t len){
+    for(size_t i = 0; i < len; i++){
+        uint8_t value = seq[i].value;
+        uint8_t status_code = ee_pmw3901mb_spi_write(seq[i].reg, &value);
+        if(status_code == 0 && seq[i].delay_ms != 0U) status_code = ee_pmw3901mb_wait_ms(seq[i].delay_ms);
+        if(status_code != 0) return status_code;
+    }
+    return 0;
+}
+
+// Performance optimization sequence version 2 hand-unrolled as before the register tables, one
+// write call and status check per step. Not static, so "make size" finds it in the object file.
+uint8_t perf_opt_v2_unrolled(void);
+
+#define UNROLLED_STEP(reg, value, delay_ms) \
+    data = value; \
+    status_code = ee_pmw3901mb_spi_write(reg, &data); \
+    if(status_code != 0) return status_code; \
+    if(delay_ms != 0U){ \
+        status_code = ee_pmw3901mb_wait_ms(delay_ms); \
+        if(status_code != 0) return status_code; \
+    }
+
+uint8_t perf_opt_v2_unrolled(void){
+    uint8_t data = 0;
+    uint8_t status_code = 0;
+    EE_PMW3901MB_SEQ_PERF_OPT_V2(UNROLLED_STEP)
+    return status_code;
+}
+
+// Sets each register a sequence writes to the complement of the written value, so a step that
+// is not applied shows in the register file
+static void sequence_poison(ee_pmw3901mb_sim_t* sim, const ee_pmw3901mb_reg_write_t* seq, size_t len){
+    uint8_t bank = 0;
+    for(size_t i = 0; i < len; i++){
+        if(seq[i].reg == SEQ_BANK_SELECT) bank = seq[i].value;
+        else sim->regs[bank][seq[i].reg] = (uint8_t) ~seq[i].value;
+    }
+}
+
+// Checks the register file after a sequence: the last value written to each register of each
+// bank, and the bank selected at the end
+static bool sequence_applied(const ee_pmw3901mb_sim_t* sim, const ee_pmw3901mb_reg_write_t* seq, size_t len){
+    uint8_t bank = 0;
+    for(size_t i = 0; i < len; i++){
+        if(seq[i].reg == SEQ_BANK_SELECT){
+            bank = seq[i].value;
+            continue;
+        }
+        bool last = true;
+        uint8_t later_bank = bank;
+        for(size_t k = i + 1U; k < len && last; k++){
+            if(seq[k].reg == SEQ_BANK_SELECT) later_bank = seq[k].value;
+            else if(later_bank == bank && seq[k].reg == seq[i].reg) last = false;
+        }
+        if(last && ee_pmw3901mb_sim_peek(sim, bank, seq[i].reg) != seq[i].value) return false;
+    }
+    return sim->bank == bank;
+}
+
+// Host time per motion read with and without the performance counters (EE_PMW3901MB_USE_STATS),
+// built twice by "make bench". The simulator dominates the absolute time, the difference
+// between the two builds is the instrumentation cost.
+static int stats_bench(void){
+    ee_pmw3901mb_motion_burst_t burst;
+    int16_t delta_x = 0;
+    int16_t delta_y = 0;
+    uint64_t best_burst = UINT64_MAX;
+    uint64_t best_delta = UINT64_MAX;
+
+    ee_pmw3901mb_sim_set_surface(&sensor, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+    ee_pmw3901mb_stats_t before;
+    ee_pmw3901mb_get_stats(&before);
+#endif
+    for(uint32_t r = 0; r < BENCH_ROUNDS; r++){
+        uint64_t t0 = host_ns();
+        for(uint32_t i = 0; i < BENCH_READS; i++){
+            if(ee_pmw3901mb_get_motion_burst(&burst) != 0) return 1;
+        }
+        uint64_t t1 = host_ns();
+        for(uint32_t i = 0; i < BENCH_READS; i++){
+            if(ee_pmw3901mb_get_delta_x_y(&delta_x, &delta_y) != 0) return 1;
+        }
+        uint64_t t2 = host_ns();
+        if(t1 - t0 < best_burst) best_burst = t1 - t0;
+        if(t2 - t1 < best_delta) best_delta = t2 - t1;
+    }
+
+    printf("stats %-8s burst read %6.1f ns, delta read %6.1f ns (host time per read), device handle %zu bytes\r\n",
+        (EE_PMW3901MB_USE_STATS == TRUE) ? "enabled" : "disabled",
+        (double) best_burst / BENCH_READS, (double) best_delta / BENCH_READS, sizeof(ee_pmw3901mb_dev_t));
+
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+    ee_pmw3901mb_frame_grab_enable();
+    for(uint32_t i = 0; i < FRAMES; i++){
+        if(ee_pmw3901mb_frame_grab(frame_bufs[0]) != 0) return 1;
+    }
+    uint8_t value = 0;
+    ee_pmw3901mb_spi_bus_read(&ee_pmw3901mb_get_default_dev()->bus, 0x00, &value, 0U); // Refused, counted as an error
+
+    ee_pmw3901mb_stats_t stats;
+    ee_pmw3901mb_get_stats(&stats);
+    // Each read is recorded once, a delta read is not also a burst read
+    uint32_t burst_ops = stats.latency[EE_PMW3901MB_OP_BURST].count - before.latency[EE_PMW3901MB_OP_BURST].count;
+    uint32_t delta_ops = stats.latency[EE_PMW3901MB_OP_DELTA].count - before.latency[EE_PMW3901MB_OP_DELTA].count;
+    bool once = burst_ops == BENCH_ROUNDS * BENCH_READS && delta_ops == BENCH_ROUNDS * BENCH_READS;
+    printf("  %" PRIu32 " burst and %" PRIu32 " delta reads recorded for %u each %s\r\n", burst_ops, delta_ops,
+        BENCH_ROUNDS * BENCH_READS, once ? "OK" : "MISMATCH");
+    printf("  bus: %" PRIu32 " reads %" PRIu32 " writes %" PRIu32 " bytes %" PRIu32 " errors %" PRIu32 " retries\r\n",
+        stats.bus.reads, stats.bus.writes, stats.bus.bytes, stats.bus.errors, stats.bus.retries);
+    static const char* const op_names[EE_PMW3901MB_OP_COUNT] = { "init", "delta read", "burst read", "frame grab" };
+    for(uint32_t op = 0; op < EE_PMW3901MB_OP_COUNT; op++){
+        const ee_pmw3901mb_hist_t* h = &stats.latency[op];
+        printf("  %-10s %8" PRIu32 " ops, simulated latency mean %9.1f us, p50 <= %7" PRIu32 " p99 <= %7" PRIu32 " max %7" PRIu32 " us\r\n",
+            op_names[op], h->count, (h->count > 0) ? (double) h->sum_us / h->count : 0.0,
+            ee_pmw3901mb_hist_percentile(h, 50U), ee_pmw3901mb_hist_percentile(h, 99U), h->max_us);
+    }
+    if(!once) return 1;
+#endif
+
+    return 0;
+}
+
+// Records a session for the trace replay example (EE_PMW3901MB_USE_TRACE), built by "make trace".
+// The consumer is the same as in the replay, its digest must match the replayed one.
+#if (EE_PMW3901MB_USE_TRACE == TRUE)
+static uint8_t trace_dump[EE_PMW3901MB_TRACE_FILE_HEADER_SIZE + EE_PMW3901MB_TRACE_SIZE];
+static ee_pmw3901mb_odometry_t trace_odo;
+static uint32_t trace_hash = 2166136261U;
+
+static void trace_consume(const ee_pmw3901mb_motion_burst_t* burst, uint32_t time_us){
+    const uint8_t bytes[] = { burst->motion, (uint8_t) burst->delta_x, (uint8_t) (burst->delta_x >> 8),
+        (uint8_t) burst->delta_y, (uint8_t) (burst->delta_y >> 8), burst->squal, (uint8_t) burst->shutter,
+        (uint8_t) (burst->shutter >> 8), (uint8_t) time_us, (uint8_t) (time_us >> 8), (uint8_t) (time_us >> 16),
+        (uint8_t) (time_us >> 24) };
+    for(size_t i = 0; i < sizeof(bytes); i++) trace_hash = (trace_hash ^ bytes[i]) * 16777619U; // FNV-1a
+    ee_pmw3901mb_odometry_update(&trace_odo, burst->delta_x, burst->delta_y, time_us);
+}
+
+static void trace_burst_done(ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_motion_burst_t* burst, void* arg){
+    (void) arg;
+    trace_consume(burst, dev->burst_assert_us);
+}
+#endif
+
+static int trace_session(const char* path){
+#if (EE_PMW3901MB_USE_TRACE == TRUE)
+    ee_pmw3901mb_motion_burst_t burst;
+    uint32_t assert_us = 0;
+    uint32_t deassert_us = 0;
+
+    ee_pmw3901mb_odometry_init(&trace_odo, 100000U, 0U);
+    for(uint32_t i = 0; i < TRACE_READS; i++){
+        ee_pmw3901mb_sim_set_surface(&sensor, (uint8_t) lcg_range(0x20, 0x80), 0x40, 0xA0, 0x10, (uint16_t) lcg_range(0x0100, 0x0800));
+        ee_pmw3901mb_sim_add_motion(&sensor, (int32_t) lcg_range(0, 60) - 30, (int32_t) lcg_range(0, 60) - 30);
+        ee_pmw3901mb_sim_advance_us(lcg_range(8000U, 12000U));
+        if((i % 10U) == 9U){
+            // Every tenth read asynchronous, recorded at completion
+            ee_pmw3901mb_acquire();
+            if(ee_pmw3901mb_get_motion_burst_async(trace_burst_done, NULL) != 0) return 1;
+            ee_pmw3901mb_release();
+        }else{
+            if(ee_pmw3901mb_get_motion_burst(&burst) != 0) return 1;
+            ee_pmw3901mb_get_burst_time(&assert_us, &deassert_us);
+            trace_consume(&burst, assert_us);
+        }
+    }
+
+    size_t len = 0;
+    if(ee_pmw3901mb_trace_dump(trace_dump, sizeof(trace_dump), &len) != 0) return 1;
+    FILE* f = fopen(path, "wb");
+    if(f == NULL || fwrite(trace_dump, 1, len, f) != len){
+        printf("Failed to write %s\r\n", path);
+        if(f != NULL) fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    uint32_t records = 0;
+    uint32_t dropped = 0;
+    ee_pmw3901mb_trace_parse_header(trace_dump, len, &records, &dropped);
+    int64_t x = 0;
+    int64_t y = 0;
+    ee_pmw3901mb_odometry_get_total(&trace_odo, &x, &y);
+    printf("recorded %" PRIu32 " transactions (%" PRIu32 " dropped), %zu bytes to %s\r\n", records, dropped, len, path);
+    printf("recorded %" PRIu32 " motion reads, position %" PRId64 ", %" PRId64 ", digest 0x%08" PRIX32 "\r\n",
+        (uint32_t) TRACE_READS, x, y, trace_hash);
+    return 0;
+#else
+    printf("Trace recorder not built in, use \"make trace\" to record %s\r\n", path);
+    return 1;
+#endif
+}
+
+// Cold start of a second sensor up to its first valid motion sample (motion bit and observation
+// bits of a processed frame set), with the former fixed sleeps, the blocking initialization, or
+// the non-blocking initialization where the waits between steps are free for other work
+typedef enum { COLD_FIXED, COLD_BLOCKING, COLD_NON_BLOCKING } cold_mode_t;
+
+static void cold_start(const char* name, cold_mode_t mode, uint32_t boot_us){
+    ee_pmw3901mb_sim_timing_t timing;
+    ee_pmw3901mb_sim_timing_t saved;
+    ee_pmw3901mb_sim_get_timing(&saved);
+    timing = saved;
+    timing.t_boot_us = boot_us;
+    ee_pmw3901mb_sim_set_timing(&timing);
+    ee_pmw3901mb_sim_init(&cold);
+
+    uint8_t status_code = 0;
+    uint64_t free_us = 0;
+    uint64_t t0 = ee_pmw3901mb_sim_now_us();
+    if(mode == COLD_FIXED){
+        status_code = ee_pmw3901mb_dev_init_start(&cold_dev, &SPID1, &cold_spi_cfg); // Power up reset
+        if(status_code == 0) status_code = ee_pmw3901mb_wait_ms(50U);
+        if(status_code == 0) status_code = ee_pmw3901mb_dev_perf_opt_v2(&cold_dev);
+        if(status_code == 0) status_code = ee_pmw3901mb_wait_ms(5U);
+    }else if(mode == COLD_BLOCKING){
+        status_code = ee_pmw3901mb_dev_init_driver(&cold_dev, &SPID1, &cold_spi_cfg);
+    }else{
+        status_code = ee_pmw3901mb_dev_init_start(&cold_dev, &SPID1, &cold_spi_cfg);
+        while(status_code == 0 && !ee_pmw3901mb_dev_init_done(&cold_dev)){
+            uint32_t wait_us = 0;
+            status_code = ee_pmw3901mb_dev_init_step(&cold_dev, &wait_us);
+            ee_pmw3901mb_sim_advance_us(wait_us);
+            free_us += wait_us;
+        }
+    }
+
+    ee_pmw3901mb_motion_burst_t burst = { 0 };
+    uint32_t reads = 0;
+    ee_pmw3901mb_sim_add_motion(&cold, 1, 1);
+    while(status_code == 0 && reads < 100U){
+        status_code = ee_pmw3901mb_dev_get_motion_burst(&cold_dev, &burst);
+        reads++;
+        if((burst.motion & EE_PMW3901MB_MOTION_MOT) != 0U && burst.observation != 0x00) break;
+        ee_pmw3901mb_sim_add_motion(&cold, 1, 1);
+        ee_pmw3901mb_sim_advance_us(EE_PMW3901MB_STARTUP_POLL_US);
+    }
+    uint64_t time_us = ee_pmw3901mb_sim_now_us() - t0;
+    ee_pmw3901mb_sim_set_timing(&saved);
+
+    if(status_code != 0){
+        printf("cold start %-20s boot %5" PRIu32 " us: failed after %6" PRIu64 " us in state %d, status 0x%02X\r\n",
+            name, boot_us, time_us, (int) cold_dev.startup.failed_state, status_code);
+        return;
+    }
+    printf("cold start %-20s boot %5" PRIu32 " us: first valid sample after %6" PRIu64 " us, %3" PRIu32 " trans, %" PRIu32 " read(s)",
+        name, boot_us, time_us, cold.stats.transactions, reads);
+    if(mode == COLD_NON_BLOCKING) printf(", %6" PRIu64 " us free between steps", free_us);
+    printf("\r\n");
+}
+
+// Fault injection into a health monitored sensor read at the frame period, from the injection
+// to the detection, through the recovery, up to the next valid sample
+typedef enum { FAULT_NONE, FAULT_GLITCH, FAULT_BROWN_OUT, FAULT_BANK, FAULT_FREEZE, FAULT_SHUTDOWN } fault_t;
+
+static const char* const fault_names[] = { "none", "bus glitch", "brown-out", "lost bank", "frozen", "shutdown" };
+static const char* const health_names[] = { "ok", "bus error", "all 0xFF", "all 0x00", "stuck", "ID mismatch", "tuning lost" };
+static const char* const recovery_names[] = { "nothing", "bank select", "retune", "full init" };
+
+static uint8_t fault_read(ee_pmw3901mb_motion_burst_t* burst){
+    ee_pmw3901mb_sim_advance_us(EE_PMW3901MB_FRAME_PERIOD_US);
+    ee_pmw3901mb_sim_add_motion(&faulty, (int32_t) lcg_range(1, 6), -(int32_t) lcg_range(1, 6));
+    return ee_pmw3901mb_health_get_motion_burst(&health, burst);
+}
+
+static void fault_inject(fault_t fault){
+    ee_pmw3901mb_sim_init(&faulty);
+    ee_pmw3901mb_sim_set_surface(&faulty, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    if(ee_pmw3901mb_dev_init_driver(&fault_dev, &SPID1, &fault_spi_cfg) != 0 ||
+       ee_pmw3901mb_health_init(&health, &fault_dev, NULL) != 0){
+        printf("fault %-11s: failed to initialize\r\n", fault_names[fault]);
+        return;
+    }
+
+    ee_pmw3901mb_motion_burst_t burst;
+    uint8_t status_code = 0;
+    for(uint32_t i = 0; i < FAULT_WARMUP && status_code == 0; i++) status_code = fault_read(&burst);
+
+    if(fault == FAULT_NONE){
+        // False positives and the bus cost of the checks over healthy reads
+        ee_pmw3901mb_sim_clear_stats(&faulty);
+        for(uint32_t i = 0; i < HEALTHY_READS; i++) fault_read(&burst);
+        printf("fault %-11s: %" PRIu32 " faults in %u reads, %" PRIu32 " check reads (%.1f%% of the bus bytes)\r\n",
+            fault_names[fault], health.faults, HEALTHY_READS, faulty.stats.reads - HEALTHY_READS,
+            100.0 * (double) (faulty.stats.bytes - HEALTHY_READS * 13U) / (double) faulty.stats.bytes);
+        return;
+    }
+
+    uint64_t t_inject = ee_pmw3901mb_sim_now_us();
+    switch(fault){
+    case FAULT_GLITCH:      ee_pmw3901mb_sim_float_miso(&faulty, EE_PMW3901MB_MOTION_BURST_SIZE); break;
+    case FAULT_BROWN_OUT:   ee_pmw3901mb_sim_brown_out(&faulty); break;
+    case FAULT_BANK:        faulty.bank = 0x05; break;
+    case FAULT_FREEZE:      ee_pmw3901mb_sim_freeze(&faulty); break;
+    case FAULT_SHUTDOWN:    faulty.shutdown = true; break;
+    default: break;
+    }
+
+    uint64_t t_detect = 0;
+    uint64_t t_recover = 0;
+    uint32_t recover_trans = 0;
+    uint32_t reads = 0;
+    ee_pmw3901mb_health_fault_t detected = EE_PMW3901MB_HEALTH_OK;
+    bool valid = false;
+    while(!valid && reads < FAULT_MAX_READS){
+        status_code = fault_read(&burst);
+        reads++;
+        if(status_code == 0){
+            valid = (t_detect != 0U);
+            continue;
+        }
+        if(t_detect != 0U) break; // Not recovered
+        t_detect = ee_pmw3901mb_sim_now_us();
+        detected = health.fault;
+        uint32_t trans = faulty.stats.transactions;
+        uint64_t t0 = ee_pmw3901mb_sim_now_us();
+        status_code = ee_pmw3901mb_health_recover(&health);
+        t_recover = ee_pmw3901mb_sim_now_us() - t0;
+        recover_trans = faulty.stats.transactions - trans;
+        if(status_code != 0) break;
+    }
+
+    if(!valid){
+        printf("fault %-11s: not recovered, fault %s after %" PRIu32 " reads\r\n", fault_names[fault], health_names[health.fault], reads);
+        return;
+    }
+    printf("fault %-11s: detected as %-11s after %6" PRIu64 " us, recovered by %-11s in %6" PRIu64 " us (%2" PRIu32 " trans), valid sample after %6" PRIu64 " us\r\n",
+        fault_names[fault], health_names[detected],
+        t_detect - t_inject, recovery_names[health.last_recovery], t_recover, recover_trans,
+        ee_pmw3901mb_sim_now_us() - t_inject);
+}
+
+// Several sensors on one SPI driver with their own chip select lines, read round-robin
+// through their device handles
+#define MULTI_MAX       4U      // Sensors of the largest run
+#define MULTI_CS_LINE   5U      // Chip select line of the first sensor, the others follow
+
+static ee_pmw3901mb_sim_t multi[MULTI_MAX];
+static ee_pmw3901mb_dev_t multi_dev[MULTI_MAX];
+static SPIConfig multi_spi_cfg[MULTI_MAX];
+
+static void multi_round_robin(uint32_t n){
+    static bool attached = false;
+    if(!attached){
+        for(uint32_t k = 0; k < MULTI_MAX; k++){
+            multi_spi_cfg[k] = my_spi_cfg;
+            multi_spi_cfg[k].ssline = MULTI_CS_LINE + k;
+            ee_pmw3901mb_sim_init(&multi[k]);
+            ee_pmw3901mb_sim_attach(&multi[k], MULTI_CS_LINE + k);
+            if(ee_pmw3901mb_dev_init_driver(&multi_dev[k], &SPID1, &multi_spi_cfg[k]) != 0){
+                printf("multi: sensor %" PRIu32 " failed to initialize\r\n", k);
+                return;
+            }
+            ee_pmw3901mb_sim_set_surface(&multi[k], 0x60, 0x40, 0xA0, 0x10, 0x0100);
+        }
+        attached = true;
+    }
+
+    int32_t sum_x[MULTI_MAX] = { 0 };
+    ee_pmw3901mb_motion_burst_t burst;
+    uint8_t status_code = 0;
+    for(uint32_t k = 0; k < n; k++) ee_pmw3901mb_sim_clear_stats(&multi[k]);
+    uint64_t t0 = ee_pmw3901mb_sim_now_us();
+    for(uint32_t i = 0; i < SAMPLES && status_code == 0; i++){
+        for(uint32_t k = 0; k < n && status_code == 0; k++){
+            ee_pmw3901mb_sim_add_motion(&multi[k], (int32_t) k + 1, 0);
+            status_code = ee_pmw3901mb_dev_get_motion_burst(&multi_dev[k], &burst);
+            sum_x[k] += burst.delta_x;
+        }
+    }
+    uint64_t time_us = ee_pmw3901mb_sim_now_us() - t0;
+
+    // Each sensor has its own motion, a mixed up handle reads the counts of another sensor
+    bool ok = status_code == 0;
+    uint64_t bus_us = 0;
+    for(uint32_t k = 0; k < n; k++){
+        ok = ok && sum_x[k] == (int32_t) ((k + 1U) * SAMPLES) && multi[k].stats.transactions == SAMPLES;
+        bus_us += multi[k].stats.bus_time_us;
+    }
+    printf("multi %" PRIu32 " sensor(s) round-robin: %8.1f samples/s per sensor, %8.1f samples/s total, bus busy %5.1f%%, counts %s\r\n",
+        n, (double) SAMPLES * 1000000.0 / (double) time_us, (double) n * SAMPLES * 1000000.0 / (double) time_us,
+        100.0 * (double) bus_us / (double) time_us, ok ? "OK" : "MISMATCH");
+}
+
+// Hour long duty cycle of a sensor on a robot stopping and moving along X at a constant speed,
+// always on, under the power manager, or shut down and fully initialized for each motion check
+typedef struct {
+    const char* name;
+    uint32_t stop_ms;   // Standstill at the start of each period
+    uint32_t move_ms;   // Move at the end of each period
+    int32_t vx;         // Counts per second while moving
+} duty_profile_t;
+
+typedef enum { DUTY_ALWAYS_ON, DUTY_MANAGED, DUTY_FULL_INIT } duty_mode_t;
+
+typedef struct {
+    const char* name;
+    duty_mode_t mode;
+    ee_pmw3901mb_sleep_mode_t sleep_mode;
+    uint32_t check_period_us;
+    bool wake_on_motion;
+} duty_policy_t;
+
+static const duty_profile_t duty_profiles[] = {
+    { "idle", 890370, 10000, 300 },     // Parked, 4 short moves per hour
+    { "active", 15370, 45000, 300 },    // Driving, short stops (periods drift against the checks)
+};
+
+static const duty_policy_t duty_policies[] = {
+    { "always on", DUTY_ALWAYS_ON, EE_PMW3901MB_SLEEP_REST, 0, false },
+    { "rest, check 250ms", DUTY_MANAGED, EE_PMW3901MB_SLEEP_REST, 250000U, false },
+    { "rest, motion line", DUTY_MANAGED, EE_PMW3901MB_SLEEP_REST, 0, true },
+    { "shutdown, check 1s", DUTY_MANAGED, EE_PMW3901MB_SLEEP_SHUTDOWN, 1000000U, false },
+    { "shutdown, check 5s", DUTY_MANAGED, EE_PMW3901MB_SLEEP_SHUTDOWN, 5000000U, false },
+    { "full init, check 1s", DUTY_FULL_INIT, EE_PMW3901MB_SLEEP_SHUTDOWN, 1000000U, false },
+};
+
+// Standstill of period k, varied by up to a second so the onsets fall at any phase of the checks
+static uint64_t duty_stop_us(const duty_profile_t* pr, uint64_t k){
+    return ((uint64_t) pr->stop_ms + (k * 7919U) % 1000U) * 1000U;
+}
+
+// Counts moved from the start up to t_us
+static int64_t duty_position(const duty_profile_t* pr, uint64_t t_us){
+    uint64_t move = (uint64_t) pr->move_ms * 1000U;
+    uint64_t start = 0;
+    uint64_t moved = 0;
+    for(uint64_t k = 0;; k++){
+        uint64_t stop = duty_stop_us(pr, k);
+        if(t_us < start + stop + move){
+            if(t_us > start + stop) moved += t_us - start - stop;
+            break;
+        }
+        moved += move;
+        start += stop + move;
+    }
+    return (int64_t) pr->vx * (int64_t) moved / 1000000;
+}
+
+// Motion onset of period k
+static uint64_t duty_onset_us(const duty_profile_t* pr, uint64_t k){
+    uint64_t start = 0;
+    for(uint64_t i = 0; i < k; i++) start += duty_stop_us(pr, i) + (uint64_t) pr->move_ms * 1000U;
+    return start + duty_stop_us(pr, k);
+}
+
+static void duty_cycle(const duty_profile_t* pr, const duty_policy_t* pol){
+    ee_pmw3901mb_sim_init(&duty);
+    ee_pmw3901mb_sim_set_surface(&duty, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    ee_pmw3901mb_power_cfg_t cfg;
+    ee_pmw3901mb_power_default_cfg(&cfg);
+    cfg.sleep_mode = pol->sleep_mode;
+    cfg.check_period_us = pol->check_period_us;
+    cfg.wake_on_motion = pol->wake_on_motion;
+    if(ee_pmw3901mb_dev_init_driver(&duty_dev, &SPID1, &duty_spi_cfg) != 0 ||
+       ee_pmw3901mb_power_init(&power, &duty_dev, &cfg) != 0){
+        printf("duty %-6s %-20s: failed to initialize\r\n", pr->name, pol->name);
+        return;
+    }
+
+    uint64_t t_start = ee_pmw3901mb_sim_now_us();
+    int64_t last_x = 0;
+    int64_t read_x = 0;
+    uint64_t off_us = 0;
+    uint64_t reading_us = 0;
+    uint64_t latency_sum = 0;
+    uint64_t latency_max = 0;
+    uint32_t onsets = 0;
+    uint64_t onset_k = 0;
+    uint64_t onset = duty_onset_us(pr, 0);  // Next motion onset not yet seen in a read
+    bool active = true;             // Full init policy: read by the application
+    uint32_t motion_us = 0;         // Full init policy: last motion
+    uint64_t due = 0;               // Full init policy: next motion check
+    uint32_t wakes = 0;
+    uint32_t checks = 0;
+    uint8_t status_code = 0;
+
+    ee_pmw3901mb_sim_clear_stats(&duty);
+    motion_us = ee_pmw3901mb_time_us();
+    for(;;){
+        uint64_t now = ee_pmw3901mb_sim_now_us() - t_start;
+        if(now >= DUTY_HOUR_US) break;
+        int64_t x = duty_position(pr, now);
+        ee_pmw3901mb_sim_add_motion(&duty, (int32_t) (x - last_x), 0);
+        last_x = x;
+
+        ee_pmw3901mb_motion_burst_t burst = { 0 };
+        bool read = false;
+        uint64_t wait = DUTY_READ_US;
+        if(pol->mode == DUTY_MANAGED){
+            // The motion line asserts with the first frame seeing motion
+            uint64_t line = onset + EE_PMW3901MB_FRAME_PERIOD_US;
+            if(pol->wake_on_motion && power.state == EE_PMW3901MB_POWER_REST){
+                if(now >= line) ee_pmw3901mb_power_notify_motion(&power);
+                else wait = line - now;
+            }
+            uint32_t step_wait = 0;
+            status_code = ee_pmw3901mb_power_step(&power, &step_wait);
+            if(status_code != 0) break;
+            if(ee_pmw3901mb_power_is_active(&power)){
+                status_code = ee_pmw3901mb_power_get_motion_burst(&power, &burst);
+                if(status_code != 0) break;
+                read = true;
+                wait = DUTY_READ_US;
+            }else if(power.state == EE_PMW3901MB_POWER_REST && pol->wake_on_motion && now < line){
+                if(step_wait < wait) wait = step_wait;
+            }else{
+                wait = step_wait;
+            }
+        }else if(pol->mode == DUTY_FULL_INIT && !active){
+            if(now >= due){
+                // Full initialization for each motion check
+                checks++;
+                status_code = ee_pmw3901mb_dev_init_driver(&duty_dev, &SPID1, &duty_spi_cfg);
+                if(status_code != 0) break;
+                x = duty_position(pr, ee_pmw3901mb_sim_now_us() - t_start);
+                ee_pmw3901mb_sim_add_motion(&duty, (int32_t) (x - last_x), 0);
+                last_x = x;
+                status_code = ee_pmw3901mb_dev_get_motion_burst(&duty_dev, &burst);
+                if(status_code != 0) break;
+                if((burst.motion & EE_PMW3901MB_MOTION_MOT) != 0U){
+                    active = true;
+                    read = true;
+                    wakes++;
+                }else{
+                    status_code = ee_pmw3901mb_dev_shutdown(&duty_dev);
+                    if(status_code != 0) break;
+                    due += pol->check_period_us;
+                }
+            }
+            wait = (due > now) ? due - now : 0U;
+        }else{
+            status_code = ee_pmw3901mb_dev_get_motion_burst(&duty_dev, &burst);
+            if(status_code != 0) break;
+            read = true;
+        }
+
+        now = ee_pmw3901mb_sim_now_us() - t_start;
+        if(read && (burst.motion & EE_PMW3901MB_MOTION_MOT) != 0U){
+            read_x += burst.delta_x;
+            if(now >= onset){
+                // Motion onset to the first read reporting motion
+                uint64_t latency = now - onset;
+                latency_sum += latency;
+                if(latency > latency_max) latency_max = latency;
+                onsets++;
+                onset = duty_onset_us(pr, ++onset_k);
+            }
+            motion_us = ee_pmw3901mb_time_us();
+        }
+        if(pol->mode == DUTY_FULL_INIT && active && ee_pmw3901mb_time_us() - motion_us >= cfg.idle_timeout_us){
+            status_code = ee_pmw3901mb_dev_shutdown(&duty_dev);
+            if(status_code != 0) break;
+            active = false;
+            due = now + pol->check_period_us;
+            wait = pol->check_period_us;
+        }
+        // Onsets passed while shut down are seen from the next one
+        while(now >= duty_onset_us(pr, onset_k + 1U)) onset = duty_onset_us(pr, ++onset_k);
+
+        if(wait > DUTY_HOUR_US - now) wait = (now < DUTY_HOUR_US) ? DUTY_HOUR_US - now : 0U;
+        if(duty.shutdown) off_us += wait;
+        if(read) reading_us += wait;
+        ee_pmw3901mb_sim_advance_us(wait);
+    }
+
+    if(status_code != 0){
+        printf("duty %-6s %-20s: failed, status 0x%02X\r\n", pr->name, pol->name, status_code);
+        return;
+    }
+    if(pol->mode == DUTY_MANAGED){
+        wakes = power.wakes;
+        checks = power.checks;
+    }
+    int64_t moved = duty_position(pr, DUTY_HOUR_US);
+    printf("duty %-6s %-20s: powered %5.1f%%, read %5.1f%%, %4" PRIu32 " wakes, %5" PRIu32 " checks, wake latency mean %6.1f max %6.1f ms, %8" PRIu32 " bytes/h (%7" PRIu32 " trans), counts lost %5.1f%%\r\n",
+        pr->name, pol->name,
+        100.0 - 100.0 * (double) off_us / (double) DUTY_HOUR_US,
+        100.0 * (double) reading_us / (double) DUTY_HOUR_US,
+        wakes, checks,
+        (onsets != 0U) ? (double) latency_sum / onsets / 1000.0 : 0.0, (double) latency_max / 1000.0,
+        duty.stats.bytes, duty.stats.transactions,
+        100.0 * (double) (moved - read_x) / (double) moved);
+}
+
+// Rigid body fusion of 2 to 4 sensors over synthetic trajectories, built by "make fusion". The
+// sensors count their displacement with noise and keep the fraction between reads, as the
+// sensor does. The drift is the pose integrated from the solves against the true pose.
+#define FUSION_SAMPLES      1000U   // 10 s at 100 Hz
+#define FUSION_DT_S         0.01f
+#define FUSION_HEIGHT_MM    80U
+#define FUSION_NOISE        0.3f    // Counts rms per sample
+#define FUSION_ROUNDS       20U     // Timing rounds, the fastest is reported
+#define FUSION_CS_LINE      8U      // Chip select line of the first fused sensor
+#define FUSION_DEG_PER_RAD  57.29578
+
+typedef struct {
+    const char* name;
+    size_t n;
+    ee_pmw3901mb_mount_t mounts[EE_PMW3901MB_FUSION_MAX_SENSORS];
+} fusion_layout_t;
+
+typedef struct {
+    const char* name;
+    float vx, vy;       // Body velocity, mm/s
+    float yaw_rate;     // rad/s
+    float weave;        // Amplitude of a sine on the yaw rate and sideways velocity, period 2 s
+} fusion_trajectory_t;
+
+static const fusion_layout_t fusion_layouts[] = {
+    { "2 sensors", 2, { { -60.0f, 0.0f, 0 }, { 60.0f, 0.0f, 180000 } } },
+    { "3 sensors", 3, { { 0.0f, 60.0f, 0 }, { -51.96f, -30.0f, 120000 }, { 51.96f, -30.0f, 240000 } } },
+    { "4 sensors", 4, { { 50.0f, 50.0f, 0 }, { -50.0f, 50.0f, 90000 }, { -50.0f, -50.0f, 180000 }, { 50.0f, -50.0f, 270000 } } },
+};
+
+static const fusion_trajectory_t fusion_trajectories[] = {
+    { "straight", 0.0f, 500.0f, 0.0f, 0.0f },
+    { "spin", 0.0f, 0.0f, 1.5708f, 0.0f },
+    { "arc", 0.0f, 400.0f, 0.5236f, 0.0f },
+    { "slalom", 0.0f, 400.0f, 0.0f, 1.0472f },
+};
+
+static ee_pmw3901mb_fusion_input_t fusion_inputs[FUSION_SAMPLES][EE_PMW3901MB_FUSION_MAX_SENSORS];
+static float fusion_truth[FUSION_SAMPLES][3];   // Body translation and yaw of each sample
+static ee_pmw3901mb_sim_t fused[EE_PMW3901MB_FUSION_MAX_SENSORS];
+static ee_pmw3901mb_dev_t fused_dev[EE_PMW3901MB_FUSION_MAX_SENSORS];
+
+static float gauss(void){
+    float u1 = ((float) lcg_range(1U, 32767U)) / 32768.0f;
+    float u2 = ((float) lcg_range(0U, 32767U)) / 32768.0f;
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+// Samples of the sensors along a trajectory, counted from the exact rigid motion of each sample
+static void fusion_generate(const ee_pmw3901mb_fusion_t* fusion, const fusion_layout_t* lay, const fusion_trajectory_t* tr){
+    float counted[EE_PMW3901MB_FUSION_MAX_SENSORS][2] = { { 0 } };
+    float mm_per_count = (float) FUSION_HEIGHT_MM * fusion->rad_per_count;
+    lcg_state = 1U;
+    for(uint32_t k = 0; k < FUSION_SAMPLES; k++){
+        float weave = sinf(6.2831853f * (float) k * FUSION_DT_S / 2.0f);
+        float tx = (tr->vx + 100.0f * tr->weave * weave) * FUSION_DT_S;
+        float ty = tr->vy * FUSION_DT_S;
+        float dyaw = (tr->yaw_rate + tr->weave * weave) * FUSION_DT_S;
+        fusion_truth[k][0] = tx;
+        fusion_truth[k][1] = ty;
+        fusion_truth[k][2] = dyaw;
+        for(size_t i = 0; i < lay->n; i++){
+            // Displacement t + (R(dyaw) - I) p in the body frame, rotated into the module frame
+            float px = fusion->x_mm[i];
+            float py = fusion->y_mm[i];
+            float bx = tx + (cosf(dyaw) - 1.0f) * px - sinf(dyaw) * py;
+            float by = ty + sinf(dyaw) * px + (cosf(dyaw) - 1.0f) * py;
+            float c = fusion->cos_yaw[i];
+            float s = fusion->sin_yaw[i];
+            float mx = (c * bx + s * by) / mm_per_count + FUSION_NOISE * gauss();
+            float my = (-s * bx + c * by) / mm_per_count + FUSION_NOISE * gauss();
+            float before_x = roundf(counted[i][0]);
+            float before_y = roundf(counted[i][1]);
+            counted[i][0] += mx;
+            counted[i][1] += my;
+            fusion_inputs[k][i].delta_x = (int16_t) (roundf(counted[i][0]) - before_x);
+            fusion_inputs[k][i].delta_y = (int16_t) (roundf(counted[i][1]) - before_y);
+            fusion_inputs[k][i].weight = 1U;
+        }
+    }
+}
+
+typedef struct {
+    float x, y, yaw;
+} fusion_pose_t;
+
+static void fusion_integrate(fusion_pose_t* pose, float tx, float ty, float dyaw){
+    float c = cosf(pose->yaw);
+    float s = sinf(pose->yaw);
+    pose->x += c * tx - s * ty;
+    pose->y += s * tx + c * ty;
+    pose->yaw += dyaw;
+}
+
+static void fusion_report(const char* name, const char* trajectory, const ee_pmw3901mb_rigid_motion_t* motions,
+                          const char* cost){
+    fusion_pose_t truth = { 0 };
+    fusion_pose_t est = { 0 };
+    double err_t = 0.0;
+    double err_yaw = 0.0;
+    double path = 0.0;
+    for(uint32_t k = 0; k < FUSION_SAMPLES; k++){
+        float ex = motions[k].dx_mm - fusion_truth[k][0];
+        float ey = motions[k].dy_mm - fusion_truth[k][1];
+        float eyaw = motions[k].dyaw_rad - fusion_truth[k][2];
+        err_t += (double) (ex * ex + ey * ey);
+        err_yaw += (double) (eyaw * eyaw);
+        path += sqrt((double) (fusion_truth[k][0] * fusion_truth[k][0] + fusion_truth[k][1] * fusion_truth[k][1]));
+        fusion_integrate(&truth, fusion_truth[k][0], fusion_truth[k][1], fusion_truth[k][2]);
+        fusion_integrate(&est, motions[k].dx_mm, motions[k].dy_mm, motions[k].dyaw_rad);
+    }
+    double drift = sqrt((double) ((est.x - truth.x) * (est.x - truth.x) + (est.y - truth.y) * (est.y - truth.y)));
+    printf("fusion %-9s %-8s: %s, rms error %5.2f mm %6.3f deg per sample, drift %6.1f mm over %5.0f mm, heading %6.2f deg over %6.0f deg\r\n",
+        name, trajectory, cost, sqrt(err_t / FUSION_SAMPLES), sqrt(err_yaw / FUSION_SAMPLES) * FUSION_DEG_PER_RAD,
+        drift, path, (double) (est.yaw - truth.yaw) * FUSION_DEG_PER_RAD, (double) truth.yaw * FUSION_DEG_PER_RAD);
+}
+
+static int fusion_bench(void){
+    static ee_pmw3901mb_rigid_motion_t motions[FUSION_SAMPLES];
+    ee_pmw3901mb_fusion_t fusion;
+
+    for(size_t l = 0; l < sizeof(fusion_layouts) / sizeof(fusion_layouts[0]); l++){
+        const fusion_layout_t* lay = &fusion_layouts[l];
+        if(ee_pmw3901mb_fusion_init(&fusion, lay->mounts, lay->n) != 0) return 1;
+        for(size_t t = 0; t < sizeof(fusion_trajectories) / sizeof(fusion_trajectories[0]); t++){
+            fusion_generate(&fusion, lay, &fusion_trajectories[t]);
+            uint64_t best = UINT64_MAX;
+            for(uint32_t r = 0; r < FUSION_ROUNDS; r++){
+                uint64_t t0 = host_ns();
+                for(uint32_t k = 0; k < FUSION_SAMPLES; k++){
+                    if(ee_pmw3901mb_fusion_solve(&fusion, fusion_inputs[k], FUSION_HEIGHT_MM, &motions[k]) != 0) return 1;
+                }
+                uint64_t t1 = host_ns();
+                if(t1 - t0 < best) best = t1 - t0;
+            }
+            char cost[64];
+            snprintf(cost, sizeof(cost), "%6.1f ns/solve (%5.1f M solves/s)",
+                (double) best / FUSION_SAMPLES, 1000.0 * FUSION_SAMPLES / (double) best);
+            fusion_report(lay->name, fusion_trajectories[t].name, motions, cost);
+        }
+    }
+
+    // The same counts read through the driver from simulated sensors, weighted by the quality score
+    const fusion_layout_t* lay = &fusion_layouts[1];
+    ee_pmw3901mb_dev_t* devs[EE_PMW3901MB_FUSION_MAX_SENSORS];
+    ee_pmw3901mb_quality_cfg_t quality;
+    ee_pmw3901mb_quality_default_cfg(&quality);
+    if(ee_pmw3901mb_fusion_init(&fusion, lay->mounts, lay->n) != 0) return 1;
+    fusion_generate(&fusion, lay, &fusion_trajectories[3]);
+    for(size_t i = 0; i < lay->n; i++){
+        static SPIConfig fused_spi_cfg[EE_PMW3901MB_FUSION_MAX_SENSORS];
+        fused_spi_cfg[i] = my_spi_cfg;
+        fused_spi_cfg[i].ssline = FUSION_CS_LINE + i;
+        ee_pmw3901mb_sim_init(&fused[i]);
+        ee_pmw3901mb_sim_attach(&fused[i], fused_spi_cfg[i].ssline);
+        if(ee_pmw3901mb_dev_init_driver(&fused_dev[i], &SPID1, &fused_spi_cfg[i]) != 0) return 1;
+        ee_pmw3901mb_sim_set_surface(&fused[i], 0x60, 0x40, 0xA0, 0x10, 0x0100);
+        devs[i] = &fused_dev[i];
+    }
+    uint64_t t0 = ee_pmw3901mb_sim_now_us();
+    for(uint32_t k = 0; k < FUSION_SAMPLES; k++){
+        for(size_t i = 0; i < lay->n; i++){
+            ee_pmw3901mb_sim_add_motion(&fused[i], fusion_inputs[k][i].delta_x, fusion_inputs[k][i].delta_y);
+        }
+        if(ee_pmw3901mb_fusion_read(&fusion, devs, &quality, FUSION_HEIGHT_MM, &motions[k]) != 0) return 1;
+    }
+    char cost[64];
+    snprintf(cost, sizeof(cost), "%6.1f us bus per read of %zu sensors  ",
+        (double) (ee_pmw3901mb_sim_now_us() - t0) / FUSION_SAMPLES, lay->n);
+    fusion_report("driver", fusion_trajectories[3].name, motions, cost);
+
+    return 0;
+}
+
+// Gyro de-rotation of synthetic flow of a wobbling sensor moving over the ground, built by
+// "make derotate". The sensor counts translation plus rotation, quantized with the fraction
+// kept between reads, over the interval up to its latency before the read. The error is the
+// output against the true translation, per sample and of the summed position.
+#define DEROT_GYRO_US       1000U   // 1 kHz gyro
+#define DEROT_READ_US       10000U  // 100 Hz flow reads
+#define DEROT_JITTER_US     1000U   // Read time jitter
+#define DEROT_LATENCY_US    4000U   // Flow interval delay behind the read
+#define DEROT_RUN_US        10000000U
+#define DEROT_GYRO_N        (DEROT_RUN_US / DEROT_GYRO_US)
+#define DEROT_READS         (DEROT_RUN_US / DEROT_READ_US)
+#define DEROT_GYRO_NOISE    0.02f   // rad/s rms
+#define DEROT_VX            20.0f   // Translation, counts/s
+#define DEROT_VY            70.0f
+#define DEROT_ROUNDS        20U
+
+typedef enum { DEROT_RAW, DEROT_RATE_AT_READ, DEROT_WINDOW, DEROT_EXACT } derot_method_t;
+
+typedef struct {
+    const char* name;
+    derot_method_t method;
+    uint32_t latency_us;
+} derot_variant_t;
+
+static const derot_variant_t derot_variants[] = {
+    { "raw", DEROT_RAW, 0 },
+    { "rate at read x interval", DEROT_RATE_AT_READ, 0 },
+    { "interpolated, latency 0", DEROT_WINDOW, 0 },
+    { "interpolated, latency 4ms", DEROT_WINDOW, DEROT_LATENCY_US },
+    { "exact rotation (floor)", DEROT_EXACT, 0 },
+};
+
+static ee_pmw3901mb_gyro_sample_t derot_gyro[DEROT_GYRO_N];
+static uint32_t derot_read_us[DEROT_READS];
+static int16_t derot_in[DEROT_READS][2];
+static float derot_true[DEROT_READS][2];
+static float derot_rot[DEROT_READS][2];    // True rotational counts
+static int16_t derot_out[DEROT_READS][2];
+static ee_pmw3901mb_derotate_t derot;
+
+// Wobble angles about X and Y at time t (s)
+static void derot_angles(float t, float* ax, float* ay){
+    *ax = 4.0f / (6.2831853f * 5.0f) * (1.0f - cosf(6.2831853f * 5.0f * t));
+    *ay = 3.0f / (6.2831853f * 3.1f) * (cosf(0.7f) - cosf(6.2831853f * 3.1f * t + 0.7f));
+}
+
+static void derot_generate(const ee_pmw3901mb_derotate_cfg_t* cfg){
+    lcg_state = 1U;
+    for(uint32_t i = 0; i < DEROT_GYRO_N; i++){
+        float t = (float) i * DEROT_GYRO_US * 1e-6f;
+        derot_gyro[i].time_us = i * DEROT_GYRO_US;
+        derot_gyro[i].rate_x = 4.0f * sinf(6.2831853f * 5.0f * t) + DEROT_GYRO_NOISE * gauss();
+        derot_gyro[i].rate_y = 3.0f * sinf(6.2831853f * 3.1f * t + 0.7f) + DEROT_GYRO_NOISE * gauss();
+    }
+    float last[2] = { 0 };
+    for(uint32_t k = 0; k < DEROT_READS; k++){
+        uint32_t read_us = (k + 1U) * DEROT_READ_US - lcg_range(0U, DEROT_JITTER_US);
+        float t = (float) (read_us - DEROT_LATENCY_US) * 1e-6f;
+        float ax = 0.0f;
+        float ay = 0.0f;
+        derot_angles(t, &ax, &ay);
+        float tx = DEROT_VX * t;
+        float ty = DEROT_VY * t;
+        float cx = tx + cfg->counts_per_rad[0][0] * ax + cfg->counts_per_rad[0][1] * ay;
+        float cy = ty + cfg->counts_per_rad[1][0] * ax + cfg->counts_per_rad[1][1] * ay;
+        derot_read_us[k] = read_us;
+        derot_in[k][0] = (int16_t) (roundf(cx) - roundf(last[0]));
+        derot_in[k][1] = (int16_t) (roundf(cy) - roundf(last[1]));
+        derot_true[k][0] = tx;
+        derot_true[k][1] = ty;
+        derot_rot[k][0] = cx - tx;
+        derot_rot[k][1] = cy - ty;
+        last[0] = cx;
+        last[1] = cy;
+    }
+    for(uint32_t k = DEROT_READS - 1U; k > 0U; k--){
+        derot_true[k][0] -= derot_true[k - 1U][0];
+        derot_true[k][1] -= derot_true[k - 1U][1];
+        derot_rot[k][0] -= derot_rot[k - 1U][0];
+        derot_rot[k][1] -= derot_rot[k - 1U][1];
+    }
+}
+
+// Runs a variant over the reads, pushing the gyro samples taken up to each read
+static void derot_run(const derot_variant_t* v, const ee_pmw3901mb_derotate_cfg_t* cfg, bool apply){
+    ee_pmw3901mb_derotate_cfg_t c = *cfg;
+    c.latency_us = v->latency_us;
+    ee_pmw3901mb_derotate_init(&derot, &c);
+    uint32_t g = 0;
+    uint32_t last_us = 0;
+    float carry[2] = { 0 };
+    for(uint32_t k = 0; k < DEROT_READS; k++){
+        while(g < DEROT_GYRO_N && (int32_t) (derot_gyro[g].time_us - derot_read_us[k]) <= 0){
+            ee_pmw3901mb_derotate_push_gyro(&derot, derot_gyro[g].time_us, derot_gyro[g].rate_x, derot_gyro[g].rate_y);
+            g++;
+        }
+        if(!apply) continue;
+        if(v->method == DEROT_WINDOW){
+            ee_pmw3901mb_derotate_apply(&derot, derot_read_us[k], derot_in[k][0], derot_in[k][1], &derot_out[k][0], &derot_out[k][1]);
+        }else if(v->method == DEROT_RATE_AT_READ && k > 0U){
+            // Latest gyro rate times the read interval, what the consumers did before
+            const ee_pmw3901mb_gyro_sample_t* s = &derot.gyro[(derot.gyro_n - 1U) & (EE_PMW3901MB_DEROTATE_GYRO_SIZE - 1U)];
+            float dt = (float) (derot_read_us[k] - last_us) * 1e-6f;
+            for(uint32_t a = 0; a < 2U; a++){
+                float f = (float) derot_in[k][a] + carry[a]
+                        - (c.counts_per_rad[a][0] * s->rate_x + c.counts_per_rad[a][1] * s->rate_y) * dt;
+                derot_out[k][a] = (int16_t) roundf(f);
+                carry[a] = f - roundf(f);
+            }
+        }else if(v->method == DEROT_EXACT && k > 0U){
+            // True rotation of the interval, the error left is the quantization of the counts
+            for(uint32_t a = 0; a < 2U; a++){
+                float f = (float) derot_in[k][a] + carry[a] - derot_rot[k][a];
+                derot_out[k][a] = (int16_t) roundf(f);
+                carry[a] = f - roundf(f);
+            }
+        }else{
+            derot_out[k][0] = derot_in[k][0];
+            derot_out[k][1] = derot_in[k][1];
+        }
+        last_us = derot_read_us[k];
+    }
+}
+
+static int derotate_test(void){
+    ee_pmw3901mb_derotate_cfg_t cfg;
+    ee_pmw3901mb_derotate_default_cfg(&cfg);
+    derot_generate(&cfg);
+
+    double rot = 0.0;
+    for(uint32_t k = 1; k < DEROT_READS; k++){
+        double rx = (double) derot_in[k][0] - derot_true[k][0];
+        double ry = (double) derot_in[k][1] - derot_true[k][1];
+        rot += rx * rx + ry * ry;
+    }
+    printf("derotate: %u reads of %.2f counts translation and %.2f counts rms rotation per read\r\n",
+        DEROT_READS, sqrt((double) (DEROT_VX * DEROT_VX + DEROT_VY * DEROT_VY)) * DEROT_READ_US * 1e-6,
+        sqrt(rot / (DEROT_READS - 1U)));
+
+    uint32_t uncovered = 0;
+    for(size_t i = 0; i < sizeof(derot_variants) / sizeof(derot_variants[0]); i++){
+        const derot_variant_t* v = &derot_variants[i];
+        uint64_t best_all = UINT64_MAX;
+        uint64_t best_push = UINT64_MAX;
+        for(uint32_t r = 0; r < DEROT_ROUNDS; r++){
+            uint64_t t0 = host_ns();
+            derot_run(v, &cfg, false);
+            uint64_t t1 = host_ns();
+            derot_run(v, &cfg, true);
+            uint64_t t2 = host_ns();
+            if(t1 - t0 < best_push) best_push = t1 - t0;
+            if(t2 - t1 < best_all) best_all = t2 - t1;
+        }
+        if(v->method == DEROT_WINDOW) uncovered += derot.uncovered;
+
+        // From the second read, the first only starts the interval
+        double err = 0.0;
+        double err_max = 0.0;
+        double pos_err = 0.0;
+        double pos[2] = { 0 };
+        double truth[2] = { 0 };
+        for(uint32_t k = 1; k < DEROT_READS; k++){
+            double e2 = 0.0;
+            double p2 = 0.0;
+            for(uint32_t a = 0; a < 2U; a++){
+                double e = (double) derot_out[k][a] - derot_true[k][a];
+                pos[a] += derot_out[k][a];
+                truth[a] += derot_true[k][a];
+                e2 += e * e;
+                p2 += (pos[a] - truth[a]) * (pos[a] - truth[a]);
+            }
+            err += e2;
+            pos_err += p2;
+            if(sqrt(e2) > err_max) err_max = sqrt(e2);
+        }
+        double apply_ns = (best_all > best_push) ? (double) (best_all - best_push) / DEROT_READS : 0.0;
+        printf("derotate %-26s: residual rms %5.2f max %5.2f counts per read, position error rms %6.2f counts, %6.1f ns per read, %5.1f ns per gyro sample\r\n",
+            v->name, sqrt(err / (DEROT_READS - 1U)), err_max, sqrt(pos_err / (DEROT_READS - 1U)),
+            (v->method == DEROT_RAW || v->method == DEROT_EXACT) ? 0.0 : apply_ns, (double) best_push / DEROT_GYRO_N);
+    }
+    printf("derotate: %" PRIu32 " reads not covered by gyro samples, stage %zu bytes\r\n", uncovered, sizeof(derot));
+
+    return 0;
+}
+
+// Velocity and position estimator over a recorded noisy session of a robot, built by
+// "make estimator". The session is recorded once (true motion, quantized counts with noise,
+// low texture stretches scoring low with noise growing as the score drops, and glitches) and replayed through the
+// estimator and through the raw deltas.
+#define EST_READS           6000U   // 60 s at 100 Hz
+#define EST_READ_US         10000U
+#define EST_JITTER_US       1000U
+#define EST_HEIGHT_MM       150U
+#define EST_NOISE           0.3f    // Counts rms per read
+#define EST_GLITCH_COUNTS   40      // Glitch amplitude
+#define EST_ROUNDS          20U
+
+typedef struct {
+    uint32_t dt_us;
+    int16_t delta_x;
+    int16_t delta_y;
+    uint8_t score;
+    float vx, vy;       // True velocity at the read, mm/s
+    float x, y;         // True position at the read, mm
+} est_record_t;
+
+static est_record_t est_records[EST_READS];
+static ee_pmw3901mb_estimator_t est;
+
+// True velocity at t (s): drive out, stop, drive back, with weaving
+static void est_velocity(float t, float* vx, float* vy){
+    float phase = fmodf(t, 20.0f);
+    float v = 0.0f;
+    if(phase < 2.0f) v = 200.0f * phase;
+    else if(phase < 8.0f) v = 400.0f;
+    else if(phase < 10.0f) v = 400.0f - 200.0f * (phase - 8.0f);
+    else if(phase < 12.0f) v = 0.0f;
+    else if(phase < 14.0f) v = -150.0f * (phase - 12.0f);
+    else if(phase < 18.0f) v = -300.0f;
+    else v = -300.0f + 150.0f * (phase - 18.0f);
+    *vy = v;
+    *vx = 150.0f * sinf(6.2831853f * t / 5.0f);
+}
+
+static void est_record(void){
+    float mm_per_count = (float) EST_HEIGHT_MM * (float) EE_PMW3901MB_FOV_MDEG * (3.14159265f / 180000.0f) / (float) EE_PMW3901MB_PIXELS;
+    float counted[2] = { 0 };
+    float pos[2] = { 0 };
+    uint32_t last_us = 0;
+    lcg_state = 7U;
+    for(uint32_t k = 0; k < EST_READS; k++){
+        est_record_t* r = &est_records[k];
+        uint32_t read_us = (k + 1U) * EST_READ_US - lcg_range(0U, EST_JITTER_US);
+        r->dt_us = read_us - last_us;
+        float t = (float) read_us * 1e-6f;
+        // Midpoint velocity times the interval, the position at the read
+        float mvx = 0.0f;
+        float mvy = 0.0f;
+        est_velocity(t - (float) r->dt_us * 0.5e-6f, &mvx, &mvy);
+        pos[0] += mvx * (float) r->dt_us * 1e-6f;
+        pos[1] += mvy * (float) r->dt_us * 1e-6f;
+        est_velocity(t, &r->vx, &r->vy);
+        r->x = pos[0];
+        r->y = pos[1];
+
+        // Low texture for 1 s of every 15 s, a glitch every few hundred reads
+        bool low = fmodf(t, 15.0f) >= 11.0f && fmodf(t, 15.0f) < 12.0f;
+        r->score = low ? (uint8_t) lcg_range(40U, 200U) : 255U;
+        float noise = EST_NOISE * 255.0f / (float) r->score;
+        int16_t d[2];
+        for(uint32_t a = 0; a < 2U; a++){
+            float before = roundf(counted[a]);
+            counted[a] = pos[a] / mm_per_count;
+            d[a] = (int16_t) (roundf(counted[a]) - before + roundf(noise * gauss()));
+        }
+        if(lcg_range(0U, 299U) == 0U) d[lcg_range(0U, 1U)] += (lcg_range(0U, 1U) == 0U) ? EST_GLITCH_COUNTS : -EST_GLITCH_COUNTS;
+        r->delta_x = d[0];
+        r->delta_y = d[1];
+        last_us = read_us;
+    }
+}
+
+typedef struct {
+    double vel_sq;
+    double pos_sq;
+    double pos_end;
+    uint32_t within_2sigma;
+} est_error_t;
+
+static void est_error_add(est_error_t* e, const est_record_t* r, float vx, float vy, float x, float y, float vel_std){
+    double ex = (double) (vx - r->vx);
+    double ey = (double) (vy - r->vy);
+    e->vel_sq += ex * ex + ey * ey;
+    e->pos_sq += (double) ((x - r->x) * (x - r->x) + (y - r->y) * (y - r->y));
+    e->pos_end = sqrt((double) ((x - r->x) * (x - r->x) + (y - r->y) * (y - r->y)));
+    if(vel_std > 0.0f && fabs(ex) <= 2.0 * vel_std) e->within_2sigma++;
+}
+
+static void est_print(const char* name, const est_error_t* e, const char* extra){
+    printf("estimator %-24s: velocity rms error %6.1f mm/s, position rms error %6.1f mm, at the end %6.1f mm%s\r\n",
+        name, sqrt(e->vel_sq / EST_READS), sqrt(e->pos_sq / EST_READS), e->pos_end, extra);
+}
+
+static int estimator_bench(void){
+    float mm_per_count = (float) EST_HEIGHT_MM * (float) EE_PMW3901MB_FOV_MDEG * (3.14159265f / 180000.0f) / (float) EE_PMW3901MB_PIXELS;
+    est_record();
+
+    // Raw: velocity of each delta, position summed, with and without the samples gated by quality
+    for(uint32_t gated = 0; gated < 2U; gated++){
+        est_error_t e = { 0 };
+        float x = 0.0f;
+        float y = 0.0f;
+        float vx = 0.0f;
+        float vy = 0.0f;
+        for(uint32_t k = 0; k < EST_READS; k++){
+            const est_record_t* r = &est_records[k];
+            if(gated == 0U || r->score >= 128U){
+                float scale = mm_per_count / ((float) r->dt_us * 1e-6f);
+                vx = (float) r->delta_x * scale;
+                vy = (float) r->delta_y * scale;
+                x += (float) r->delta_x * mm_per_count;
+                y += (float) r->delta_y * mm_per_count;
+            }
+            est_error_add(&e, r, vx, vy, x, y, 0.0f);
+        }
+        est_print(gated ? "raw deltas, quality gated" : "raw deltas", &e, "");
+    }
+
+    static const char* const names[] = { "kalman", "kalman, no glitch gate" };
+    for(uint32_t v = 0; v < 2U; v++){
+        ee_pmw3901mb_estimator_cfg_t cfg;
+        ee_pmw3901mb_estimator_default_cfg(&cfg);
+        if(v == 1U) cfg.gate_sigma = 0.0f;
+
+        uint64_t best = UINT64_MAX;
+        for(uint32_t round = 0; round < EST_ROUNDS; round++){
+            ee_pmw3901mb_estimator_init(&est, &cfg);
+            uint64_t t0 = host_ns();
+            for(uint32_t k = 0; k < EST_READS; k++){
+                const est_record_t* r = &est_records[k];
+                (void) ee_pmw3901mb_estimator_update(&est, r->delta_x, r->delta_y, r->dt_us, EST_HEIGHT_MM, r->score);
+            }
+            uint64_t t1 = host_ns();
+            if(t1 - t0 < best) best = t1 - t0;
+        }
+
+        est_error_t e = { 0 };
+        ee_pmw3901mb_estimate_t s;
+        ee_pmw3901mb_estimator_init(&est, &cfg);
+        for(uint32_t k = 0; k < EST_READS; k++){
+            const est_record_t* r = &est_records[k];
+            (void) ee_pmw3901mb_estimator_update(&est, r->delta_x, r->delta_y, r->dt_us, EST_HEIGHT_MM, r->score);
+            ee_pmw3901mb_estimator_get(&est, &s);
+            est_error_add(&e, r, s.vx_mm_s, s.vy_mm_s, s.x_mm, s.y_mm, s.vel_std_mm_s);
+        }
+        char extra[160];
+        snprintf(extra, sizeof(extra), ", %4.1f%% of X velocity errors within 2 sigma (%5.1f mm/s), %5.1f ns/update (%4.1f M updates/s)",
+            100.0 * e.within_2sigma / EST_READS, (double) s.vel_std_mm_s,
+            (double) best / EST_READS, 1000.0 * EST_READS / (double) best);
+        est_print(names[v], &e, extra);
+        if(v == 0U){
+            printf("estimator: %" PRIu32 " fused, %" PRIu32 " below the min score, %" PRIu32 " beyond the gate, state %zu bytes RAM\r\n",
+                est.updates, est.skipped, est.rejected, sizeof(ee_pmw3901mb_estimator_t));
+        }
+    }
+
+    // A zero height measures no velocity, the update is refused before advancing the state
+    ee_pmw3901mb_estimate_t before, after;
+    ee_pmw3901mb_estimator_get(&est, &before);
+    uint8_t zero_height = ee_pmw3901mb_estimator_update(&est, 100, 100, EST_READ_US, 0U, EE_PMW3901MB_QUALITY_SCORE_MAX);
+    ee_pmw3901mb_estimator_get(&est, &after);
+    bool refused = zero_height == 2U && memcmp(&before, &after, sizeof(before)) == 0;
+    printf("estimator: zero height update status %u, state %s\r\n", zero_height, refused ? "unchanged OK" : "changed FAILED");
+
+    return refused ? 0 : 1;
+}
+
+// High-speed motion through the simulated sensor integrated by the odometry, built by "make odometry".
+// Motion is added every millisecond and read every 10 ms, and in the stalled run every 200th read
+// is 60 ms late, so the motion since the last read overflows the int16 delta registers. The totals
+// must equal the clamped read deltas, the saturations the late reads, and the displacement since
+// each checkpoint the one summed from the reads. The wrapped run offsets the time stamps so the
+// uint32_t microsecond clock wraps within the checkpoint history queried at the end.
+#define ODO_READS           2000U
+#define ODO_READ_US         10000U
+#define ODO_STALL_EVERY     200U
+#define ODO_STALL_US        60000U
+#define ODO_INTERVAL_US     100000U     // Checkpoint interval
+#define ODO_WRAP_AFTER_US   19500000U   // Run time before the wrap, in the checkpoint history at the end
+
+static uint32_t odo_time[ODO_READS];
+static int64_t odo_path[ODO_READS][2];  // Clamped read deltas summed after each read
+
+static int odometry_test(void){
+    ee_pmw3901mb_dev_t* dev = ee_pmw3901mb_get_default_dev();
+    ee_pmw3901mb_odometry_t odo;
+    int failed = 0;
+
+    static const char* const run_names[] = { "on time", "stalled", "wrapped" };
+    for(uint32_t run = 0; run < 3U; run++){
+        bool stalled = run == 1U;
+        ee_pmw3901mb_motion_burst_t burst;
+        ee_pmw3901mb_get_motion_burst(&burst); // Clear the motion left over
+        uint64_t start_us = ee_pmw3901mb_sim_now_us();
+        uint32_t offset = (run == 2U) ? (uint32_t) (UINT32_MAX - ODO_WRAP_AFTER_US - (uint32_t) start_us) : 0U;
+        uint32_t t0 = (uint32_t) start_us + offset;
+        ee_pmw3901mb_odometry_init(&odo, ODO_INTERVAL_US, t0);
+
+        int64_t true_x = 0, true_y = 0, read_x = 0, read_y = 0;
+        uint32_t expected_saturations = 0;
+        uint32_t step = 0;
+        for(uint32_t i = 0; i < ODO_READS; i++){
+            // Up to 2500 counts/ms, 25000 per read, the motion of a late read saturates
+            uint32_t wait_us = (stalled && (i % ODO_STALL_EVERY) == ODO_STALL_EVERY - 1U) ? ODO_STALL_US : ODO_READ_US;
+            int32_t motion_x = 0, motion_y = 0;
+            for(uint32_t us = 0; us < wait_us; us += 1000U, step++){
+                int32_t dx = (int32_t) (2500.0 * sin(6.2831853 * step / 4000.0));
+                int32_t dy = (int32_t) (1800.0 * cos(6.2831853 * step / 3000.0));
+                ee_pmw3901mb_sim_add_motion(&sensor, dx, dy);
+                ee_pmw3901mb_sim_advance_us(1000U);
+                motion_x += dx;
+                motion_y += dy;
+            }
+            true_x += motion_x;
+            true_y += motion_y;
+            int32_t clamped_x = motion_x > INT16_MAX ? INT16_MAX : (motion_x < INT16_MIN ? INT16_MIN : motion_x);
+            int32_t clamped_y = motion_y > INT16_MAX ? INT16_MAX : (motion_y < INT16_MIN ? INT16_MIN : motion_y);
+            read_x += clamped_x;
+            read_y += clamped_y;
+            if(clamped_x >= EE_PMW3901MB_ODOMETRY_SATURATED || clamped_x <= -EE_PMW3901MB_ODOMETRY_SATURATED ||
+               clamped_y >= EE_PMW3901MB_ODOMETRY_SATURATED || clamped_y <= -EE_PMW3901MB_ODOMETRY_SATURATED) expected_saturations++;
+
+            odo_time[i] = (uint32_t) ee_pmw3901mb_sim_now_us() + offset;
+            uint8_t status_code = ee_pmw3901mb_odometry_read(&odo, dev, odo_time[i]);
+            if(status_code != 0 && status_code != 2) return 1;
+            odo_path[i][0] = read_x;
+            odo_path[i][1] = read_y;
+        }
+
+        // Displacement since a time in each checkpoint interval of the history, counted from the
+        // initialization: the path after the last read before the start of the interval
+        uint32_t queries = 0, query_errors = 0;
+        uint32_t now_slot = (odo_time[ODO_READS - 1U] - t0) / ODO_INTERVAL_US;
+        for(uint32_t age = 0; age < EE_PMW3901MB_ODOMETRY_CHECKPOINTS; age++){
+            uint32_t slot_us = (now_slot - age) * ODO_INTERVAL_US;
+            int64_t since_x = 0, since_y = 0;
+            if(ee_pmw3901mb_odometry_get_since(&odo, t0 + slot_us + ODO_INTERVAL_US / 2U, &since_x, &since_y) != 0){
+                query_errors++;
+                continue;
+            }
+            int64_t before_x = 0, before_y = 0;
+            for(uint32_t i = 0; i < ODO_READS && odo_time[i] - t0 < slot_us; i++){
+                before_x = odo_path[i][0];
+                before_y = odo_path[i][1];
+            }
+            queries++;
+            if(since_x != read_x - before_x || since_y != read_y - before_y) query_errors++;
+        }
+        int64_t old_x = 0, old_y = 0;
+        bool old_refused = ee_pmw3901mb_odometry_get_since(&odo, t0 + (now_slot - EE_PMW3901MB_ODOMETRY_CHECKPOINTS) * ODO_INTERVAL_US, &old_x, &old_y) != 0;
+
+        int64_t x = 0, y = 0;
+        ee_pmw3901mb_odometry_get_total(&odo, &x, &y);
+        bool ok = x == read_x && y == read_y && odo.saturations == expected_saturations && odo.samples == ODO_READS &&
+                  query_errors == 0U && old_refused && (stalled ? expected_saturations > 0U : x == true_x && y == true_y);
+        printf("odometry %-8s: %u reads in %.1f s, %u saturated (expected %u), total %" PRId64 ", %" PRId64 " (path %" PRId64 ", %" PRId64 ", lost %" PRId64 ", %" PRId64 "), %u since queries, %u wrong %s\r\n",
+            run_names[run], ODO_READS, (double) (ee_pmw3901mb_sim_now_us() - start_us) * 1e-6,
+            odo.saturations, expected_saturations, x, y, true_x, true_y, true_x - x, true_y - y, queries, query_errors,
+            ok ? "OK" : "FAILED");
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
+
+// Magnitude and angle of deltas with the integer CORDIC against the former double sqrt() and
+// float atan2() of the ChibiOS example, built by "make cordic". Both are checked against double
+// hypot() and atan2(), the CORDIC must stay within its documented bounds.
+#define CORDIC_VECTORS      (1U << 20)
+#define CORDIC_ROUNDS       8U
+#define CORDIC_INPUT_LIMIT  ((1 << 29) - 1)
+#define CORDIC_MAG_REL      1e-4        // 0.01 %
+#define CORDIC_MAG_LSB      1.0
+#define CORDIC_ANGLE_DEG    0.01
+
+static int32_t cordic_in[CORDIC_VECTORS][2];
+
+static double angle_error_deg(double a_deg, double ref_rad){
+    double e = a_deg - ref_rad * (180.0 / 3.14159265358979);
+    while(e > 180.0) e -= 360.0;
+    while(e < -180.0) e += 360.0;
+    return fabs(e);
+}
+
+static int cordic_bench(void){
+    // Motion deltas, small deltas and the widest inputs (velocity magnitudes), with the axes and corners
+    lcg_state = 1U;
+    for(uint32_t i = 0; i < CORDIC_VECTORS; i++){
+        for(uint32_t k = 0; k < 2U; k++){
+            int32_t v;
+            switch(i & 3U){
+            case 0: case 1: v = (int32_t) lcg_range(0U, 65535U) - 32768; break;
+            case 2: v = (int32_t) lcg_range(0U, 128U) - 64; break;
+            default: v = (int32_t) ((lcg_range(0U, 32767U) << 15) | lcg_range(0U, 32767U)) % CORDIC_INPUT_LIMIT; break;
+            }
+            cordic_in[i][k] = ((i & 4U) != 0U) ? -v : v;
+        }
+    }
+    static const int32_t edges[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 }, { -32768, 0 }, { 0, -32768 },
+        { -32768, -32768 }, { 32767, -32768 }, { -32768, 32767 }, { -1, -1 }, { CORDIC_INPUT_LIMIT, CORDIC_INPUT_LIMIT },
+        { -CORDIC_INPUT_LIMIT, 1 }, { -CORDIC_INPUT_LIMIT, -1 }, { 1, -CORDIC_INPUT_LIMIT } };
+    memcpy(cordic_in, edges, sizeof(edges));
+
+    // Errors against double hypot() and atan2()
+    // Relative magnitude error above 10000, where it outweighs the LSB of rounding, absolute below
+    double mag_err[2] = { 0 }, mag_lsb[2] = { 0 }, ang_err[2] = { 0 };
+    uint32_t violations = 0;
+    for(uint32_t i = 0; i < CORDIC_VECTORS; i++){
+        double x = cordic_in[i][0], y = cordic_in[i][1];
+        double ref_mag = hypot(x, y), ref_ang = atan2(y, x);
+        double mag_f = sqrt(x * x + y * y);
+        double ang_f = atan2f((float) y, (float) x) * (180.0f / 3.14159265f);
+        uint32_t mag_c = 0;
+        int32_t ang_c = 0;
+        if(ee_pmw3901mb_cordic_vector(cordic_in[i][0], cordic_in[i][1], &mag_c, &ang_c) != 0) return 1;
+        double e_mag[2] = { fabs(mag_f - ref_mag), fabs((double) mag_c - ref_mag) };
+        double e_ang[2] = { angle_error_deg(ang_f, ref_ang), angle_error_deg((double) ang_c * 180.0 / EE_PMW3901MB_ANGLE_PI, ref_ang) };
+        if(ref_mag == 0.0) e_ang[0] = e_ang[1] = 0.0; // No angle
+        for(uint32_t k = 0; k < 2U; k++){
+            if(ref_mag >= CORDIC_MAG_LSB / CORDIC_MAG_REL && e_mag[k] / ref_mag > mag_err[k]) mag_err[k] = e_mag[k] / ref_mag;
+            else if(ref_mag < CORDIC_MAG_LSB / CORDIC_MAG_REL && e_mag[k] > mag_lsb[k]) mag_lsb[k] = e_mag[k];
+            if(e_ang[k] > ang_err[k]) ang_err[k] = e_ang[k];
+        }
+        if(e_mag[1] > ref_mag * CORDIC_MAG_REL + CORDIC_MAG_LSB || e_ang[1] > CORDIC_ANGLE_DEG){
+            if(violations++ < 5U){
+                printf("cordic (%" PRId32 ", %" PRId32 "): magnitude %" PRIu32 " (%.2f), angle %.4f deg (%.4f)\r\n",
+                    cordic_in[i][0], cordic_in[i][1], mag_c, ref_mag, (double) ang_c * 180.0 / EE_PMW3901MB_ANGLE_PI,
+                    ref_ang * 180.0 / 3.14159265358979);
+            }
+        }
+    }
+
+    // Host time per vector, the sink keeps the results alive
+    volatile double sink_f = 0;
+    volatile uint32_t sink_c = 0;
+    uint64_t t0 = host_ns();
+    for(uint32_t r = 0; r < CORDIC_ROUNDS; r++){
+        for(uint32_t i = 0; i < CORDIC_VECTORS; i++){
+            double x = cordic_in[i][0], y = cordic_in[i][1];
+            sink_f += sqrt(x * x + y * y) + atan2f((float) y, (float) x) * (180.0f / 3.14159265f);
+        }
+    }
+    uint64_t t1 = host_ns();
+    for(uint32_t r = 0; r < CORDIC_ROUNDS; r++){
+        for(uint32_t i = 0; i < CORDIC_VECTORS; i++){
+            uint32_t mag = 0;
+            int32_t ang = 0;
+            ee_pmw3901mb_cordic_vector(cordic_in[i][0], cordic_in[i][1], &mag, &ang);
+            sink_c += mag + (uint32_t) ang;
+        }
+    }
+    uint64_t t2 = host_ns();
+    (void) sink_f;
+    (void) sink_c;
+
+    const double n = (double) CORDIC_VECTORS * CORDIC_ROUNDS;
+    printf("sqrt/atan2f: %6.1f ns per vector, magnitude error %.5f %% (%.3f LSB below 10000), angle error %.5f deg\r\n",
+        (double) (t1 - t0) / n, mag_err[0] * 100.0, mag_lsb[0], ang_err[0]);
+    printf("cordic     : %6.1f ns per vector, magnitude error %.5f %% (%.3f LSB below 10000), angle error %.5f deg, %" PRIu32 " of %u vectors beyond %.2f %% + %.0f LSB, %.2f deg %s\r\n",
+        (double) (t2 - t1) / n, mag_err[1] * 100.0, mag_lsb[1], ang_err[1], violations, CORDIC_VECTORS,
+        CORDIC_MAG_REL * 100.0, CORDIC_MAG_LSB, CORDIC_ANGLE_DEG, violations == 0U ? "OK" : "FAILED");
+    return violations == 0U ? 0 : 1;
+}
+
+// Sample ring between two host threads, the producer pushing as fast as it can and the
+// consumer popping. Every field of a sample is derived from its sequence number, so a sample
+// copied while being overwritten (torn) or read out of order shows as a mismatch.
+#define RING_SAMPLES        2000000U
+
+typedef struct {
+    ee_pmw3901mb_ring_t ring;
+    bool retry;                 // Producer retries a push on full ring, nothing may be lost
+    bool done;                  // Producer pushed its last sample
+    uint32_t full;              // Pushes refused on full ring
+    uint32_t received;
+    uint32_t torn;
+    uint32_t out_of_order;
+    uint32_t lost;              // Sequence numbers skipped by the consumer
+} ring_stress_t;
+
+static void ring_sample(uint32_t seq, ee_pmw3901mb_sample_t* sample){
+    sample->delta_x = (int16_t) (seq & 0xFFFFU);
+    sample->delta_y = (int16_t) (~seq & 0xFFFFU);
+    sample->squal = (uint8_t) (seq * 7U);
+    sample->shutter = (uint16_t) ((seq >> 16) ^ (seq * 13U));
+    sample->time = seq;
+}
+
+static void* ring_producer(void* arg){
+    ring_stress_t* st = arg;
+    ee_pmw3901mb_sample_t sample;
+    for(uint32_t seq = 0; seq < RING_SAMPLES; seq++){
+        ring_sample(seq, &sample);
+        while(ee_pmw3901mb_ring_push(&st->ring, &sample) != 0){
+            st->full++;
+            sched_yield();      // Let the consumer run on a single core host
+            if(!st->retry) break;
+        }
+    }
+    __atomic_store_n(&st->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void* ring_consumer(void* arg){
+    ring_stress_t* st = arg;
+    ee_pmw3901mb_sample_t sample, expected;
+    uint32_t next = 0;
+    for(;;){
+        // Done flag read before the pop, a sample pushed before it was set is still popped
+        bool done = __atomic_load_n(&st->done, __ATOMIC_ACQUIRE);
+        if(ee_pmw3901mb_ring_pop(&st->ring, &sample) != 0){
+            if(done) break;
+            sched_yield();
+            continue;
+        }
+        st->received++;
+        ring_sample(sample.time, &expected);
+        // Field by field, the padding after squal is not copied
+        if(sample.delta_x != expected.delta_x || sample.delta_y != expected.delta_y ||
+           sample.squal != expected.squal || sample.shutter != expected.shutter) st->torn++;
+        if(sample.time < next) st->out_of_order++;
+        else st->lost += sample.time - next;
+        next = sample.time + 1U;
+    }
+    st->lost += RING_SAMPLES - next;
+    return NULL;
+}
+
+static int ring_stress(void){
+    static ring_stress_t st;
+    int failed = 0;
+    for(int retry = 1; retry >= 0; retry--){
+        memset(&st, 0, sizeof(st));
+        ee_pmw3901mb_ring_init(&st.ring);
+        st.retry = retry != 0U;
+
+        pthread_t producer, consumer;
+        uint64_t t0 = host_ns();
+        pthread_create(&consumer, NULL, ring_consumer, &st);
+        pthread_create(&producer, NULL, ring_producer, &st);
+        pthread_join(producer, NULL);
+        pthread_join(consumer, NULL);
+        uint64_t t1 = host_ns();
+
+        // Every sample either arrives in order or is one the producer saw refused
+        bool ok = st.torn == 0U && st.out_of_order == 0U && st.full == ee_pmw3901mb_ring_overflows(&st.ring) &&
+                  (retry ? st.lost == 0U && st.received == RING_SAMPLES : st.lost == st.full && st.received + st.full == RING_SAMPLES);
+        printf("ring %-15s: %u samples in %.2f s, %6.2f M samples/s, %u received, %u full, %u lost, %u torn, %u out of order %s\r\n",
+            retry ? "producer retry" : "producer drop", RING_SAMPLES, (double) (t1 - t0) * 1e-9,
+            (double) RING_SAMPLES * 1e3 / (double) (t1 - t0), st.received, st.full, st.lost, st.torn, st.out_of_order,
+            ok ? "OK" : "FAILED");
+        if(!ok) failed = 1;
+    }
+    return failed;
+}
+
+// Event-driven acquisition on the motion line against polling at a fixed period, over a trace
+// of short moves in a still scene and over motion in every frame, built by "make event"
+#if (EE_PMW3901MB_USE_MOTION_EVENT == TRUE)
+#define EVENT_RUN_US        20000000U   // Simulated time per trace
+#define EVENT_POLL_US       10000U      // Period of the polled acquisition
+#define EVENT_MOT_LINE      16U         // PAL line of the sensor motion line
+
+typedef struct {
+    const char* name;
+    uint32_t moving_frames;     // Frames with motion at the start of each period
+    uint32_t period_frames;
+} event_trace_t;
+
+static const event_trace_t event_traces[] = {
+    { "idle", 12U, 600U },      // 0.1 s move every 5 s
+    { "high motion", 1U, 1U },
+};
+
+static THD_WORKING_AREA(event_wa, 512);
+static ee_pmw3901mb_motion_event_t motion_event;
+
+typedef struct {
+    uint32_t pending_us;        // Time of the oldest motion not yet read
+    bool pending;
+    uint64_t latency_sum_us;
+    uint32_t latency_max_us;
+    uint32_t reads_with_motion;
+    int32_t counts;
+} event_latency_t;
+
+static void event_read(event_latency_t* lat, uint32_t read_us, int16_t dx){
+    if(!lat->pending) return;
+    uint32_t latency = read_us - lat->pending_us;
+    lat->latency_sum_us += latency;
+    if(latency > lat->latency_max_us) lat->latency_max_us = latency;
+    lat->reads_with_motion++;
+    lat->counts += dx;
+    lat->pending = false;
+}
+
+static void event_trace(const event_trace_t* tr, bool event_driven){
+    ee_pmw3901mb_sim_timing_t timing;
+    ee_pmw3901mb_sim_get_timing(&timing);
+    ee_pmw3901mb_dev_t* dev = ee_pmw3901mb_get_default_dev();
+    event_latency_t lat;
+    memset(&lat, 0, sizeof(lat));
+    uint8_t status_code = 0;
+
+    if(event_driven) status_code = ee_pmw3901mb_motion_event_start(&motion_event, dev, EVENT_MOT_LINE,
+                                                                   event_wa, sizeof(event_wa), NORMALPRIO + 1U);
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    uint64_t t_start = ee_pmw3901mb_sim_now_us();
+    uint64_t next_frame = t_start;
+    uint64_t next_poll = t_start + EVENT_POLL_US;
+    int32_t added = 0;
+    uint32_t frame = 0;
+    while(next_frame < t_start + EVENT_RUN_US && status_code == 0){
+        uint64_t now = ee_pmw3901mb_sim_now_us();
+        if(event_driven || next_frame <= next_poll){
+            if(next_frame > now) ee_pmw3901mb_sim_advance_us(next_frame - now);
+            if(frame % tr->period_frames < tr->moving_frames){
+                if(!lat.pending) lat.pending_us = ee_pmw3901mb_time_us();
+                lat.pending = true;
+                ee_pmw3901mb_sim_add_motion(&sensor, 2, -1);    // Wakes the reader on the motion line
+                added += 2;
+            }
+            frame++;
+            next_frame += timing.t_frame_us;
+        }else{
+            if(next_poll > now) ee_pmw3901mb_sim_advance_us(next_poll - now);
+            ee_pmw3901mb_motion_burst_t burst;
+            status_code = ee_pmw3901mb_dev_get_motion_burst(dev, &burst);
+            if((burst.motion & EE_PMW3901MB_MOTION_MOT) != 0U) event_read(&lat, dev->burst_assert_us, burst.delta_x);
+            next_poll += EVENT_POLL_US;
+        }
+
+        ee_pmw3901mb_motion_sample_t sample;
+        while(event_driven && ee_pmw3901mb_motion_event_get(&motion_event, &sample, TIME_IMMEDIATE) == 0){
+            event_read(&lat, sample.time_us, sample.burst.delta_x);
+        }
+    }
+    uint64_t run_us = ee_pmw3901mb_sim_now_us() - t_start;
+    if(event_driven && status_code == 0) status_code = ee_pmw3901mb_motion_event_stop(&motion_event);
+
+    // Motion after the last poll, so the next trace starts without motion pending
+    ee_pmw3901mb_motion_burst_t burst;
+    if(!event_driven && status_code == 0) status_code = ee_pmw3901mb_dev_get_motion_burst(dev, &burst);
+    if(!event_driven && status_code == 0) lat.counts += burst.delta_x;
+
+    printf("event %-11s %-12s: bus busy %6.3f%%, %8.1f trans/s, latency mean %7.1f max %6" PRIu32 " us, counts %s",
+        tr->name, event_driven ? "event-driven" : "polled 10ms", 100.0 * (double) sensor.stats.bus_time_us / (double) run_us,
+        (double) sensor.stats.transactions * 1000000.0 / (double) run_us,
+        (lat.reads_with_motion > 0) ? (double) lat.latency_sum_us / lat.reads_with_motion : 0.0, lat.latency_max_us,
+        (status_code == 0 && lat.counts == added) ? "OK" : "MISMATCH");
+    if(event_driven){
+        printf(" (%" PRIu32 " events, %" PRIu32 " spurious, %" PRIu32 " overruns)", motion_event.events,
+            motion_event.spurious, motion_event.overruns);
+    }
+    printf("\r\n");
+}
+
+// Health check of an idle sensor with the reader thread paused, as in the ChibiOS example. The
+// queued sample and the counters are kept, and motion while paused is read on resume.
+static int event_pause(void){
+    ee_pmw3901mb_dev_t* dev = ee_pmw3901mb_get_default_dev();
+    ee_pmw3901mb_health_t health;
+    ee_pmw3901mb_motion_sample_t first, second;
+    if(ee_pmw3901mb_health_init(&health, dev, NULL) != 0 ||
+       ee_pmw3901mb_motion_event_start(&motion_event, dev, EVENT_MOT_LINE, event_wa, sizeof(event_wa), NORMALPRIO + 1U) != 0) return 1;
+
+    ee_pmw3901mb_sim_add_motion(&sensor, 5, -3);
+    ee_pmw3901mb_motion_event_pause(&motion_event);
+    uint32_t reads = sensor.stats.reads;
+    ee_pmw3901mb_health_fault_t fault = ee_pmw3901mb_health_check(&health);
+    uint32_t check_reads = sensor.stats.reads - reads;
+    ee_pmw3901mb_sim_add_motion(&sensor, 7, 2);
+    uint32_t paused_reads = sensor.stats.reads - reads - check_reads;   // Must be 0, the reader waits
+    ee_pmw3901mb_motion_event_resume(&motion_event);
+
+    bool ok = ee_pmw3901mb_motion_event_get(&motion_event, &first, TIME_IMMEDIATE) == 0 &&
+              ee_pmw3901mb_motion_event_get(&motion_event, &second, TIME_IMMEDIATE) == 0 &&
+              first.burst.delta_x == 5 && first.burst.delta_y == -3 && second.burst.delta_x == 7 && second.burst.delta_y == 2 &&
+              fault == EE_PMW3901MB_HEALTH_OK && paused_reads == 0U && motion_event.samples == 2U && motion_event.events == 2U;
+    ee_pmw3901mb_motion_event_stop(&motion_event);
+    printf("pause: health check of %" PRIu32 " reads with the reader paused, %" PRIu32 " reads while paused, %" PRIu32 " samples kept %s\r\n",
+        check_reads, paused_reads, motion_event.samples, ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+// Motion line held asserted by a frozen motion pipeline. After the bounded reads of the edge the
+// reader thread reads again every retry interval, and stops once a power up reset releases the line.
+#define EVENT_STUCK_US      20000U
+
+static int event_stuck(void){
+    ee_pmw3901mb_dev_t* dev = ee_pmw3901mb_get_default_dev();
+    if(ee_pmw3901mb_motion_event_start(&motion_event, dev, EVENT_MOT_LINE, event_wa, sizeof(event_wa), NORMALPRIO + 1U) != 0) return 1;
+
+    ee_pmw3901mb_sim_freeze(&sensor);
+    ee_pmw3901mb_sim_add_motion(&sensor, 3, 1);
+    uint32_t reads = sensor.stats.reads;
+    ee_pmw3901mb_sim_advance_us(EVENT_STUCK_US);
+    uint32_t stuck_reads = sensor.stats.reads - reads;
+    uint32_t stuck_retries = motion_event.retries;
+
+    // Released by the reset, one more retry reads the line released
+    ee_pmw3901mb_sim_brown_out(&sensor);
+    ee_pmw3901mb_sim_advance_us(EE_PMW3901MB_MOTION_EVENT_RETRY_US);
+    uint32_t released_retries = motion_event.retries;
+    ee_pmw3901mb_sim_advance_us(EVENT_STUCK_US);
+    uint32_t idle_retries = motion_event.retries - released_retries;
+    ee_pmw3901mb_motion_event_stop(&motion_event);
+
+    // A retry every interval plus the bus time of its reads, so at least one every two intervals
+    bool ok = stuck_retries >= EVENT_STUCK_US / (2U * EE_PMW3901MB_MOTION_EVENT_RETRY_US) && stuck_reads >= stuck_retries && idle_retries == 0U;
+    printf("stuck: line held %u us, %" PRIu32 " retries, %" PRIu32 " reads, %" PRIu32 " retries after the release %s\r\n",
+        EVENT_STUCK_US, stuck_retries, stuck_reads, idle_retries, ok ? "OK" : "FAILED");
+
+    // Initialize the reset sensor again for the sections after
+    ee_pmw3901mb_sim_advance_us(100000U);
+    if(ee_pmw3901mb_init_driver(&SPID1, &my_spi_cfg) != 0) return 1;
+    return ok ? 0 : 1;
+}
+#endif
+
+static int event_bench(void){
+#if (EE_PMW3901MB_USE_MOTION_EVENT == TRUE)
+    ee_pmw3901mb_sim_set_surface(&sensor, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    ee_pmw3901mb_sim_set_motion_line(&sensor, EVENT_MOT_LINE);
+    for(size_t i = 0; i < sizeof(event_traces) / sizeof(event_traces[0]); i++){
+        event_trace(&event_traces[i], false);
+        event_trace(&event_traces[i], true);
+    }
+    if(event_pause() != 0) return 1;
+    return event_stuck();
+#else
+    printf("Built without EE_PMW3901MB_USE_MOTION_EVENT, run \"make event\"\r\n");
+    return 1;
+#endif
+}
+
+// Adaptive polling acquisition (EE_PMW3901MB_USE_POLL) read by its thread sleeping on the simulated
+// clock, over the traces of "make event", built by "make poll"
+#if (EE_PMW3901MB_USE_POLL == TRUE)
+#define POLL_RUN_US         20000000U   // Simulated time per trace
+
+typedef struct {
+    const char* name;
+    uint32_t moving_frames;     // Frames with motion at the start of each period
+    uint32_t period_frames;
+} poll_trace_t;
+
+static const poll_trace_t poll_traces[] = {
+    { "idle", 12U, 600U },      // 0.1 s move every 5 s
+    { "high motion", 1U, 1U },
+};
+
+static THD_WORKING_AREA(poll_wa, 512);
+static ee_pmw3901mb_poll_t poll;
+static ee_pmw3901mb_ring_t poll_ring;
+
+static bool poll_trace(const poll_trace_t* tr){
+    ee_pmw3901mb_sim_timing_t timing;
+    ee_pmw3901mb_sim_get_timing(&timing);
+    ee_pmw3901mb_dev_t* dev = ee_pmw3901mb_get_default_dev();
+    ee_pmw3901mb_ring_init(&poll_ring);
+    uint32_t pending_us = 0;    // Time of the oldest motion not yet read
+    bool pending = false;
+    uint64_t latency_sum_us = 0;
+    uint32_t latency_max_us = 0;
+    uint32_t reads_with_motion = 0;
+    int32_t added = 0, counts = 0;
+
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    uint64_t t_start = ee_pmw3901mb_sim_now_us();
+    uint8_t status_code = ee_pmw3901mb_poll_start(&poll, dev, &poll_ring, EE_PMW3901MB_FRAME_PERIOD_US,
+                                                  EE_PMW3901MB_POLL_MAX_PERIOD_US, poll_wa, sizeof(poll_wa), NORMALPRIO + 1U);
+    uint64_t next_frame = t_start;
+    uint32_t frame = 0;
+    while(next_frame < t_start + POLL_RUN_US && status_code == 0){
+        // The polling thread reads while the time advances to the frame
+        uint64_t now = ee_pmw3901mb_sim_now_us();
+        if(next_frame > now) ee_pmw3901mb_sim_advance_us(next_frame - now);
+
+        ee_pmw3901mb_sample_t sample;
+        while(ee_pmw3901mb_ring_pop(&poll_ring, &sample) == 0){
+            counts += sample.delta_x;
+            if(!pending) continue;
+            uint32_t latency = sample.time - pending_us;
+            latency_sum_us += latency;
+            if(latency > latency_max_us) latency_max_us = latency;
+            reads_with_motion++;
+            pending = false;
+        }
+
+        if(frame % tr->period_frames < tr->moving_frames){
+            if(!pending) pending_us = ee_pmw3901mb_time_us();
+            pending = true;
+            ee_pmw3901mb_sim_add_motion(&sensor, 2, -1);
+            added += 2;
+        }
+        frame++;
+        next_frame += timing.t_frame_us;
+    }
+    uint64_t run_us = ee_pmw3901mb_sim_now_us() - t_start;
+    uint32_t bus_time_us = sensor.stats.bus_time_us;
+    if(status_code == 0) status_code = ee_pmw3901mb_poll_stop(&poll);
+
+    // Samples read before the stop, and the motion after the last read
+    ee_pmw3901mb_sample_t sample;
+    while(ee_pmw3901mb_ring_pop(&poll_ring, &sample) == 0) counts += sample.delta_x;
+    ee_pmw3901mb_motion_burst_t burst;
+    if(status_code == 0) status_code = ee_pmw3901mb_dev_get_motion_burst(dev, &burst);
+    if(status_code == 0) counts += burst.delta_x;
+
+    bool ok = status_code == 0 && counts == added && poll.errors == 0U && poll.overruns == 0U;
+    printf("poll %-11s: %7.1f reads/s, bus busy %6.3f%%, latency mean %8.1f max %6" PRIu32 " us, %" PRIu32 " samples, counts %s\r\n",
+        tr->name, (double) poll.reads * 1000000.0 / (double) run_us, 100.0 * (double) bus_time_us / (double) run_us,
+        (reads_with_motion > 0) ? (double) latency_sum_us / reads_with_motion : 0.0, latency_max_us, poll.samples,
+        ok ? "OK" : "MISMATCH");
+    return ok;
+}
+#endif
+
+static int poll_bench(void){
+#if (EE_PMW3901MB_USE_POLL == TRUE)
+    ee_pmw3901mb_sim_set_surface(&sensor, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    bool ok = true;
+    for(size_t i = 0; i < sizeof(poll_traces) / sizeof(poll_traces[0]); i++){
+        if(!poll_trace(&poll_traces[i])) ok = false;
+    }
+    return ok ? 0 : 1;
+#else
+    printf("Built without EE_PMW3901MB_USE_POLL, run \"make poll\"\r\n");
+    return 1;
+#endif
+}
+
+// Shared bus of the flow sensor with an IMU and a baro (EE_PMW3901MB_USE_SCHED), built by "make sched".
+// The IMU and the baro are not simulated, their reads cost the bus time and read 0xFF.
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+#define SCHED_CS_LINE       5U          // Chip select line of the flow sensor on the shared bus
+#define IMU_CS_LINE         6U          // Chip select line of the IMU
+#define BARO_CS_LINE        7U          // Chip select line of the baro
+#define SCHED_RUN_US        2000000U    // Simulated time of a scheduler run
+#define IMU_PERIOD_US       1000U       // 1 kHz, 6 reads of 2 registers (accel and gyro axes)
+#define FLOW_PERIOD_US      10000U      // 100 Hz motion burst through the driver
+#define BARO_PERIOD_US      20000U      // 50 Hz, 2 reads of 3 registers (pressure and temperature)
+#define DIAG_PERIOD_US      20000U      // Background batch of flow register reads
+#define DIAG_READS          50U
+#define IMU_READS           6U
+#define BARO_READS          2U
+
+typedef struct {
+    const char* name;
+    bool prioritized;   // Priorities and deadlines, otherwise submit order
+    bool coalesce;      // Coalescing of the IMU and baro reads
+} sched_policy_t;
+
+typedef struct {
+    const char* name;
+    uint32_t period_us;
+    uint32_t deadline_us;   // Relative to the release, the period of the IMU
+    uint32_t release_us;    // Next release
+    uint32_t job_us;        // Release of the queued job
+    uint32_t jobs;
+    uint32_t misses;        // Completed after the deadline, or still pending at the next release
+    uint32_t max_us;
+    bool pending;
+} sched_stream_t;
+
+static const sched_policy_t sched_policies[] = {
+    { "fifo", false, false },
+    { "fifo, coalesce", false, true },
+    { "priority", true, false },
+    { "priority, coalesce", true, true },
+};
+
+static SPIConfig sched_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = ee_pmw3901mb_spi_data_cb,
+    .error_cb   = NULL,
+    .ssline     = SCHED_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static SPIConfig imu_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = NULL,
+    .error_cb   = NULL,
+    .ssline     = IMU_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static SPIConfig baro_spi_cfg = {
+    .circular   = false,
+    .slave      = false,
+    .data_cb    = NULL,
+    .error_cb   = NULL,
+    .ssline     = BARO_CS_LINE,
+    .cr1        = 0,
+    .cr2        = 0
+};
+
+static ee_pmw3901mb_sim_t shared;
+static ee_pmw3901mb_dev_t shared_dev;
+static ee_pmw3901mb_spi_sched_t sched;
+static ee_pmw3901mb_spi_trans_t imu_trans[IMU_READS];
+static ee_pmw3901mb_spi_trans_t baro_trans[BARO_READS];
+static ee_pmw3901mb_spi_trans_t diag_trans[DIAG_READS];
+static uint8_t imu_data[IMU_READS][2];
+static uint8_t baro_data[BARO_READS][3];
+static uint8_t diag_data[DIAG_READS];
+
+// Job of a stream done with its last transaction
+static void sched_job_done(ee_pmw3901mb_spi_trans_t* trans, void* arg){
+    sched_stream_t* s = arg;
+    uint32_t latency = trans->done_us - s->job_us;
+    if(latency > s->max_us) s->max_us = latency;
+    if(s->deadline_us != 0U && latency > s->deadline_us) s->misses++;
+    s->pending = false;
+}
+
+// Submits the transactions of a job released at the stream period
+static void sched_release(sched_stream_t* s, ee_pmw3901mb_spi_trans_t* trans, size_t n){
+    if(s->pending) s->misses++;     // Overrun, the previous job is still queued
+    else{
+        for(size_t i = 0; i < n; i++) (void) ee_pmw3901mb_spi_sched_submit(&sched, &trans[i]);
+        s->job_us = s->release_us;
+        s->pending = true;
+    }
+    s->jobs++;
+    s->release_us += s->period_us;
+}
+
+static void sched_print(const sched_stream_t* s){
+    printf(" %s %4" PRIu32 "/%4" PRIu32 " missed, max %5" PRIu32 " us,", s->name, s->misses, s->jobs, s->max_us);
+}
+
+static void sched_bus(const sched_policy_t* pol){
+    ee_pmw3901mb_spi_periph_t imu = { &imu_spi_cfg, 0x7FU, pol->coalesce ? 14U : 0U };
+    ee_pmw3901mb_spi_periph_t baro = { &baro_spi_cfg, 0x7FU, pol->coalesce ? 6U : 0U };
+    sched_stream_t imu_s = { "imu", IMU_PERIOD_US, IMU_PERIOD_US, 0, 0, 0, 0, 0, false };
+    sched_stream_t flow_s = { "flow", FLOW_PERIOD_US, 5000U, 0, 0, 0, 0, 0, false };
+    sched_stream_t baro_s = { "baro", BARO_PERIOD_US, BARO_PERIOD_US, 0, 0, 0, 0, 0, false };
+    sched_stream_t diag_s = { "diag", DIAG_PERIOD_US, 0, 0, 0, 0, 0, 0, false };
+
+    if(ee_pmw3901mb_dev_init_driver(&shared_dev, &SPID1, &sched_spi_cfg) != 0 ||
+       ee_pmw3901mb_spi_sched_init(&sched, &SPID1) != 0 ||
+       ee_pmw3901mb_spi_bus_set_sched(&shared_dev.bus, &sched, pol->prioritized ? 2U : 0U, pol->prioritized ? flow_s.deadline_us : 0U) != 0){
+        printf("sched %-18s: failed to initialize\r\n", pol->name);
+        return;
+    }
+
+    // IMU: accel and gyro axes 0x3B..0x46, baro: pressure 0xF7..0xF9 and temperature 0xFA..0xFC,
+    // background: squal of the flow sensor. The R/W bit of the IMU and baro is set for reads.
+    for(size_t i = 0; i < IMU_READS; i++){
+        imu_trans[i] = (ee_pmw3901mb_spi_trans_t) { .periph = &imu, .cmd = (uint8_t) (0x80U | (0x3BU + 2U * i)),
+            .rx = imu_data[i], .rx_n = 2U, .priority = pol->prioritized ? 3U : 0U,
+            .deadline_us = pol->prioritized ? imu_s.deadline_us : 0U };
+    }
+    imu_trans[IMU_READS - 1U].cb = sched_job_done;
+    imu_trans[IMU_READS - 1U].arg = &imu_s;
+    for(size_t i = 0; i < BARO_READS; i++){
+        baro_trans[i] = (ee_pmw3901mb_spi_trans_t) { .periph = &baro, .cmd = (uint8_t) (0xF7U + 3U * i),
+            .rx = baro_data[i], .rx_n = 3U, .priority = pol->prioritized ? 1U : 0U,
+            .deadline_us = pol->prioritized ? baro_s.deadline_us : 0U };
+    }
+    baro_trans[BARO_READS - 1U].cb = sched_job_done;
+    baro_trans[BARO_READS - 1U].arg = &baro_s;
+    for(size_t i = 0; i < DIAG_READS; i++){
+        diag_trans[i] = (ee_pmw3901mb_spi_trans_t) { .periph = &shared_dev.bus.periph, .cmd = 0x07U,
+            .rx = &diag_data[i], .rx_n = 1U, .priority = 0U, .deadline_us = 0U };
+    }
+    diag_trans[DIAG_READS - 1U].cb = sched_job_done;
+    diag_trans[DIAG_READS - 1U].arg = &diag_s;
+
+    uint32_t t_start = ee_pmw3901mb_time_us();
+    imu_s.release_us = flow_s.release_us = baro_s.release_us = t_start;
+    diag_s.release_us = t_start + DIAG_PERIOD_US / 2U;     // Out of phase with the baro
+    ee_pmw3901mb_motion_burst_t burst;
+    uint8_t status_code = 0;
+
+    for(;;){
+        uint32_t now = ee_pmw3901mb_time_us();
+        if(now - t_start >= SCHED_RUN_US) break;
+
+        if((int32_t) (now - imu_s.release_us) >= 0) sched_release(&imu_s, imu_trans, IMU_READS);
+        if((int32_t) (now - baro_s.release_us) >= 0) sched_release(&baro_s, baro_trans, BARO_READS);
+        if((int32_t) (now - diag_s.release_us) >= 0) sched_release(&diag_s, diag_trans, DIAG_READS);
+        if((int32_t) (now - flow_s.release_us) >= 0){
+            // The flow thread blocks in the driver, running the queue up to its transaction
+            status_code = ee_pmw3901mb_dev_get_motion_burst(&shared_dev, &burst);
+            if(status_code != 0) break;
+            uint32_t latency = shared_dev.bus.cs_deassert_us - flow_s.release_us;
+            if(latency > flow_s.max_us) flow_s.max_us = latency;
+            if(latency > flow_s.deadline_us) flow_s.misses++;
+            flow_s.jobs++;
+            flow_s.release_us += flow_s.period_us;
+            continue;
+        }
+
+        // One frame at a time, so the releases in between are queued in order
+        if(ee_pmw3901mb_spi_sched_run(&sched, 1U) == 0U){
+            uint32_t next = imu_s.release_us;
+            if((int32_t) (flow_s.release_us - next) < 0) next = flow_s.release_us;
+            if((int32_t) (baro_s.release_us - next) < 0) next = baro_s.release_us;
+            if((int32_t) (diag_s.release_us - next) < 0) next = diag_s.release_us;
+            ee_pmw3901mb_sim_advance_us(next - now);
+        }
+    }
+    (void) ee_pmw3901mb_spi_sched_run(&sched, 0U);
+    uint32_t elapsed_us = ee_pmw3901mb_time_us() - t_start;
+
+    if(status_code != 0 || ee_pmw3901mb_spi_bus_set_sched(&shared_dev.bus, NULL, 0U, 0U) != 0 ||
+       ee_pmw3901mb_spi_sched_stop(&sched) != 0){
+        printf("sched %-18s: failed, status 0x%02X\r\n", pol->name, status_code);
+        return;
+    }
+    printf("sched %-18s:", pol->name);
+    sched_print(&imu_s);
+    sched_print(&flow_s);
+    sched_print(&baro_s);
+    printf(" bus busy %5.1f%%, %6" PRIu32 " frames, %6" PRIu32 " config switches, %5" PRIu32 " coalesced\r\n",
+        100.0 * (double) sched.busy_us / (double) elapsed_us, sched.frames, sched.switches, sched.coalesced);
+}
+
+static int sched_session(void){
+    ee_pmw3901mb_sim_init(&shared);
+    ee_pmw3901mb_sim_set_surface(&shared, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    ee_pmw3901mb_sim_attach(&shared, SCHED_CS_LINE);
+    for(size_t i = 0; i < sizeof(sched_policies) / sizeof(sched_policies[0]); i++) sched_bus(&sched_policies[i]);
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv){
+
+    ee_pmw3901mb_sim_reset_all();
+    ee_pmw3901mb_sim_init(&sensor);
+    ee_pmw3901mb_sim_attach(&sensor, SIM_CS_LINE);
+    ee_pmw3901mb_sim_attach(&cold, COLD_CS_LINE);
+    ee_pmw3901mb_sim_attach(&faulty, FAULT_CS_LINE);
+    ee_pmw3901mb_sim_attach(&duty, DUTY_CS_LINE);
+
+    uint8_t status_code = 0;
+    uint64_t t0 = 0;
+
+    // Driver initialization
+    t0 = ee_pmw3901mb_sim_now_us();
+    status_code = ee_pmw3901mb_init_driver(&SPID1, &my_spi_cfg);
+    if(status_code != 0){
+        printf("Failed to initialize driver! Status Code: 0x%02X\r\n", status_code);
+        return 1;
+    }
+    if(argc > 1 && strcmp(argv[1], "bench") == 0) return stats_bench();
+    if(argc > 2 && strcmp(argv[1], "trace") == 0) return trace_session(argv[2]);
+    if(argc > 1 && strcmp(argv[1], "fusion") == 0) return fusion_bench();
+    if(argc > 1 && strcmp(argv[1], "derotate") == 0) return derotate_test();
+    if(argc > 1 && strcmp(argv[1], "estimator") == 0) return estimator_bench();
+    if(argc > 1 && strcmp(argv[1], "event") == 0) return event_bench();
+    if(argc > 1 && strcmp(argv[1], "poll") == 0) return poll_bench();
+    if(argc > 1 && strcmp(argv[1], "odometry") == 0) return odometry_test();
+    if(argc > 1 && strcmp(argv[1], "ring") == 0) return ring_stress();
+    if(argc > 1 && strcmp(argv[1], "cordic") == 0) return cordic_bench();
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    if(argc > 1 && strcmp(argv[1], "sched") == 0) return sched_session();
+#endif
+    print_stats("init", ee_pmw3901mb_sim_now_us() - t0, 1);
+
+    // Start/stop time of the performance optimization sequence and of motion polling, with the
+    // SPI driver started and stopped per transfer and held started by a bus session
+    ee_pmw3901mb_motion_burst_t burst;
+    uint64_t session_us[2][2];
+    for(uint32_t held = 0; held < 2U; held++){
+        ee_pmw3901mb_sim_clear_stats(&sensor);
+        t0 = ee_pmw3901mb_sim_now_us();
+        status_code = held ? ee_pmw3901mb_write_sequence(perf_opt_v2_steps, PERF_OPT_V2_STEPS, NULL) :
+                             write_per_transfer(perf_opt_v2_steps, PERF_OPT_V2_STEPS);
+        print_stats(held ? "perf opt, session" : "perf opt, per transfer", ee_pmw3901mb_sim_now_us() - t0, 1);
+        session_us[held][0] = sensor.stats.start_stop_time_us;
+
+        ee_pmw3901mb_sim_clear_stats(&sensor);
+        t0 = ee_pmw3901mb_sim_now_us();
+        if(held) ee_pmw3901mb_acquire();
+        for(uint32_t i = 0; i < SAMPLES && status_code == 0; i++) status_code = ee_pmw3901mb_get_motion_burst(&burst);
+        if(held) ee_pmw3901mb_release();
+        print_stats(held ? "poll, session" : "poll, per transfer", ee_pmw3901mb_sim_now_us() - t0, SAMPLES);
+        session_us[held][1] = sensor.stats.start_stop_time_us;
+    }
+    printf("Bus session: start/stop time of the perf opt %" PRIu64 " -> %" PRIu64 " us, of %u polls %" PRIu64 " -> %" PRIu64 " us, status 0x%02X\r\n",
+        session_us[0][0], session_us[1][0], SAMPLES, session_us[0][1], session_us[1][1], status_code);
+
+    // Register tables replayed against the simulated register file, and the former unrolled
+    // sequence for comparison ("make size" prints the code size of both)
+    sequence_poison(&sensor, perf_opt_steps, PERF_OPT_STEPS);
+    status_code = ee_pmw3901mb_perf_opt();
+    bool perf_opt_ok = status_code == 0 && sequence_applied(&sensor, perf_opt_steps, PERF_OPT_STEPS);
+    sequence_poison(&sensor, perf_opt_v2_steps, PERF_OPT_V2_STEPS);
+    status_code = perf_opt_v2_unrolled();
+    bool unrolled_ok = status_code == 0 && sequence_applied(&sensor, perf_opt_v2_steps, PERF_OPT_V2_STEPS);
+    sequence_poison(&sensor, perf_opt_v2_steps, PERF_OPT_V2_STEPS);
+    status_code = ee_pmw3901mb_perf_opt_v2();
+    bool perf_opt_v2_ok = status_code == 0 && sequence_applied(&sensor, perf_opt_v2_steps, PERF_OPT_V2_STEPS);
+    printf("Sequence replay: perf opt %zu steps %s, perf opt v2 %zu steps %s (unrolled %s), tables %zu bytes\r\n",
+        PERF_OPT_STEPS, perf_opt_ok ? "OK" : "MISMATCH", PERF_OPT_V2_STEPS, perf_opt_v2_ok ? "OK" : "MISMATCH",
+        unrolled_ok ? "OK" : "MISMATCH", sizeof(perf_opt_steps) + sizeof(perf_opt_v2_steps));
+
+    uint8_t product_id = 0;
+    uint8_t inv_product_id = 0;
+    ee_pmw3901mb_get_product_id(&product_id);
+    ee_pmw3901mb_get_inverse_product_id(&inv_product_id);
+    printf("Product ID: 0x%02X, Inverse Product ID: 0x%02X\r\n", product_id, inv_product_id);
+
+    // Boot to first valid sample, with the fixed sleeps and the readiness polls
+    cold_start("fixed sleeps", COLD_FIXED, 2000U);
+    cold_start("polled", COLD_BLOCKING, 2000U);
+    cold_start("polled", COLD_BLOCKING, 20000U);
+    cold_start("polled non-blocking", COLD_NON_BLOCKING, 2000U);
+    cold_start("polled, no boot", COLD_BLOCKING, 60000U);
+
+    // Time to detect and to recover from injected faults
+    for(fault_t f = FAULT_NONE; f <= FAULT_SHUTDOWN; f++) fault_inject(f);
+
+    // Per-sensor throughput with several device handles on one bus
+    for(uint32_t n = 1; n <= MULTI_MAX; n *= 2U) multi_round_robin(n);
+
+    // Duty cycle, wake latency and bus traffic per hour of the power policies
+    for(size_t i = 0; i < sizeof(duty_profiles) / sizeof(duty_profiles[0]); i++){
+        for(size_t k = 0; k < sizeof(duty_policies) / sizeof(duty_policies[0]); k++) duty_cycle(&duty_profiles[i], &duty_policies[k]);
+    }
+
+    // Polling delta X and Y
+    ee_pmw3901mb_sim_set_surface(&sensor, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    int16_t delta_x = 0;
+    int16_t delta_y = 0;
+    int32_t sum_x = 0;
+    int32_t sum_y = 0;
+
+    // Former five transaction delta read against the motion burst, same motion
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    t0 = ee_pmw3901mb_sim_now_us();
+    for(uint32_t i = 0; i < SAMPLES; i++){
+        ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+        status_code = five_read_delta_x_y(&delta_x, &delta_y);
+        if(status_code != 0) break;
+        sum_x += delta_x;
+        sum_y += delta_y;
+    }
+    uint64_t five_time_us = ee_pmw3901mb_sim_now_us() - t0;
+    uint32_t five_bytes = sensor.stats.bytes;
+    int32_t five_x = sum_x;
+    int32_t five_y = sum_y;
+    print_stats("poll five reads", five_time_us, SAMPLES);
+    sum_x = 0;
+    sum_y = 0;
+
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    t0 = ee_pmw3901mb_sim_now_us();
+    for(uint32_t i = 0; i < SAMPLES; i++){
+        ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+        status_code = ee_pmw3901mb_get_delta_x_y(&delta_x, &delta_y);
+        if(status_code != 0) break;
+        sum_x += delta_x;
+        sum_y += delta_y;
+    }
+    uint64_t burst_time_us = ee_pmw3901mb_sim_now_us() - t0;
+    print_stats("poll delta x/y", burst_time_us, SAMPLES);
+    printf("Motion burst vs. five reads: %.2fx bus bytes, %.2fx time per sample, same deltas %s\r\n",
+        (double) sensor.stats.bytes / (double) five_bytes, (double) burst_time_us / (double) five_time_us,
+        (five_x == sum_x && five_y == sum_y) ? "OK" : "MISMATCH");
+
+    // Polling motion burst within one bus session
+
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    t0 = ee_pmw3901mb_sim_now_us();
+    ee_pmw3901mb_acquire();
+    for(uint32_t i = 0; i < SAMPLES; i++){
+        ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+        status_code = ee_pmw3901mb_get_motion_burst(&burst);
+        if(status_code != 0) break;
+        sum_x += burst.delta_x;
+        sum_y += burst.delta_y;
+    }
+    ee_pmw3901mb_release();
+    print_stats("poll burst in session", ee_pmw3901mb_sim_now_us() - t0, SAMPLES);
+
+    // The platform functions without a bus handle share the default device bus, so their
+    // session nests with the driver session and the bus is started and locked once
+    uint8_t nested_id = 0;
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    status_code = ee_pmw3901mb_spi_acquire();
+    if(status_code == 0) status_code = ee_pmw3901mb_acquire();
+    if(status_code == 0) status_code = ee_pmw3901mb_get_delta_x_y(&delta_x, &delta_y);
+    if(status_code == 0) status_code = ee_pmw3901mb_spi_read(0x00, &nested_id, 1U);
+    if(status_code == 0) status_code = ee_pmw3901mb_release();
+    if(status_code == 0) status_code = ee_pmw3901mb_spi_release();
+    printf("Nested default bus sessions: status 0x%02X, %" PRIu32 " start(s), %" PRIu32 " stop(s) %s\r\n",
+        status_code, sensor.stats.starts, sensor.stats.stops,
+        (status_code == 0 && nested_id == product_id && sensor.stats.starts == 1U && sensor.stats.stops == 1U) ? "OK" : "MISMATCH");
+
+    // Asynchronous motion burst within one bus session, completed in the callback
+    async_done = 0;
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    t0 = ee_pmw3901mb_sim_now_us();
+    ee_pmw3901mb_acquire();
+    for(uint32_t i = 0; i < SAMPLES; i++){
+        ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+        status_code = ee_pmw3901mb_get_motion_burst_async(motion_burst_done, NULL);
+        if(status_code != 0) break;
+    }
+    ee_pmw3901mb_release();
+    print_stats("poll burst async", ee_pmw3901mb_sim_now_us() - t0, SAMPLES);
+    sum_x += async_sum_x;
+    sum_y += async_sum_y;
+
+    // Caller time per read at 1 kHz, blocking against asynchronous with the exchange running in
+    // the background, the rest of each period is left to the caller
+    uint64_t caller_us[2] = { 0, 0 };
+    int32_t caller_x[2] = { 0, 0 };
+    for(uint32_t async = 0; async < 2U; async++){
+        ee_pmw3901mb_sim_set_async(async != 0U);
+        async_done = 0;
+        async_sum_x = 0;
+        ee_pmw3901mb_acquire();
+        for(uint32_t i = 0; i < SAMPLES && status_code == 0; i++){
+            uint64_t t_period = ee_pmw3901mb_sim_now_us();
+            ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+            if(async){
+                status_code = ee_pmw3901mb_get_motion_burst_async(motion_burst_done, NULL);
+            }else{
+                status_code = ee_pmw3901mb_get_motion_burst(&burst);
+                caller_x[0] += burst.delta_x;
+            }
+            caller_us[async] += ee_pmw3901mb_sim_now_us() - t_period;
+            ee_pmw3901mb_sim_advance_us(t_period + 1000U - ee_pmw3901mb_sim_now_us());
+        }
+        ee_pmw3901mb_release();
+        if(async) caller_x[1] = async_sum_x;
+    }
+    ee_pmw3901mb_sim_set_async(false);
+    printf("Caller time per read at 1 kHz: blocking %.1f us, async %.1f us, %.1f us more of each 1000 us period to the caller, counts %s\r\n",
+        (double) caller_us[0] / SAMPLES, (double) caller_us[1] / SAMPLES, (double) (caller_us[0] - caller_us[1]) / SAMPLES,
+        (status_code == 0 && async_done == SAMPLES && caller_x[0] == 3 * (int32_t) SAMPLES && caller_x[1] == caller_x[0]) ? "OK" : "MISMATCH");
+
+    // Blocking transfers while the asynchronous burst is in flight are refused without a chip select frame
+    ee_pmw3901mb_sim_set_async(true);
+    async_done = 0;
+    async_sum_x = 0;
+    ee_pmw3901mb_acquire();
+    ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+    status_code = ee_pmw3901mb_get_motion_burst_async(motion_burst_done, NULL);
+    uint32_t frames = sensor.stats.transactions;
+    uint8_t bank = 0x00;
+    uint8_t refused_id = ee_pmw3901mb_get_product_id(&product_id);
+    uint8_t refused_burst = ee_pmw3901mb_get_motion_burst(&burst);
+    uint8_t refused_write = ee_pmw3901mb_spi_write(0x7F, &bank);
+    uint32_t overlapping = sensor.stats.transactions - frames;
+    ee_pmw3901mb_sim_advance_us(1000U);
+    ee_pmw3901mb_release();
+    ee_pmw3901mb_sim_set_async(false);
+    uint8_t after = ee_pmw3901mb_get_product_id(&product_id);
+    printf("Blocking transfers during an async read: product ID %u, burst %u, write %u, %" PRIu32 " frames started, %s\r\n",
+        refused_id, refused_burst, refused_write, overlapping,
+        (status_code == 0 && refused_id != 0 && refused_burst != 0 && refused_write != 0 && overlapping == 0U &&
+         async_done == 1U && async_sum_x == 3 && after == 0 && product_id == 0x49) ? "refused OK" : "MISMATCH");
+
+    printf("Accumulated X: %" PRId32 ", Y: %" PRId32 " (expected %" PRId32 ", %" PRId32 ")\r\n",
+        sum_x, sum_y, (int32_t) (3U * SAMPLES * 3), -(int32_t) (3U * SAMPLES * 2));
+    printf("Last burst: SQUAL 0x%02X, shutter 0x%04X\r\n", burst.squal, burst.shutter);
+
+    // Quality gate over a trace alternating textured and low-texture surface segments, where the
+    // low-texture segments give random deltas, 1 in 3 segments is low-texture
+    ee_pmw3901mb_quality_cfg_t quality;
+    ee_pmw3901mb_quality_default_cfg(&quality);
+    uint32_t bad = 0;
+    uint32_t bad_rejected = 0;
+    uint32_t good = 0;
+    uint32_t good_rejected = 0;
+    for(uint32_t i = 0; i < SAMPLES; i++){
+        bool low_texture = ((i / TRACE_SEGMENT) % 3U) == 2U;
+        if(low_texture){
+            uint8_t min = (uint8_t) lcg_range(0x00, 0x10);
+            ee_pmw3901mb_sim_set_surface(&sensor, (uint8_t) lcg_range(0x04, 0x28), 0x10,
+                (uint8_t) (min + lcg_range(0x00, 0x18)), min, (uint16_t) lcg_range(0x1400, 0x1FFF));
+            ee_pmw3901mb_sim_add_motion(&sensor, (int32_t) lcg_range(0, 40) - 20, (int32_t) lcg_range(0, 40) - 20);
+        }else{
+            uint8_t min = (uint8_t) lcg_range(0x08, 0x20);
+            ee_pmw3901mb_sim_set_surface(&sensor, (uint8_t) lcg_range(0x30, 0x80), 0x40,
+                (uint8_t) (min + lcg_range(0x28, 0x60)), min, (uint16_t) lcg_range(0x0100, 0x0800));
+            ee_pmw3901mb_sim_add_motion(&sensor, 3, -2);
+        }
+
+        status_code = ee_pmw3901mb_get_motion_burst(&burst);
+        if(status_code != 0) break;
+        bool rejected = ee_pmw3901mb_quality_gate(&quality, &burst, NULL) != EE_PMW3901MB_QUALITY_PASS;
+        if(low_texture){
+            bad++;
+            if(rejected) bad_rejected++;
+        }else{
+            good++;
+            if(rejected) good_rejected++;
+        }
+    }
+    printf("Quality gate: rejected %" PRIu32 " of %" PRIu32 " low-texture samples, %" PRIu32 " of %" PRIu32 " good samples\r\n",
+        bad_rejected, bad, good_rejected, good);
+
+    // Motion read jitter: reads at a nominal period with injected scheduling jitter, the driver
+    // statistics from the latched chip select times are checked against the simulated bus
+    ee_pmw3901mb_reset_jitter();
+    sensor.on_transaction = record_burst;
+    for(uint32_t i = 0; i < JITTER_READS; i++){
+        ee_pmw3901mb_sim_advance_us(JITTER_PERIOD_US - JITTER_SPREAD_US + lcg_range(0, 2U * JITTER_SPREAD_US));
+        status_code = ee_pmw3901mb_get_motion_burst(&burst);
+        if(status_code != 0) break;
+    }
+    sensor.on_transaction = NULL;
+
+    uint64_t exp_min = UINT64_MAX;
+    uint64_t exp_max = 0;
+    double exp_mean = 0.0;
+    double exp_var = 0.0;
+    for(uint32_t i = 1; i < burst_starts; i++){
+        uint64_t d = burst_start_us[i] - burst_start_us[i - 1U];
+        if(d < exp_min) exp_min = d;
+        if(d > exp_max) exp_max = d;
+        exp_mean += (double) d;
+    }
+    exp_mean /= (double) (burst_starts - 1U);
+    for(uint32_t i = 1; i < burst_starts; i++){
+        double e = (double) (burst_start_us[i] - burst_start_us[i - 1U]) - exp_mean;
+        exp_var += e * e;
+    }
+    exp_var /= (double) (burst_starts - 1U);
+
+    ee_pmw3901mb_jitter_t jitter;
+    ee_pmw3901mb_get_jitter(&jitter);
+    float var = ee_pmw3901mb_jitter_variance(&jitter);
+    bool jitter_ok = jitter.reads == burst_starts && jitter.min_us == exp_min && jitter.max_us == exp_max &&
+        fabs(jitter.mean_us - exp_mean) < 0.01 && fabs(var - exp_var) < exp_var * 1e-4;
+    printf("Read jitter: %" PRIu32 " reads, interval min %" PRIu32 " max %" PRIu32 " mean %.2f sd %.2f us "
+        "(bus: min %" PRIu64 " max %" PRIu64 " mean %.2f sd %.2f us) %s\r\n",
+        jitter.reads, jitter.min_us, jitter.max_us, jitter.mean_us, sqrt(var),
+        exp_min, exp_max, exp_mean, sqrt(exp_var), jitter_ok ? "OK" : "MISMATCH");
+
+    // A read after a gap longer than the realtime counter wrap keeps the gap to one system tick
+    uint32_t assert_us, deassert_before, deassert;
+    ee_pmw3901mb_get_burst_time(&assert_us, &deassert_before);
+    ee_pmw3901mb_sim_advance_us(JITTER_GAP_US);
+    ee_pmw3901mb_get_motion_burst(&burst);
+    ee_pmw3901mb_get_burst_time(&assert_us, &deassert);
+    uint32_t gap = assert_us - deassert_before;
+    uint32_t gap_err = (gap > JITTER_GAP_US) ? gap - JITTER_GAP_US : JITTER_GAP_US - gap;
+    printf("Read after %" PRIu32 " us idle: measured %" PRIu32 " us, read took %" PRIu32 " us %s\r\n",
+        JITTER_GAP_US, gap, deassert - assert_us, (gap_err <= 1000000U / CH_CFG_ST_FREQUENCY) ? "OK" : "MISMATCH");
+
+    // Adaptive polling vs. fixed periods over recorded motion profiles, in simulated time
+    ee_pmw3901mb_sim_set_surface(&sensor, 0x60, 0x40, 0xA0, 0x10, 0x0100);
+    for(size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++){
+        poll_profile(&profiles[i], "adaptive", EE_PMW3901MB_FRAME_PERIOD_US, EE_PMW3901MB_POLL_MAX_PERIOD_US);
+        poll_profile(&profiles[i], "fixed 300ms", 300000U, 300000U);
+        poll_profile(&profiles[i], "fixed frame", EE_PMW3901MB_FRAME_PERIOD_US, EE_PMW3901MB_FRAME_PERIOD_US);
+    }
+
+    // Continuous raw frame capture into double buffers, the consumer checks each frame
+    for(uint32_t i = 0; i < EE_PMW3901MB_FRAME_SIZE; i++) frame_pixels[i] = (uint8_t) (i * 7U);
+    ee_pmw3901mb_sim_set_frame(&sensor, frame_pixels);
+
+    status_code = ee_pmw3901mb_frame_capture_init(&capture, ee_pmw3901mb_get_default_dev(), frame_bufs[0], frame_bufs[1]);
+    if(status_code != 0){
+        printf("Failed to start frame capture! Status Code: 0x%02X\r\n", status_code);
+        return 1;
+    }
+
+    uint32_t frames_ok = 0;
+    const uint8_t* frame = NULL;
+    ee_pmw3901mb_sim_clear_stats(&sensor);
+    t0 = ee_pmw3901mb_sim_now_us();
+    for(uint32_t i = 0; i < FRAMES; i++){
+        status_code = ee_pmw3901mb_frame_capture_next(&capture);
+        if(status_code != 0) break;
+        if(ee_pmw3901mb_frame_capture_get(&capture, &frame, NULL) != 0) continue;
+        if(memcmp(frame, frame_pixels, EE_PMW3901MB_FRAME_SIZE) == 0) frames_ok++;
+        ee_pmw3901mb_frame_capture_release(&capture);
+    }
+    uint64_t frame_time_us = ee_pmw3901mb_sim_now_us() - t0;
+    print_stats("frame capture", frame_time_us, FRAMES);
+    printf("Frames: %" PRIu32 " of %u match, %.1f frames/s, %.0f bus bytes/frame\r\n",
+        frames_ok, FRAMES, (double) FRAMES * 1000000.0 / (double) frame_time_us,
+        (double) sensor.stats.bytes / FRAMES);
+
+    return status_code;
+}
@@ -0,0 +1,219 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Platform layer serving a recorded bus trace, in place of ee_pmw3901mb_platform.c.
+ */
+
+#include "ee_pmw3901mb_replay.h"
+#include "ee_pmw3901mb_trace.h"
+#include "ee_pmw3901mb_driver.h"
+
+#define SPI_RW_BIT_READ_MASK    0x7F
+
+// Loaded dump and the position of the next record
+static const uint8_t* replay_dump;
+static size_t replay_len;
+static size_t replay_pos;
+static uint32_t replay_time_us;
+static ee_pmw3901mb_replay_stats_t replay_stats;
+
+// Bus of the driver default device, so the functions without a bus handle share its
+// session depth and bus lock with the functions without a device handle
+#define DEFAULT_BUS             (&ee_pmw3901mb_get_default_dev()->bus)
+
+
+uint8_t ee_pmw3901mb_replay_load(const uint8_t* dump, size_t len){
+    uint32_t records = 0;
+    uint8_t status_code = ee_pmw3901mb_trace_parse_header(dump, len, &records, NULL);
+    if(status_code != 0) return status_code;
+
+    replay_dump = dump;
+    replay_len = len;
+    ee_pmw3901mb_replay_rewind();
+    replay_stats.records = records;
+    return 0;
+}
+
+void ee_pmw3901mb_replay_rewind(void){
+    uint32_t records = replay_stats.records;
+    memset(&replay_stats, 0, sizeof(replay_stats));
+    replay_stats.records = records;
+    replay_pos = EE_PMW3901MB_TRACE_FILE_HEADER_SIZE;
+    replay_time_us = 0;
+}
+
+bool ee_pmw3901mb_replay_done(void){
+    return replay_stats.replayed >= replay_stats.records;
+}
+
+void ee_pmw3901mb_replay_get_stats(ee_pmw3901mb_replay_stats_t* stats){
+    if(stats != NULL) *stats = replay_stats;
+}
+
+// Takes the next record when it matches the transaction, the recorded and the replayed
+// asynchronous reads are interchangeable
+static uint8_t replay_next(ee_pmw3901mb_spi_bus_t* bus, bool write, uint8_t addr, size_t n, ee_pmw3901mb_trace_record_t* rec){
+    size_t size = 0;
+    if(!ee_pmw3901mb_replay_done()) size = ee_pmw3901mb_trace_parse(replay_dump, replay_len, replay_pos, rec);
+
+    if(size == 0U || ((rec->flags & EE_PMW3901MB_TRACE_WRITE) != 0U) != write ||
+       rec->addr != (addr & SPI_RW_BIT_READ_MASK) || rec->n != n){
+        replay_stats.diverged++;
+        return EE_PMW3901MB_REPLAY_DIVERGED;
+    }
+
+    replay_pos += size;
+    replay_stats.replayed++;
+    replay_time_us = rec->time_us;
+    bus->cs_assert_us = rec->time_us;
+    bus->cs_deassert_us = rec->time_us;
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_spi_init(SPIDriver* spid_p, SPIConfig* spic_p){
+    return ee_pmw3901mb_spi_bus_init(DEFAULT_BUS, spid_p, spic_p);
+}
+
+uint8_t ee_pmw3901mb_spi_deinit(void){
+    return ee_pmw3901mb_spi_bus_deinit(DEFAULT_BUS);
+}
+
+uint8_t ee_pmw3901mb_spi_read(uint8_t addr, uint8_t* data, size_t n){
+    return ee_pmw3901mb_spi_bus_read(DEFAULT_BUS, addr, data, n);
+}
+
+uint8_t ee_pmw3901mb_spi_write(uint8_t addr, uint8_t* data){
+    return ee_pmw3901mb_spi_bus_write(DEFAULT_BUS, addr, data);
+}
+
+uint8_t ee_pmw3901mb_spi_acquire(void){
+    return ee_pmw3901mb_spi_bus_acquire(DEFAULT_BUS);
+}
+
+uint8_t ee_pmw3901mb_spi_release(void){
+    return ee_pmw3901mb_spi_bus_release(DEFAULT_BUS);
+}
+
+uint8_t ee_pmw3901mb_spi_bus_init(ee_pmw3901mb_spi_bus_t* bus, SPIDriver* spid_p, SPIConfig* spic_p){
+    if(bus == NULL) return 3; // Error: NULL bus handle passed
+    if(spid_p == NULL) return 1; // Error: NULL pointer passed
+    if(spic_p == NULL) return 2; // Error: NULL pointer passed
+
+    bus->spi_driver = spid_p;
+    bus->spi_config = spic_p;
+    bus->session_depth = 0U;
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_deinit(ee_pmw3901mb_spi_bus_t* bus){
+    if(bus == NULL) return 2; // Error: NULL bus handle passed
+    if(bus->spi_driver == NULL || bus->spi_config == NULL) return 1; // Error: Not initialized / Already Deinitialized
+    if(bus->session_depth != 0U) return 3; // Error: Bus session still acquired
+
+    bus->spi_driver = NULL;
+    bus->spi_config = NULL;
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_spi_bus_read(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, uint8_t* data, size_t n){
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(n < 1) return 2; // Error: Invalid size
+
+    ee_pmw3901mb_trace_record_t rec;
+    uint8_t status_code = replay_next(bus, false, addr, n, &rec);
+    if(status_code != 0) return status_code;
+
+    memcpy(data, rec.data, n);
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_write(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, uint8_t* data){
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(data == NULL) return 2; // Error: Data pointer is NULL
+    if(bus->spi_config == NULL) return 3; // Error: SPI Config is NULL
+
+    ee_pmw3901mb_trace_record_t rec;
+    uint8_t status_code = replay_next(bus, true, addr, 1U, &rec);
+    if(status_code != 0) return status_code;
+
+    if(rec.data[0] != *data){
+        replay_stats.diverged++;
+        return EE_PMW3901MB_REPLAY_DIVERGED;
+    }
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_acquire(ee_pmw3901mb_spi_bus_t* bus){
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(bus->spi_config == NULL) return 3; // Error: SPI Config is NULL
+    if(bus->session_depth == UINT8_MAX) return 2; // Error: Too deeply nested
+
+    bus->session_depth++;
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_release(ee_pmw3901mb_spi_bus_t* bus){
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(bus->session_depth == 0U) return 2; // Error: Bus session not acquired
+
+    bus->session_depth--;
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_read_async(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, size_t n,
+                                        ee_pmw3901mb_spi_async_cb_t cb, void* arg){
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(n < 1 || n > EE_PMW3901MB_SPI_ASYNC_MAX_SIZE) return 2; // Error: Invalid size
+    if(bus->session_depth == 0U) return 4; // Error: Bus session not acquired
+    if(bus->async_busy) return 5; // Error: Asynchronous read in flight
+
+    ee_pmw3901mb_trace_record_t rec;
+    uint8_t status_code = replay_next(bus, false, addr, n, &rec);
+    if(status_code != 0) return status_code;
+
+    // Completed at once, as if the transfer finished before the call returned
+    memcpy(&bus->async_rxbuf[1], rec.data, n);
+    bus->async_n = n;
+    if(cb != NULL) cb(bus, &bus->async_rxbuf[1], n, arg);
+    return 0; // Success
+}
+
+bool ee_pmw3901mb_spi_bus_async_busy(const ee_pmw3901mb_spi_bus_t* bus){
+    return (bus != NULL) && bus->async_busy;
+}
+
+void ee_pmw3901mb_spi_data_cb(SPIDriver* spip){
+    (void) spip;
+}
+
+uint32_t ee_pmw3901mb_time_us(void){
+    return replay_time_us;
+}
+
+uint8_t ee_pmw3901mb_wait_ms(uint32_t wait_ms){
+    // Returns at once, the time moves on to the next transaction as on the recording
+    replay_time_us += wait_ms * 1000U;
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_replay.h
+ * 
+ * @brief EngEmil PMW3901MB bus trace replay for Linux host builds.
+ * 
+ * Replaces the platform layer (ee_pmw3901mb_platform.c) and serves the transactions of a
+ * trace dump (ee_pmw3901mb_trace.h) in recorded order: reads return the recorded payload,
+ * writes are checked against it, and ee_pmw3901mb_time_us() returns the recorded chip select
+ * time. Waits return at once, so the driver and the code consuming its samples re-run
+ * bit-exactly and as fast as the host allows. A transaction differing from the recording in
+ * direction, address, size or written value fails with EE_PMW3901MB_REPLAY_DIVERGED, and
+ * so does any transaction after the end of the recording.
+ * 
+ * @note Replays one sensor, recordings of several sensors on one recorder interleave.
+ */
+
+#ifndef _EE_PMW3901MB_REPLAY_
+#define _EE_PMW3901MB_REPLAY_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ee_pmw3901mb_platform.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define EE_PMW3901MB_REPLAY_DIVERGED    0x20U   /**< Status code of a transaction not matching the recording */
+
+/**
+ * @brief Replay statistics.
+ */
+typedef struct {
+    uint32_t records;       /**< Records in the loaded dump */
+    uint32_t replayed;      /**< Records served since the last rewind */
+    uint32_t diverged;      /**< Transactions not matching the recording */
+} ee_pmw3901mb_replay_stats_t;
+
+
+/**
+ * @brief Load a trace dump to replay, and rewind to its first record.
+ * @note The dump is not copied and must outlive the replay.
+ * 
+ * @param[in] dump pointer to the dump
+ * @param[in] len size of the dump in bytes
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_replay_load(const uint8_t* dump, size_t len);
+
+/**
+ * @brief Rewind to the first record and clear the statistics.
+ */
+void ee_pmw3901mb_replay_rewind(void);
+
+/**
+ * @brief Check if all records are served.
+ * 
+ * @return true at the end of the recording
+ */
+bool ee_pmw3901mb_replay_done(void);
+
+/**
+ * @brief Get the replay statistics.
+ * 
+ * @param[out] stats pointer to the return value
+ */
+void ee_pmw3901mb_replay_get_stats(ee_pmw3901mb_replay_stats_t* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_REPLAY_ */
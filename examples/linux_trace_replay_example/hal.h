@@ -0,0 +1,75 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file hal.h
+ * 
+ * @brief Stand-in for the ChibiOS hal.h on a Linux host.
+ * 
+ * Only the types the driver headers use, the platform layer is replaced by the trace replay
+ * (ee_pmw3901mb_platform_replay.c), which does not touch the SPI driver.
+ */
+
+#ifndef _HAL_H_
+#define _HAL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#define TRUE    1
+#define FALSE   0
+
+typedef struct hal_spi_driver SPIDriver;
+
+typedef void (*spicb_t)(SPIDriver* spip);
+
+/**
+ * @brief SPI configuration, only the completion callback is kept.
+ */
+typedef struct {
+    spicb_t data_cb;
+} SPIConfig;
+
+/**
+ * @brief SPI driver, a placeholder for the bus handle.
+ */
+struct hal_spi_driver {
+    int unused;
+};
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _HAL_H_ */
@@ -0,0 +1,160 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Linux trace replay example. Re-runs the driver and an odometry consumer on a bus trace
+ * recorded by the Linux host simulator example ("make trace" there), checks the replay
+ * follows the recording, and measures the replay throughput.
+ */
+
+#define _POSIX_C_SOURCE 199309L  // clock_gettime()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include "hal.h"
+#include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_odometry.h"
+#include "ee_pmw3901mb_replay.h"
+
+#define BENCH_MIN_NS    1000000000U // Replay rounds until at least this host time has passed
+
+static SPIDriver replay_spi;
+static SPIConfig replay_spi_cfg;
+
+static ee_pmw3901mb_odometry_t odo;
+static uint32_t digest;
+static uint32_t reads;
+
+// Same consumer as the recording session, the digest covers every sample and its time stamp
+static void consume(const ee_pmw3901mb_motion_burst_t* burst, uint32_t time_us){
+    const uint8_t bytes[] = { burst->motion, (uint8_t) burst->delta_x, (uint8_t) (burst->delta_x >> 8),
+        (uint8_t) burst->delta_y, (uint8_t) (burst->delta_y >> 8), burst->squal, (uint8_t) burst->shutter,
+        (uint8_t) (burst->shutter >> 8), (uint8_t) time_us, (uint8_t) (time_us >> 8), (uint8_t) (time_us >> 16),
+        (uint8_t) (time_us >> 24) };
+    for(size_t i = 0; i < sizeof(bytes); i++) digest = (digest ^ bytes[i]) * 16777619U; // FNV-1a
+    ee_pmw3901mb_odometry_update(&odo, burst->delta_x, burst->delta_y, time_us);
+    reads++;
+}
+
+// One pass over the recording: driver initialization, then motion reads until its end
+static uint8_t replay_session(void){
+    ee_pmw3901mb_motion_burst_t burst;
+    uint32_t assert_us = 0;
+    uint32_t deassert_us = 0;
+
+    ee_pmw3901mb_replay_rewind();
+    ee_pmw3901mb_odometry_init(&odo, 100000U, 0U);
+    digest = 2166136261U;
+    reads = 0;
+
+    uint8_t status_code = ee_pmw3901mb_init_driver(&replay_spi, &replay_spi_cfg);
+    if(status_code != 0) return status_code;
+
+    while(!ee_pmw3901mb_replay_done()){
+        status_code = ee_pmw3901mb_get_motion_burst(&burst);
+        if(status_code != 0) return status_code;
+        ee_pmw3901mb_get_burst_time(&assert_us, &deassert_us);
+        consume(&burst, assert_us);
+    }
+    return 0;
+}
+
+static uint64_t host_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000U + (uint64_t) ts.tv_nsec;
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        printf("Usage: %s <trace file>\r\n", argv[0]);
+        return 1;
+    }
+
+    FILE* f = fopen(argv[1], "rb");
+    if(f == NULL){
+        printf("Failed to open %s\r\n", argv[1]);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* dump = malloc((size_t) size);
+    if(dump == NULL || fread(dump, 1, (size_t) size, f) != (size_t) size){
+        printf("Failed to read %s\r\n", argv[1]);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+
+    uint8_t status_code = ee_pmw3901mb_replay_load(dump, (size_t) size);
+    if(status_code != 0){
+        printf("Not a trace dump! Status Code: 0x%02X\r\n", status_code);
+        return 1;
+    }
+
+    // Replay once and report what the consumer saw
+    status_code = replay_session();
+    ee_pmw3901mb_replay_stats_t stats;
+    ee_pmw3901mb_replay_get_stats(&stats);
+    int64_t x = 0;
+    int64_t y = 0;
+    ee_pmw3901mb_odometry_get_total(&odo, &x, &y);
+    printf("replayed %" PRIu32 " of %" PRIu32 " transactions, %" PRIu32 " diverged, status 0x%02X\r\n",
+        stats.replayed, stats.records, stats.diverged, status_code);
+    printf("replayed %" PRIu32 " motion reads, position %" PRId64 ", %" PRId64 ", digest 0x%08" PRIX32 "\r\n",
+        reads, x, y, digest);
+    if(status_code != 0 || stats.diverged != 0) return 1;
+
+    uint32_t first_digest = digest;
+    uint32_t recorded_us = 0;
+    uint32_t unused = 0;
+    ee_pmw3901mb_get_burst_time(&recorded_us, &unused);
+
+    // Throughput, whole passes including the driver initialization
+    uint32_t rounds = 0;
+    uint64_t samples = 0;
+    uint64_t t0 = host_ns();
+    uint64_t elapsed = 0;
+    do{
+        if(replay_session() != 0 || digest != first_digest){
+            printf("Replay not repeatable\r\n");
+            return 1;
+        }
+        rounds++;
+        samples += reads;
+        elapsed = host_ns() - t0;
+    }while(elapsed < BENCH_MIN_NS);
+
+    double seconds = (double) elapsed / 1e9;
+    printf("replay throughput: %.2f M samples/s, %.0fx real time (%" PRIu32 " rounds of %.1f s recorded)\r\n",
+        (double) samples / seconds / 1e6, (double) recorded_us * rounds / 1e6 / seconds, rounds,
+        (double) recorded_us / 1e6);
+
+    free(dump);
+    return 0;
+}
@@ -23,16 +23,13 @@ SOFTWARE.
 */
 
 
-/* IMPORTANT:
- * - To use float support, change CHPRINTF_USE_FLOAT to TRUE in ChibiOS/os/hal/lib/streams/chprintf.h.
- * - To use math, include <math.h> and link with -lm. (.e.g. in Makefile: ULIBS = -lm)
- */
-
-#include <math.h>
 #include "ch.h"
 #include "hal.h"
 #include "chprintf.h"
 #include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_motion_event.h"
+#include "ee_pmw3901mb_velocity.h"
+#include "ee_pmw3901mb_health.h"
 
 /* Serial / Virtual COM Port related */
 #define VIRTUAL_COM_TX_LINE         LINE_VCP_TX // UART2_TX (PA2)
@@ -63,8 +60,7 @@ SOFTWARE.
 #define SPI_CS_LINE_MODE    PAL_MODE_OUTPUT_PUSHPULL | \
                             PAL_STM32_PUPDR_PULLUP /* Added SW PULL-UP (No HW PULL-UP on module) */
 #define MOT_INT_LINE        LINE_ARD_A2 // "Motion Interrupt" (PA3)
-#define MOT_INT_LINE_MODE   PAL_MODE_OUTPUT_PUSHPULL | \
-                            PAL_STM32_PUPDR_PULLUP /* Added SW PULL-UP (No HW PULL-UP on module) */
+#define MOT_INT_LINE_MODE   PAL_MODE_INPUT_PULLUP /* Motion output of the sensor, active low. Added SW PULL-UP (No HW PULL-UP on module) */
 #define RESET_LINE          LINE_ARD_A1 // "Reset" (PA1)
 #define RESET_LINE_MODE     PAL_MODE_OUTPUT_PUSHPULL  /* No need for SW PULL-UP (Module has HW PULL-UP) */
 #define my_spi_driver (&SPID1)
@@ -97,6 +93,45 @@ static SPIConfig my_spi_cfg = {
 };
 
 
+/* Motion event acquisition, reader thread woken by the motion line. */
+static THD_WORKING_AREA(waThdMotion, 256);
+static ee_pmw3901mb_motion_event_t motion_event;
+static ee_pmw3901mb_quality_cfg_t motion_quality;  // Drops samples over featureless surfaces
+
+/* Health monitor, recovers the sensor after a brown-out or a bus fault. */
+static ee_pmw3901mb_health_t health;
+
+/* Start the motion event acquisition with the quality gate. */
+static uint8_t motion_event_start(ee_pmw3901mb_dev_t* dev) {
+    uint8_t status_code = ee_pmw3901mb_motion_event_start(&motion_event, dev, MOT_INT_LINE,
+                                                          waThdMotion, sizeof(waThdMotion), NORMALPRIO + 1);
+    if(status_code != 0) return status_code;
+    return ee_pmw3901mb_motion_event_set_quality(&motion_event, &motion_quality);
+}
+
+/* Recover the sensor with the motion event acquisition paused, it owns the bus while running.
+ * Only a full init restarts the acquisition, motion pending after it would not give a new edge. */
+static uint8_t recover_sensor(BaseSequentialStream* stream, ee_pmw3901mb_health_fault_t fault) {
+    static const char* const paths[] = { "nothing", "bank select", "retune", "full init" };
+    uint8_t status_code = 0;
+
+    chprintf(stream, "Sensor fault %d, recovering...\r\n", (int) fault);
+    health.fault = fault;
+    ee_pmw3901mb_motion_event_pause(&motion_event);
+    status_code = ee_pmw3901mb_health_recover(&health);
+    ee_pmw3901mb_motion_event_resume(&motion_event);
+    if(status_code == 0){
+        chprintf(stream, "Recovered by %s in %u us\r\n", paths[health.last_recovery], health.last_recovery_us);
+    }else{
+        chprintf(stream, "Failed to recover! Status Code: 0x%02X \r\n", status_code);
+    }
+    if(health.last_recovery == EE_PMW3901MB_RECOVERY_FULL){
+        ee_pmw3901mb_motion_event_stop(&motion_event);
+        motion_event_start(health.dev);
+    }
+    return status_code;
+}
+
 /* System running indicator, LED blinker thread. */
 static THD_WORKING_AREA(waThdBlinker, 128);
 static THD_FUNCTION(ThdBlinker, arg) {
@@ -108,12 +143,17 @@ static THD_FUNCTION(ThdBlinker, arg) {
     }
 }
 
-float calc_angle(int16_t *delta_x, int16_t *delta_y) {
-    return atan2((float) *delta_y, (float) *delta_x) * (180.0f / 3.14159265f);
+/* Angle in centidegrees, from the integer CORDIC (no FPU or math library needed). */
+int32_t calc_angle(int16_t *delta_x, int16_t *delta_y) {
+    int32_t angle = 0;
+    ee_pmw3901mb_cordic_vector(*delta_x, *delta_y, NULL, &angle);
+    return (angle * 18000) / EE_PMW3901MB_ANGLE_PI;
 }
 
-double calc_magnitude(int16_t *delta_x, int16_t *delta_y) {
-    return sqrt((double)(*delta_x * *delta_x + *delta_y * *delta_y));
+uint32_t calc_magnitude(int16_t *delta_x, int16_t *delta_y) {
+    uint32_t magnitude = 0;
+    ee_pmw3901mb_cordic_vector(*delta_x, *delta_y, &magnitude, NULL);
+    return magnitude;
 }
 
 /* Main function */
@@ -166,31 +206,49 @@ int main(void) {
     }
     product_id = 0x00;
 
+    // Motion event acquisition, the sensor is only read when it flags motion
+    ee_pmw3901mb_dev_t* sensor = ee_pmw3901mb_get_default_dev();
+    ee_pmw3901mb_motion_sample_t sample;
+    ee_pmw3901mb_quality_default_cfg(&motion_quality);
+    status_code = motion_event_start(sensor);
+    if(status_code != 0){
+        chprintf(my_serial_stream, "Failed to start motion event acquisition!\r\n");
+        chprintf(my_serial_stream, "Status Code: 0x%02X \r\n", status_code);
+    }
+    ee_pmw3901mb_health_init(&health, sensor, NULL);
+    ee_pmw3901mb_health_fault_t fault = EE_PMW3901MB_HEALTH_OK;
+
 
     // Main Thread
     while (true) {
 
-        // Reading X and Y values
-        status_code = ee_pmw3901mb_get_delta_x_y(&delta_x, &delta_y);
-
-        if(status_code == 0){
-            if(CHPRINTF_USE_FLOAT) {
-                chprintf(my_serial_stream, "X: %d , Y: %d , Magnitue: %f , Angle (deg.): %f \r\n", 
-                delta_x,
-                delta_y,
-                calc_magnitude(&delta_x, &delta_y),
-                calc_angle(&delta_x, &delta_y));
-            }else{
-                chprintf(my_serial_stream, "X: %d , Y: %d \r\n", delta_x, delta_y);
-            }
-        }else{
-            chprintf(my_serial_stream, "Failed to read!\r\n");
-            chprintf(my_serial_stream, "Status Code: 0x%04X \r\n", status_code);
+        // Waiting for X and Y values
+        status_code = ee_pmw3901mb_motion_event_get(&motion_event, &sample, TIME_MS2I(1000));
+        if(status_code != 0){
+            // Without motion there are no samples to check, check the sensor itself with the
+            // acquisition paused, its queued samples and counters are kept
+            ee_pmw3901mb_motion_event_pause(&motion_event);
+            fault = ee_pmw3901mb_health_check(&health);
+            ee_pmw3901mb_motion_event_resume(&motion_event);
+            if(fault != EE_PMW3901MB_HEALTH_OK) recover_sensor(my_serial_stream, fault);
+            else chprintf(my_serial_stream, "No motion\r\n");
+            continue;
         }
+        fault = ee_pmw3901mb_health_check_burst(&health, &sample.burst);
+        if(fault != EE_PMW3901MB_HEALTH_OK){
+            recover_sensor(my_serial_stream, fault);
+            continue;
+        }
+        delta_x = sample.burst.delta_x;
+        delta_y = sample.burst.delta_y;
+
+        chprintf(my_serial_stream, "X: %d , Y: %d , Magnitude: %u , Angle (centideg.): %d \r\n", 
+            delta_x,
+            delta_y,
+            calc_magnitude(&delta_x, &delta_y),
+            calc_angle(&delta_x, &delta_y));
         delta_x = 0x00;
         delta_y = 0x00;
-        status_code = 0x00;
-        chThdSleepMilliseconds(300);
         
     }
 
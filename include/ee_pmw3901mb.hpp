@@ -0,0 +1,367 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb.hpp
+ * 
+ * @brief EngEmil PMW3901MB C++17 header-only front-end.
+ * 
+ * Compile-time register map with the access of each register (read-only, write-only or
+ * read/write) checked by static_assert, constexpr initialization sequences, and a sensor
+ * class templated on its transport, so register accesses inline down to the transport.
+ * 
+ * A transport is any class with the members
+ * - uint8_t read(uint8_t addr, uint8_t* data, std::size_t n)
+ * - uint8_t write(uint8_t addr, uint8_t value)
+ * - uint8_t acquire() and uint8_t release(), a bus session as ee_pmw3901mb_spi_bus_acquire()
+ * - uint8_t wait_ms(uint32_t ms)
+ * returning the status codes of the C API (0 success, nonzero on error). bus_transport
+ * forwards to the platform layer (ee_pmw3901mb_platform.h).
+ */
+
+#ifndef _EE_PMW3901MB_HPP_
+#define _EE_PMW3901MB_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_sequences.inc"
+
+
+namespace ee {
+namespace pmw3901mb {
+
+
+/**
+ * @brief Register access.
+ */
+enum class access : uint8_t { ro, wo, rw };
+
+/**
+ * @brief Register, its address and access as compile-time constants.
+ */
+template <uint8_t Addr, access Access, std::size_t Size = 1U>
+struct reg {
+    static constexpr uint8_t addr = Addr;
+    static constexpr access acc = Access;
+    static constexpr std::size_t size = Size;       /**< Bytes returned by one read */
+    static constexpr bool readable = (Access != access::wo);
+    static constexpr bool writable = (Access != access::ro);
+};
+
+/**
+ * @brief Register map.
+ */
+namespace regs {
+using product_id            = reg<0x00, access::ro>;
+using revision_id           = reg<0x01, access::ro>;
+using motion                = reg<0x02, access::rw>;
+using delta_x_l             = reg<0x03, access::ro>;
+using delta_x_h             = reg<0x04, access::ro>;
+using delta_y_l             = reg<0x05, access::ro>;
+using delta_y_h             = reg<0x06, access::ro>;
+using squal                 = reg<0x07, access::ro>;
+using rawdata_sum           = reg<0x08, access::ro>;
+using maximum_rawdata       = reg<0x09, access::ro>;
+using minimum_rawdata       = reg<0x0A, access::ro>;
+using shutter_lower         = reg<0x0B, access::ro>;
+using shutter_upper         = reg<0x0C, access::ro>;
+using observation           = reg<0x15, access::rw>;
+using motion_burst          = reg<0x16, access::ro, EE_PMW3901MB_MOTION_BURST_SIZE>;
+using power_up_reset        = reg<0x3A, access::wo>;
+using shutdown              = reg<0x3B, access::wo>;
+using rawdata_grab          = reg<0x58, access::rw>;
+using rawdata_grab_status   = reg<0x59, access::ro>;
+using inverse_product_id    = reg<0x5F, access::ro>;
+using bank_select           = reg<0x7F, access::rw>;
+} // namespace regs
+
+/**
+ * @brief Byte offsets within a motion burst read.
+ */
+namespace burst {
+constexpr std::size_t motion            = 0;
+constexpr std::size_t observation       = 1;
+constexpr std::size_t delta_x_l         = 2;
+constexpr std::size_t delta_x_h         = 3;
+constexpr std::size_t delta_y_l         = 4;
+constexpr std::size_t delta_y_h         = 5;
+constexpr std::size_t squal             = 6;
+constexpr std::size_t rawdata_sum       = 7;
+constexpr std::size_t maximum_rawdata   = 8;
+constexpr std::size_t minimum_rawdata   = 9;
+constexpr std::size_t shutter_upper     = 10;
+constexpr std::size_t shutter_lower     = 11;
+} // namespace burst
+
+constexpr uint8_t product_id_value          = 0x49; /**< Value of regs::product_id */
+constexpr uint8_t inverse_product_id_value  = 0xB6; /**< Value of regs::inverse_product_id */
+constexpr uint8_t power_up_reset_value      = 0x5A; /**< Value written to regs::power_up_reset */
+
+/**
+ * @brief Register write step of a sequence, the layout of ee_pmw3901mb_reg_write_t.
+ */
+struct reg_write {
+    uint8_t addr;       /**< Register address */
+    uint8_t value;      /**< Value to write */
+    uint8_t delay_ms;   /**< Delay after the write in milliseconds, 0 for none */
+};
+
+/**
+ * @brief Bank selected after a sequence, assuming bank 0 before it.
+ */
+template <std::size_t N>
+constexpr uint8_t final_bank(const std::array<reg_write, N>& seq){
+    uint8_t bank = 0;
+    for(const reg_write& step : seq){
+        if(step.addr == regs::bank_select::addr) bank = step.value;
+    }
+    return bank;
+}
+
+/**
+ * @brief Check if a bank 0 address is a read-only register of the map.
+ */
+constexpr bool is_read_only(uint8_t addr){
+    return addr == regs::product_id::addr || addr == regs::revision_id::addr ||
+           (addr >= regs::delta_x_l::addr && addr <= regs::shutter_upper::addr) ||
+           addr == regs::motion_burst::addr || addr == regs::rawdata_grab_status::addr ||
+           addr == regs::inverse_product_id::addr;
+}
+
+/**
+ * @brief Check that a sequence writes no read-only register of bank 0, assuming bank 0 before it.
+ * @note Also catches steps left zero by a too large std::array size, which write register 0x00.
+ */
+template <std::size_t N>
+constexpr bool writes_only_writable(const std::array<reg_write, N>& seq){
+    uint8_t bank = 0;
+    for(const reg_write& step : seq){
+        if(step.addr == regs::bank_select::addr) bank = step.value;
+        else if(bank == 0U && is_read_only(step.addr)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Total delay of a sequence in milliseconds.
+ */
+template <std::size_t N>
+constexpr uint32_t total_delay_ms(const std::array<reg_write, N>& seq){
+    uint32_t ms = 0;
+    for(const reg_write& step : seq) ms += step.delay_ms;
+    return ms;
+}
+
+// Steps of an X-macro list of ee_pmw3901mb_sequences.inc
+#define EE_PMW3901MB_HPP_STEP(reg, value, delay_ms)    reg_write{ reg, value, delay_ms },
+#define EE_PMW3901MB_HPP_COUNT(reg, value, delay_ms)   + 1U
+
+/**
+ * @brief Performance optimization sequence version 2, the one ee_pmw3901mb_init_driver() writes.
+ * 
+ * Adapted from https://github.com/bitcraze/Bitcraze_PMW3901, MIT License,
+ * Copyright (c) 2017 Bitcraze
+ */
+inline constexpr std::array<reg_write, 0U EE_PMW3901MB_SEQ_PERF_OPT_V2(EE_PMW3901MB_HPP_COUNT)> perf_opt_v2 {{
+    EE_PMW3901MB_SEQ_PERF_OPT_V2(EE_PMW3901MB_HPP_STEP)
+}};
+
+/**
+ * @brief Raw data grab mode sequence, the one ee_pmw3901mb_frame_grab_enable() writes.
+ */
+inline constexpr std::array<reg_write, 0U EE_PMW3901MB_SEQ_FRAME_GRAB(EE_PMW3901MB_HPP_COUNT)> frame_grab {{
+    EE_PMW3901MB_SEQ_FRAME_GRAB(EE_PMW3901MB_HPP_STEP)
+}};
+
+#undef EE_PMW3901MB_HPP_STEP
+#undef EE_PMW3901MB_HPP_COUNT
+
+static_assert(final_bank(perf_opt_v2) == 0U, "perf_opt_v2 must return to bank 0");
+static_assert(final_bank(frame_grab) == 0U, "frame_grab must return to bank 0");
+static_assert(writes_only_writable(perf_opt_v2), "perf_opt_v2 writes a read-only register");
+static_assert(writes_only_writable(frame_grab), "frame_grab writes a read-only register");
+static_assert(sizeof(reg_write) == sizeof(ee_pmw3901mb_reg_write_t), "reg_write must match ee_pmw3901mb_reg_write_t");
+
+
+/**
+ * @brief Transport over a platform layer bus handle.
+ */
+class bus_transport {
+public:
+    explicit constexpr bus_transport(ee_pmw3901mb_spi_bus_t& bus) : bus_(&bus) {}
+
+    uint8_t read(uint8_t addr, uint8_t* data, std::size_t n){ return ee_pmw3901mb_spi_bus_read(bus_, addr, data, n); }
+    uint8_t write(uint8_t addr, uint8_t value){ return ee_pmw3901mb_spi_bus_write(bus_, addr, &value); }
+    uint8_t acquire(){ return ee_pmw3901mb_spi_bus_acquire(bus_); }
+    uint8_t release(){ return ee_pmw3901mb_spi_bus_release(bus_); }
+    uint8_t wait_ms(uint32_t ms){ return ee_pmw3901mb_wait_ms(ms); }
+
+    ee_pmw3901mb_spi_bus_t& bus(){ return *bus_; }
+
+private:
+    ee_pmw3901mb_spi_bus_t* bus_;
+};
+
+
+/**
+ * @brief PMW3901MB sensor over a transport.
+ */
+template <class Transport>
+class sensor {
+public:
+    explicit constexpr sensor(Transport transport) : transport_(transport) {}
+
+    /**
+     * @brief Read a register.
+     */
+    template <class Reg>
+    uint8_t read(uint8_t& value){
+        static_assert(Reg::readable, "register is write-only");
+        static_assert(Reg::size == 1U, "register reads more than one byte");
+        return transport_.read(Reg::addr, &value, 1U);
+    }
+
+    /**
+     * @brief Write a register.
+     */
+    template <class Reg>
+    uint8_t write(uint8_t value){
+        static_assert(Reg::writable, "register is read-only");
+        return transport_.write(Reg::addr, value);
+    }
+
+    /**
+     * @brief Write a sequence within one bus session, as ee_pmw3901mb_write_sequence().
+     * 
+     * @param[in] seq sequence
+     * @param[out] failed_step index of the failing step, the sequence size on success, can be nullptr
+     * @return uint8_t status code, 0 success, nonzero on error
+     */
+    template <std::size_t N>
+    uint8_t write_sequence(const std::array<reg_write, N>& seq, std::size_t* failed_step = nullptr){
+        uint8_t status_code = transport_.acquire();
+        if(status_code != 0) return status_code;
+
+        std::size_t i = 0;
+        for(i = 0; i < N; i++){
+            status_code = transport_.write(seq[i].addr, seq[i].value);
+            if(status_code != 0) break;
+
+            if(seq[i].delay_ms != 0U){
+                status_code = transport_.wait_ms(seq[i].delay_ms);
+                if(status_code != 0) break;
+            }
+        }
+
+        if(failed_step != nullptr) *failed_step = i;
+
+        transport_.release();
+        return status_code;
+    }
+
+    /**
+     * @brief Initialize the sensor, the same bus sequence as ee_pmw3901mb_init_driver().
+     * @note Readiness polls are bounded by their count, the transport has no time base.
+     */
+    uint8_t init(){
+        uint8_t status_code = write<regs::power_up_reset>(power_up_reset_value);
+        if(status_code != 0) return 1;
+
+        status_code = poll(EE_PMW3901MB_BOOT_TIMEOUT_MS, false, [this](bool& ready){
+            uint8_t id = 0;
+            uint8_t inv_id = 0;
+            uint8_t st = get_product_id(id);
+            if(st == 0) st = get_inverse_product_id(inv_id);
+            ready = (id == product_id_value && inv_id == inverse_product_id_value);
+            return st;
+        });
+        if(status_code != 0) return 1;
+
+        if(write_sequence(perf_opt_v2) != 0) return 1;
+        if(write<regs::observation>(0x00) != 0) return 1;
+
+        status_code = poll(EE_PMW3901MB_FRAME_TIMEOUT_MS, true, [this](bool& ready){
+            uint8_t observation = 0;
+            uint8_t st = read<regs::observation>(observation);
+            ready = (observation != 0x00);
+            return st;
+        });
+        if(status_code != 0) return 1;
+
+        return 0;
+    }
+
+    /**
+     * @brief Read motion, delta X/Y, surface quality and shutter in one transaction.
+     */
+    uint8_t get_motion_burst(ee_pmw3901mb_motion_burst_t& out){
+        uint8_t buf[regs::motion_burst::size];
+        uint8_t status_code = transport_.read(regs::motion_burst::addr, buf, sizeof(buf));
+        if(status_code != 0) return status_code;
+
+        out.motion      = buf[burst::motion];
+        out.observation = buf[burst::observation];
+        out.delta_x     = static_cast<int16_t>((buf[burst::delta_x_h] << 8) | buf[burst::delta_x_l]);
+        out.delta_y     = static_cast<int16_t>((buf[burst::delta_y_h] << 8) | buf[burst::delta_y_l]);
+        out.squal       = buf[burst::squal];
+        out.rawdata_sum = buf[burst::rawdata_sum];
+        out.max_rawdata = buf[burst::maximum_rawdata];
+        out.min_rawdata = buf[burst::minimum_rawdata];
+        out.shutter     = static_cast<uint16_t>((buf[burst::shutter_upper] << 8) | buf[burst::shutter_lower]);
+        return 0;
+    }
+
+    uint8_t get_product_id(uint8_t& value){ return read<regs::product_id>(value); }
+    uint8_t get_inverse_product_id(uint8_t& value){ return read<regs::inverse_product_id>(value); }
+    uint8_t power_up_reset(){ return write<regs::power_up_reset>(power_up_reset_value); }
+    uint8_t shutdown(){ return write<regs::shutdown>(0x00); }
+
+    Transport& transport(){ return transport_; }
+
+private:
+    // Calls check until it reports ready, at most as often as the C state machine polls
+    template <class Check>
+    uint8_t poll(uint32_t timeout_ms, bool wait_first, Check check){
+        constexpr uint32_t poll_ms = (EE_PMW3901MB_STARTUP_POLL_US + 999U) / 1000U;
+        const uint32_t max_polls = (timeout_ms * 1000U) / EE_PMW3901MB_STARTUP_POLL_US + 1U;
+        for(uint32_t polls = 0; polls < max_polls; polls++){
+            if((wait_first || polls > 0U) && transport_.wait_ms(poll_ms) != 0) return 1;
+            bool ready = false;
+            if(check(ready) != 0) return 1;
+            if(ready) return 0;
+        }
+        return 1;
+    }
+
+    Transport transport_;
+};
+
+
+} // namespace pmw3901mb
+} // namespace ee
+
+
+#endif /* _EE_PMW3901MB_HPP_ */
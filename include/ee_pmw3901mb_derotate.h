@@ -0,0 +1,172 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_derotate.h
+ * 
+ * @brief EngEmil PMW3901MB Gyro De-Rotation.
+ * 
+ * Removes the flow caused by rotation of the sensor from its deltas, leaving the flow of
+ * translation. Time stamped gyro rates are kept in a small ring; for each flow sample the
+ * rate is interpolated linearly between the gyro samples and integrated over the interval the
+ * sample covers, and the rotation angle times the counts per radian is subtracted.
+ * 
+ * Rates are in the module frame of docs/images/module_orientation.png (+X right, +Y front,
+ * right-handed rotations). Not thread safe: push the gyro samples and apply the flow samples
+ * from one thread, or under a lock.
+ */
+
+#ifndef _EE_PMW3901MB_DEROTATE_
+#define _EE_PMW3901MB_DEROTATE_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+/**
+ * @brief Number of gyro samples kept, must be a power of two.
+ * @note Must cover the interval of a flow sample plus its latency at the gyro rate, e.g. 16 ms
+ *       at 1 kHz with the default.
+ */
+#if !defined(EE_PMW3901MB_DEROTATE_GYRO_SIZE)
+#define EE_PMW3901MB_DEROTATE_GYRO_SIZE     32U
+#endif
+
+#if (EE_PMW3901MB_DEROTATE_GYRO_SIZE < 2U) || ((EE_PMW3901MB_DEROTATE_GYRO_SIZE & (EE_PMW3901MB_DEROTATE_GYRO_SIZE - 1U)) != 0U)
+#error "EE_PMW3901MB_DEROTATE_GYRO_SIZE must be a power of two"
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Time stamped gyro sample.
+ */
+typedef struct {
+    uint32_t time_us;   /**< Time stamp, on the time base of ee_pmw3901mb_time_us() */
+    float rate_x;       /**< Rate about module X, rad/s */
+    float rate_y;       /**< Rate about module Y, rad/s */
+} ee_pmw3901mb_gyro_sample_t;
+
+/**
+ * @brief De-rotation configuration.
+ */
+typedef struct {
+    float counts_per_rad[2][2]; /**< Flow counts per radian, rows flow X/Y, columns rotation about X/Y */
+    uint32_t latency_us;        /**< Delay of the flow interval behind the read time stamp */
+} ee_pmw3901mb_derotate_cfg_t;
+
+/**
+ * @brief De-rotation stage of one sensor.
+ */
+typedef struct {
+    ee_pmw3901mb_derotate_cfg_t cfg;                                /**< Configuration */
+    ee_pmw3901mb_gyro_sample_t gyro[EE_PMW3901MB_DEROTATE_GYRO_SIZE];   /**< Gyro ring */
+    uint32_t gyro_n;                                                /**< Gyro samples pushed */
+    uint32_t last_us;                                               /**< Read time stamp of the last flow sample */
+    bool started;                                                   /**< A flow sample was applied */
+    float carry_x;                                                  /**< Fractional counts not yet output */
+    float carry_y;
+    float rot_x;                                                    /**< Rotational flow of the last sample, counts */
+    float rot_y;
+    uint32_t uncovered;                                             /**< Flow samples not covered by gyro samples */
+} ee_pmw3901mb_derotate_t;
+
+
+/**
+ * @brief Get the default de-rotation configuration.
+ * @details Counts per radian from the PMW3901MB field of view (EE_PMW3901MB_FOV_MDEG over
+ *          EE_PMW3901MB_PIXELS): rotation about +X (front up) reads as +Y, rotation about +Y
+ *          (right down) as -X, as moving the sensor in that direction. No latency. Calibrate
+ *          the signs and scale of a mounting with the sensor rotated over a fixed surface.
+ * 
+ * @param[out] cfg pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_derotate_default_cfg(ee_pmw3901mb_derotate_cfg_t* cfg);
+
+/**
+ * @brief Initialize a de-rotation stage.
+ * 
+ * @param[out] d pointer to the de-rotation stage
+ * @param[in] cfg pointer to the configuration
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_derotate_init(ee_pmw3901mb_derotate_t* d, const ee_pmw3901mb_derotate_cfg_t* cfg);
+
+/**
+ * @brief Push a gyro sample, overwriting the oldest.
+ * 
+ * @param[in,out] d pointer to the de-rotation stage
+ * @param[in] time_us time stamp of the sample
+ * @param[in] rate_x rate about module X, rad/s
+ * @param[in] rate_y rate about module Y, rad/s
+ * @return uint8_t status code, 0 success, nonzero on error (e.g. time stamp before the last one)
+ */
+uint8_t ee_pmw3901mb_derotate_push_gyro(ee_pmw3901mb_derotate_t* d, uint32_t time_us, float rate_x, float rate_y);
+
+/**
+ * @brief Rotation angle over an interval, from the linearly interpolated gyro rate.
+ * @details Parts of the interval outside the kept gyro samples take the rate of the nearest one,
+ *          up to one gyro period after the newest sample counts as covered.
+ * 
+ * @param[in] d pointer to the de-rotation stage
+ * @param[in] start_us start of the interval
+ * @param[in] end_us end of the interval
+ * @param[out] angle_x pointer to the return value, angle about X in radians
+ * @param[out] angle_y pointer to the return value, angle about Y in radians
+ * @return uint8_t status code, 0 success, nonzero on error (3 when the gyro samples do not
+ *         cover the interval, with the angle of the held rates)
+ */
+uint8_t ee_pmw3901mb_derotate_angle(const ee_pmw3901mb_derotate_t* d, uint32_t start_us, uint32_t end_us,
+                                    float* angle_x, float* angle_y);
+
+/**
+ * @brief Remove the rotational flow from a flow sample.
+ * @details The sample covers the interval since the previous one, delayed by the configured
+ *          latency. The fractional counts are carried to the next sample, so the output sums
+ *          up without drift. The first sample only starts the interval and passes unchanged.
+ * 
+ * @param[in,out] d pointer to the de-rotation stage
+ * @param[in] time_us read time stamp of the sample, e.g. the chip select deassert of the motion burst
+ * @param[in] delta_x delta X in counts
+ * @param[in] delta_y delta Y in counts
+ * @param[out] out_x pointer to the return value, translational delta X in counts
+ * @param[out] out_y pointer to the return value, translational delta Y in counts
+ * @return uint8_t status code, 0 success, nonzero on error (3 when the gyro samples do not
+ *         cover the interval, still compensated with the held rates)
+ */
+uint8_t ee_pmw3901mb_derotate_apply(ee_pmw3901mb_derotate_t* d, uint32_t time_us, int16_t delta_x, int16_t delta_y,
+                                    int16_t* out_x, int16_t* out_y);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_DEROTATE_ */
@@ -41,6 +41,164 @@ extern "C"
 #endif
 
 
+/**
+ * @brief Number of bytes in a full motion burst frame.
+ */
+#define EE_PMW3901MB_MOTION_BURST_SIZE  12U
+
+/**
+ * @brief Motion register bit set when motion occurred since the last motion read.
+ */
+#define EE_PMW3901MB_MOTION_MOT         0x80U
+
+/**
+ * @brief Width and height of a raw data grab frame in pixels.
+ */
+#define EE_PMW3901MB_FRAME_WIDTH        35U
+
+/**
+ * @brief Number of bytes (pixels) in a raw data grab frame.
+ */
+#define EE_PMW3901MB_FRAME_SIZE         (EE_PMW3901MB_FRAME_WIDTH * EE_PMW3901MB_FRAME_WIDTH)
+
+/**
+ * @brief Maximum number of register reads without progress before a frame grab fails.
+ */
+#if !defined(EE_PMW3901MB_FRAME_GRAB_MAX_POLLS)
+#define EE_PMW3901MB_FRAME_GRAB_MAX_POLLS   1000U
+#endif
+
+/**
+ * @brief Maximum time from power up reset until the product ID pair reads back, in milliseconds.
+ */
+#if !defined(EE_PMW3901MB_BOOT_TIMEOUT_MS)
+#define EE_PMW3901MB_BOOT_TIMEOUT_MS        50U
+#endif
+
+/**
+ * @brief Maximum time from the end of the performance optimization sequence until the first
+ *        frame, in milliseconds.
+ */
+#if !defined(EE_PMW3901MB_FRAME_TIMEOUT_MS)
+#define EE_PMW3901MB_FRAME_TIMEOUT_MS       50U
+#endif
+
+/**
+ * @brief Interval of the readiness polls during initialization, in microseconds.
+ */
+#if !defined(EE_PMW3901MB_STARTUP_POLL_US)
+#define EE_PMW3901MB_STARTUP_POLL_US        1000U
+#endif
+
+/**
+ * @brief Motion burst frame.
+ * @note Filled from a single REG_MOTION_BURST read, i.e. one chip-select frame.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t motion;         /**< Motion register, bit 7 set when motion occurred */
+    uint8_t observation;    /**< Observation register */
+    int16_t delta_x;        /**< Delta X since last motion read */
+    int16_t delta_y;        /**< Delta Y since last motion read */
+    uint8_t squal;          /**< Surface quality */
+    uint8_t rawdata_sum;    /**< Sum of raw pixel data */
+    uint8_t max_rawdata;    /**< Max of raw pixel data */
+    uint8_t min_rawdata;    /**< Min of raw pixel data */
+    uint16_t shutter;       /**< Shutter value */
+} ee_pmw3901mb_motion_burst_t;
+
+/**
+ * @brief Register write step of a register write sequence.
+ */
+typedef struct {
+    uint8_t reg;        /**< Register address */
+    uint8_t value;      /**< Value to write */
+    uint8_t delay_ms;   /**< Delay after the write in milliseconds, 0 for none */
+} ee_pmw3901mb_reg_write_t;
+
+/**
+ * @brief Motion read interval statistics, from the chip select assert times of the reads.
+ */
+typedef struct {
+    uint32_t reads;     /**< Motion reads, one interval less */
+    uint32_t min_us;    /**< Min interval */
+    uint32_t max_us;    /**< Max interval */
+    float mean_us;      /**< Mean interval */
+    float m2;           /**< Sum of squared interval deviations from the mean (Welford) */
+    uint32_t last_us;   /**< Chip select assert time of the last motion read */
+} ee_pmw3901mb_jitter_t;
+
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+/**
+ * @brief Snapshot of the bus counters and latency histograms of a device.
+ */
+typedef struct {
+    ee_pmw3901mb_counters_t bus;                            /**< Bus counters */
+    ee_pmw3901mb_hist_t latency[EE_PMW3901MB_OP_COUNT];     /**< Latency per operation, indexed by ee_pmw3901mb_op_t */
+} ee_pmw3901mb_stats_t;
+#endif
+
+/**
+ * @brief Initialization state.
+ */
+typedef enum {
+    EE_PMW3901MB_STARTUP_IDLE = 0,  /**< Not started */
+    EE_PMW3901MB_STARTUP_BOOT,      /**< Polling product ID and inverse product ID after power up reset */
+    EE_PMW3901MB_STARTUP_BOOTED,    /**< Booted, held before the performance optimization sequence */
+    EE_PMW3901MB_STARTUP_TUNE,      /**< Writing the performance optimization sequence */
+    EE_PMW3901MB_STARTUP_FRAME,     /**< Polling the observation register for the first frame */
+    EE_PMW3901MB_STARTUP_READY,     /**< Initialized */
+    EE_PMW3901MB_STARTUP_FAILED,    /**< Failed, see failed_state */
+} ee_pmw3901mb_startup_state_t;
+
+/**
+ * @brief Initialization state machine of a device.
+ * @note Times are ee_pmw3901mb_time_us().
+ */
+typedef struct {
+    ee_pmw3901mb_startup_state_t state;         /**< Current state */
+    ee_pmw3901mb_startup_state_t failed_state;  /**< State that failed, on EE_PMW3901MB_STARTUP_FAILED */
+    size_t step;                                /**< Next step of the performance optimization sequence */
+    bool hold;                                  /**< Hold in EE_PMW3901MB_STARTUP_BOOTED after the boot */
+    uint32_t polls;                             /**< Readiness polls in the current state */
+    uint32_t start_us;                          /**< Power up reset */
+    uint32_t state_us;                          /**< Entry of the current state */
+    uint32_t due_us;                            /**< Next bus access */
+    uint32_t ready_us;                          /**< Time from power up reset to ready */
+} ee_pmw3901mb_startup_t;
+
+struct ee_pmw3901mb_dev;
+
+/**
+ * @brief Asynchronous motion burst completion callback.
+ * @note Called from the SPI interrupt, must not block or start a new transfer.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[in] burst pointer to the motion burst read
+ * @param[in] arg argument passed to ee_pmw3901mb_dev_get_motion_burst_async()
+ */
+typedef void (*ee_pmw3901mb_motion_burst_cb_t)(struct ee_pmw3901mb_dev* dev, const ee_pmw3901mb_motion_burst_t* burst, void* arg);
+
+/**
+ * @brief Device handle, one per sensor.
+ * @note The functions without a device handle operate on a driver internal default device.
+ */
+typedef struct ee_pmw3901mb_dev {
+    ee_pmw3901mb_spi_bus_t bus;                 /**< SPI bus of the sensor */
+    bool initialized;                           /**< Set when the initialization succeeded */
+    ee_pmw3901mb_motion_burst_t last_burst;     /**< Last motion burst read from the sensor */
+    ee_pmw3901mb_motion_burst_cb_t async_cb;    /**< Asynchronous motion burst completion callback */
+    void* async_arg;                            /**< Asynchronous motion burst completion callback argument */
+    uint32_t burst_assert_us;                   /**< Chip select assert time of the last motion burst, ee_pmw3901mb_time_us() */
+    uint32_t burst_deassert_us;                 /**< Chip select deassert time of the last motion burst */
+    ee_pmw3901mb_jitter_t jitter;               /**< Motion read interval statistics */
+    ee_pmw3901mb_startup_t startup;             /**< Initialization state machine */
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+    ee_pmw3901mb_hist_t latency[EE_PMW3901MB_OP_COUNT];    /**< Latency histograms, indexed by ee_pmw3901mb_op_t */
+    uint32_t async_start_us;                    /**< Start time of the asynchronous motion burst in flight */
+#endif
+} ee_pmw3901mb_dev_t;
+
+
 /**
  * @brief Initialize EngEmil PMW3901MB Driver.
  * 
@@ -50,6 +208,30 @@ extern "C"
  */
 uint8_t ee_pmw3901mb_init_driver(void* spid_p, void* spic_p);
 
+/**
+ * @brief Start a non-blocking initialization, advanced by ee_pmw3901mb_init_step().
+ * 
+ * @param[in] spid_p pointer to the platform specific SPI driver
+ * @param[in] spic_p pointer to the platform specific SPI Config
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_init_start(void* spid_p, void* spic_p);
+
+/**
+ * @brief Advance the non-blocking initialization.
+ * 
+ * @param[out] wait_us pointer to the time until the next step is due, 0 when done, can be NULL
+ * @return uint8_t status code, 0 success (in progress or done), nonzero on error
+ */
+uint8_t ee_pmw3901mb_init_step(uint32_t* wait_us);
+
+/**
+ * @brief Check if the initialization is done.
+ * 
+ * @return true when initialized
+ */
+bool ee_pmw3901mb_init_done(void);
+
 /**
  * @brief Get Product ID
  * 
@@ -75,6 +257,66 @@ uint8_t ee_pmw3901mb_get_revision_id(uint8_t* revision_id);
  */
 uint8_t ee_pmw3901mb_get_delta_x_y(int16_t* delta_x, int16_t* delta_y);
 
+/**
+ * @brief Get Motion Burst (motion, deltas, SQUAL, raw data statistics and shutter)
+ * 
+ * @param[out] burst pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_get_motion_burst(ee_pmw3901mb_motion_burst_t* burst);
+
+/**
+ * @brief Start an asynchronous Motion Burst read, completed in the callback.
+ * @pre A bus session must be acquired with ee_pmw3901mb_acquire(), and the SPI config
+ *      must have ee_pmw3901mb_spi_data_cb() as data_cb.
+ * 
+ * @param[in] cb completion callback, called from the SPI interrupt
+ * @param[in] arg completion callback argument
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_get_motion_burst_async(ee_pmw3901mb_motion_burst_cb_t cb, void* arg);
+
+/**
+ * @brief Get the chip select assert and deassert times of the last motion burst.
+ * 
+ * @param[out] assert_us pointer to the return value, can be NULL
+ * @param[out] deassert_us pointer to the return value, can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_get_burst_time(uint32_t* assert_us, uint32_t* deassert_us);
+
+/**
+ * @brief Get the motion read interval statistics.
+ * 
+ * @param[out] jitter pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_get_jitter(ee_pmw3901mb_jitter_t* jitter);
+
+/**
+ * @brief Reset the motion read interval statistics.
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_reset_jitter(void);
+
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+/**
+ * @brief Get the bus counters and latency histograms.
+ * 
+ * @param[out] stats pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_get_stats(ee_pmw3901mb_stats_t* stats);
+
+/**
+ * @brief Reset the bus counters and latency histograms.
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_reset_stats(void);
+#endif
+
 /**
  * @brief Power Up Reset
  * 
@@ -95,7 +337,7 @@ uint8_t ee_pmw3901mb_shutdown(void);
  * @param[out] inv_product_id pointer to the return value 
  * @return uint8_t status code, 0 success, nonzero on error
  */
-uint8_t ee_pmw3901mb_inverse_product_id(uint8_t* inv_product_id);
+uint8_t ee_pmw3901mb_get_inverse_product_id(uint8_t* inv_product_id);
 
 /**
  * @brief Run the PMW3901MB performance optimization sequence.
@@ -113,6 +355,349 @@ uint8_t ee_pmw3901mb_perf_opt(void);
  */
 uint8_t ee_pmw3901mb_perf_opt_v2(void);
 
+/**
+ * @brief Write a register write sequence in one bus session.
+ * 
+ * @param[in] seq pointer to the sequence
+ * @param[in] len number of steps in the sequence
+ * @param[out] failed_step index of the failing step (len on success), can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_write_sequence(const ee_pmw3901mb_reg_write_t* seq, size_t len, size_t* failed_step);
+
+/**
+ * @brief Put the sensor in raw data grab (frame capture) mode.
+ * @note Motion tracking stops, call ee_pmw3901mb_init_driver() to resume it.
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_grab_enable(void);
+
+/**
+ * @brief Grab one raw 35x35 pixel frame, row major.
+ * @pre Frame grab mode enabled with ee_pmw3901mb_frame_grab_enable().
+ * 
+ * @param[out] frame pointer to a EE_PMW3901MB_FRAME_SIZE byte buffer
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_grab(uint8_t* frame);
+
+/**
+ * @brief Acquire the bus of the sensor and keep it started until released.
+ * @note Wrap a group of calls (e.g. a polling loop) to skip per transaction SPI start/stop.
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_acquire(void);
+
+/**
+ * @brief Release the bus of the sensor acquired with ee_pmw3901mb_acquire().
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_release(void);
+
+
+/**
+ * @brief Get the default device, used by the functions without a device handle.
+ * 
+ * @return ee_pmw3901mb_dev_t* pointer to the default device handle
+ */
+ee_pmw3901mb_dev_t* ee_pmw3901mb_get_default_dev(void);
+
+/**
+ * @brief Initialize EngEmil PMW3901MB Driver for a device handle.
+ * @details Runs ee_pmw3901mb_dev_init_start() and ee_pmw3901mb_dev_init_step() to the end,
+ *          waiting between the steps.
+ * 
+ * @param[out] dev pointer to the device handle
+ * @param[in] spid_p pointer to the platform specific SPI driver
+ * @param[in] spic_p pointer to the platform specific SPI Config
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_init_driver(ee_pmw3901mb_dev_t* dev, void* spid_p, void* spic_p);
+
+/**
+ * @brief Start a non-blocking initialization of a device.
+ * @details Resets the sensor and returns. ee_pmw3901mb_dev_init_step() then polls the
+ *          product ID pair until the sensor booted, writes the performance optimization
+ *          sequence, and polls the observation register until the first frame, each poll
+ *          bounded by a timeout. Between steps the bus is released, so other bus users
+ *          and other work can overlap with the initialization.
+ * 
+ * @param[out] dev pointer to the device handle
+ * @param[in] spid_p pointer to the platform specific SPI driver
+ * @param[in] spic_p pointer to the platform specific SPI Config
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_init_start(ee_pmw3901mb_dev_t* dev, void* spid_p, void* spic_p);
+
+/**
+ * @brief Advance the non-blocking initialization of a device.
+ * @note Steps can be called early, a step not yet due returns the remaining wait.
+ * 
+ * @param[in,out] dev pointer to the device handle
+ * @param[out] wait_us pointer to the time until the next step is due, 0 when done or held
+ *                    after the boot, can be NULL
+ * @return uint8_t status code, 0 success (in progress or done), nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_init_step(ee_pmw3901mb_dev_t* dev, uint32_t* wait_us);
+
+/**
+ * @brief Run the initialization of a device started with ee_pmw3901mb_dev_init_start() or
+ *        ee_pmw3901mb_dev_retune_start() to the end, waiting between the steps.
+ * @note A start with ee_pmw3901mb_dev_boot_start() runs up to the boot.
+ * 
+ * @param[in,out] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_init_finish(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Start re-applying the performance optimization sequence without a power up reset.
+ * @details For a sensor that lost its tuning (e.g. reset by a brown-out) but still answers
+ *          with its product ID pair. Continues with ee_pmw3901mb_dev_init_step() or
+ *          ee_pmw3901mb_dev_init_finish() from writing the sequence, keeping the handle state.
+ * @pre The device bus must be initialized.
+ * 
+ * @param[in,out] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_retune_start(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Start a power up reset of an initialized device, held after the boot.
+ * @details Wakes the sensor from shutdown without the performance optimization sequence.
+ *          ee_pmw3901mb_dev_init_step() polls the boot and stops in
+ *          EE_PMW3901MB_STARTUP_BOOTED, where the sensor delivers untuned frames, until
+ *          ee_pmw3901mb_dev_retune_start() continues with the sequence.
+ * @pre The device bus must be initialized.
+ * 
+ * @param[in,out] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_boot_start(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Check if the sensor still holds the performance optimization sequence.
+ * @details Reads back the last bank 0 register written by the sequence, which returns to its
+ *          power up value when the sensor resets on its own (e.g. on a brown-out).
+ * @pre Bank 0 must be selected.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] tuned pointer to the return value, true when the register holds the written value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_check_tuning(ee_pmw3901mb_dev_t* dev, bool* tuned);
+
+/**
+ * @brief Check if the initialization of a device is done.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return true when initialized
+ */
+bool ee_pmw3901mb_dev_init_done(const ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Get Product ID of a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] product_id pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_product_id(ee_pmw3901mb_dev_t* dev, uint8_t* product_id);
+
+/**
+ * @brief Get Revision ID of a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] revision_id pointer to the return value 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_revision_id(ee_pmw3901mb_dev_t* dev, uint8_t* revision_id);
+
+/**
+ * @brief Get Delta X and Delta Y of a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] delta_x pointer to the return value 
+ * @param[out] delta_y pointer to the return value 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_delta_x_y(ee_pmw3901mb_dev_t* dev, int16_t* delta_x, int16_t* delta_y);
+
+/**
+ * @brief Get Motion Burst of a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] burst pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_motion_burst(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_t* burst);
+
+/**
+ * @brief Start an asynchronous Motion Burst read of a device, completed in the callback.
+ * @details The caller returns as soon as the transfer is started. On completion the burst is
+ *          decoded, stored as last_burst of the device and passed to the callback.
+ * @pre A bus session must be acquired with ee_pmw3901mb_dev_acquire(), and the SPI config
+ *      must have ee_pmw3901mb_spi_data_cb() as data_cb.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[in] cb completion callback, called from the SPI interrupt
+ * @param[in] arg completion callback argument
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_motion_burst_async(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_cb_t cb, void* arg);
+
+/**
+ * @brief Get the chip select assert and deassert times of the last motion burst of a device.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] assert_us pointer to the return value, can be NULL
+ * @param[out] deassert_us pointer to the return value, can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_burst_time(ee_pmw3901mb_dev_t* dev, uint32_t* assert_us, uint32_t* deassert_us);
+
+/**
+ * @brief Get the motion read interval statistics of a device.
+ * @note Updated by the motion burst reads, call from the thread reading the device.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] jitter pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_jitter(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_jitter_t* jitter);
+
+/**
+ * @brief Reset the motion read interval statistics of a device.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_reset_jitter(ee_pmw3901mb_dev_t* dev);
+
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+/**
+ * @brief Get the bus counters and latency histograms of a device.
+ * @note Not synchronized with reads in progress on other threads, a snapshot may be torn.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] stats pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_stats(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_stats_t* stats);
+
+/**
+ * @brief Reset the bus counters and latency histograms of a device.
+ * @note The statistics are kept across ee_pmw3901mb_dev_init_driver(), which requires a
+ *       zeroed (e.g. static) handle before the first initialization.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_reset_stats(ee_pmw3901mb_dev_t* dev);
+#endif
+
+/**
+ * @brief Get the (population) variance of the motion read interval.
+ * 
+ * @param[in] jitter pointer to the interval statistics
+ * @return float variance in microseconds squared, 0 without intervals
+ */
+float ee_pmw3901mb_jitter_variance(const ee_pmw3901mb_jitter_t* jitter);
+
+/**
+ * @brief Power Up Reset of a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_power_up_reset(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Shutdown a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_shutdown(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Get Inverse Product ID of a device
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] inv_product_id pointer to the return value 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_get_inverse_product_id(ee_pmw3901mb_dev_t* dev, uint8_t* inv_product_id);
+
+/**
+ * @brief Run the PMW3901MB performance optimization sequence on a device.
+ * @pre The device bus must be initialized.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_perf_opt(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Run the PMW3901MB performance optimization sequence version 2 on a device.
+ * @pre The device bus must be initialized.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_perf_opt_v2(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Write a register write sequence to a device in one bus session.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[in] seq pointer to the sequence
+ * @param[in] len number of steps in the sequence
+ * @param[out] failed_step index of the failing step (len on success), can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_write_sequence(ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_reg_write_t* seq, size_t len, size_t* failed_step);
+
+/**
+ * @brief Put a device in raw data grab (frame capture) mode.
+ * @note Motion tracking stops, call ee_pmw3901mb_dev_init_driver() to resume it.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_frame_grab_enable(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Grab one raw 35x35 pixel frame of a device, row major.
+ * @details The trigger, grab status polling and the 2 reads per pixel share one bus session.
+ * @pre Frame grab mode enabled with ee_pmw3901mb_dev_frame_grab_enable().
+ * 
+ * @param[in] dev pointer to the device handle
+ * @param[out] frame pointer to a EE_PMW3901MB_FRAME_SIZE byte buffer
+ * @return uint8_t status code, 0 success, 2 grab not ready, 3 pixel data stalled, other nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_frame_grab(ee_pmw3901mb_dev_t* dev, uint8_t* frame);
+
+/**
+ * @brief Acquire the bus of a device and keep it started until released.
+ * @note Wrap a group of calls (e.g. a polling loop) to skip per transaction SPI start/stop.
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_acquire(ee_pmw3901mb_dev_t* dev);
+
+/**
+ * @brief Release the bus of a device acquired with ee_pmw3901mb_dev_acquire().
+ * 
+ * @param[in] dev pointer to the device handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_dev_release(ee_pmw3901mb_dev_t* dev);
+
 
 #ifdef __cplusplus
 }
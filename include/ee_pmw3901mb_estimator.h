@@ -0,0 +1,162 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_estimator.h
+ * 
+ * @brief EngEmil PMW3901MB Velocity and Position Estimator.
+ * 
+ * Kalman filter of a constant velocity model per axis, fusing the deltas of each sample as a
+ * velocity measurement (from the height above the surface and the sample interval), with the
+ * measurement noise scaled by the quality score of the sample. Innovations beyond a gate are
+ * rejected as glitches. Statically sized state in single precision, no heap.
+ * 
+ * Both axes see the same intervals, heights and scores, so they share one covariance: one
+ * 2x2 update serves both axes.
+ */
+
+#ifndef _EE_PMW3901MB_ESTIMATOR_
+#define _EE_PMW3901MB_ESTIMATOR_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+/**
+ * @brief Consecutive gated samples after which the next one is taken anyway (e.g. after a real
+ *        step in velocity the model did not expect).
+ */
+#if !defined(EE_PMW3901MB_ESTIMATOR_MAX_REJECTS)
+#define EE_PMW3901MB_ESTIMATOR_MAX_REJECTS  3U
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Estimator configuration.
+ */
+typedef struct {
+    float accel_noise;      /**< Process noise, rms acceleration in mm/s^2 */
+    float count_noise;      /**< Measurement noise of a delta at full quality, rms counts */
+    float velocity_std;     /**< Initial velocity uncertainty, mm/s */
+    float gate_sigma;       /**< Innovations beyond this many standard deviations are rejected, 0 disables */
+    uint8_t min_score;      /**< Samples scoring below are not fused (time update only) */
+} ee_pmw3901mb_estimator_cfg_t;
+
+/**
+ * @brief Estimator state.
+ */
+typedef struct {
+    ee_pmw3901mb_estimator_cfg_t cfg;   /**< Configuration */
+    float rad_per_count;                /**< Angle of a count */
+    float pos[2];                       /**< Position X/Y, mm */
+    float vel[2];                       /**< Velocity X/Y, mm/s */
+    float p_pp;                         /**< Covariance of each axis, position variance (mm^2) */
+    float p_pv;                         /**< Position velocity covariance (mm^2/s) */
+    float p_vv;                         /**< Velocity variance (mm^2/s^2) */
+    uint32_t updates;                   /**< Fused samples */
+    uint32_t skipped;                   /**< Samples below the min score */
+    uint32_t rejected;                  /**< Samples beyond the gate */
+    uint8_t rejects;                    /**< Consecutive rejected samples */
+} ee_pmw3901mb_estimator_t;
+
+/**
+ * @brief Estimate with standard deviations.
+ */
+typedef struct {
+    float x_mm;             /**< Position X */
+    float y_mm;             /**< Position Y */
+    float vx_mm_s;          /**< Velocity X */
+    float vy_mm_s;          /**< Velocity Y */
+    float pos_std_mm;       /**< Position standard deviation of each axis */
+    float vel_std_mm_s;     /**< Velocity standard deviation of each axis */
+} ee_pmw3901mb_estimate_t;
+
+
+/**
+ * @brief Get the default estimator configuration.
+ * @details 2000 mm/s^2 acceleration, 0.5 counts (quantization and noise), 1000 mm/s initial
+ *          velocity uncertainty, 5 sigma gate, and the default quality gate threshold.
+ * 
+ * @param[out] cfg pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_estimator_default_cfg(ee_pmw3901mb_estimator_cfg_t* cfg);
+
+/**
+ * @brief Initialize an estimator at rest at the origin.
+ * 
+ * @param[out] est pointer to the estimator
+ * @param[in] cfg pointer to the configuration
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_estimator_init(ee_pmw3901mb_estimator_t* est, const ee_pmw3901mb_estimator_cfg_t* cfg);
+
+/**
+ * @brief Time update only, e.g. for a sample that was not read.
+ * 
+ * @param[in,out] est pointer to the estimator
+ * @param[in] dt_us time since the last update in microseconds
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_estimator_predict(ee_pmw3901mb_estimator_t* est, uint32_t dt_us);
+
+/**
+ * @brief Fuse the deltas of a sample.
+ * @details The deltas over the interval measure the mean velocity. The measurement noise grows
+ *          with the square of full over score, samples scoring below the min score or beyond
+ *          the gate only advance the time.
+ * 
+ * @param[in,out] est pointer to the estimator
+ * @param[in] delta_x delta X in counts
+ * @param[in] delta_y delta Y in counts
+ * @param[in] dt_us sample interval in microseconds
+ * @param[in] height_mm height above the surface in millimeters, nonzero
+ * @param[in] score quality score of the sample (ee_pmw3901mb_quality_score()), EE_PMW3901MB_QUALITY_SCORE_MAX without quality gate
+ * @return uint8_t status code, 0 fused, nonzero on error (2 zero sample interval or height, 3 below the min score,
+ *         4 beyond the gate)
+ */
+uint8_t ee_pmw3901mb_estimator_update(ee_pmw3901mb_estimator_t* est, int16_t delta_x, int16_t delta_y,
+                                      uint32_t dt_us, uint16_t height_mm, uint8_t score);
+
+/**
+ * @brief Get the estimate.
+ * 
+ * @param[in] est pointer to the estimator
+ * @param[out] estimate pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_estimator_get(const ee_pmw3901mb_estimator_t* est, ee_pmw3901mb_estimate_t* estimate);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_ESTIMATOR_ */
@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/**
+ * @file ee_pmw3901mb_frame_capture.h
+ * 
+ * @brief EngEmil PMW3901MB Continuous Frame Capture.
+ * 
+ * Double buffered raw frame capture. A capture thread (producer) grabs frames with
+ * ee_pmw3901mb_frame_capture_next() while a consumer works on the latest complete frame
+ * taken with ee_pmw3901mb_frame_capture_get(). Lock-free: each buffer has a state moved
+ * with atomic compare-and-swap, a frame not taken before the next one completes is dropped.
+ */
+
+#ifndef _EE_PMW3901MB_FRAME_CAPTURE_
+#define _EE_PMW3901MB_FRAME_CAPTURE_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Frame buffer state.
+ */
+typedef enum {
+    EE_PMW3901MB_FRAME_FREE = 0,    /**< Empty, can be filled */
+    EE_PMW3901MB_FRAME_FILLING,     /**< Being grabbed, producer owned */
+    EE_PMW3901MB_FRAME_READY,       /**< Complete frame, not taken yet */
+    EE_PMW3901MB_FRAME_HELD         /**< Taken by the consumer */
+} ee_pmw3901mb_frame_state_t;
+
+/**
+ * @brief Continuous frame capture.
+ */
+typedef struct {
+    ee_pmw3901mb_dev_t* dev;        /**< Device grabbed from */
+    uint8_t* buffers[2];            /**< Caller supplied EE_PMW3901MB_FRAME_SIZE byte buffers */
+    volatile uint8_t state[2];      /**< ee_pmw3901mb_frame_state_t of each buffer */
+    volatile uint32_t seq[2];       /**< Frame number of each buffer */
+    uint8_t held;                   /**< Buffer taken by the consumer */
+    volatile uint32_t frames;       /**< Frames grabbed */
+    volatile uint32_t dropped;      /**< Frames overwritten before taken */
+    volatile uint32_t errors;       /**< Failed grabs */
+} ee_pmw3901mb_frame_capture_t;
+
+
+/**
+ * @brief Initialize a capture and put the device in frame grab mode.
+ * @note Not thread safe, call before the producer and consumer start.
+ * 
+ * @param[out] cap pointer to the capture
+ * @param[in] dev pointer to the device handle
+ * @param[in] buf0 first EE_PMW3901MB_FRAME_SIZE byte buffer
+ * @param[in] buf1 second EE_PMW3901MB_FRAME_SIZE byte buffer
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_capture_init(ee_pmw3901mb_frame_capture_t* cap, ee_pmw3901mb_dev_t* dev, uint8_t* buf0, uint8_t* buf1);
+
+/**
+ * @brief Grab the next frame into the buffer not held by the consumer, producer side.
+ * 
+ * @param[in] cap pointer to the capture
+ * @return uint8_t status code, 0 success, 2 no free buffer, other nonzero on grab error
+ */
+uint8_t ee_pmw3901mb_frame_capture_next(ee_pmw3901mb_frame_capture_t* cap);
+
+/**
+ * @brief Take the latest complete frame, consumer side.
+ * @note The frame stays valid until ee_pmw3901mb_frame_capture_release().
+ * 
+ * @param[in] cap pointer to the capture
+ * @param[out] frame pointer to the return value, the frame pixels
+ * @param[out] seq pointer to the return value, the frame number, can be NULL
+ * @return uint8_t status code, 0 success, 2 no new frame, other nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_capture_get(ee_pmw3901mb_frame_capture_t* cap, const uint8_t** frame, uint32_t* seq);
+
+/**
+ * @brief Hand the frame taken with ee_pmw3901mb_frame_capture_get() back, consumer side.
+ * 
+ * @param[in] cap pointer to the capture
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_capture_release(ee_pmw3901mb_frame_capture_t* cap);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_FRAME_CAPTURE_ */
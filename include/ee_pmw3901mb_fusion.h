@@ -0,0 +1,156 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_fusion.h
+ * 
+ * @brief EngEmil PMW3901MB Rigid Body Fusion.
+ * 
+ * Combines the deltas of two or more sensors mounted at known positions and rotations on a
+ * rigid body into the body translation and yaw of the sample, by a weighted least-squares fit
+ * of a planar rigid motion. The fit is closed-form, in a fixed number of operations for the
+ * configured number of sensors, in single precision.
+ * 
+ * The body frame is the one of docs/images/module_orientation.png: +Y to the front, +X to the
+ * right, yaw positive from +X towards +Y. A module mounted as pictured has rotation 0.
+ */
+
+#ifndef _EE_PMW3901MB_FUSION_
+#define _EE_PMW3901MB_FUSION_
+
+#include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_quality.h"
+
+
+/**
+ * @brief Max sensors of a fusion.
+ */
+#if !defined(EE_PMW3901MB_FUSION_MAX_SENSORS)
+#define EE_PMW3901MB_FUSION_MAX_SENSORS     4U
+#endif
+
+#if (EE_PMW3901MB_FUSION_MAX_SENSORS < 2U)
+#error "EE_PMW3901MB_FUSION_MAX_SENSORS must be at least 2"
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Mounting pose of a sensor on the body.
+ */
+typedef struct {
+    float x_mm;         /**< Position X in the body frame */
+    float y_mm;         /**< Position Y in the body frame */
+    int32_t yaw_mdeg;   /**< Rotation of the module from the pictured orientation, from +X towards +Y, in millidegrees */
+} ee_pmw3901mb_mount_t;
+
+/**
+ * @brief Sample of one sensor.
+ */
+typedef struct {
+    int16_t delta_x;    /**< Delta X in counts, in the module frame */
+    int16_t delta_y;    /**< Delta Y in counts, in the module frame */
+    uint8_t weight;     /**< Weight in the fit (e.g. the quality score), 0 leaves the sensor out */
+} ee_pmw3901mb_fusion_input_t;
+
+/**
+ * @brief Rigid body motion of a sample.
+ */
+typedef struct {
+    float dx_mm;        /**< Translation X of the body origin */
+    float dy_mm;        /**< Translation Y of the body origin */
+    float dyaw_rad;     /**< Yaw */
+    float rms_mm;       /**< Weighted RMS residual of the sensors, disagreement with a rigid motion */
+    uint8_t sensors;    /**< Sensors with nonzero weight */
+} ee_pmw3901mb_rigid_motion_t;
+
+/**
+ * @brief Rigid body fusion of N sensors.
+ */
+typedef struct {
+    size_t n;                                           /**< Number of sensors */
+    float x_mm[EE_PMW3901MB_FUSION_MAX_SENSORS];        /**< Positions X */
+    float y_mm[EE_PMW3901MB_FUSION_MAX_SENSORS];        /**< Positions Y */
+    float cos_yaw[EE_PMW3901MB_FUSION_MAX_SENSORS];     /**< Module to body rotations */
+    float sin_yaw[EE_PMW3901MB_FUSION_MAX_SENSORS];
+    float rad_per_count;                                /**< Angle of a count */
+} ee_pmw3901mb_fusion_t;
+
+
+/**
+ * @brief Initialize a fusion from the mounting poses.
+ * @details The angle of a count is taken from the PMW3901MB field of view
+ *          (EE_PMW3901MB_FOV_MDEG over EE_PMW3901MB_PIXELS).
+ * 
+ * @param[out] fusion pointer to the fusion
+ * @param[in] mounts mounting poses of the sensors
+ * @param[in] n number of sensors, 2 to EE_PMW3901MB_FUSION_MAX_SENSORS
+ * @return uint8_t status code, 0 success, nonzero on error (e.g. all sensors at one position)
+ */
+uint8_t ee_pmw3901mb_fusion_init(ee_pmw3901mb_fusion_t* fusion, const ee_pmw3901mb_mount_t* mounts, size_t n);
+
+/**
+ * @brief Solve the rigid body motion of a sample.
+ * @details The fit is linear in the yaw, with an error of the order of yaw^2 / 2 times the
+ *          sensor distance, e.g. 0.05 % of it at 1.8 degrees per sample.
+ * 
+ * @param[in] fusion pointer to the fusion
+ * @param[in] inputs samples of the sensors, taken at the same time, in the order of the mounts
+ * @param[in] height_mm height above the surface in millimeters
+ * @param[out] motion pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error (e.g. fewer than two weighted sensors
+ *         at distinct positions, then the translation is the weighted mean and the yaw 0)
+ */
+uint8_t ee_pmw3901mb_fusion_solve(const ee_pmw3901mb_fusion_t* fusion, const ee_pmw3901mb_fusion_input_t* inputs,
+                                  uint16_t height_mm, ee_pmw3901mb_rigid_motion_t* motion);
+
+/**
+ * @brief Read the sensors back-to-back and solve the rigid body motion.
+ * @details The samples are weighted by the quality score, sensors gated with the drop action are
+ *          left out. The sensors are read within a few hundred microseconds, read them at the
+ *          same rate so their deltas cover the same interval.
+ * 
+ * @param[in] fusion pointer to the fusion
+ * @param[in,out] devs device handles, in the order of the mounts
+ * @param[in] quality pointer to the quality gate configuration, NULL for equal weights
+ * @param[in] height_mm height above the surface in millimeters
+ * @param[out] motion pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_fusion_read(const ee_pmw3901mb_fusion_t* fusion, ee_pmw3901mb_dev_t* const* devs,
+                                 const ee_pmw3901mb_quality_cfg_t* quality, uint16_t height_mm,
+                                 ee_pmw3901mb_rigid_motion_t* motion);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_FUSION_ */
@@ -0,0 +1,174 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_health.h
+ * 
+ * @brief EngEmil PMW3901MB Health Monitor.
+ * 
+ * Detects a sensor that stopped delivering valid data, from the motion bursts it returns
+ * (all 0xFF from a floating MISO line, all 0x00 from a sensor in reset or shutdown, the same
+ * frame with motion repeated from a frozen motion pipeline) and from a periodic check of the
+ * product ID pair and of the tuning (a reset on its own, e.g. on a brown-out, loses it).
+ * Recovery takes the cheapest path that brings the sensor back: nothing for a transient bus
+ * glitch, a bank select for a lost bank, the performance optimization sequence for a lost
+ * tuning, and a full initialization otherwise.
+ */
+
+#ifndef _EE_PMW3901MB_HEALTH_
+#define _EE_PMW3901MB_HEALTH_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Status code of ee_pmw3901mb_health_get_motion_burst() when a fault was detected.
+ */
+#define EE_PMW3901MB_HEALTH_FAULT   0x40U
+
+/**
+ * @brief Detected fault.
+ */
+typedef enum {
+    EE_PMW3901MB_HEALTH_OK = 0,         /**< No fault */
+    EE_PMW3901MB_HEALTH_BUS_ERROR,      /**< Transfer refused by the bus */
+    EE_PMW3901MB_HEALTH_ALL_ONES,       /**< Motion burst all 0xFF, the sensor does not drive MISO */
+    EE_PMW3901MB_HEALTH_ALL_ZEROS,      /**< Motion burst all 0x00, the sensor is in reset or shutdown */
+    EE_PMW3901MB_HEALTH_STUCK,          /**< Same motion burst with motion repeated, the motion pipeline is frozen */
+    EE_PMW3901MB_HEALTH_ID_MISMATCH,    /**< Product ID pair does not read back */
+    EE_PMW3901MB_HEALTH_TUNING_LOST,    /**< Performance optimization sequence lost, the sensor reset on its own */
+} ee_pmw3901mb_health_fault_t;
+
+/**
+ * @brief Recovery path taken.
+ */
+typedef enum {
+    EE_PMW3901MB_RECOVERY_NONE = 0,     /**< Sensor found healthy, nothing replayed */
+    EE_PMW3901MB_RECOVERY_BANK,         /**< Bank 0 selected again */
+    EE_PMW3901MB_RECOVERY_RETUNE,       /**< Performance optimization sequence written again */
+    EE_PMW3901MB_RECOVERY_FULL,         /**< Full initialization */
+} ee_pmw3901mb_recovery_t;
+
+/**
+ * @brief Health monitor configuration.
+ */
+typedef struct {
+    uint32_t check_period_us;   /**< Interval of the product ID pair and tuning checks, 0 disables */
+    uint8_t stuck_limit;        /**< Same motion bursts with motion in a row reported as stuck, 0 disables */
+    bool check_tuning;          /**< Check the tuning with the product ID pair */
+} ee_pmw3901mb_health_cfg_t;
+
+/**
+ * @brief Health monitor of a device.
+ * @note Times are ee_pmw3901mb_time_us().
+ */
+typedef struct {
+    ee_pmw3901mb_dev_t* dev;                /**< Monitored device */
+    ee_pmw3901mb_health_cfg_t cfg;          /**< Configuration */
+    ee_pmw3901mb_health_fault_t fault;      /**< Fault to recover from, EE_PMW3901MB_HEALTH_OK when healthy */
+    ee_pmw3901mb_motion_burst_t last;       /**< Last motion burst */
+    uint8_t repeats;                        /**< Repeats of the last motion burst with motion */
+    uint32_t check_us;                      /**< Last product ID pair check */
+    uint32_t fault_us;                      /**< Detection of the fault */
+    uint32_t faults;                        /**< Detected faults */
+    uint8_t attempts;                       /**< Recoveries since the last passed check, escalate the path */
+    uint32_t recoveries[EE_PMW3901MB_RECOVERY_FULL + 1];   /**< Recoveries per path, indexed by ee_pmw3901mb_recovery_t */
+    ee_pmw3901mb_recovery_t last_recovery;  /**< Path of the last recovery */
+    uint32_t last_recovery_us;              /**< Duration of the last recovery */
+} ee_pmw3901mb_health_t;
+
+
+/**
+ * @brief Get the default health monitor configuration.
+ * @details Checks the product ID pair and the tuning every 100 ms (3 register reads), and
+ *          reports a motion burst with motion repeated 16 times in a row as stuck.
+ * 
+ * @param[out] cfg pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_health_default_cfg(ee_pmw3901mb_health_cfg_t* cfg);
+
+/**
+ * @brief Initialize a health monitor.
+ * 
+ * @param[out] health pointer to the health monitor
+ * @param[in] dev pointer to the monitored device handle
+ * @param[in] cfg pointer to the configuration, NULL for the default
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_health_init(ee_pmw3901mb_health_t* health, ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_health_cfg_t* cfg);
+
+/**
+ * @brief Check a motion burst for fault patterns, without bus traffic.
+ * 
+ * @param[in,out] health pointer to the health monitor
+ * @param[in] burst pointer to the motion burst
+ * @return ee_pmw3901mb_health_fault_t detected fault, EE_PMW3901MB_HEALTH_OK for none
+ */
+ee_pmw3901mb_health_fault_t ee_pmw3901mb_health_check_burst(ee_pmw3901mb_health_t* health, const ee_pmw3901mb_motion_burst_t* burst);
+
+/**
+ * @brief Check the product ID pair and the tuning of the sensor.
+ * 
+ * @param[in,out] health pointer to the health monitor
+ * @return ee_pmw3901mb_health_fault_t detected fault, EE_PMW3901MB_HEALTH_OK for none
+ */
+ee_pmw3901mb_health_fault_t ee_pmw3901mb_health_check(ee_pmw3901mb_health_t* health);
+
+/**
+ * @brief Read a motion burst and check it, and the product ID pair when the check period passed.
+ * @details A detected fault is kept until ee_pmw3901mb_health_recover().
+ * 
+ * @param[in,out] health pointer to the health monitor
+ * @param[out] burst pointer to the return value
+ * @return uint8_t status code, 0 success, EE_PMW3901MB_HEALTH_FAULT when a fault was
+ *         detected (the burst is not valid), other nonzero on error
+ */
+uint8_t ee_pmw3901mb_health_get_motion_burst(ee_pmw3901mb_health_t* health, ee_pmw3901mb_motion_burst_t* burst);
+
+/**
+ * @brief Recover from the detected fault with the cheapest path that passes the checks.
+ * @details A stuck motion pipeline always takes a full initialization. A fault detected again
+ *          before a periodic check passed (or a valid burst, with the checks disabled) starts
+ *          from a retune on the second attempt and from a full initialization after.
+ * @note Blocks for the waits of the path taken, up to a full initialization.
+ * 
+ * @param[in,out] health pointer to the health monitor
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_health_recover(ee_pmw3901mb_health_t* health);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_HEALTH_ */
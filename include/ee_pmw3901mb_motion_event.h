@@ -0,0 +1,205 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_motion_event.h
+ * 
+ * @brief EngEmil PMW3901MB Motion Event Acquisition.
+ * 
+ * Event-driven acquisition on the sensor motion (MOT) line. A PAL edge callback on the
+ * falling edge of the motion line wakes a reader thread, which burst-reads the sensor
+ * only while it flags motion and puts each sample on a queue. An optional quality gate
+ * (ee_pmw3901mb_quality.h) drops or flags low confidence samples before they are queued.
+ * While the line stays asserted after a failed read or a bounded number of reads, no new
+ * edge comes, so the thread reads again after a retry interval until the line is released.
+ * 
+ * @note Requires PAL_USE_CALLBACKS and CH_CFG_USE_OBJ_FIFOS, and is enabled by defining
+ *       EE_PMW3901MB_USE_MOTION_EVENT to TRUE (e.g. in the Makefile UDEFS).
+ */
+
+#ifndef _EE_PMW3901MB_MOTION_EVENT_
+#define _EE_PMW3901MB_MOTION_EVENT_
+
+#include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_quality.h"
+
+
+/**
+ * @brief Enables the motion event acquisition.
+ */
+#if !defined(EE_PMW3901MB_USE_MOTION_EVENT)
+#define EE_PMW3901MB_USE_MOTION_EVENT       FALSE
+#endif
+
+/**
+ * @brief Number of samples the motion event queue can hold.
+ */
+#if !defined(EE_PMW3901MB_MOTION_EVENT_QUEUE_SIZE)
+#define EE_PMW3901MB_MOTION_EVENT_QUEUE_SIZE    8U
+#endif
+
+/**
+ * @brief Retry interval in microseconds while the motion line stays asserted.
+ */
+#if !defined(EE_PMW3901MB_MOTION_EVENT_RETRY_US)
+#define EE_PMW3901MB_MOTION_EVENT_RETRY_US      1000U
+#endif
+
+/**
+ * @brief Max retry interval in microseconds, the interval doubles on each failed read up to it.
+ */
+#if !defined(EE_PMW3901MB_MOTION_EVENT_RETRY_MAX_US)
+#define EE_PMW3901MB_MOTION_EVENT_RETRY_MAX_US  64000U
+#endif
+
+#if (EE_PMW3901MB_USE_MOTION_EVENT == TRUE)
+
+#if (PAL_USE_CALLBACKS != TRUE)
+#error "EE_PMW3901MB_USE_MOTION_EVENT requires PAL_USE_CALLBACKS"
+#endif
+
+#if (CH_CFG_USE_OBJ_FIFOS != TRUE)
+#error "EE_PMW3901MB_USE_MOTION_EVENT requires CH_CFG_USE_OBJ_FIFOS"
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Motion sample flag set when the sample was gated with EE_PMW3901MB_QUALITY_FLAG.
+ */
+#define EE_PMW3901MB_SAMPLE_LOW_QUALITY     0x01U
+
+/**
+ * @brief Motion sample.
+ */
+typedef struct {
+    ee_pmw3901mb_motion_burst_t burst;  /**< Motion burst read after the motion event */
+    systime_t time;                     /**< System time of the read */
+    uint32_t time_us;                   /**< Chip select assert time of the read, ee_pmw3901mb_time_us() */
+    uint8_t confidence;                 /**< Confidence score, EE_PMW3901MB_QUALITY_SCORE_MAX without quality gate */
+    uint8_t flags;                      /**< Sample flags, e.g. EE_PMW3901MB_SAMPLE_LOW_QUALITY */
+} ee_pmw3901mb_motion_sample_t;
+
+/**
+ * @brief Motion event acquisition of one sensor.
+ */
+typedef struct {
+    ee_pmw3901mb_dev_t* dev;            /**< Sensor */
+    ioline_t line;                      /**< Motion (MOT) line of the sensor */
+    thread_t* thread;                   /**< Reader thread, NULL when stopped */
+    const ee_pmw3901mb_quality_cfg_t* quality;  /**< Quality gate, NULL for none */
+    binary_semaphore_t wakeup;          /**< Signalled by the line callback */
+    binary_semaphore_t lock;            /**< Held by the reader thread while reading, and while paused */
+    objects_fifo_t fifo;                /**< Queue of samples */
+    msg_t fifo_msgs[EE_PMW3901MB_MOTION_EVENT_QUEUE_SIZE];
+    ee_pmw3901mb_motion_sample_t fifo_samples[EE_PMW3901MB_MOTION_EVENT_QUEUE_SIZE];
+    uint32_t events;                    /**< Motion line events */
+    uint32_t samples;                   /**< Samples queued */
+    uint32_t spurious;                  /**< Reads without motion flagged */
+    uint32_t overruns;                  /**< Samples dropped on full queue */
+    uint32_t rejected;                  /**< Samples dropped by the quality gate */
+    uint32_t flagged;                   /**< Samples flagged by the quality gate */
+    uint32_t errors;                    /**< Failed reads */
+    uint32_t retries;                   /**< Wakeups by the retry interval, the motion line still asserted */
+} ee_pmw3901mb_motion_event_t;
+
+
+/**
+ * @brief Start motion event acquisition.
+ * @pre The device must be initialized and the motion line configured as input.
+ * @note The reader thread reads the device, other threads should not use it while started.
+ * 
+ * @param[out] me pointer to the motion event acquisition
+ * @param[in] dev pointer to the device handle
+ * @param[in] line motion (MOT) line of the sensor
+ * @param[in] wa pointer to the working area of the reader thread
+ * @param[in] wa_size size of the working area
+ * @param[in] prio priority of the reader thread
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_motion_event_start(ee_pmw3901mb_motion_event_t* me, ee_pmw3901mb_dev_t* dev,
+                                        ioline_t line, void* wa, size_t wa_size, tprio_t prio);
+
+/**
+ * @brief Stop motion event acquisition, waits for the reader thread to exit.
+ * 
+ * @param[in] me pointer to the motion event acquisition
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_motion_event_stop(ee_pmw3901mb_motion_event_t* me);
+
+/**
+ * @brief Pause motion event acquisition, waits for a read in progress to complete.
+ * @details Until resumed the reader thread does not use the device, so other threads can,
+ *          e.g. for a health check. Queued samples and counters are kept, motion events
+ *          while paused are read on resume.
+ * @note Must be resumed before stopping.
+ * 
+ * @param[in] me pointer to the motion event acquisition
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_motion_event_pause(ee_pmw3901mb_motion_event_t* me);
+
+/**
+ * @brief Resume motion event acquisition paused with ee_pmw3901mb_motion_event_pause().
+ * 
+ * @param[in] me pointer to the motion event acquisition
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_motion_event_resume(ee_pmw3901mb_motion_event_t* me);
+
+/**
+ * @brief Set the quality gate of a started motion event acquisition.
+ * @note The configuration is used by the reader thread and must stay valid until replaced.
+ * 
+ * @param[in] me pointer to the motion event acquisition
+ * @param[in] cfg pointer to the quality gate configuration, NULL to pass all samples
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_motion_event_set_quality(ee_pmw3901mb_motion_event_t* me, const ee_pmw3901mb_quality_cfg_t* cfg);
+
+/**
+ * @brief Get the oldest queued motion sample.
+ * 
+ * @param[in] me pointer to the motion event acquisition
+ * @param[out] sample pointer to the return value
+ * @param[in] timeout time to wait for a sample, TIME_IMMEDIATE or TIME_INFINITE
+ * @return uint8_t status code, 0 success, nonzero on error or timeout
+ */
+uint8_t ee_pmw3901mb_motion_event_get(ee_pmw3901mb_motion_event_t* me, ee_pmw3901mb_motion_sample_t* sample,
+                                      sysinterval_t timeout);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EE_PMW3901MB_USE_MOTION_EVENT == TRUE */
+
+#endif /* _EE_PMW3901MB_MOTION_EVENT_ */
@@ -0,0 +1,156 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_odometry.h
+ * 
+ * @brief EngEmil PMW3901MB Odometry.
+ * 
+ * Accumulates the deltas of a sensor into 64-bit running X/Y totals, and counts deltas
+ * saturated at the int16 limits (motion lost by reading too late). A small history of
+ * checkpoints, one per checkpoint interval, answers "displacement since time T" in O(1).
+ * 
+ * Checkpoint intervals are counted from the time stamp of the initialization with the
+ * unsigned difference of the time stamps, so they may wrap (e.g. the uint32_t microsecond
+ * clock after 71.6 minutes) as long as two samples are less than a wrap apart.
+ */
+
+#ifndef _EE_PMW3901MB_ODOMETRY_
+#define _EE_PMW3901MB_ODOMETRY_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+/**
+ * @brief Number of checkpoints kept, must be a power of two.
+ */
+#if !defined(EE_PMW3901MB_ODOMETRY_CHECKPOINTS)
+#define EE_PMW3901MB_ODOMETRY_CHECKPOINTS   16U
+#endif
+
+#if (EE_PMW3901MB_ODOMETRY_CHECKPOINTS < 2U) || ((EE_PMW3901MB_ODOMETRY_CHECKPOINTS & (EE_PMW3901MB_ODOMETRY_CHECKPOINTS - 1U)) != 0U)
+#error "EE_PMW3901MB_ODOMETRY_CHECKPOINTS must be a power of two"
+#endif
+
+/**
+ * @brief Delta magnitude treated as saturated.
+ */
+#define EE_PMW3901MB_ODOMETRY_SATURATED     32767
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Position at the start of a checkpoint interval.
+ */
+typedef struct {
+    uint32_t slot;      /**< Checkpoint interval number since the initialization */
+    int64_t x;          /**< Total X at the start of the interval */
+    int64_t y;          /**< Total Y at the start of the interval */
+} ee_pmw3901mb_odometry_checkpoint_t;
+
+/**
+ * @brief Odometry of one sensor.
+ */
+typedef struct {
+    int64_t x;                  /**< Total X */
+    int64_t y;                  /**< Total Y */
+    uint32_t samples;           /**< Accumulated samples */
+    uint32_t saturations;       /**< Samples with a saturated delta */
+    uint32_t interval;          /**< Checkpoint interval, in time stamp units */
+    uint32_t slot;              /**< Checkpoint interval of the last sample */
+    uint32_t phase;             /**< Time of the last sample since the start of its interval */
+    uint32_t last_time;         /**< Time stamp of the last sample */
+    uint32_t checkpoints_n;     /**< Valid checkpoints, up to EE_PMW3901MB_ODOMETRY_CHECKPOINTS */
+    ee_pmw3901mb_odometry_checkpoint_t checkpoints[EE_PMW3901MB_ODOMETRY_CHECKPOINTS];
+} ee_pmw3901mb_odometry_t;
+
+
+/**
+ * @brief Initialize odometry at zero.
+ * 
+ * @param[out] odo pointer to the odometry
+ * @param[in] interval checkpoint interval, in time stamp units (e.g. system ticks)
+ * @param[in] time time stamp of the start
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_odometry_init(ee_pmw3901mb_odometry_t* odo, uint32_t interval, uint32_t time);
+
+/**
+ * @brief Accumulate a delta.
+ * @note Time stamps must be non-decreasing, modulo the wrap of the time stamp.
+ * 
+ * @param[in] odo pointer to the odometry
+ * @param[in] delta_x delta X
+ * @param[in] delta_y delta Y
+ * @param[in] time time stamp of the delta
+ * @return uint8_t status code, 0 success, nonzero on error (the delta is accumulated when saturated)
+ */
+uint8_t ee_pmw3901mb_odometry_update(ee_pmw3901mb_odometry_t* odo, int16_t delta_x, int16_t delta_y, uint32_t time);
+
+/**
+ * @brief Read the deltas of a device with a motion burst and accumulate them.
+ * 
+ * @param[in] odo pointer to the odometry
+ * @param[in] dev pointer to the device handle
+ * @param[in] time time stamp of the read
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_odometry_read(ee_pmw3901mb_odometry_t* odo, ee_pmw3901mb_dev_t* dev, uint32_t time);
+
+/**
+ * @brief Get the total displacement.
+ * 
+ * @param[in] odo pointer to the odometry
+ * @param[out] x pointer to the return value
+ * @param[out] y pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_odometry_get_total(const ee_pmw3901mb_odometry_t* odo, int64_t* x, int64_t* y);
+
+/**
+ * @brief Get the displacement since time T, in O(1).
+ * @note Resolution is the checkpoint interval: the displacement is counted from the start of
+ *       the checkpoint interval containing T, the intervals starting at the initialization time.
+ *       T must be at or before the last sample, at most a time stamp wrap before it.
+ * 
+ * @param[in] odo pointer to the odometry
+ * @param[in] time time stamp T
+ * @param[out] x pointer to the return value
+ * @param[out] y pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error (T older than the checkpoint history or in the future)
+ */
+uint8_t ee_pmw3901mb_odometry_get_since(const ee_pmw3901mb_odometry_t* odo, uint32_t time, int64_t* x, int64_t* y);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_ODOMETRY_ */
@@ -35,6 +35,8 @@ SOFTWARE.
 #include <stdint.h>
 #include <string.h>
 #include "hal.h"
+#include "ee_pmw3901mb_stats.h"
+#include "ee_pmw3901mb_trace.h"
 
 
 #ifdef __cplusplus
@@ -43,6 +45,136 @@ extern "C"
 #endif
 
 
+/**
+ * @brief Enables the shared bus transaction scheduler.
+ */
+#if !defined(EE_PMW3901MB_USE_SCHED)
+#define EE_PMW3901MB_USE_SCHED              FALSE
+#endif
+
+/**
+ * @brief Max number of registers in one asynchronous read.
+ */
+#define EE_PMW3901MB_SPI_ASYNC_MAX_SIZE     12U
+
+/**
+ * @brief Max number of SPI drivers with asynchronous reads in flight at the same time.
+ */
+#define EE_PMW3901MB_SPI_ASYNC_MAX_DRIVERS  3U
+
+struct ee_pmw3901mb_spi_bus;
+
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+/**
+ * @brief Peripheral on a scheduled SPI bus.
+ */
+typedef struct {
+    SPIConfig* spi_config;  /**< Config of the peripheral, with its chip select line */
+    uint8_t addr_mask;      /**< Register address bits of the command byte */
+    uint8_t coalesce_max;   /**< Max registers of a coalesced read, 0 when the peripheral has no address auto-increment */
+} ee_pmw3901mb_spi_periph_t;
+
+struct ee_pmw3901mb_spi_trans;
+
+/**
+ * @brief Scheduled transaction completion callback.
+ * @note Called from the thread running the scheduler, must not block.
+ * 
+ * @param[in] trans pointer to the completed transaction
+ * @param[in] arg argument of the transaction
+ */
+typedef void (*ee_pmw3901mb_spi_trans_cb_t)(struct ee_pmw3901mb_spi_trans* trans, void* arg);
+
+/**
+ * @brief Transaction on a scheduled SPI bus, one chip select frame.
+ * @details The command byte is followed by tx_n written bytes and rx_n read bytes. Pending
+ *          transactions run by priority (highest first), then by deadline (earliest first,
+ *          none last), then in submit order.
+ * @note Owned by the scheduler from submit until done.
+ */
+typedef struct ee_pmw3901mb_spi_trans {
+    const ee_pmw3901mb_spi_periph_t* periph;    /**< Addressed peripheral */
+    uint8_t cmd;                                /**< Command byte, register address with R/W bit */
+    const uint8_t* tx;                          /**< Bytes written after the command */
+    size_t tx_n;                                /**< Number of written bytes */
+    uint8_t* rx;                                /**< Bytes read after the written ones */
+    size_t rx_n;                                /**< Number of read bytes */
+    uint8_t priority;                           /**< Priority, higher runs first */
+    uint32_t deadline_us;                       /**< Deadline relative to the submit, 0 for none */
+    ee_pmw3901mb_spi_trans_cb_t cb;             /**< Completion callback, can be NULL */
+    void* arg;                                  /**< Completion callback argument */
+    /* Scheduler state */
+    struct ee_pmw3901mb_spi_trans* next;        /**< Next pending transaction */
+    uint32_t seq;                               /**< Submit order */
+    uint32_t submit_us;                         /**< ee_pmw3901mb_time_us() at submit */
+    uint32_t start_us;                          /**< Chip select assert */
+    uint32_t done_us;                           /**< Chip select deassert */
+    volatile bool done;                         /**< Set on completion */
+    bool missed;                                /**< Completed after its deadline */
+    thread_reference_t waiter;                  /**< Thread blocked in ee_pmw3901mb_spi_sched_transfer() */
+} ee_pmw3901mb_spi_trans_t;
+
+/**
+ * @brief Transaction scheduler of a shared SPI bus.
+ * @note All users of the SPI driver must go through the scheduler, or lock the bus with
+ *       spiAcquireBus() (the scheduler re-applies its config after them).
+ */
+typedef struct {
+    SPIDriver* spi_driver;                      /**< Shared SPI driver */
+    ee_pmw3901mb_spi_trans_t* pending;          /**< Pending transactions, in run order */
+    bool running;                               /**< Set while a thread runs transactions */
+    uint32_t seq;                               /**< Submit order of the next transaction */
+    /* Statistics */
+    uint32_t submitted;                         /**< Submitted transactions */
+    uint32_t completed;                         /**< Completed transactions */
+    uint32_t missed;                            /**< Transactions completed after their deadline */
+    uint32_t frames;                            /**< Chip select frames */
+    uint32_t coalesced;                         /**< Transactions merged into the frame of the previous one */
+    uint32_t switches;                          /**< SPI config (re-)applications */
+    uint64_t busy_us;                           /**< Time spent in frames, including config switches */
+} ee_pmw3901mb_spi_sched_t;
+#endif
+
+/**
+ * @brief Asynchronous read completion callback.
+ * @note Called from the SPI interrupt, must not block or start a new transfer.
+ * 
+ * @param[in] bus pointer to the SPI bus handle
+ * @param[in] data pointer to the read registers
+ * @param[in] n number of read registers
+ * @param[in] arg argument passed to ee_pmw3901mb_spi_bus_read_async()
+ */
+typedef void (*ee_pmw3901mb_spi_async_cb_t)(struct ee_pmw3901mb_spi_bus* bus, const uint8_t* data, size_t n, void* arg);
+
+/**
+ * @brief SPI bus handle of one sensor.
+ * @note Sensors on a shared bus use the same SPI driver with separate configs (chip select lines).
+ */
+typedef struct ee_pmw3901mb_spi_bus {
+    SPIDriver* spi_driver;  /**< Platform specific SPI driver */
+    SPIConfig* spi_config;  /**< Platform specific SPI config */
+    uint8_t session_depth;  /**< Nesting depth of acquired bus sessions, 0 when released */
+    volatile uint32_t cs_assert_us;     /**< ee_pmw3901mb_time_us() at the last chip select assert */
+    volatile uint32_t cs_deassert_us;   /**< ee_pmw3901mb_time_us() at the last chip select deassert */
+    /* Asynchronous read in flight */
+    volatile bool async_busy;                                   /**< Set from start until completion */
+    size_t async_n;                                             /**< Number of registers being read */
+    ee_pmw3901mb_spi_async_cb_t async_cb;                       /**< Completion callback */
+    void* async_arg;                                            /**< Completion callback argument */
+    uint8_t async_txbuf[EE_PMW3901MB_SPI_ASYNC_MAX_SIZE + 1U];  /**< Address byte and dummy bytes */
+    uint8_t async_rxbuf[EE_PMW3901MB_SPI_ASYNC_MAX_SIZE + 1U];  /**< Ignored byte and read registers */
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+    ee_pmw3901mb_counters_t counters;                           /**< Bus counters */
+#endif
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    ee_pmw3901mb_spi_sched_t* sched;                            /**< Scheduler of a shared bus, NULL for exclusive use */
+    ee_pmw3901mb_spi_periph_t periph;                           /**< The sensor as peripheral of the scheduler */
+    uint8_t priority;                                           /**< Priority of the sensor transactions */
+    uint32_t deadline_us;                                       /**< Deadline of the sensor transactions, 0 for none */
+#endif
+} ee_pmw3901mb_spi_bus_t;
+
+
 /**
  * @brief Initialize SPI.
  * 
@@ -80,6 +212,195 @@ uint8_t ee_pmw3901mb_spi_read(uint8_t addr, uint8_t* data, size_t n);
  */
 uint8_t ee_pmw3901mb_spi_write(uint8_t addr, uint8_t* data);
 
+/**
+ * @brief Acquire the default SPI bus and keep it started until released.
+ * 
+ * The default SPI bus is the bus of the driver default device, so a session
+ * nests with ee_pmw3901mb_acquire() and the functions without a device handle.
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_acquire(void);
+
+/**
+ * @brief Release the default SPI bus acquired with ee_pmw3901mb_spi_acquire().
+ * 
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_release(void);
+
+/**
+ * @brief Initialize SPI bus handle.
+ * 
+ * @param[out] bus pointer to the SPI bus handle
+ * @param[in] spid_p pointer to the platform specific SPI driver
+ * @param[in] spic_p pointer to the platform specific SPI Config
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_bus_init(ee_pmw3901mb_spi_bus_t* bus, SPIDriver* spid_p, SPIConfig* spic_p);
+
+/**
+ * @brief Deinitialize SPI bus handle.
+ * 
+ * @param[in,out] bus pointer to the SPI bus handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_bus_deinit(ee_pmw3901mb_spi_bus_t* bus);
+
+/**
+ * @brief Read value from register address over SPI bus handle.
+ * @pre The SPI bus handle must be initialized.
+ * 
+ * @param[in] bus pointer to the SPI bus handle
+ * @param[in] addr starting register address
+ * @param[out] data pointer to data buffer
+ * @param[in] n number of consecutive registers to read
+ * @return uint8_t status code, 0 success, nonzero on error (5 asynchronous read in flight)
+ */
+uint8_t ee_pmw3901mb_spi_bus_read(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, uint8_t* data, size_t n);
+
+/**
+ * @brief Write value to register address over SPI bus handle.
+ * @pre The SPI bus handle must be initialized.
+ * 
+ * @param[in] bus pointer to the SPI bus handle
+ * @param[in] addr starting register address
+ * @param[in] data pointer to data buffer
+ * @return uint8_t status code, 0 success, nonzero on error (5 asynchronous read in flight)
+ */
+uint8_t ee_pmw3901mb_spi_bus_write(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, uint8_t* data);
+
+/**
+ * @brief Acquire SPI bus session.
+ * @details Locks the bus (if SPI_USE_MUTUAL_EXCLUSION) and starts the SPI driver once, so
+ *          reads and writes within the session skip the start/stop of the SPI driver.
+ *          Sessions can be nested, only the outermost acquire/release touch the bus.
+ * @pre The SPI bus handle must be initialized.
+ * 
+ * @param[in,out] bus pointer to the SPI bus handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_bus_acquire(ee_pmw3901mb_spi_bus_t* bus);
+
+/**
+ * @brief Release SPI bus session acquired with ee_pmw3901mb_spi_bus_acquire().
+ * 
+ * @param[in,out] bus pointer to the SPI bus handle
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_bus_release(ee_pmw3901mb_spi_bus_t* bus);
+
+/**
+ * @brief Start an asynchronous read of registers over SPI bus handle.
+ * @details The address and data are exchanged in one non-blocking transfer (DMA). The
+ *          callback is called from the SPI interrupt when the transfer completes.
+ * @pre A bus session must be acquired with ee_pmw3901mb_spi_bus_acquire(), and the SPI config
+ *      must have ee_pmw3901mb_spi_data_cb() as data_cb.
+ * 
+ * @param[in] bus pointer to the SPI bus handle
+ * @param[in] addr starting register address
+ * @param[in] n number of consecutive registers to read, max EE_PMW3901MB_SPI_ASYNC_MAX_SIZE
+ * @param[in] cb completion callback
+ * @param[in] arg completion callback argument
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_bus_read_async(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, size_t n,
+                                        ee_pmw3901mb_spi_async_cb_t cb, void* arg);
+
+/**
+ * @brief Check if an asynchronous read is in flight on the SPI bus handle.
+ * 
+ * @param[in] bus pointer to the SPI bus handle
+ * @return true when an asynchronous read is in flight
+ */
+bool ee_pmw3901mb_spi_bus_async_busy(const ee_pmw3901mb_spi_bus_t* bus);
+
+/**
+ * @brief SPI data callback completing asynchronous reads.
+ * @note Set as data_cb in the platform specific SPI Config. Completions of blocking
+ *       transfers are ignored.
+ * 
+ * @param[in] spip pointer to the platform specific SPI driver
+ */
+void ee_pmw3901mb_spi_data_cb(SPIDriver* spip);
+
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+/**
+ * @brief Initialize the transaction scheduler of a shared SPI bus.
+ * 
+ * @param[out] sched pointer to the scheduler
+ * @param[in] spid_p pointer to the platform specific SPI driver
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_sched_init(ee_pmw3901mb_spi_sched_t* sched, SPIDriver* spid_p);
+
+/**
+ * @brief Stop the SPI driver left started by the scheduler.
+ * 
+ * @param[in,out] sched pointer to the scheduler
+ * @return uint8_t status code, 0 success, nonzero on error (transactions pending)
+ */
+uint8_t ee_pmw3901mb_spi_sched_stop(ee_pmw3901mb_spi_sched_t* sched);
+
+/**
+ * @brief Queue a transaction without waiting for it.
+ * @details Runs on the next ee_pmw3901mb_spi_sched_run() or blocking transfer on the bus.
+ * 
+ * @param[in,out] sched pointer to the scheduler
+ * @param[in,out] trans pointer to the transaction, owned by the scheduler until done
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_sched_submit(ee_pmw3901mb_spi_sched_t* sched, ee_pmw3901mb_spi_trans_t* trans);
+
+/**
+ * @brief Run pending transactions in order, in the calling thread.
+ * @details Back-to-back reads of consecutive registers of a peripheral with address
+ *          auto-increment share one chip select frame, and the SPI config is applied only
+ *          when the addressed peripheral differs from the one the driver is started with.
+ * 
+ * @param[in,out] sched pointer to the scheduler
+ * @param[in] max_frames max chip select frames to run, 0 until none is pending
+ * @return size_t number of chip select frames run, 0 also while another thread runs
+ */
+size_t ee_pmw3901mb_spi_sched_run(ee_pmw3901mb_spi_sched_t* sched, size_t max_frames);
+
+/**
+ * @brief Queue a transaction and wait until it is done.
+ * @details The thread runs the pending transactions in order up to its own when the bus is
+ *          free, otherwise it sleeps until a running thread completed its transaction or
+ *          handed the bus over.
+ * 
+ * @param[in,out] sched pointer to the scheduler
+ * @param[in,out] trans pointer to the transaction
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_sched_transfer(ee_pmw3901mb_spi_sched_t* sched, ee_pmw3901mb_spi_trans_t* trans);
+
+/**
+ * @brief Route the transactions of a sensor bus handle through a shared bus scheduler.
+ * @details Bus sessions then only nest, without locking the bus, and asynchronous reads are
+ *          refused. The PMW3901MB documents no address auto-increment outside the motion
+ *          burst, its reads are not coalesced.
+ * @pre The SPI bus handle must be initialized, on the SPI driver of the scheduler.
+ * 
+ * @param[in,out] bus pointer to the SPI bus handle
+ * @param[in] sched pointer to the scheduler, NULL for exclusive use again
+ * @param[in] priority priority of the sensor transactions
+ * @param[in] deadline_us deadline of the sensor transactions relative to their start, 0 for none
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_spi_bus_set_sched(ee_pmw3901mb_spi_bus_t* bus, ee_pmw3901mb_spi_sched_t* sched,
+                                       uint8_t priority, uint32_t deadline_us);
+#endif
+
+/**
+ * @brief Get a monotonic microsecond time with platform specific function
+ * @note Wraps around after 2^32 microseconds (about 71 minutes), use unsigned differences.
+ * 
+ * @return uint32_t time in microseconds
+ */
+uint32_t ee_pmw3901mb_time_us(void);
+
 /**
  * @brief Wait in milliseconds with platform specific function
  * 
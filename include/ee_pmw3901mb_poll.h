@@ -0,0 +1,177 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/**
+ * @file ee_pmw3901mb_poll.h
+ * 
+ * @brief EngEmil PMW3901MB Adaptive Polling Acquisition.
+ * 
+ * Polling acquisition with an adaptive rate. The sensor is read at the fastest period
+ * (down to the sensor frame period) while it reports motion, and the period doubles on
+ * every idle read past a short hold, up to the slowest period.
+ * 
+ * The rate controller (ee_pmw3901mb_poll_rate_*()) is platform independent. The acquisition
+ * thread requires CH_CFG_USE_WAITEXIT, and is enabled by defining EE_PMW3901MB_USE_POLL
+ * to TRUE (e.g. in the Makefile UDEFS).
+ */
+
+#ifndef _EE_PMW3901MB_POLL_
+#define _EE_PMW3901MB_POLL_
+
+#include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_quality.h"
+#include "ee_pmw3901mb_ring.h"
+
+
+/**
+ * @brief Enables the adaptive polling acquisition thread.
+ */
+#if !defined(EE_PMW3901MB_USE_POLL)
+#define EE_PMW3901MB_USE_POLL           FALSE
+#endif
+
+/**
+ * @brief Sensor frame period in microseconds (121 frames per second).
+ */
+#define EE_PMW3901MB_FRAME_PERIOD_US    8265U
+
+/**
+ * @brief Default slowest polling period in microseconds.
+ */
+#define EE_PMW3901MB_POLL_MAX_PERIOD_US 500000U
+
+/**
+ * @brief Default number of idle reads at the current period before backing off.
+ */
+#define EE_PMW3901MB_POLL_IDLE_HOLD     4U
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Polling rate controller.
+ */
+typedef struct {
+    uint32_t min_period_us;     /**< Fastest period, used while moving */
+    uint32_t max_period_us;     /**< Slowest period, reached when idle */
+    uint32_t period_us;         /**< Current period */
+    uint8_t idle_hold;          /**< Idle reads at the fastest period before backing off */
+    uint8_t idle_reads;         /**< Consecutive idle reads */
+} ee_pmw3901mb_poll_rate_t;
+
+
+/**
+ * @brief Initialize a polling rate controller, starting at the fastest period.
+ * 
+ * @param[out] rate pointer to the rate controller
+ * @param[in] min_period_us fastest period, at least EE_PMW3901MB_FRAME_PERIOD_US is useful
+ * @param[in] max_period_us slowest period
+ * @param[in] idle_hold idle reads at the fastest period before backing off
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_poll_rate_init(ee_pmw3901mb_poll_rate_t* rate, uint32_t min_period_us,
+                                    uint32_t max_period_us, uint8_t idle_hold);
+
+/**
+ * @brief Update the rate controller with the result of a read.
+ * 
+ * @param[in] rate pointer to the rate controller
+ * @param[in] burst pointer to the motion burst read
+ * @return uint32_t period until the next read, in microseconds
+ */
+uint32_t ee_pmw3901mb_poll_rate_update(ee_pmw3901mb_poll_rate_t* rate, const ee_pmw3901mb_motion_burst_t* burst);
+
+
+#if (EE_PMW3901MB_USE_POLL == TRUE)
+
+#if (CH_CFG_USE_WAITEXIT != TRUE)
+#error "EE_PMW3901MB_USE_POLL requires CH_CFG_USE_WAITEXIT"
+#endif
+
+/**
+ * @brief Adaptive polling acquisition of one sensor.
+ */
+typedef struct {
+    ee_pmw3901mb_dev_t* dev;                    /**< Sensor */
+    ee_pmw3901mb_ring_t* ring;                  /**< Samples with motion, time stamped at chip select assert in microseconds */
+    thread_t* thread;                           /**< Polling thread, NULL when stopped */
+    ee_pmw3901mb_poll_rate_t rate;              /**< Rate controller */
+    const ee_pmw3901mb_quality_cfg_t* quality;  /**< Quality gate, NULL for none, flagged samples are passed */
+    uint32_t reads;                             /**< Motion burst reads */
+    uint32_t samples;                           /**< Samples pushed to the ring */
+    uint32_t rejected;                          /**< Samples dropped by the quality gate */
+    uint32_t overruns;                          /**< Samples dropped on full ring */
+    uint32_t errors;                            /**< Failed reads */
+} ee_pmw3901mb_poll_t;
+
+
+/**
+ * @brief Start adaptive polling acquisition.
+ * @pre The device must be initialized.
+ * @note The polling thread reads the device, other threads should not use it while started.
+ * 
+ * @param[out] poll pointer to the polling acquisition
+ * @param[in] dev pointer to the device handle
+ * @param[in] ring pointer to an initialized ring the samples are pushed to
+ * @param[in] min_period_us fastest period
+ * @param[in] max_period_us slowest period
+ * @param[in] wa pointer to the working area of the polling thread
+ * @param[in] wa_size size of the working area
+ * @param[in] prio priority of the polling thread
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_poll_start(ee_pmw3901mb_poll_t* poll, ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_ring_t* ring,
+                                uint32_t min_period_us, uint32_t max_period_us, void* wa, size_t wa_size, tprio_t prio);
+
+/**
+ * @brief Stop adaptive polling acquisition, waits for the polling thread to exit.
+ * @note Returns after the current polling period, up to the slowest period.
+ * 
+ * @param[in] poll pointer to the polling acquisition
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_poll_stop(ee_pmw3901mb_poll_t* poll);
+
+/**
+ * @brief Set the quality gate of a started polling acquisition.
+ * @note The configuration is used by the polling thread and must stay valid until replaced.
+ * 
+ * @param[in] poll pointer to the polling acquisition
+ * @param[in] cfg pointer to the quality gate configuration, NULL to pass all samples
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_poll_set_quality(ee_pmw3901mb_poll_t* poll, const ee_pmw3901mb_quality_cfg_t* cfg);
+
+#endif /* EE_PMW3901MB_USE_POLL == TRUE */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_POLL_ */
@@ -0,0 +1,187 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_power.h
+ * 
+ * @brief EngEmil PMW3901MB Power Manager.
+ * 
+ * Puts a sensor without motion to sleep and wakes it on motion. Asleep, the sensor either
+ * rests (stays powered and tuned, not read) and is checked with one motion burst read or
+ * woken by the motion line, or is shut down and woken at the check period for a quick motion
+ * check: a power up reset, the boot and a few untuned frames. The performance optimization
+ * sequence is written only when the check found motion, and the manager tracks whether the
+ * sensor still holds it, so a wake from rest writes nothing.
+ */
+
+#ifndef _EE_PMW3901MB_POWER_
+#define _EE_PMW3901MB_POWER_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Status code of ee_pmw3901mb_power_get_motion_burst() while the sensor is not active.
+ */
+#define EE_PMW3901MB_POWER_ASLEEP   0x41U
+
+/**
+ * @brief Power state.
+ */
+typedef enum {
+    EE_PMW3901MB_POWER_ACTIVE = 0,  /**< Tuned and read by the application */
+    EE_PMW3901MB_POWER_REST,        /**< Powered and tuned, not read, checked for motion */
+    EE_PMW3901MB_POWER_SHUTDOWN,    /**< Shut down, woken at the check period */
+    EE_PMW3901MB_POWER_CHECK,       /**< Woken from shutdown, booting and collecting untuned frames */
+    EE_PMW3901MB_POWER_WAKE,        /**< Writing the performance optimization sequence, then active */
+    EE_PMW3901MB_POWER_FAILED,      /**< A bus access or the initialization failed */
+} ee_pmw3901mb_power_state_t;
+
+/**
+ * @brief Sleep mode, taken after the idle timeout.
+ */
+typedef enum {
+    EE_PMW3901MB_SLEEP_REST = 0,    /**< Sensor stays powered and tuned, no bus writes to wake */
+    EE_PMW3901MB_SLEEP_SHUTDOWN,    /**< Sensor shut down, motion while shut down is not counted */
+} ee_pmw3901mb_sleep_mode_t;
+
+/**
+ * @brief Power manager configuration.
+ */
+typedef struct {
+    ee_pmw3901mb_sleep_mode_t sleep_mode;   /**< Sleep mode */
+    uint32_t idle_timeout_us;   /**< Time without motion before sleeping, 0 never sleeps */
+    uint32_t check_period_us;   /**< Interval of the motion checks while asleep, 0 for none */
+    uint32_t check_window_us;   /**< Shutdown: time from the boot to the motion check, collecting frames */
+    bool wake_on_motion;        /**< Rest: wake on ee_pmw3901mb_power_notify_motion() (motion line) */
+} ee_pmw3901mb_power_cfg_t;
+
+/**
+ * @brief Power manager of a device.
+ * @note Times are ee_pmw3901mb_time_us().
+ */
+typedef struct {
+    ee_pmw3901mb_dev_t* dev;                /**< Managed device */
+    ee_pmw3901mb_power_cfg_t cfg;           /**< Configuration */
+    ee_pmw3901mb_power_state_t state;       /**< Current state */
+    bool tuned;                             /**< Sensor holds the performance optimization sequence */
+    volatile bool motion_pending;           /**< Motion line asserted since the last check */
+    bool burst_pending;                     /**< Motion burst of the waking check not yet returned */
+    ee_pmw3901mb_motion_burst_t burst;      /**< Motion burst of the last motion check */
+    uint32_t motion_us;                     /**< Last motion burst with motion, or wake */
+    uint32_t state_us;                      /**< Entry of the current state */
+    uint32_t due_us;                        /**< Next motion check */
+    uint32_t wake_us;                       /**< Wake decision of the wake in progress */
+    /* Statistics */
+    uint32_t sleeps;                        /**< Sleeps after the idle timeout */
+    uint32_t checks;                        /**< Motion checks while asleep */
+    uint32_t wakes;                         /**< Wakes to active */
+    uint32_t last_wake_us;                  /**< Time from the wake decision to active of the last wake */
+    uint64_t state_time_us[EE_PMW3901MB_POWER_FAILED + 1];  /**< Time per state up to the entry of the current one, indexed by ee_pmw3901mb_power_state_t */
+} ee_pmw3901mb_power_t;
+
+
+/**
+ * @brief Get the default power manager configuration.
+ * @details Rests after 2 s without motion and checks for motion every 250 ms, with the wake
+ *          on the motion line enabled. A shutdown check collects 3 frames (25 ms).
+ * 
+ * @param[out] cfg pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_power_default_cfg(ee_pmw3901mb_power_cfg_t* cfg);
+
+/**
+ * @brief Initialize a power manager, active.
+ * @pre The device must be initialized.
+ * 
+ * @param[out] power pointer to the power manager
+ * @param[in] dev pointer to the managed device handle
+ * @param[in] cfg pointer to the configuration, NULL for the default
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_power_init(ee_pmw3901mb_power_t* power, ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_power_cfg_t* cfg);
+
+/**
+ * @brief Run the due power state transitions.
+ * @details Sleeps after the idle timeout, checks for motion while asleep and advances a wake.
+ *          Call it again within the returned wait (or on ee_pmw3901mb_power_notify_motion()).
+ * 
+ * @param[in,out] power pointer to the power manager
+ * @param[out] wait_us pointer to the time until the next transition is due, UINT32_MAX when
+ *                    none is (only a notification or a wake), can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error (EE_PMW3901MB_POWER_FAILED)
+ */
+uint8_t ee_pmw3901mb_power_step(ee_pmw3901mb_power_t* power, uint32_t* wait_us);
+
+/**
+ * @brief Read a motion burst of an active sensor, restarting the idle timeout on motion.
+ * @details The first burst after a wake is the one of the motion check that woke the sensor.
+ * 
+ * @param[in,out] power pointer to the power manager
+ * @param[out] burst pointer to the return value
+ * @return uint8_t status code, 0 success, EE_PMW3901MB_POWER_ASLEEP while not active, other
+ *         nonzero on error
+ */
+uint8_t ee_pmw3901mb_power_get_motion_burst(ee_pmw3901mb_power_t* power, ee_pmw3901mb_motion_burst_t* burst);
+
+/**
+ * @brief Notify motion from the motion line.
+ * @note Only sets a flag, can be called from the motion line interrupt. Acted on by the next
+ *       ee_pmw3901mb_power_step() when wake_on_motion is set.
+ * 
+ * @param[in,out] power pointer to the power manager
+ */
+void ee_pmw3901mb_power_notify_motion(ee_pmw3901mb_power_t* power);
+
+/**
+ * @brief Wake the sensor without a motion check, e.g. before a commanded move.
+ * @details Active at once from rest, otherwise continued by ee_pmw3901mb_power_step().
+ * 
+ * @param[in,out] power pointer to the power manager
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_power_wake(ee_pmw3901mb_power_t* power);
+
+/**
+ * @brief Check if the sensor is active.
+ * 
+ * @param[in] power pointer to the power manager
+ * @return true when active
+ */
+bool ee_pmw3901mb_power_is_active(const ee_pmw3901mb_power_t* power);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_POWER_ */
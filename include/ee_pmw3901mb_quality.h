@@ -0,0 +1,113 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/**
+ * @file ee_pmw3901mb_quality.h
+ * 
+ * @brief EngEmil PMW3901MB Sample Quality Gating.
+ * 
+ * Confidence score of a motion sample from the surface quality (SQUAL), shutter, raw data
+ * min/max and raw data sum read in the same motion burst as the deltas. Over featureless or
+ * dark surfaces SQUAL drops, the shutter opens up, the raw data range collapses and the
+ * brightness (raw data sum) falls, and the deltas can not be trusted. The score is the
+ * weakest of the four terms, each scaled to 0..255.
+ */
+
+#ifndef _EE_PMW3901MB_QUALITY_
+#define _EE_PMW3901MB_QUALITY_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Full confidence score.
+ */
+#define EE_PMW3901MB_QUALITY_SCORE_MAX  255U
+
+/**
+ * @brief Gate action on a sample.
+ */
+typedef enum {
+    EE_PMW3901MB_QUALITY_PASS = 0,  /**< Pass the sample */
+    EE_PMW3901MB_QUALITY_FLAG,      /**< Pass the sample flagged as low quality */
+    EE_PMW3901MB_QUALITY_DROP       /**< Drop the sample */
+} ee_pmw3901mb_quality_action_t;
+
+/**
+ * @brief Quality gate configuration.
+ */
+typedef struct {
+    uint8_t squal_full;                     /**< SQUAL at and above which the SQUAL term is full */
+    uint16_t shutter_low;                   /**< Shutter at and below which the shutter term is full */
+    uint16_t shutter_high;                  /**< Shutter at and above which the shutter term is zero */
+    uint8_t contrast_full;                  /**< Max minus min raw data at and above which the contrast term is full, 0 disables the term */
+    uint8_t rawdata_sum_full;               /**< Raw data sum at and above which the brightness term is full, 0 disables the term */
+    uint8_t min_score;                      /**< Samples scoring below are gated */
+    ee_pmw3901mb_quality_action_t action;   /**< Action on gated samples */
+} ee_pmw3901mb_quality_cfg_t;
+
+
+/**
+ * @brief Get the default quality gate configuration.
+ * @details The default rejects SQUAL below 0x1A, a shutter near its 0x1FFF maximum and a raw
+ *          data sum below 0x11, the conditions the sensor does not report valid motion in, and
+ *          drops gated samples.
+ * 
+ * @param[out] cfg pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_quality_default_cfg(ee_pmw3901mb_quality_cfg_t* cfg);
+
+/**
+ * @brief Compute the confidence score of a motion burst.
+ * 
+ * @param[in] cfg pointer to the quality gate configuration
+ * @param[in] burst pointer to the motion burst
+ * @return uint8_t confidence score, 0 (none) to EE_PMW3901MB_QUALITY_SCORE_MAX (full)
+ */
+uint8_t ee_pmw3901mb_quality_score(const ee_pmw3901mb_quality_cfg_t* cfg, const ee_pmw3901mb_motion_burst_t* burst);
+
+/**
+ * @brief Score a motion burst and get the gate action.
+ * 
+ * @param[in] cfg pointer to the quality gate configuration
+ * @param[in] burst pointer to the motion burst
+ * @param[out] score pointer to the return value, the confidence score, can be NULL
+ * @return ee_pmw3901mb_quality_action_t EE_PMW3901MB_QUALITY_PASS, or the configured action when gated
+ */
+ee_pmw3901mb_quality_action_t ee_pmw3901mb_quality_gate(const ee_pmw3901mb_quality_cfg_t* cfg,
+                                                        const ee_pmw3901mb_motion_burst_t* burst, uint8_t* score);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_QUALITY_ */
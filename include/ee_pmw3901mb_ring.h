@@ -0,0 +1,149 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_ring.h
+ * 
+ * @brief EngEmil PMW3901MB Sample Ring Buffer.
+ * 
+ * Fixed-capacity single-producer/single-consumer ring of timestamped motion samples, between
+ * the acquisition (producer) and e.g. a fusion thread (consumer). Lock-free: the producer only
+ * writes the head index and the consumer only writes the tail index. The indices are kept on
+ * separate cache lines so producer and consumer on different cores do not share a line.
+ */
+
+#ifndef _EE_PMW3901MB_RING_
+#define _EE_PMW3901MB_RING_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+/**
+ * @brief Number of samples in the ring, must be a power of two.
+ */
+#if !defined(EE_PMW3901MB_RING_SIZE)
+#define EE_PMW3901MB_RING_SIZE      16U
+#endif
+
+/**
+ * @brief Alignment of the ring indices, the cache line size of the target.
+ */
+#if !defined(EE_PMW3901MB_RING_ALIGN)
+#define EE_PMW3901MB_RING_ALIGN     64U
+#endif
+
+#if (EE_PMW3901MB_RING_SIZE < 2U) || ((EE_PMW3901MB_RING_SIZE & (EE_PMW3901MB_RING_SIZE - 1U)) != 0U)
+#error "EE_PMW3901MB_RING_SIZE must be a power of two"
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Timestamped motion sample.
+ */
+typedef struct {
+    int16_t delta_x;    /**< Delta X */
+    int16_t delta_y;    /**< Delta Y */
+    uint8_t squal;      /**< Surface quality */
+    uint16_t shutter;   /**< Shutter value */
+    uint32_t time;      /**< Chip select assert time of the read, ee_pmw3901mb_time_us() */
+} ee_pmw3901mb_sample_t;
+
+/**
+ * @brief Sample ring buffer.
+ */
+typedef struct {
+    volatile uint32_t head __attribute__((aligned(EE_PMW3901MB_RING_ALIGN)));  /**< Next write, producer owned */
+    volatile uint32_t overflows;                                                /**< Samples dropped on full ring, producer owned */
+    volatile uint32_t tail __attribute__((aligned(EE_PMW3901MB_RING_ALIGN)));  /**< Next read, consumer owned */
+    ee_pmw3901mb_sample_t samples[EE_PMW3901MB_RING_SIZE] __attribute__((aligned(EE_PMW3901MB_RING_ALIGN)));
+} ee_pmw3901mb_ring_t;
+
+
+/**
+ * @brief Initialize an empty ring.
+ * @note Not thread safe, call before the producer and consumer start.
+ * 
+ * @param[out] ring pointer to the ring
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_ring_init(ee_pmw3901mb_ring_t* ring);
+
+/**
+ * @brief Push a sample, producer side.
+ * @note Drops the sample and counts an overflow when the ring is full.
+ * 
+ * @param[in] ring pointer to the ring
+ * @param[in] sample pointer to the sample
+ * @return uint8_t status code, 0 success, nonzero on error or full ring
+ */
+uint8_t ee_pmw3901mb_ring_push(ee_pmw3901mb_ring_t* ring, const ee_pmw3901mb_sample_t* sample);
+
+/**
+ * @brief Push a sample made from a motion burst, producer side.
+ * 
+ * @param[in] ring pointer to the ring
+ * @param[in] burst pointer to the motion burst
+ * @param[in] time chip select assert time of the read, ee_pmw3901mb_time_us() (dev->burst_assert_us)
+ * @return uint8_t status code, 0 success, nonzero on error or full ring
+ */
+uint8_t ee_pmw3901mb_ring_push_burst(ee_pmw3901mb_ring_t* ring, const ee_pmw3901mb_motion_burst_t* burst, uint32_t time);
+
+/**
+ * @brief Pop the oldest sample, consumer side.
+ * 
+ * @param[in] ring pointer to the ring
+ * @param[out] sample pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error or empty ring
+ */
+uint8_t ee_pmw3901mb_ring_pop(ee_pmw3901mb_ring_t* ring, ee_pmw3901mb_sample_t* sample);
+
+/**
+ * @brief Get the number of samples in the ring.
+ * 
+ * @param[in] ring pointer to the ring
+ * @return uint32_t number of samples
+ */
+uint32_t ee_pmw3901mb_ring_count(const ee_pmw3901mb_ring_t* ring);
+
+/**
+ * @brief Get the number of samples dropped on full ring.
+ * 
+ * @param[in] ring pointer to the ring
+ * @return uint32_t number of dropped samples
+ */
+uint32_t ee_pmw3901mb_ring_overflows(const ee_pmw3901mb_ring_t* ring);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_RING_ */
@@ -0,0 +1,140 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_stats.h
+ * 
+ * @brief EngEmil PMW3901MB Performance Counters.
+ * 
+ * Per bus counters of transactions, bytes, errors and retries, and per device log2 latency
+ * histograms of driver initialization, delta read, motion burst read and frame grab. The
+ * instrumentation points in the platform and driver are macros expanding to nothing unless
+ * EE_PMW3901MB_USE_STATS is defined to TRUE (e.g. in the Makefile UDEFS), so a build without
+ * it carries neither the code nor the fields.
+ */
+
+#ifndef _EE_PMW3901MB_STATS_
+#define _EE_PMW3901MB_STATS_
+
+#include <stdint.h>
+#include <string.h>
+#include "hal.h"
+
+
+/**
+ * @brief Enables the performance counters.
+ */
+#if !defined(EE_PMW3901MB_USE_STATS)
+#define EE_PMW3901MB_USE_STATS      FALSE
+#endif
+
+/**
+ * @brief Number of latency histogram buckets. Bucket 0 counts 0 us, bucket k counts
+ *        [2^(k-1), 2^k) us, the last bucket everything above.
+ */
+#if !defined(EE_PMW3901MB_STATS_BUCKETS)
+#define EE_PMW3901MB_STATS_BUCKETS  24U
+#endif
+
+#if (EE_PMW3901MB_STATS_BUCKETS < 2U) || (EE_PMW3901MB_STATS_BUCKETS > 33U)
+#error "EE_PMW3901MB_STATS_BUCKETS must be within 2..33"
+#endif
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Timed driver operations.
+ */
+typedef enum {
+    EE_PMW3901MB_OP_INIT = 0,       /**< ee_pmw3901mb_dev_init_driver() */
+    EE_PMW3901MB_OP_DELTA,          /**< ee_pmw3901mb_dev_get_delta_x_y() */
+    EE_PMW3901MB_OP_BURST,          /**< Motion burst read, blocking or asynchronous (start to completion) */
+    EE_PMW3901MB_OP_FRAME_GRAB,     /**< ee_pmw3901mb_dev_frame_grab() */
+    EE_PMW3901MB_OP_COUNT
+} ee_pmw3901mb_op_t;
+
+/**
+ * @brief Bus counters.
+ */
+typedef struct {
+    uint32_t reads;     /**< Read transactions */
+    uint32_t writes;    /**< Write transactions */
+    uint32_t bytes;     /**< Bytes on the bus, including address bytes */
+    uint32_t errors;    /**< Transfers refused with a nonzero status code */
+    uint32_t retries;   /**< Repeated status polls waiting on the sensor */
+} ee_pmw3901mb_counters_t;
+
+/**
+ * @brief Log2 latency histogram of one operation, successful completions only.
+ */
+typedef struct {
+    uint32_t count;                                     /**< Completed operations */
+    uint32_t max_us;                                    /**< Max latency */
+    uint64_t sum_us;                                    /**< Sum of latencies */
+    uint32_t buckets[EE_PMW3901MB_STATS_BUCKETS];       /**< Operations per latency bucket */
+} ee_pmw3901mb_hist_t;
+
+
+/**
+ * @brief Add a latency to a histogram.
+ * 
+ * @param[in,out] hist pointer to the histogram
+ * @param[in] us latency in microseconds
+ */
+void ee_pmw3901mb_hist_add(ee_pmw3901mb_hist_t* hist, uint32_t us);
+
+/**
+ * @brief Get a latency percentile from a histogram.
+ * @note Resolved to the upper bound of the bucket holding the percentile, capped at the max.
+ * 
+ * @param[in] hist pointer to the histogram
+ * @param[in] percent percentile, 0 to 100
+ * @return uint32_t latency in microseconds, 0 for an empty histogram
+ */
+uint32_t ee_pmw3901mb_hist_percentile(const ee_pmw3901mb_hist_t* hist, uint32_t percent);
+
+
+/* Instrumentation points, no code unless enabled */
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+#define EE_PMW3901MB_STATS_ADD(field, n)            ((field) += (n))
+#define EE_PMW3901MB_STATS_TIME_START(var)          uint32_t var = ee_pmw3901mb_time_us()
+#define EE_PMW3901MB_STATS_TIME_END(hist, var, st)  do{ if((st) == 0U) ee_pmw3901mb_hist_add((hist), ee_pmw3901mb_time_us() - (var)); }while(0)
+#else
+#define EE_PMW3901MB_STATS_ADD(field, n)            do{ }while(0)
+#define EE_PMW3901MB_STATS_TIME_START(var)          do{ }while(0)
+#define EE_PMW3901MB_STATS_TIME_END(hist, var, st)  do{ }while(0)
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_STATS_ */
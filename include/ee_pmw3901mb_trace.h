@@ -0,0 +1,167 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_trace.h
+ * 
+ * @brief EngEmil PMW3901MB Bus Trace Recorder.
+ * 
+ * Records every SPI transaction of the platform layer (direction, register address, payload
+ * and chip select assert time) into a byte ring, overwriting the oldest records when full, so
+ * the last part of the sensor conversation can be dumped from a misbehaving unit and replayed
+ * on a host. The recorder is enabled by defining EE_PMW3901MB_USE_TRACE to TRUE (e.g. in the
+ * Makefile UDEFS), the format functions are always available.
+ * 
+ * Dump format, all integers little endian:
+ * - File header (EE_PMW3901MB_TRACE_FILE_HEADER_SIZE bytes): magic "PMWT", version, 3 reserved
+ *   bytes, number of records (uint32), number of records dropped before the first (uint32).
+ * - Records, oldest first (EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE bytes followed by the payload):
+ *   flags, register address, payload size n, ee_pmw3901mb_time_us() at chip select assert
+ *   (uint32), n payload bytes (written or read data, without the address byte).
+ */
+
+#ifndef _EE_PMW3901MB_TRACE_
+#define _EE_PMW3901MB_TRACE_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "hal.h"
+
+
+/**
+ * @brief Enables the bus trace recorder.
+ */
+#if !defined(EE_PMW3901MB_USE_TRACE)
+#define EE_PMW3901MB_USE_TRACE      FALSE
+#endif
+
+/**
+ * @brief Size of the trace ring in bytes, must be a power of two.
+ */
+#if !defined(EE_PMW3901MB_TRACE_SIZE)
+#define EE_PMW3901MB_TRACE_SIZE     4096U
+#endif
+
+#if (EE_PMW3901MB_TRACE_SIZE < 64U) || ((EE_PMW3901MB_TRACE_SIZE & (EE_PMW3901MB_TRACE_SIZE - 1U)) != 0U)
+#error "EE_PMW3901MB_TRACE_SIZE must be a power of two of at least 64"
+#endif
+
+#define EE_PMW3901MB_TRACE_VERSION              1U      /**< Dump format version */
+#define EE_PMW3901MB_TRACE_FILE_HEADER_SIZE     16U     /**< Bytes before the first record */
+#define EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE   7U      /**< Bytes of a record before its payload */
+
+#define EE_PMW3901MB_TRACE_WRITE    0x80U   /**< Record flag, write transaction */
+#define EE_PMW3901MB_TRACE_ASYNC    0x40U   /**< Record flag, asynchronous read */
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief One decoded trace record.
+ */
+typedef struct {
+    uint8_t flags;          /**< EE_PMW3901MB_TRACE_WRITE, EE_PMW3901MB_TRACE_ASYNC */
+    uint8_t addr;           /**< Register address */
+    uint8_t n;              /**< Payload size */
+    uint32_t time_us;       /**< Chip select assert time */
+    const uint8_t* data;    /**< Payload, points into the dump */
+} ee_pmw3901mb_trace_record_t;
+
+
+/**
+ * @brief Check a dump header and get the position of its first record.
+ * 
+ * @param[in] dump pointer to the dump
+ * @param[in] len size of the dump in bytes
+ * @param[out] records number of records, can be NULL
+ * @param[out] dropped number of records dropped before the first, can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_trace_parse_header(const uint8_t* dump, size_t len, uint32_t* records, uint32_t* dropped);
+
+/**
+ * @brief Decode the record at a position of a dump.
+ * 
+ * @param[in] dump pointer to the dump
+ * @param[in] len size of the dump in bytes
+ * @param[in] pos position of the record, EE_PMW3901MB_TRACE_FILE_HEADER_SIZE for the first
+ * @param[out] rec pointer to the return value
+ * @return size_t size of the record, 0 at the end of the dump or on a truncated record
+ */
+size_t ee_pmw3901mb_trace_parse(const uint8_t* dump, size_t len, size_t pos, ee_pmw3901mb_trace_record_t* rec);
+
+
+#if (EE_PMW3901MB_USE_TRACE == TRUE)
+
+/**
+ * @brief Record a transaction.
+ * @note Called by the platform layer, from thread or interrupt context.
+ * 
+ * @param[in] flags record flags
+ * @param[in] addr register address
+ * @param[in] data pointer to the payload
+ * @param[in] n payload size
+ * @param[in] time_us chip select assert time
+ */
+void ee_pmw3901mb_trace_record(uint8_t flags, uint8_t addr, const uint8_t* data, size_t n, uint32_t time_us);
+
+/**
+ * @brief Dump the recorded transactions, oldest first.
+ * 
+ * @param[out] out pointer to the dump buffer
+ * @param[in] size size of the dump buffer, at most EE_PMW3901MB_TRACE_FILE_HEADER_SIZE + EE_PMW3901MB_TRACE_SIZE is needed
+ * @param[out] len size of the dump in bytes
+ * @return uint8_t status code, 0 success, nonzero on error or too small buffer
+ */
+uint8_t ee_pmw3901mb_trace_dump(uint8_t* out, size_t size, size_t* len);
+
+/**
+ * @brief Clear the recorded transactions and the dropped counter.
+ */
+void ee_pmw3901mb_trace_clear(void);
+
+/**
+ * @brief Get the number of records overwritten since the last clear.
+ * 
+ * @return uint32_t number of dropped records
+ */
+uint32_t ee_pmw3901mb_trace_dropped(void);
+
+#define EE_PMW3901MB_TRACE_RECORD(flags, addr, data, n, t)  ee_pmw3901mb_trace_record((flags), (addr), (data), (n), (t))
+#else
+#define EE_PMW3901MB_TRACE_RECORD(flags, addr, data, n, t)  do{ }while(0)
+#endif /* EE_PMW3901MB_USE_TRACE == TRUE */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_TRACE_ */
@@ -0,0 +1,115 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file ee_pmw3901mb_velocity.h
+ * 
+ * @brief EngEmil PMW3901MB Velocity Estimation.
+ * 
+ * Converts deltas (counts) to velocity (mm/s) from the sample interval and the height above
+ * the surface, using the field of view of the PMW3901MB. Integer/fixed-point only, for
+ * targets without (double precision) FPU. Includes an integer CORDIC for magnitude and angle.
+ */
+
+#ifndef _EE_PMW3901MB_VELOCITY_
+#define _EE_PMW3901MB_VELOCITY_
+
+#include "ee_pmw3901mb_driver.h"
+
+
+/**
+ * @brief PMW3901MB field of view, in millidegrees.
+ */
+#define EE_PMW3901MB_FOV_MDEG           42000U
+
+/**
+ * @brief PMW3901MB pixels across the field of view.
+ */
+#define EE_PMW3901MB_PIXELS             35U
+
+/**
+ * @brief Angle of pi in CORDIC angle units (Q15 of pi, i.e. +-32768 is +-180 degrees).
+ */
+#define EE_PMW3901MB_ANGLE_PI           32768
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Velocity estimation of one sensor.
+ */
+typedef struct {
+    uint32_t k_q16;     /**< Radians per count times 1e6 (Q16.16) */
+} ee_pmw3901mb_velocity_t;
+
+
+/**
+ * @brief Initialize velocity estimation from the field of view.
+ * 
+ * @param[out] vel pointer to the velocity estimation
+ * @param[in] fov_mdeg field of view in millidegrees, e.g. EE_PMW3901MB_FOV_MDEG
+ * @param[in] pixels pixels across the field of view, e.g. EE_PMW3901MB_PIXELS
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_velocity_init(ee_pmw3901mb_velocity_t* vel, uint32_t fov_mdeg, uint32_t pixels);
+
+/**
+ * @brief Compute velocity from deltas.
+ * 
+ * @param[in] vel pointer to the velocity estimation
+ * @param[in] delta_x delta X in counts
+ * @param[in] delta_y delta Y in counts
+ * @param[in] dt_us sample interval in microseconds
+ * @param[in] height_mm height above the surface in millimeters
+ * @param[out] vx_mm_s pointer to the return value, velocity X in mm/s (saturated to int32)
+ * @param[out] vy_mm_s pointer to the return value, velocity Y in mm/s (saturated to int32)
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_velocity_compute(const ee_pmw3901mb_velocity_t* vel, int16_t delta_x, int16_t delta_y,
+                                      uint32_t dt_us, uint16_t height_mm, int32_t* vx_mm_s, int32_t* vy_mm_s);
+
+/**
+ * @brief Magnitude and angle of a vector with integer CORDIC.
+ * @note |x| and |y| must be below 2^29. Magnitude error is below 0.01 % + 1 LSB, angle error
+ *       below 0.01 degrees (1 LSB).
+ * 
+ * @param[in] x vector X
+ * @param[in] y vector Y
+ * @param[out] magnitude pointer to the return value, same unit as x and y, can be NULL
+ * @param[out] angle pointer to the return value, atan2(y, x) in units of EE_PMW3901MB_ANGLE_PI, can be NULL
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_cordic_vector(int32_t x, int32_t y, uint32_t* magnitude, int32_t* angle);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_VELOCITY_ */
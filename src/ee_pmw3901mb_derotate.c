@@ -0,0 +1,170 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include "ee_pmw3901mb_derotate.h"
+#include "ee_pmw3901mb_velocity.h"
+
+#define GYRO_MASK       (EE_PMW3901MB_DEROTATE_GYRO_SIZE - 1U)
+#define DEROTATE_PI     3.14159265f
+
+
+// Integral over [u, v] of the rate interpolated between (t0, r0) and (t1, r1), times in us
+static float trapezoid(int32_t t0, float r0, int32_t t1, float r1, int32_t u, int32_t v){
+    float slope = (r1 - r0) / (float) (t1 - t0);
+    float ru = r0 + slope * (float) (u - t0);
+    float rv = r0 + slope * (float) (v - t0);
+    return 0.5f * (ru + rv) * (float) (v - u);
+}
+
+// Output counts of a fractional delta, the rest carried to the next sample
+static int16_t carry_out(float value, float* carry){
+    float v = value + *carry;
+    if(v >= 32767.0f){
+        *carry = 0.0f;
+        return 32767;
+    }
+    if(v <= -32768.0f){
+        *carry = 0.0f;
+        return -32768;
+    }
+    float out = roundf(v);
+    *carry = v - out;
+    return (int16_t) out;
+}
+
+
+uint8_t ee_pmw3901mb_derotate_default_cfg(ee_pmw3901mb_derotate_cfg_t* cfg){
+    if(cfg == NULL) return 1;
+
+    float k = (float) EE_PMW3901MB_PIXELS * 180000.0f / ((float) EE_PMW3901MB_FOV_MDEG * DEROTATE_PI);
+    cfg->counts_per_rad[0][0] = 0.0f;
+    cfg->counts_per_rad[0][1] = -k;
+    cfg->counts_per_rad[1][0] = k;
+    cfg->counts_per_rad[1][1] = 0.0f;
+    cfg->latency_us = 0U;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_derotate_init(ee_pmw3901mb_derotate_t* d, const ee_pmw3901mb_derotate_cfg_t* cfg){
+    if(d == NULL || cfg == NULL) return 1;
+
+    memset(d, 0, sizeof(ee_pmw3901mb_derotate_t));
+    d->cfg = *cfg;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_derotate_push_gyro(ee_pmw3901mb_derotate_t* d, uint32_t time_us, float rate_x, float rate_y){
+    if(d == NULL) return 1;
+    if(d->gyro_n != 0U && (int32_t) (time_us - d->gyro[(d->gyro_n - 1U) & GYRO_MASK].time_us) < 0) return 2; // Error: Out of order
+
+    ee_pmw3901mb_gyro_sample_t* s = &d->gyro[d->gyro_n & GYRO_MASK];
+    s->time_us = time_us;
+    s->rate_x = rate_x;
+    s->rate_y = rate_y;
+    d->gyro_n++;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_derotate_angle(const ee_pmw3901mb_derotate_t* d, uint32_t start_us, uint32_t end_us,
+                                    float* angle_x, float* angle_y){
+    if(d == NULL || angle_x == NULL || angle_y == NULL) return 1;
+
+    *angle_x = 0.0f;
+    *angle_y = 0.0f;
+    int32_t span = (int32_t) (end_us - start_us);
+    if(span <= 0) return 0;
+    if(d->gyro_n == 0U) return 3; // Error: No gyro samples
+
+    // Times relative to the interval start, from the newest sample back to the interval start
+    uint32_t kept = (d->gyro_n < EE_PMW3901MB_DEROTATE_GYRO_SIZE) ? d->gyro_n : EE_PMW3901MB_DEROTATE_GYRO_SIZE;
+    const ee_pmw3901mb_gyro_sample_t* newest = &d->gyro[(d->gyro_n - 1U) & GYRO_MASK];
+    const ee_pmw3901mb_gyro_sample_t* oldest = &d->gyro[(d->gyro_n - kept) & GYRO_MASK];
+    float ax = 0.0f;
+    float ay = 0.0f;
+    uint8_t status_code = 0;
+
+    int32_t t = (int32_t) (newest->time_us - start_us);
+    if(t < span){
+        // Rate held after the newest sample, covered up to one gyro period (the next sample not taken yet)
+        int32_t u = (t > 0) ? t : 0;
+        ax += newest->rate_x * (float) (span - u);
+        ay += newest->rate_y * (float) (span - u);
+        const ee_pmw3901mb_gyro_sample_t* prev = &d->gyro[(d->gyro_n - 2U) & GYRO_MASK];
+        if(kept < 2U || span - t > (int32_t) (newest->time_us - prev->time_us)) status_code = 3;
+    }
+    for(uint32_t k = 1U; k < kept; k++){
+        const ee_pmw3901mb_gyro_sample_t* s1 = &d->gyro[(d->gyro_n - k) & GYRO_MASK];
+        const ee_pmw3901mb_gyro_sample_t* s0 = &d->gyro[(d->gyro_n - k - 1U) & GYRO_MASK];
+        int32_t t1 = (int32_t) (s1->time_us - start_us);
+        int32_t t0 = (int32_t) (s0->time_us - start_us);
+        if(t1 <= 0) break;
+        if(t0 >= span || t1 <= t0) continue;
+        int32_t u = (t0 > 0) ? t0 : 0;
+        int32_t v = (t1 < span) ? t1 : span;
+        ax += trapezoid(t0, s0->rate_x, t1, s1->rate_x, u, v);
+        ay += trapezoid(t0, s0->rate_y, t1, s1->rate_y, u, v);
+    }
+    t = (int32_t) (oldest->time_us - start_us);
+    if(t > 0){
+        // Rate held before the oldest sample
+        int32_t v = (t < span) ? t : span;
+        ax += oldest->rate_x * (float) v;
+        ay += oldest->rate_y * (float) v;
+        status_code = 3;
+    }
+
+    *angle_x = ax * 1e-6f;
+    *angle_y = ay * 1e-6f;
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_derotate_apply(ee_pmw3901mb_derotate_t* d, uint32_t time_us, int16_t delta_x, int16_t delta_y,
+                                    int16_t* out_x, int16_t* out_y){
+    if(d == NULL || out_x == NULL || out_y == NULL) return 1;
+
+    if(!d->started){
+        d->started = true;
+        d->last_us = time_us;
+        *out_x = delta_x;
+        *out_y = delta_y;
+        return 0;
+    }
+
+    float ax = 0.0f;
+    float ay = 0.0f;
+    uint8_t status_code = ee_pmw3901mb_derotate_angle(d, d->last_us - d->cfg.latency_us, time_us - d->cfg.latency_us, &ax, &ay);
+    d->last_us = time_us;
+    if(status_code == 3) d->uncovered++;
+
+    d->rot_x = d->cfg.counts_per_rad[0][0] * ax + d->cfg.counts_per_rad[0][1] * ay;
+    d->rot_y = d->cfg.counts_per_rad[1][0] * ax + d->cfg.counts_per_rad[1][1] * ay;
+    *out_x = carry_out((float) delta_x - d->rot_x, &d->carry_x);
+    *out_y = carry_out((float) delta_y - d->rot_y, &d->carry_y);
+
+    return status_code;
+}
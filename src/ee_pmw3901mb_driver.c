@@ -23,6 +23,9 @@ SOFTWARE.
 */
 
 #include "ee_pmw3901mb_driver.h"
+#include "ee_pmw3901mb_sequences.inc"
+
+#define ARRAY_LEN(a) (sizeof(a) / sizeof((a)[0]))
 
 // Registers List
 #define REG_PRODUCT_ID          0x00 // RO  // Product ID
@@ -39,485 +42,706 @@ SOFTWARE.
 #define REG_SHUTTER_LOWER       0x0B // RO  // (?)
 #define REG_SHUTTER_UPPER       0x0C // RO  // (?)
 #define REG_OBSERVATION         0x15 // R/W // (?)
-#define REG_MOTION_BURST        0x16 // RO  // (?)
+#define REG_MOTION_BURST        0x16 // RO  // Motion Burst, reads 12 bytes in one frame
 #define REG_POWER_UP_RESET      0x3A // WO  // Reset Sensor
 #define REG_SHUTDOWN            0x3B // WO  // Shutdown Sensor
-#define REG_RAWDATA_GRAB        0x58 // R/W // (?)
-#define REG_RAWDATA_GRAB_STATUS 0x59 // RO  // (?)
+#define REG_RAWDATA_GRAB        0x58 // R/W // Raw data grab, write to trigger, read pixel data
+#define REG_RAWDATA_GRAB_STATUS 0x59 // RO  // Raw data grab status, bits [7:6] nonzero when grab ready
 #define REG_INVERSE_PRODUCT_ID  0x5F // RO  // Inverse Product ID
 
+// Motion Burst byte order (read from REG_MOTION_BURST)
+#define BURST_MOTION            0
+#define BURST_OBSERVATION       1
+#define BURST_DELTA_X_L         2
+#define BURST_DELTA_X_H         3
+#define BURST_DELTA_Y_L         4
+#define BURST_DELTA_Y_H         5
+#define BURST_SQUAL             6
+#define BURST_RAWDATA_SUM       7
+#define BURST_MAXIMUM_RAWDATA   8
+#define BURST_MINIMUM_RAWDATA   9
+#define BURST_SHUTTER_UPPER     10
+#define BURST_SHUTTER_LOWER     11
+
 // Register Default Values
 #define DEF_REG_PRODUCT_ID          0x49
 #define DEF_REG_REVERSE_PRODUCT_ID  0xB6
 
 // Performance Optimization Registers (PixArt proprietary information, hence address used as name)
-#define PER_REG_0x40            0x40
-#define PER_REG_0x41            0x41
-#define PER_REG_0x43            0x43
-#define PER_REG_0x44            0x44
-#define PER_REG_0x45            0x45
-#define PER_REG_0x4E            0x4E
-#define PER_REG_0x5B            0x5B
-#define PER_REG_0x5F            0x5F
-#define PER_REG_0x61            0x61
-#define PER_REG_0x7B            0x7B
 #define PER_REG_0x7F            0x7F
 
+// Register write sequences (const, kept in flash), from the lists shared with the C++ front-end
+#define SEQ_STEP(reg, value, delay_ms)  { reg, value, delay_ms },
 
-uint8_t ee_pmw3901mb_init_driver(void* spi_driver, void* spi_config){
-    if(spi_driver == NULL) return 1;
+// Performance optimization sequence
+static const ee_pmw3901mb_reg_write_t perf_opt_table[] = {
+    EE_PMW3901MB_SEQ_PERF_OPT(SEQ_STEP)
+};
 
-    uint8_t status_code = 0;
+// Performance optimization sequence version 2, adapted from Bitcraze_PMW3901 (MIT License)
+static const ee_pmw3901mb_reg_write_t perf_opt_v2_table[] = {
+    EE_PMW3901MB_SEQ_PERF_OPT_V2(SEQ_STEP)
+};
 
-    status_code = ee_pmw3901mb_spi_init(spi_driver, spi_config);
-    if(status_code != 0) return 1;
 
-    status_code = ee_pmw3901mb_power_up_reset();
-    if(status_code != 0) return 1;
-    
-    status_code = ee_pmw3901mb_wait_ms(50U); // Wait 50 ms while system resets
-    if(status_code != 0) return 1;
+// Raw data grab, RAWDATA_GRAB reads carry the pixel half in bits [7:6]
+#define RAWDATA_STATUS_MASK     0xC0
+#define RAWDATA_STATUS_UPPER    0x40 // Pixel bits [7:2] in bits [5:0]
+#define RAWDATA_STATUS_LOWER    0x80 // Pixel bits [1:0] in bits [3:2]
 
-    //status_code = ee_pmw3901mb_perf_opt();
-    status_code = ee_pmw3901mb_perf_opt_v2();
-    if(status_code != 0) return 1;
+// Frame grab mode sequence, leaves the sensor out of motion tracking
+static const ee_pmw3901mb_reg_write_t frame_grab_table[] = {
+    EE_PMW3901MB_SEQ_FRAME_GRAB(SEQ_STEP)
+};
 
-    status_code = ee_pmw3901mb_wait_ms(5U); // Wait 5 ms while system resets
-    if(status_code != 0) return 1;
-    
-    return status_code;
+
+// Default device, used by the functions without a device handle. Its bus is also the
+// default bus of the platform functions without a bus handle.
+static ee_pmw3901mb_dev_t default_dev;
+
+
+uint8_t ee_pmw3901mb_init_driver(void* spi_driver, void* spi_config){
+    return ee_pmw3901mb_dev_init_driver(&default_dev, spi_driver, spi_config);
+}
+
+uint8_t ee_pmw3901mb_init_start(void* spi_driver, void* spi_config){
+    return ee_pmw3901mb_dev_init_start(&default_dev, spi_driver, spi_config);
+}
+
+uint8_t ee_pmw3901mb_init_step(uint32_t* wait_us){
+    return ee_pmw3901mb_dev_init_step(&default_dev, wait_us);
+}
+
+bool ee_pmw3901mb_init_done(void){
+    return ee_pmw3901mb_dev_init_done(&default_dev);
 }
 
 uint8_t ee_pmw3901mb_get_product_id(uint8_t* product_id){
-    if(product_id == NULL) return 1;
-    return ee_pmw3901mb_spi_read(REG_PRODUCT_ID, product_id, 1U);
+    return ee_pmw3901mb_dev_get_product_id(&default_dev, product_id);
 }
 
 uint8_t ee_pmw3901mb_get_revision_id(uint8_t* revision_id){
-    if(revision_id == NULL) return 1;
-    return ee_pmw3901mb_spi_read(REG_REVISION_ID, revision_id, 1U);
+    return ee_pmw3901mb_dev_get_revision_id(&default_dev, revision_id);
 }
 
 uint8_t ee_pmw3901mb_get_delta_x_y(int16_t* delta_x, int16_t* delta_y){
-    if(delta_x == NULL || delta_y == NULL ) return 1;
-    uint8_t status_code = 0;
+    return ee_pmw3901mb_dev_get_delta_x_y(&default_dev, delta_x, delta_y);
+}
 
-    // Must read motion for each time reading changes to delta x and delta y
-    uint8_t motion = 0;
-    status_code = ee_pmw3901mb_spi_read(REG_MOTION, &motion, 1U);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_get_motion_burst(ee_pmw3901mb_motion_burst_t* burst){
+    return ee_pmw3901mb_dev_get_motion_burst(&default_dev, burst);
+}
 
-    uint8_t delta_x_l = 0;
-    uint8_t delta_x_h = 0;
+uint8_t ee_pmw3901mb_get_motion_burst_async(ee_pmw3901mb_motion_burst_cb_t cb, void* arg){
+    return ee_pmw3901mb_dev_get_motion_burst_async(&default_dev, cb, arg);
+}
 
-    status_code = ee_pmw3901mb_spi_read(REG_DELTA_X_L, &delta_x_l, 1U);
-    if(status_code != 0) return status_code;
-    status_code = ee_pmw3901mb_spi_read(REG_DELTA_X_H, &delta_x_h, 1U);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_get_burst_time(uint32_t* assert_us, uint32_t* deassert_us){
+    return ee_pmw3901mb_dev_get_burst_time(&default_dev, assert_us, deassert_us);
+}
 
-    uint8_t delta_y_l = 0;
-    uint8_t delta_y_h = 0;
+uint8_t ee_pmw3901mb_get_jitter(ee_pmw3901mb_jitter_t* jitter){
+    return ee_pmw3901mb_dev_get_jitter(&default_dev, jitter);
+}
 
-    status_code = ee_pmw3901mb_spi_read(REG_DELTA_Y_L, &delta_y_l, 1U);
-    if(status_code != 0) return status_code;
-    status_code = ee_pmw3901mb_spi_read(REG_DELTA_Y_H, &delta_y_h, 1U);
-    if(status_code != 0) return status_code;
-    
-    *delta_x = (int16_t) ((delta_x_h << 8) | (delta_x_l));
-    *delta_y = (int16_t) ((delta_y_h << 8) | (delta_y_l));
+uint8_t ee_pmw3901mb_reset_jitter(void){
+    return ee_pmw3901mb_dev_reset_jitter(&default_dev);
+}
 
-    return status_code;
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+uint8_t ee_pmw3901mb_get_stats(ee_pmw3901mb_stats_t* stats){
+    return ee_pmw3901mb_dev_get_stats(&default_dev, stats);
+}
+
+uint8_t ee_pmw3901mb_reset_stats(void){
+    return ee_pmw3901mb_dev_reset_stats(&default_dev);
 }
+#endif
 
 uint8_t ee_pmw3901mb_power_up_reset(void){
-    uint8_t value = 0x5A;
-    return ee_pmw3901mb_spi_write(REG_POWER_UP_RESET, &value);
+    return ee_pmw3901mb_dev_power_up_reset(&default_dev);
 }
 
 uint8_t ee_pmw3901mb_shutdown(void){
-    uint8_t value = 0x00;
-    return ee_pmw3901mb_spi_write(REG_SHUTDOWN, &value);
+    return ee_pmw3901mb_dev_shutdown(&default_dev);
 }
 
 uint8_t ee_pmw3901mb_get_inverse_product_id(uint8_t* inv_product_id){
-    if(inv_product_id == NULL) return 1;
-    return ee_pmw3901mb_spi_read(REG_INVERSE_PRODUCT_ID, inv_product_id, 1U);
+    return ee_pmw3901mb_dev_get_inverse_product_id(&default_dev, inv_product_id);
 }
 
 uint8_t ee_pmw3901mb_perf_opt(void){
+    return ee_pmw3901mb_dev_perf_opt(&default_dev);
+}
+
+uint8_t ee_pmw3901mb_perf_opt_v2(void){
+    return ee_pmw3901mb_dev_perf_opt_v2(&default_dev);
+}
+
+uint8_t ee_pmw3901mb_write_sequence(const ee_pmw3901mb_reg_write_t* seq, size_t len, size_t* failed_step){
+    return ee_pmw3901mb_dev_write_sequence(&default_dev, seq, len, failed_step);
+}
+
+uint8_t ee_pmw3901mb_frame_grab_enable(void){
+    return ee_pmw3901mb_dev_frame_grab_enable(&default_dev);
+}
+
+uint8_t ee_pmw3901mb_frame_grab(uint8_t* frame){
+    return ee_pmw3901mb_dev_frame_grab(&default_dev, frame);
+}
+
+uint8_t ee_pmw3901mb_acquire(void){
+    return ee_pmw3901mb_dev_acquire(&default_dev);
+}
+
+uint8_t ee_pmw3901mb_release(void){
+    return ee_pmw3901mb_dev_release(&default_dev);
+}
+
+
+ee_pmw3901mb_dev_t* ee_pmw3901mb_get_default_dev(void){
+    return &default_dev;
+}
+
+// Time left until a due time, 0 when due
+static uint32_t time_left_us(uint32_t due_us, uint32_t now_us){
+    int32_t left = (int32_t) (due_us - now_us);
+    return (left > 0) ? (uint32_t) left : 0U;
+}
+
+static void startup_enter(ee_pmw3901mb_startup_t* st, ee_pmw3901mb_startup_state_t state, uint32_t now_us){
+    st->state = state;
+    st->state_us = now_us;
+    st->due_us = now_us;
+    st->polls = 0;
+}
+
+static uint8_t startup_fail(ee_pmw3901mb_startup_t* st){
+    st->failed_state = st->state;
+    st->state = EE_PMW3901MB_STARTUP_FAILED;
+    return 1;
+}
+
+// Schedules the next readiness poll, or fails after the timeout. The poll count also bounds
+// the wait on a time base that does not advance.
+static uint8_t startup_poll_again(ee_pmw3901mb_startup_t* st, uint32_t now_us, uint32_t timeout_ms){
+    uint32_t max_polls = (timeout_ms * 1000U) / EE_PMW3901MB_STARTUP_POLL_US + 1U;
+    st->polls++;
+    if(now_us - st->state_us >= timeout_ms * 1000U || st->polls >= max_polls) return startup_fail(st);
+    st->due_us = now_us + EE_PMW3901MB_STARTUP_POLL_US;
+    return 0;
+}
+
+// Runs the due steps, within a bus session
+static uint8_t startup_run(ee_pmw3901mb_dev_t* dev, uint32_t* wait_us){
+    ee_pmw3901mb_startup_t* st = &dev->startup;
     uint8_t status_code = 0;
-    uint8_t value = 0x00;
 
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x7F, &value);
-    if(status_code != 0) return status_code;
+    for(;;){
+        uint32_t now_us = ee_pmw3901mb_time_us();
+        *wait_us = time_left_us(st->due_us, now_us);
+        if(st->state == EE_PMW3901MB_STARTUP_READY || *wait_us != 0U) return 0;
+
+        switch(st->state){
+        case EE_PMW3901MB_STARTUP_BOOT: {
+            // The ID pair reads back once the sensor booted
+            uint8_t product_id = 0;
+            uint8_t inv_product_id = 0;
+            status_code = ee_pmw3901mb_dev_get_product_id(dev, &product_id);
+            if(status_code == 0) status_code = ee_pmw3901mb_dev_get_inverse_product_id(dev, &inv_product_id);
+            if(status_code != 0) return startup_fail(st);
+
+            if(product_id == DEF_REG_PRODUCT_ID && inv_product_id == DEF_REG_REVERSE_PRODUCT_ID){
+                if(st->hold){
+                    startup_enter(st, EE_PMW3901MB_STARTUP_BOOTED, now_us);
+                    *wait_us = 0;
+                    return 0;
+                }
+                startup_enter(st, EE_PMW3901MB_STARTUP_TUNE, now_us);
+                st->step = 0;
+            }else{
+                status_code = startup_poll_again(st, now_us, EE_PMW3901MB_BOOT_TIMEOUT_MS);
+                if(status_code != 0) return status_code;
+            }
+            break;
+        }
+        case EE_PMW3901MB_STARTUP_TUNE: {
+            // Writes up to the next step with a delay, the delay is left to the caller
+            const ee_pmw3901mb_reg_write_t* step = &perf_opt_v2_table[st->step];
+            uint8_t value = step->value;
+            status_code = ee_pmw3901mb_spi_bus_write(&dev->bus, step->reg, &value);
+            if(status_code != 0) return startup_fail(st);
+            st->step++;
+            if(step->delay_ms != 0U) st->due_us = ee_pmw3901mb_time_us() + (uint32_t) step->delay_ms * 1000U;
+
+            if(st->step >= ARRAY_LEN(perf_opt_v2_table)){
+                // Observation bits are set again by the next frame
+                value = 0x00;
+                status_code = ee_pmw3901mb_spi_bus_write(&dev->bus, REG_OBSERVATION, &value);
+                if(status_code != 0) return startup_fail(st);
+                uint32_t due_us = st->due_us;
+                startup_enter(st, EE_PMW3901MB_STARTUP_FRAME, now_us);
+                st->due_us = (time_left_us(due_us, now_us) != 0U) ? due_us : now_us + EE_PMW3901MB_STARTUP_POLL_US;
+            }
+            break;
+        }
+        case EE_PMW3901MB_STARTUP_FRAME: {
+            uint8_t observation = 0;
+            status_code = ee_pmw3901mb_spi_bus_read(&dev->bus, REG_OBSERVATION, &observation, 1U);
+            if(status_code != 0) return startup_fail(st);
+
+            if(observation != 0x00){
+                startup_enter(st, EE_PMW3901MB_STARTUP_READY, now_us);
+                st->ready_us = now_us - st->start_us;
+                dev->initialized = true;
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+                ee_pmw3901mb_hist_add(&dev->latency[EE_PMW3901MB_OP_INIT], st->ready_us);
+#endif
+            }else{
+                status_code = startup_poll_again(st, now_us, EE_PMW3901MB_FRAME_TIMEOUT_MS);
+                if(status_code != 0) return status_code;
+            }
+            break;
+        }
+        default:
+            return 1; // Error: Not started or failed
+        }
+    }
+}
 
-    value = 0xAD;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x61, &value);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_dev_init_start(ee_pmw3901mb_dev_t* dev, void* spi_driver, void* spi_config){
+    if(dev == NULL || spi_driver == NULL) return 1;
+
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    // A re-initialized handle stays on its bus scheduler (e.g. a recovery)
+    ee_pmw3901mb_spi_sched_t* sched = dev->bus.sched;
+    uint8_t sched_priority = dev->bus.priority;
+    uint32_t sched_deadline_us = dev->bus.deadline_us;
+#endif
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+    // Statistics survive re-initialization of the handle
+    ee_pmw3901mb_stats_t stats;
+    ee_pmw3901mb_dev_get_stats(dev, &stats);
+    memset(dev, 0, sizeof(ee_pmw3901mb_dev_t));
+    dev->bus.counters = stats.bus;
+    memcpy(dev->latency, stats.latency, sizeof(dev->latency));
+#else
+    memset(dev, 0, sizeof(ee_pmw3901mb_dev_t));
+#endif
+
+    uint8_t status_code = ee_pmw3901mb_spi_bus_init(&dev->bus, spi_driver, spi_config);
+    if(status_code != 0) return 1;
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    if(sched != NULL) (void) ee_pmw3901mb_spi_bus_set_sched(&dev->bus, sched, sched_priority, sched_deadline_us);
+#endif
 
-    value = 0x03;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x7F, &value);
-    if(status_code != 0) return status_code;
+    status_code = ee_pmw3901mb_dev_power_up_reset(dev);
+    if(status_code != 0) return 1;
 
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x40, &value);
-    if(status_code != 0) return status_code;
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    dev->startup.start_us = now_us;
+    startup_enter(&dev->startup, EE_PMW3901MB_STARTUP_BOOT, now_us);
 
-    value = 0x05;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x7F, &value);
-    if(status_code != 0) return status_code;
+    return 0;
+}
 
-    value = 0xB3;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x41, &value);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_dev_init_step(ee_pmw3901mb_dev_t* dev, uint32_t* wait_us){
+    if(dev == NULL) return 1;
+    uint32_t left_us = 0;
+
+    switch(dev->startup.state){
+    case EE_PMW3901MB_STARTUP_BOOT:
+    case EE_PMW3901MB_STARTUP_TUNE:
+    case EE_PMW3901MB_STARTUP_FRAME:
+        break;
+    case EE_PMW3901MB_STARTUP_BOOTED:
+    case EE_PMW3901MB_STARTUP_READY:
+        if(wait_us != NULL) *wait_us = 0;
+        return 0;
+    default:
+        return 1; // Error: Not started or failed
+    }
+
+    // Bus session only for due steps, the bus is free while waiting
+    left_us = time_left_us(dev->startup.due_us, ee_pmw3901mb_time_us());
+    if(left_us == 0U){
+        uint8_t status_code = ee_pmw3901mb_dev_acquire(dev);
+        if(status_code != 0) return status_code;
+        status_code = startup_run(dev, &left_us);
+        ee_pmw3901mb_dev_release(dev);
+        if(status_code != 0) return status_code;
+    }
+
+    if(wait_us != NULL) *wait_us = left_us;
+    return 0;
+}
 
-    value = 0xF1;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x43, &value);
-    if(status_code != 0) return status_code;
+bool ee_pmw3901mb_dev_init_done(const ee_pmw3901mb_dev_t* dev){
+    return dev != NULL && dev->startup.state == EE_PMW3901MB_STARTUP_READY;
+}
 
-    value = 0x14;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x45, &value);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_dev_boot_start(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL || dev->bus.spi_driver == NULL) return 1;
 
-    value = 0x32;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x5B, &value);
+    dev->initialized = false;
+    uint8_t status_code = ee_pmw3901mb_dev_power_up_reset(dev);
     if(status_code != 0) return status_code;
 
-    value = 0x34;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x5F, &value);
-    if(status_code != 0) return status_code;
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    dev->startup.start_us = now_us;
+    dev->startup.hold = true;
+    startup_enter(&dev->startup, EE_PMW3901MB_STARTUP_BOOT, now_us);
 
-    value = 0x08;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x7B, &value);
-    if(status_code != 0) return status_code;
+    return 0;
+}
 
-    value = 0x06;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x7F, &value);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_dev_retune_start(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL || dev->bus.spi_driver == NULL) return 1;
 
-    value = 0x1B;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x44, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xBF;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x40, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x3F;
-    status_code = ee_pmw3901mb_spi_write(PER_REG_0x4E, &value);
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    dev->initialized = false;
+    if(dev->startup.state != EE_PMW3901MB_STARTUP_BOOTED) dev->startup.start_us = now_us;
+    dev->startup.hold = false;
+    startup_enter(&dev->startup, EE_PMW3901MB_STARTUP_TUNE, now_us);
+    dev->startup.step = 0;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_dev_check_tuning(ee_pmw3901mb_dev_t* dev, bool* tuned){
+    if(dev == NULL || tuned == NULL) return 1;
+
+    // Last bank 0 write of the sequence, back to its power up value after a reset
+    const ee_pmw3901mb_reg_write_t* canary = NULL;
+    uint8_t bank = 0;
+    for(size_t i = 0; i < ARRAY_LEN(perf_opt_v2_table); i++){
+        if(perf_opt_v2_table[i].reg == PER_REG_0x7F) bank = perf_opt_v2_table[i].value;
+        else if(bank == 0U) canary = &perf_opt_v2_table[i];
+    }
+    if(canary == NULL) return 1;
+
+    uint8_t value = 0;
+    uint8_t status_code = ee_pmw3901mb_spi_bus_read(&dev->bus, canary->reg, &value, 1U);
     if(status_code != 0) return status_code;
 
-    return status_code; // Success
+    *tuned = (value == canary->value);
+    return 0;
 }
 
-uint8_t ee_pmw3901mb_perf_opt_v2(void){
+uint8_t ee_pmw3901mb_dev_init_finish(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
 
-    /*
-    * Some parts of this file include code adapted from:
-    * https://github.com/bitcraze/Bitcraze_PMW3901
-    * Licensed under the MIT License.
-    *
-    * Copyright (c) 2017 Bitcraze
-    */
-    
+    // Bound on the total wait, also on a time base that does not advance
+    uint32_t max_wait_ms = EE_PMW3901MB_BOOT_TIMEOUT_MS + EE_PMW3901MB_FRAME_TIMEOUT_MS;
+    for(size_t i = 0; i < ARRAY_LEN(perf_opt_v2_table); i++) max_wait_ms += perf_opt_v2_table[i].delay_ms;
+    uint32_t waited_ms = 0;
     uint8_t status_code = 0;
-    uint8_t value = 0x00;
 
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
+    for(;;){
+        uint32_t wait_us = 0;
+        status_code = ee_pmw3901mb_dev_init_step(dev, &wait_us);
+        if(status_code != 0 || dev->initialized || dev->startup.state == EE_PMW3901MB_STARTUP_BOOTED) break;
+
+        uint32_t wait_ms = (wait_us + 999U) / 1000U;
+        waited_ms += wait_ms;
+        if(waited_ms > max_wait_ms){
+            status_code = startup_fail(&dev->startup);
+            break;
+        }
+        status_code = ee_pmw3901mb_wait_ms(wait_ms);
+        if(status_code != 0) break;
+    }
 
-    value = 0xAD;
-    status_code = ee_pmw3901mb_spi_write(0x61, &value);
-    if(status_code != 0) return status_code;
+    return status_code;
+}
 
-    value = 0x03;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
+uint8_t ee_pmw3901mb_dev_init_driver(ee_pmw3901mb_dev_t* dev, void* spi_driver, void* spi_config){
+    uint8_t status_code = ee_pmw3901mb_dev_init_start(dev, spi_driver, spi_config);
     if(status_code != 0) return status_code;
 
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(0x40, &value);
-    if(status_code != 0) return status_code;
+    return ee_pmw3901mb_dev_init_finish(dev);
+}
 
-    value = 0x05;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xB3;
-    status_code = ee_pmw3901mb_spi_write(0x41, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xF1;
-    status_code = ee_pmw3901mb_spi_write(0x43, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x14;
-    status_code = ee_pmw3901mb_spi_write(0x45, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x32;
-    status_code = ee_pmw3901mb_spi_write(0x5B, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x34;
-    status_code = ee_pmw3901mb_spi_write(0x5F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x08;
-    status_code = ee_pmw3901mb_spi_write(0x7B, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x06;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x1B;
-    status_code = ee_pmw3901mb_spi_write(0x44, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xBF;
-    status_code = ee_pmw3901mb_spi_write(0x40, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x3F;
-    status_code = ee_pmw3901mb_spi_write(0x4E, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x08;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x20;
-    status_code = ee_pmw3901mb_spi_write(0x65, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x18;
-    status_code = ee_pmw3901mb_spi_write(0x6A, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x09;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xAF;
-    status_code = ee_pmw3901mb_spi_write(0x4F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x40;
-    status_code = ee_pmw3901mb_spi_write(0x5F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x80;
-    status_code = ee_pmw3901mb_spi_write(0x48, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x80;
-    status_code = ee_pmw3901mb_spi_write(0x49, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x77;
-    status_code = ee_pmw3901mb_spi_write(0x57, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x78;
-    status_code = ee_pmw3901mb_spi_write(0x60, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x78;
-    status_code = ee_pmw3901mb_spi_write(0x61, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x08;
-    status_code = ee_pmw3901mb_spi_write(0x62, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x50;
-    status_code = ee_pmw3901mb_spi_write(0x63, &value);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_dev_get_product_id(ee_pmw3901mb_dev_t* dev, uint8_t* product_id){
+    if(dev == NULL || product_id == NULL) return 1;
+    return ee_pmw3901mb_spi_bus_read(&dev->bus, REG_PRODUCT_ID, product_id, 1U);
+}
 
-    value = 0x0A;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x60;
-    status_code = ee_pmw3901mb_spi_write(0x45, &value);
-    if(status_code != 0) return status_code;
+uint8_t ee_pmw3901mb_dev_get_revision_id(ee_pmw3901mb_dev_t* dev, uint8_t* revision_id){
+    if(dev == NULL || revision_id == NULL) return 1;
+    return ee_pmw3901mb_spi_bus_read(&dev->bus, REG_REVISION_ID, revision_id, 1U);
+}
 
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x11;
-    status_code = ee_pmw3901mb_spi_write(0x4D, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x80;
-    status_code = ee_pmw3901mb_spi_write(0x55, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x1F;
-    status_code = ee_pmw3901mb_spi_write(0x74, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x1F;
-    status_code = ee_pmw3901mb_spi_write(0x75, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x78;
-    status_code = ee_pmw3901mb_spi_write(0x4A, &value);
+static void decode_motion_burst(const uint8_t* buf, ee_pmw3901mb_motion_burst_t* burst){
+    burst->motion       = buf[BURST_MOTION];
+    burst->observation  = buf[BURST_OBSERVATION];
+    burst->delta_x      = (int16_t) ((buf[BURST_DELTA_X_H] << 8) | (buf[BURST_DELTA_X_L]));
+    burst->delta_y      = (int16_t) ((buf[BURST_DELTA_Y_H] << 8) | (buf[BURST_DELTA_Y_L]));
+    burst->squal        = buf[BURST_SQUAL];
+    burst->rawdata_sum  = buf[BURST_RAWDATA_SUM];
+    burst->max_rawdata  = buf[BURST_MAXIMUM_RAWDATA];
+    burst->min_rawdata  = buf[BURST_MINIMUM_RAWDATA];
+    burst->shutter      = (uint16_t) ((buf[BURST_SHUTTER_UPPER] << 8) | (buf[BURST_SHUTTER_LOWER]));
+}
+
+// Latches the chip select times of a motion burst and adds the interval to the statistics
+static void motion_burst_timed(ee_pmw3901mb_dev_t* dev){
+    ee_pmw3901mb_jitter_t* j = &dev->jitter;
+    uint32_t t = dev->bus.cs_assert_us;
+
+    dev->burst_assert_us = t;
+    dev->burst_deassert_us = dev->bus.cs_deassert_us;
+
+    if(j->reads > 0U){
+        uint32_t interval = t - j->last_us;
+        uint32_t n = j->reads; // Intervals including this one
+        if(n == 1U || interval < j->min_us) j->min_us = interval;
+        if(n == 1U || interval > j->max_us) j->max_us = interval;
+        float delta = (float) interval - j->mean_us;
+        j->mean_us += delta / (float) n;
+        j->m2 += delta * ((float) interval - j->mean_us);
+    }
+    j->last_us = t;
+    j->reads++;
+}
+
+// Reads a motion burst, without latency statistics so each public read records its own operation
+static uint8_t motion_burst_read(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_t* burst){
+    uint8_t buf[EE_PMW3901MB_MOTION_BURST_SIZE];
+    uint8_t status_code = ee_pmw3901mb_spi_bus_read(&dev->bus, REG_MOTION_BURST, buf, EE_PMW3901MB_MOTION_BURST_SIZE);
     if(status_code != 0) return status_code;
-    
-    value = 0x78;
-    status_code = ee_pmw3901mb_spi_write(0x4B, &value);
+
+    decode_motion_burst(buf, burst);
+
+    dev->last_burst = *burst;
+    motion_burst_timed(dev);
+
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_dev_get_delta_x_y(ee_pmw3901mb_dev_t* dev, int16_t* delta_x, int16_t* delta_y){
+    if(dev == NULL || delta_x == NULL || delta_y == NULL ) return 1;
+    uint8_t status_code = 0;
+
+    // Motion burst reads motion and latched delta x and delta y in one transaction. A failed read
+    // is counted in the bus errors, the latency histograms hold completed operations only.
+    EE_PMW3901MB_STATS_TIME_START(t_start);
+    ee_pmw3901mb_motion_burst_t burst;
+    status_code = motion_burst_read(dev, &burst);
+    EE_PMW3901MB_STATS_TIME_END(&dev->latency[EE_PMW3901MB_OP_DELTA], t_start, status_code);
     if(status_code != 0) return status_code;
-    
-    value = 0x08;
-    status_code = ee_pmw3901mb_spi_write(0x44, &value);
+
+    *delta_x = burst.delta_x;
+    *delta_y = burst.delta_y;
+
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_dev_get_motion_burst(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_t* burst){
+    if(dev == NULL || burst == NULL) return 1;
+    uint8_t status_code = 0;
+
+    // As for the delta read, only completed reads add to the latency histogram
+    EE_PMW3901MB_STATS_TIME_START(t_start);
+    status_code = motion_burst_read(dev, burst);
+    EE_PMW3901MB_STATS_TIME_END(&dev->latency[EE_PMW3901MB_OP_BURST], t_start, status_code);
+
+    return status_code;
+}
+
+static void motion_burst_async_done(ee_pmw3901mb_spi_bus_t* bus, const uint8_t* data, size_t n, void* arg){
+    (void) bus;
+    (void) n;
+    ee_pmw3901mb_dev_t* dev = (ee_pmw3901mb_dev_t*) arg;
+
+    decode_motion_burst(data, &dev->last_burst);
+    motion_burst_timed(dev);
+    EE_PMW3901MB_STATS_TIME_END(&dev->latency[EE_PMW3901MB_OP_BURST], dev->async_start_us, 0U);
+
+    if(dev->async_cb != NULL) dev->async_cb(dev, &dev->last_burst, dev->async_arg);
+}
+
+uint8_t ee_pmw3901mb_dev_get_motion_burst_async(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_motion_burst_cb_t cb, void* arg){
+    if(dev == NULL) return 1;
+    if(ee_pmw3901mb_spi_bus_async_busy(&dev->bus)) return 2; // Error: Previous read in flight
+
+    dev->async_cb = cb;
+    dev->async_arg = arg;
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+    dev->async_start_us = ee_pmw3901mb_time_us();
+#endif
+    return ee_pmw3901mb_spi_bus_read_async(&dev->bus, REG_MOTION_BURST, EE_PMW3901MB_MOTION_BURST_SIZE,
+                                           motion_burst_async_done, dev);
+}
+
+uint8_t ee_pmw3901mb_dev_get_burst_time(ee_pmw3901mb_dev_t* dev, uint32_t* assert_us, uint32_t* deassert_us){
+    if(dev == NULL) return 1;
+    if(assert_us != NULL) *assert_us = dev->burst_assert_us;
+    if(deassert_us != NULL) *deassert_us = dev->burst_deassert_us;
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_dev_get_jitter(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_jitter_t* jitter){
+    if(dev == NULL || jitter == NULL) return 1;
+    *jitter = dev->jitter;
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_dev_reset_jitter(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    memset(&dev->jitter, 0, sizeof(ee_pmw3901mb_jitter_t));
+    return 0;
+}
+
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+uint8_t ee_pmw3901mb_dev_get_stats(ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_stats_t* stats){
+    if(dev == NULL || stats == NULL) return 1;
+    stats->bus = dev->bus.counters;
+    memcpy(stats->latency, dev->latency, sizeof(stats->latency));
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_dev_reset_stats(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    memset(&dev->bus.counters, 0, sizeof(dev->bus.counters));
+    memset(dev->latency, 0, sizeof(dev->latency));
+    return 0;
+}
+#endif
+
+float ee_pmw3901mb_jitter_variance(const ee_pmw3901mb_jitter_t* jitter){
+    if(jitter == NULL || jitter->reads < 2U) return 0.0f;
+    return jitter->m2 / (float) (jitter->reads - 1U);
+}
+
+uint8_t ee_pmw3901mb_dev_power_up_reset(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    uint8_t value = 0x5A;
+    return ee_pmw3901mb_spi_bus_write(&dev->bus, REG_POWER_UP_RESET, &value);
+}
+
+uint8_t ee_pmw3901mb_dev_shutdown(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    uint8_t value = 0x00;
+    return ee_pmw3901mb_spi_bus_write(&dev->bus, REG_SHUTDOWN, &value);
+}
+
+uint8_t ee_pmw3901mb_dev_get_inverse_product_id(ee_pmw3901mb_dev_t* dev, uint8_t* inv_product_id){
+    if(dev == NULL || inv_product_id == NULL) return 1;
+    return ee_pmw3901mb_spi_bus_read(&dev->bus, REG_INVERSE_PRODUCT_ID, inv_product_id, 1U);
+}
+
+
+uint8_t ee_pmw3901mb_dev_perf_opt(ee_pmw3901mb_dev_t* dev){
+    return ee_pmw3901mb_dev_write_sequence(dev, perf_opt_table, ARRAY_LEN(perf_opt_table), NULL);
+}
+
+uint8_t ee_pmw3901mb_dev_perf_opt_v2(ee_pmw3901mb_dev_t* dev){
+    return ee_pmw3901mb_dev_write_sequence(dev, perf_opt_v2_table, ARRAY_LEN(perf_opt_v2_table), NULL);
+}
+
+uint8_t ee_pmw3901mb_dev_write_sequence(ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_reg_write_t* seq, size_t len, size_t* failed_step){
+    if(dev == NULL || seq == NULL) return 1;
+
+    uint8_t status_code = ee_pmw3901mb_dev_acquire(dev);
     if(status_code != 0) return status_code;
-    
-    value = 0x50;
-    status_code = ee_pmw3901mb_spi_write(0x45, &value);
+
+    size_t i = 0;
+    for(i = 0; i < len; i++){
+        uint8_t value = seq[i].value;
+        status_code = ee_pmw3901mb_spi_bus_write(&dev->bus, seq[i].reg, &value);
+        if(status_code != 0) break;
+
+        if(seq[i].delay_ms != 0U){
+            status_code = ee_pmw3901mb_wait_ms(seq[i].delay_ms);
+            if(status_code != 0) break;
+        }
+    }
+
+    if(failed_step != NULL) *failed_step = i; // Equals len on success
+
+    ee_pmw3901mb_dev_release(dev);
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_dev_frame_grab_enable(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    uint8_t status_code = ee_pmw3901mb_dev_write_sequence(dev, frame_grab_table, ARRAY_LEN(frame_grab_table), NULL);
     if(status_code != 0) return status_code;
-    
+
+    dev->initialized = false; // Motion tracking needs ee_pmw3901mb_dev_init_driver() again
+    return status_code;
+}
+
+static uint8_t frame_grab_pixels(ee_pmw3901mb_dev_t* dev, uint8_t* frame){
+    uint8_t status_code = 0;
+    uint8_t value = 0;
+    uint32_t polls = 0;
+
+    // Trigger the grab, then wait until the sensor flags the frame as latched
     value = 0xFF;
-    status_code = ee_pmw3901mb_spi_write(0x64, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x1F;
-    status_code = ee_pmw3901mb_spi_write(0x65, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x14;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x60;
-    status_code = ee_pmw3901mb_spi_write(0x65, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x08;
-    status_code = ee_pmw3901mb_spi_write(0x66, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x78;
-    status_code = ee_pmw3901mb_spi_write(0x63, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x15;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x58;
-    status_code = ee_pmw3901mb_spi_write(0x48, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x07;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x0D;
-    status_code = ee_pmw3901mb_spi_write(0x41, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x14;
-    status_code = ee_pmw3901mb_spi_write(0x43, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x0E;
-    status_code = ee_pmw3901mb_spi_write(0x4B, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x0F;
-    status_code = ee_pmw3901mb_spi_write(0x45, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x42;
-    status_code = ee_pmw3901mb_spi_write(0x44, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x80;
-    status_code = ee_pmw3901mb_spi_write(0x4C, &value);
+    status_code = ee_pmw3901mb_spi_bus_write(&dev->bus, REG_RAWDATA_GRAB, &value);
     if(status_code != 0) return status_code;
-    
-    value = 0x10;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x02;
-    status_code = ee_pmw3901mb_spi_write(0x5B, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x07;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x41;
-    status_code = ee_pmw3901mb_spi_write(0x40, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(0x70, &value);
-    if(status_code != 0) return status_code;
-    
-    ee_pmw3901mb_wait_ms(100U);
 
-    value = 0x44;
-    status_code = ee_pmw3901mb_spi_write(0x32, &value);
-    if(status_code != 0) return status_code;
+    do{
+        if(polls++ >= EE_PMW3901MB_FRAME_GRAB_MAX_POLLS) return 2; // Error: Grab not ready
+        if(polls > 1U) EE_PMW3901MB_STATS_ADD(dev->bus.counters.retries, 1U);
+        status_code = ee_pmw3901mb_spi_bus_read(&dev->bus, REG_RAWDATA_GRAB_STATUS, &value, 1U);
+        if(status_code != 0) return status_code;
+    }while((value & RAWDATA_STATUS_MASK) == 0U);
 
-    value = 0x07;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x40;
-    status_code = ee_pmw3901mb_spi_write(0x40, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x06;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xF0;
-    status_code = ee_pmw3901mb_spi_write(0x62, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(0x63, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x0D;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xC0;
-    status_code = ee_pmw3901mb_spi_write(0x48, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xD5;
-    status_code = ee_pmw3901mb_spi_write(0x6F, &value);
-    if(status_code != 0) return status_code;
-    
     value = 0x00;
-    status_code = ee_pmw3901mb_spi_write(0x7F, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xA0;
-    status_code = ee_pmw3901mb_spi_write(0x5B, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0xA8;
-    status_code = ee_pmw3901mb_spi_write(0x4E, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x50;
-    status_code = ee_pmw3901mb_spi_write(0x5A, &value);
-    if(status_code != 0) return status_code;
-    
-    value = 0x80;
-    status_code = ee_pmw3901mb_spi_write(0x40, &value);
+    status_code = ee_pmw3901mb_spi_bus_write(&dev->bus, REG_RAWDATA_GRAB, &value);
+    if(status_code != 0) return status_code;
+
+    // Each pixel arrives as an upper 6 bit read followed by a lower 2 bit read,
+    // reads without either status carry no data and only count against the poll budget
+    size_t i = 0;
+    polls = 0;
+    while(i < EE_PMW3901MB_FRAME_SIZE){
+        status_code = ee_pmw3901mb_spi_bus_read(&dev->bus, REG_RAWDATA_GRAB, &value, 1U);
+        if(status_code != 0) return status_code;
+
+        switch(value & RAWDATA_STATUS_MASK){
+            case RAWDATA_STATUS_UPPER:
+                frame[i] = (uint8_t) ((value & 0x3FU) << 2);
+                break;
+            case RAWDATA_STATUS_LOWER:
+                frame[i] = (uint8_t) (frame[i] | ((value & 0x0CU) >> 2));
+                i++;
+                polls = 0;
+                break;
+            default:
+                if(polls++ >= EE_PMW3901MB_FRAME_GRAB_MAX_POLLS) return 3; // Error: Pixel data stalled
+                EE_PMW3901MB_STATS_ADD(dev->bus.counters.retries, 1U);
+                break;
+        }
+    }
+
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_dev_frame_grab(ee_pmw3901mb_dev_t* dev, uint8_t* frame){
+    if(dev == NULL || frame == NULL) return 1;
+
+    // One session for the trigger, status polling and all pixel reads
+    EE_PMW3901MB_STATS_TIME_START(t_start);
+    uint8_t status_code = ee_pmw3901mb_dev_acquire(dev);
     if(status_code != 0) return status_code;
 
-    return status_code; // Success
+    status_code = frame_grab_pixels(dev, frame);
+
+    ee_pmw3901mb_dev_release(dev);
+    EE_PMW3901MB_STATS_TIME_END(&dev->latency[EE_PMW3901MB_OP_FRAME_GRAB], t_start, status_code);
+    return status_code;
 }
 
+uint8_t ee_pmw3901mb_dev_acquire(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    return ee_pmw3901mb_spi_bus_acquire(&dev->bus);
+}
+
+uint8_t ee_pmw3901mb_dev_release(ee_pmw3901mb_dev_t* dev){
+    if(dev == NULL) return 1;
+    return ee_pmw3901mb_spi_bus_release(&dev->bus);
+}
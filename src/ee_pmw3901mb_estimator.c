@@ -0,0 +1,131 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include "ee_pmw3901mb_estimator.h"
+#include "ee_pmw3901mb_quality.h"
+#include "ee_pmw3901mb_velocity.h"
+
+#define ESTIMATOR_PI            3.14159265f
+#define DEF_ACCEL_NOISE         2000.0f
+#define DEF_COUNT_NOISE         0.5f
+#define DEF_VELOCITY_STD        1000.0f
+#define DEF_GATE_SIGMA          5.0f
+#define DEF_MIN_SCORE           128U    // As the quality gate default
+
+
+uint8_t ee_pmw3901mb_estimator_default_cfg(ee_pmw3901mb_estimator_cfg_t* cfg){
+    if(cfg == NULL) return 1;
+
+    cfg->accel_noise = DEF_ACCEL_NOISE;
+    cfg->count_noise = DEF_COUNT_NOISE;
+    cfg->velocity_std = DEF_VELOCITY_STD;
+    cfg->gate_sigma = DEF_GATE_SIGMA;
+    cfg->min_score = DEF_MIN_SCORE;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_estimator_init(ee_pmw3901mb_estimator_t* est, const ee_pmw3901mb_estimator_cfg_t* cfg){
+    if(est == NULL || cfg == NULL) return 1;
+    if(cfg->accel_noise < 0.0f || cfg->count_noise <= 0.0f || cfg->velocity_std < 0.0f) return 2; // Error: Invalid noise
+
+    memset(est, 0, sizeof(ee_pmw3901mb_estimator_t));
+    est->cfg = *cfg;
+    est->rad_per_count = (float) EE_PMW3901MB_FOV_MDEG * (ESTIMATOR_PI / 180000.0f) / (float) EE_PMW3901MB_PIXELS;
+    est->p_vv = cfg->velocity_std * cfg->velocity_std;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_estimator_predict(ee_pmw3901mb_estimator_t* est, uint32_t dt_us){
+    if(est == NULL) return 1;
+
+    // Constant velocity, white noise acceleration: Q = q * [dt^4/4 dt^3/2; dt^3/2 dt^2]
+    float dt = (float) dt_us * 1e-6f;
+    float q = est->cfg.accel_noise * est->cfg.accel_noise;
+    float dt2 = dt * dt;
+    for(uint32_t a = 0; a < 2U; a++) est->pos[a] += est->vel[a] * dt;
+    est->p_pp += dt * (2.0f * est->p_pv + dt * est->p_vv) + q * dt2 * dt2 * 0.25f;
+    est->p_pv += dt * est->p_vv + q * dt2 * dt * 0.5f;
+    est->p_vv += q * dt2;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_estimator_update(ee_pmw3901mb_estimator_t* est, int16_t delta_x, int16_t delta_y,
+                                      uint32_t dt_us, uint16_t height_mm, uint8_t score){
+    if(est == NULL) return 1;
+    if(dt_us == 0U) return 2; // Error: Invalid sample interval
+    if(height_mm == 0U) return 2; // Error: Invalid height, the deltas measure no velocity
+
+    ee_pmw3901mb_estimator_predict(est, dt_us);
+    if(score == 0U || score < est->cfg.min_score){
+        est->skipped++;
+        return 3; // Error: Below the min score
+    }
+
+    // Mean velocity of the interval, noise of a count scaled by the score
+    float mm_s_per_count = (float) height_mm * est->rad_per_count / ((float) dt_us * 1e-6f);
+    float r = est->cfg.count_noise * mm_s_per_count * (float) EE_PMW3901MB_QUALITY_SCORE_MAX / (float) score;
+    float s = est->p_vv + r * r;
+    float innov[2] = { (float) delta_x * mm_s_per_count - est->vel[0], (float) delta_y * mm_s_per_count - est->vel[1] };
+
+    if(est->cfg.gate_sigma > 0.0f && est->rejects < EE_PMW3901MB_ESTIMATOR_MAX_REJECTS){
+        float gate = est->cfg.gate_sigma * est->cfg.gate_sigma * s;
+        if(innov[0] * innov[0] > gate || innov[1] * innov[1] > gate){
+            est->rejected++;
+            est->rejects++;
+            return 4; // Error: Beyond the gate
+        }
+    }
+    est->rejects = 0;
+
+    // H = [0 1], shared gain of both axes
+    float k_p = est->p_pv / s;
+    float k_v = est->p_vv / s;
+    for(uint32_t a = 0; a < 2U; a++){
+        est->pos[a] += k_p * innov[a];
+        est->vel[a] += k_v * innov[a];
+    }
+    est->p_pp -= k_p * est->p_pv;
+    est->p_pv -= k_v * est->p_pv;
+    est->p_vv -= k_v * est->p_vv;
+    est->updates++;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_estimator_get(const ee_pmw3901mb_estimator_t* est, ee_pmw3901mb_estimate_t* estimate){
+    if(est == NULL || estimate == NULL) return 1;
+
+    estimate->x_mm = est->pos[0];
+    estimate->y_mm = est->pos[1];
+    estimate->vx_mm_s = est->vel[0];
+    estimate->vy_mm_s = est->vel[1];
+    estimate->pos_std_mm = sqrtf(est->p_pp);
+    estimate->vel_std_mm_s = sqrtf(est->p_vv);
+
+    return 0;
+}
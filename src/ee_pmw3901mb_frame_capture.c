@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_frame_capture.h"
+
+#define CAP_LOAD_ACQUIRE(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define CAP_STORE_RELEASE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CAP_ADD(p, v)               __atomic_add_fetch((p), (v), __ATOMIC_RELAXED)
+
+#define NO_BUFFER   0xFFU
+
+
+static bool cap_move(ee_pmw3901mb_frame_capture_t* cap, uint8_t i, uint8_t from, uint8_t to){
+    uint8_t expected = from;
+    return __atomic_compare_exchange_n(&cap->state[i], &expected, to, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+
+uint8_t ee_pmw3901mb_frame_capture_init(ee_pmw3901mb_frame_capture_t* cap, ee_pmw3901mb_dev_t* dev, uint8_t* buf0, uint8_t* buf1){
+    if(cap == NULL || dev == NULL || buf0 == NULL || buf1 == NULL) return 1;
+
+    memset(cap, 0, sizeof(ee_pmw3901mb_frame_capture_t));
+    cap->dev = dev;
+    cap->buffers[0] = buf0;
+    cap->buffers[1] = buf1;
+    cap->held = NO_BUFFER;
+
+    return ee_pmw3901mb_dev_frame_grab_enable(dev);
+}
+
+uint8_t ee_pmw3901mb_frame_capture_next(ee_pmw3901mb_frame_capture_t* cap){
+    if(cap == NULL) return 1;
+
+    // Prefer the free buffer, so a ready frame stays available while the next one is grabbed
+    uint8_t fill = NO_BUFFER;
+    for(uint8_t i = 0; i < 2U && fill == NO_BUFFER; i++){
+        if(cap_move(cap, i, EE_PMW3901MB_FRAME_FREE, EE_PMW3901MB_FRAME_FILLING)) fill = i;
+    }
+    for(uint8_t i = 0; i < 2U && fill == NO_BUFFER; i++){
+        if(cap_move(cap, i, EE_PMW3901MB_FRAME_READY, EE_PMW3901MB_FRAME_FILLING)){
+            fill = i;
+            CAP_ADD(&cap->dropped, 1U);
+        }
+    }
+    if(fill == NO_BUFFER) return 2; // Error: No free buffer
+
+    uint8_t status_code = ee_pmw3901mb_dev_frame_grab(cap->dev, cap->buffers[fill]);
+    if(status_code != 0){
+        CAP_ADD(&cap->errors, 1U);
+        CAP_STORE_RELEASE(&cap->state[fill], EE_PMW3901MB_FRAME_FREE);
+        return status_code;
+    }
+
+    cap->seq[fill] = CAP_ADD(&cap->frames, 1U);
+    CAP_STORE_RELEASE(&cap->state[fill], EE_PMW3901MB_FRAME_READY);
+
+    // The other buffer, if still not taken, now holds a stale frame
+    if(cap_move(cap, (uint8_t) (fill ^ 1U), EE_PMW3901MB_FRAME_READY, EE_PMW3901MB_FRAME_FREE)){
+        CAP_ADD(&cap->dropped, 1U);
+    }
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_frame_capture_get(ee_pmw3901mb_frame_capture_t* cap, const uint8_t** frame, uint32_t* seq){
+    if(cap == NULL || frame == NULL) return 1;
+    if(cap->held != NO_BUFFER) return 1; // Error: Previous frame not released
+
+    // Both buffers may be ready for a moment, take the newest
+    uint8_t take = NO_BUFFER;
+    for(uint8_t i = 0; i < 2U; i++){
+        if(CAP_LOAD_ACQUIRE(&cap->state[i]) != EE_PMW3901MB_FRAME_READY) continue;
+        if(take == NO_BUFFER || (int32_t) (cap->seq[i] - cap->seq[take]) > 0) take = i;
+    }
+    if(take == NO_BUFFER || !cap_move(cap, take, EE_PMW3901MB_FRAME_READY, EE_PMW3901MB_FRAME_HELD)){
+        return 2; // Error: No new frame
+    }
+
+    cap->held = take;
+    *frame = cap->buffers[take];
+    if(seq != NULL) *seq = cap->seq[take];
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_frame_capture_release(ee_pmw3901mb_frame_capture_t* cap){
+    if(cap == NULL || cap->held == NO_BUFFER) return 1;
+
+    CAP_STORE_RELEASE(&cap->state[cap->held], EE_PMW3901MB_FRAME_FREE);
+    cap->held = NO_BUFFER;
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include "ee_pmw3901mb_fusion.h"
+#include "ee_pmw3901mb_velocity.h"
+
+#define FUSION_PI               3.14159265f
+#define FUSION_MIN_SPREAD_MM2   1.0f    // Min weighted spread of the positions around their centroid, per weight
+
+
+uint8_t ee_pmw3901mb_fusion_init(ee_pmw3901mb_fusion_t* fusion, const ee_pmw3901mb_mount_t* mounts, size_t n){
+    if(fusion == NULL || mounts == NULL) return 1;
+    if(n < 2U || n > EE_PMW3901MB_FUSION_MAX_SENSORS) return 2; // Error: Invalid number of sensors
+
+    float cx = 0.0f;
+    float cy = 0.0f;
+    for(size_t i = 0; i < n; i++){
+        cx += mounts[i].x_mm;
+        cy += mounts[i].y_mm;
+    }
+    cx /= (float) n;
+    cy /= (float) n;
+    float spread = 0.0f;
+    for(size_t i = 0; i < n; i++){
+        spread += (mounts[i].x_mm - cx) * (mounts[i].x_mm - cx) + (mounts[i].y_mm - cy) * (mounts[i].y_mm - cy);
+    }
+    if(spread < FUSION_MIN_SPREAD_MM2 * (float) n) return 3; // Error: Yaw not observable, sensors at one position
+
+    memset(fusion, 0, sizeof(ee_pmw3901mb_fusion_t));
+    fusion->n = n;
+    for(size_t i = 0; i < n; i++){
+        float yaw = (float) mounts[i].yaw_mdeg * (FUSION_PI / 180000.0f);
+        fusion->x_mm[i] = mounts[i].x_mm;
+        fusion->y_mm[i] = mounts[i].y_mm;
+        fusion->cos_yaw[i] = cosf(yaw);
+        fusion->sin_yaw[i] = sinf(yaw);
+    }
+    fusion->rad_per_count = (float) EE_PMW3901MB_FOV_MDEG * (FUSION_PI / 180000.0f) / (float) EE_PMW3901MB_PIXELS;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_fusion_solve(const ee_pmw3901mb_fusion_t* fusion, const ee_pmw3901mb_fusion_input_t* inputs,
+                                  uint16_t height_mm, ee_pmw3901mb_rigid_motion_t* motion){
+    if(fusion == NULL || inputs == NULL || motion == NULL) return 1;
+
+    // Sensor displacements in the body frame, m = t + yaw * (-y, x), fitted around the weighted
+    // centroid of the positions, where translation and yaw decouple. The sums take the same
+    // operations for any weights, left out sensors weigh 0.
+    float mm_per_count = (float) height_mm * fusion->rad_per_count;
+    float mx[EE_PMW3901MB_FUSION_MAX_SENSORS];
+    float my[EE_PMW3901MB_FUSION_MAX_SENSORS];
+    float sw = 0.0f;
+    float sx = 0.0f;
+    float sy = 0.0f;
+    float smx = 0.0f;
+    float smy = 0.0f;
+    float scross = 0.0f;
+    float snorm = 0.0f;
+    uint8_t sensors = 0;
+    for(size_t i = 0; i < fusion->n; i++){
+        float w = (float) inputs[i].weight;
+        float dx = (float) inputs[i].delta_x * mm_per_count;
+        float dy = (float) inputs[i].delta_y * mm_per_count;
+        mx[i] = fusion->cos_yaw[i] * dx - fusion->sin_yaw[i] * dy;
+        my[i] = fusion->sin_yaw[i] * dx + fusion->cos_yaw[i] * dy;
+        sw += w;
+        sx += w * fusion->x_mm[i];
+        sy += w * fusion->y_mm[i];
+        smx += w * mx[i];
+        smy += w * my[i];
+        scross += w * (fusion->x_mm[i] * my[i] - fusion->y_mm[i] * mx[i]);
+        snorm += w * (fusion->x_mm[i] * fusion->x_mm[i] + fusion->y_mm[i] * fusion->y_mm[i]);
+        sensors += (inputs[i].weight != 0U) ? 1U : 0U;
+    }
+
+    memset(motion, 0, sizeof(ee_pmw3901mb_rigid_motion_t));
+    motion->sensors = sensors;
+    if(sensors == 0U) return 2; // Error: No sensor weighted
+
+    float cx = sx / sw;
+    float cy = sy / sw;
+    float tx = smx / sw;
+    float ty = smy / sw;
+    float spread = snorm - sw * (cx * cx + cy * cy);
+    uint8_t status_code = 0;
+    float yaw = 0.0f;
+    if(spread >= FUSION_MIN_SPREAD_MM2 * sw){
+        yaw = (scross - sw * (cx * ty - cy * tx)) / spread;
+    }else{
+        status_code = 3; // Error: Yaw not observable, weighted sensors at one position
+    }
+
+    // Translation of the centroid moved to the body origin
+    motion->dx_mm = tx + yaw * cy;
+    motion->dy_mm = ty - yaw * cx;
+    motion->dyaw_rad = yaw;
+
+    float sr = 0.0f;
+    for(size_t i = 0; i < fusion->n; i++){
+        float rx = mx[i] - motion->dx_mm + yaw * fusion->y_mm[i];
+        float ry = my[i] - motion->dy_mm - yaw * fusion->x_mm[i];
+        sr += (float) inputs[i].weight * (rx * rx + ry * ry);
+    }
+    motion->rms_mm = sqrtf(sr / sw);
+
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_fusion_read(const ee_pmw3901mb_fusion_t* fusion, ee_pmw3901mb_dev_t* const* devs,
+                                 const ee_pmw3901mb_quality_cfg_t* quality, uint16_t height_mm,
+                                 ee_pmw3901mb_rigid_motion_t* motion){
+    if(fusion == NULL || devs == NULL || motion == NULL) return 1;
+
+    ee_pmw3901mb_fusion_input_t inputs[EE_PMW3901MB_FUSION_MAX_SENSORS];
+    for(size_t i = 0; i < fusion->n; i++){
+        ee_pmw3901mb_motion_burst_t burst;
+        if(ee_pmw3901mb_dev_get_motion_burst(devs[i], &burst) != 0) return 4; // Error: Read failed
+        inputs[i].delta_x = burst.delta_x;
+        inputs[i].delta_y = burst.delta_y;
+        inputs[i].weight = 1U;
+        if(quality != NULL){
+            uint8_t score = 0;
+            ee_pmw3901mb_quality_action_t action = ee_pmw3901mb_quality_gate(quality, &burst, &score);
+            inputs[i].weight = (action == EE_PMW3901MB_QUALITY_DROP) ? 0U : score;
+        }
+    }
+
+    return ee_pmw3901mb_fusion_solve(fusion, inputs, height_mm, motion);
+}
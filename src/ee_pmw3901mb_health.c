@@ -0,0 +1,188 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_health.h"
+
+#define REG_PRODUCT_ID          0x00
+#define REG_INVERSE_PRODUCT_ID  0x5F
+#define REG_BANK_SELECT         0x7F
+#define DEF_PRODUCT_ID          0x49
+#define DEF_INVERSE_PRODUCT_ID  0xB6
+
+// Defaults
+#define DEF_CHECK_PERIOD_US     100000U
+#define DEF_STUCK_LIMIT         16U
+
+
+uint8_t ee_pmw3901mb_health_default_cfg(ee_pmw3901mb_health_cfg_t* cfg){
+    if(cfg == NULL) return 1;
+
+    cfg->check_period_us = DEF_CHECK_PERIOD_US;
+    cfg->stuck_limit = DEF_STUCK_LIMIT;
+    cfg->check_tuning = true;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_health_init(ee_pmw3901mb_health_t* health, ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_health_cfg_t* cfg){
+    if(health == NULL || dev == NULL) return 1;
+
+    memset(health, 0, sizeof(ee_pmw3901mb_health_t));
+    health->dev = dev;
+    if(cfg != NULL) health->cfg = *cfg;
+    else ee_pmw3901mb_health_default_cfg(&health->cfg);
+    health->check_us = ee_pmw3901mb_time_us();
+
+    return 0;
+}
+
+ee_pmw3901mb_health_fault_t ee_pmw3901mb_health_check_burst(ee_pmw3901mb_health_t* health, const ee_pmw3901mb_motion_burst_t* burst){
+    if(health == NULL || burst == NULL) return EE_PMW3901MB_HEALTH_OK;
+
+    const uint8_t* bytes = (const uint8_t*) burst;
+    bool ones = true;
+    bool zeros = true;
+    for(size_t i = 0; i < sizeof(ee_pmw3901mb_motion_burst_t); i++){
+        if(bytes[i] != 0xFFU) ones = false;
+        if(bytes[i] != 0x00U) zeros = false;
+    }
+    if(ones) return EE_PMW3901MB_HEALTH_ALL_ONES;
+    if(zeros) return EE_PMW3901MB_HEALTH_ALL_ZEROS;
+
+    // Motion is cleared by each read, the same frame with motion again means no new frames
+    if((burst->motion & EE_PMW3901MB_MOTION_MOT) == 0U){
+        health->repeats = 0;
+    }else if(memcmp(burst, &health->last, sizeof(ee_pmw3901mb_motion_burst_t)) == 0){
+        if(health->repeats < UINT8_MAX) health->repeats++;
+    }else{
+        health->repeats = 1;
+    }
+    health->last = *burst;
+
+    if(health->cfg.stuck_limit != 0U && health->repeats >= health->cfg.stuck_limit) return EE_PMW3901MB_HEALTH_STUCK;
+    return EE_PMW3901MB_HEALTH_OK;
+}
+
+ee_pmw3901mb_health_fault_t ee_pmw3901mb_health_check(ee_pmw3901mb_health_t* health){
+    if(health == NULL || health->dev == NULL) return EE_PMW3901MB_HEALTH_BUS_ERROR;
+
+    uint8_t product_id = 0;
+    uint8_t inv_product_id = 0;
+    if(ee_pmw3901mb_dev_get_product_id(health->dev, &product_id) != 0) return EE_PMW3901MB_HEALTH_BUS_ERROR;
+    if(ee_pmw3901mb_dev_get_inverse_product_id(health->dev, &inv_product_id) != 0) return EE_PMW3901MB_HEALTH_BUS_ERROR;
+    if(product_id != DEF_PRODUCT_ID || inv_product_id != DEF_INVERSE_PRODUCT_ID) return EE_PMW3901MB_HEALTH_ID_MISMATCH;
+
+    if(health->cfg.check_tuning){
+        bool tuned = false;
+        if(ee_pmw3901mb_dev_check_tuning(health->dev, &tuned) != 0) return EE_PMW3901MB_HEALTH_BUS_ERROR;
+        if(!tuned) return EE_PMW3901MB_HEALTH_TUNING_LOST;
+    }
+
+    return EE_PMW3901MB_HEALTH_OK;
+}
+
+uint8_t ee_pmw3901mb_health_get_motion_burst(ee_pmw3901mb_health_t* health, ee_pmw3901mb_motion_burst_t* burst){
+    if(health == NULL || health->dev == NULL || burst == NULL) return 1;
+    if(health->fault != EE_PMW3901MB_HEALTH_OK) return EE_PMW3901MB_HEALTH_FAULT; // Until recovered
+
+    ee_pmw3901mb_health_fault_t fault = EE_PMW3901MB_HEALTH_BUS_ERROR;
+    if(ee_pmw3901mb_dev_get_motion_burst(health->dev, burst) == 0) fault = ee_pmw3901mb_health_check_burst(health, burst);
+
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    if(fault == EE_PMW3901MB_HEALTH_OK){
+        if(health->cfg.check_period_us == 0U){
+            health->attempts = 0;
+        }else if(now_us - health->check_us >= health->cfg.check_period_us){
+            health->check_us = now_us;
+            fault = ee_pmw3901mb_health_check(health);
+            if(fault == EE_PMW3901MB_HEALTH_OK) health->attempts = 0;
+        }
+    }
+
+    if(fault != EE_PMW3901MB_HEALTH_OK){
+        health->fault = fault;
+        health->fault_us = now_us;
+        health->faults++;
+        return EE_PMW3901MB_HEALTH_FAULT;
+    }
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_health_recover(ee_pmw3901mb_health_t* health){
+    if(health == NULL || health->dev == NULL) return 1;
+
+    ee_pmw3901mb_dev_t* dev = health->dev;
+    uint32_t start_us = ee_pmw3901mb_time_us();
+    uint8_t status_code = 0;
+
+    // Cheapest path first, escalated on repeated faults
+    if(health->attempts < UINT8_MAX) health->attempts++;
+    ee_pmw3901mb_recovery_t floor = EE_PMW3901MB_RECOVERY_NONE;
+    if(health->attempts == 2U) floor = EE_PMW3901MB_RECOVERY_RETUNE;
+    if(health->attempts > 2U || health->fault == EE_PMW3901MB_HEALTH_STUCK) floor = EE_PMW3901MB_RECOVERY_FULL;
+
+    ee_pmw3901mb_recovery_t path = EE_PMW3901MB_RECOVERY_NONE;
+    ee_pmw3901mb_health_fault_t fault = EE_PMW3901MB_HEALTH_OK;
+    if(floor != EE_PMW3901MB_RECOVERY_FULL){
+        fault = ee_pmw3901mb_health_check(health);
+
+        if(fault == EE_PMW3901MB_HEALTH_ID_MISMATCH){
+            // Registers of another bank read back in place of the IDs after a lost bank select
+            uint8_t bank = 0x00;
+            path = EE_PMW3901MB_RECOVERY_BANK;
+            fault = (ee_pmw3901mb_spi_bus_write(&dev->bus, REG_BANK_SELECT, &bank) == 0) ?
+                ee_pmw3901mb_health_check(health) : EE_PMW3901MB_HEALTH_BUS_ERROR;
+        }
+
+        if(fault == EE_PMW3901MB_HEALTH_TUNING_LOST ||
+           (fault == EE_PMW3901MB_HEALTH_OK && floor == EE_PMW3901MB_RECOVERY_RETUNE)){
+            path = EE_PMW3901MB_RECOVERY_RETUNE;
+            status_code = ee_pmw3901mb_dev_retune_start(dev);
+            if(status_code == 0) status_code = ee_pmw3901mb_dev_init_finish(dev);
+            fault = (status_code == 0) ? ee_pmw3901mb_health_check(health) : EE_PMW3901MB_HEALTH_BUS_ERROR;
+        }
+    }
+
+    if(floor == EE_PMW3901MB_RECOVERY_FULL || fault != EE_PMW3901MB_HEALTH_OK){
+        path = EE_PMW3901MB_RECOVERY_FULL;
+        status_code = ee_pmw3901mb_dev_init_driver(dev, dev->bus.spi_driver, dev->bus.spi_config);
+        fault = (status_code == 0) ? ee_pmw3901mb_health_check(health) : EE_PMW3901MB_HEALTH_BUS_ERROR;
+    }
+
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    health->last_recovery = path;
+    health->last_recovery_us = now_us - start_us;
+    if(fault != EE_PMW3901MB_HEALTH_OK){
+        health->fault = fault;
+        return (status_code != 0) ? status_code : 1;
+    }
+
+    health->recoveries[path]++;
+    health->fault = EE_PMW3901MB_HEALTH_OK;
+    health->repeats = 0;
+    memset(&health->last, 0, sizeof(ee_pmw3901mb_motion_burst_t));
+    health->check_us = now_us;
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_motion_event.h"
+
+#if (EE_PMW3901MB_USE_MOTION_EVENT == TRUE)
+
+// Max motion burst reads per wakeup, bounds the time the motion line can keep the thread busy
+#define MOTION_EVENT_MAX_READS  4U
+
+
+static void motion_line_cb(void* arg){
+    ee_pmw3901mb_motion_event_t* me = (ee_pmw3901mb_motion_event_t*) arg;
+
+    chSysLockFromISR();
+    me->events++;
+    chBSemSignalI(&me->wakeup);
+    chSysUnlockFromISR();
+}
+
+// Returns 0 when the motion line is released, 1 when still asserted, 2 on a failed read
+static uint8_t motion_event_read(ee_pmw3901mb_motion_event_t* me){
+    ee_pmw3901mb_motion_burst_t burst;
+
+    // The motion line stays asserted (low) until the motion is read
+    for(uint32_t i = 0; i < MOTION_EVENT_MAX_READS; i++){
+        if(ee_pmw3901mb_dev_get_motion_burst(me->dev, &burst) != 0){
+            me->errors++;
+            return 2;
+        }
+
+        uint8_t confidence = EE_PMW3901MB_QUALITY_SCORE_MAX;
+        ee_pmw3901mb_quality_action_t action = EE_PMW3901MB_QUALITY_PASS;
+        const ee_pmw3901mb_quality_cfg_t* quality = me->quality;
+        if(quality != NULL) action = ee_pmw3901mb_quality_gate(quality, &burst, &confidence);
+
+        if((burst.motion & EE_PMW3901MB_MOTION_MOT) == 0U){
+            me->spurious++;
+        }else if(action == EE_PMW3901MB_QUALITY_DROP){
+            me->rejected++;
+        }else{
+            ee_pmw3901mb_motion_sample_t* sample = chFifoTakeObjectTimeout(&me->fifo, TIME_IMMEDIATE);
+            if(sample == NULL){
+                me->overruns++; // Queue full, consumer is behind
+            }else{
+                sample->burst = burst;
+                sample->time = chVTGetSystemTime();
+                sample->time_us = me->dev->burst_assert_us;
+                sample->confidence = confidence;
+                sample->flags = 0U;
+                if(action == EE_PMW3901MB_QUALITY_FLAG){
+                    sample->flags |= EE_PMW3901MB_SAMPLE_LOW_QUALITY;
+                    me->flagged++;
+                }
+                chFifoSendObject(&me->fifo, sample);
+                me->samples++;
+            }
+        }
+
+        if(palReadLine(me->line) == PAL_HIGH) return 0;
+    }
+    return 1;
+}
+
+static uint8_t motion_event_read_locked(ee_pmw3901mb_motion_event_t* me){
+    chBSemWait(&me->lock);
+    uint8_t status_code = motion_event_read(me);
+    chBSemSignal(&me->lock);
+    return status_code;
+}
+
+static THD_FUNCTION(motion_event_thread, arg){
+    ee_pmw3901mb_motion_event_t* me = (ee_pmw3901mb_motion_event_t*) arg;
+    chRegSetThreadName("pmw3901mb_motion");
+
+    // Clear motion pending from before the start, it would not give a new edge
+    uint8_t status_code = motion_event_read_locked(me);
+    uint32_t retry_us = EE_PMW3901MB_MOTION_EVENT_RETRY_US;
+
+    while(!chThdShouldTerminateX()){
+        // Still asserted, no new edge comes: read again after the retry interval, backing off
+        // on failed reads. The line can also be released in between by a read of another thread.
+        sysinterval_t timeout = TIME_INFINITE;
+        if(status_code != 0U && palReadLine(me->line) == PAL_LOW) timeout = TIME_US2I(retry_us);
+        if(chBSemWaitTimeout(&me->wakeup, timeout) == MSG_TIMEOUT) me->retries++;
+        if(chThdShouldTerminateX()) break;
+
+        status_code = motion_event_read_locked(me);
+        if(status_code == 2U){
+            retry_us = (retry_us > EE_PMW3901MB_MOTION_EVENT_RETRY_MAX_US / 2U) ? EE_PMW3901MB_MOTION_EVENT_RETRY_MAX_US : retry_us * 2U;
+        }else{
+            retry_us = EE_PMW3901MB_MOTION_EVENT_RETRY_US;
+        }
+    }
+}
+
+
+uint8_t ee_pmw3901mb_motion_event_start(ee_pmw3901mb_motion_event_t* me, ee_pmw3901mb_dev_t* dev,
+                                        ioline_t line, void* wa, size_t wa_size, tprio_t prio){
+    if(me == NULL || dev == NULL || wa == NULL) return 1;
+    if(!dev->initialized) return 2; // Error: Device not initialized
+
+    memset(me, 0, sizeof(ee_pmw3901mb_motion_event_t));
+    me->dev = dev;
+    me->line = line;
+    chBSemObjectInit(&me->wakeup, true);
+    chBSemObjectInit(&me->lock, false);
+    chFifoObjectInit(&me->fifo, sizeof(ee_pmw3901mb_motion_sample_t), EE_PMW3901MB_MOTION_EVENT_QUEUE_SIZE,
+                     me->fifo_samples, me->fifo_msgs);
+
+    palSetLineCallback(line, motion_line_cb, me);
+    palEnableLineEvent(line, PAL_EVENT_MODE_FALLING_EDGE);
+
+    me->thread = chThdCreateStatic(wa, wa_size, prio, motion_event_thread, me);
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_motion_event_stop(ee_pmw3901mb_motion_event_t* me){
+    if(me == NULL) return 1;
+    if(me->thread == NULL) return 2; // Error: Not started
+
+    palDisableLineEvent(me->line);
+
+    chThdTerminate(me->thread);
+    chBSemSignal(&me->wakeup);
+    chThdWait(me->thread);
+    me->thread = NULL;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_motion_event_pause(ee_pmw3901mb_motion_event_t* me){
+    if(me == NULL) return 1;
+    if(me->thread == NULL) return 2; // Error: Not started
+
+    chBSemWait(&me->lock);
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_motion_event_resume(ee_pmw3901mb_motion_event_t* me){
+    if(me == NULL) return 1;
+    if(me->thread == NULL) return 2; // Error: Not started
+
+    chBSemSignal(&me->lock);
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_motion_event_set_quality(ee_pmw3901mb_motion_event_t* me, const ee_pmw3901mb_quality_cfg_t* cfg){
+    if(me == NULL) return 1;
+
+    chSysLock();
+    me->quality = cfg;
+    chSysUnlock();
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_motion_event_get(ee_pmw3901mb_motion_event_t* me, ee_pmw3901mb_motion_sample_t* sample,
+                                      sysinterval_t timeout){
+    if(me == NULL || sample == NULL) return 1;
+
+    void* obj = NULL;
+    if(chFifoReceiveObjectTimeout(&me->fifo, &obj, timeout) != MSG_OK) return 2; // Error: Timeout
+
+    *sample = *(ee_pmw3901mb_motion_sample_t*) obj;
+    chFifoReturnObject(&me->fifo, obj);
+
+    return 0;
+}
+
+#endif /* EE_PMW3901MB_USE_MOTION_EVENT == TRUE */
@@ -0,0 +1,121 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_odometry.h"
+
+#define CHECKPOINT_MASK (EE_PMW3901MB_ODOMETRY_CHECKPOINTS - 1U)
+
+
+static void checkpoint(ee_pmw3901mb_odometry_t* odo, uint32_t slot){
+    ee_pmw3901mb_odometry_checkpoint_t* cp = &odo->checkpoints[slot & CHECKPOINT_MASK];
+    cp->slot = slot;
+    cp->x = odo->x;
+    cp->y = odo->y;
+    if(odo->checkpoints_n < EE_PMW3901MB_ODOMETRY_CHECKPOINTS) odo->checkpoints_n++;
+}
+
+static bool is_saturated(int16_t delta){
+    return delta >= EE_PMW3901MB_ODOMETRY_SATURATED || delta <= -EE_PMW3901MB_ODOMETRY_SATURATED;
+}
+
+
+uint8_t ee_pmw3901mb_odometry_init(ee_pmw3901mb_odometry_t* odo, uint32_t interval, uint32_t time){
+    if(odo == NULL) return 1;
+    if(interval == 0U) return 2; // Error: Invalid interval
+
+    memset(odo, 0, sizeof(ee_pmw3901mb_odometry_t));
+    odo->interval = interval;
+    odo->last_time = time;
+    checkpoint(odo, 0U);
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_odometry_update(ee_pmw3901mb_odometry_t* odo, int16_t delta_x, int16_t delta_y, uint32_t time){
+    if(odo == NULL) return 1;
+
+    // Intervals passed since the last sample, from the unsigned difference so the time stamp may wrap
+    uint32_t elapsed = time - odo->last_time;
+    uint32_t passed = elapsed / odo->interval;
+    uint64_t phase = (uint64_t) odo->phase + elapsed % odo->interval;
+    if(phase >= odo->interval){
+        phase -= odo->interval;
+        passed++;
+    }
+    odo->phase = (uint32_t) phase;
+    odo->last_time = time;
+
+    // Entering new checkpoint intervals, the position before this delta is their start position
+    uint32_t slot = odo->slot + passed;
+    if(passed > EE_PMW3901MB_ODOMETRY_CHECKPOINTS) passed = EE_PMW3901MB_ODOMETRY_CHECKPOINTS;
+    for(uint32_t i = passed; i > 0U; i--){
+        checkpoint(odo, slot - i + 1U);
+    }
+    odo->slot = slot;
+
+    odo->x += delta_x;
+    odo->y += delta_y;
+    odo->samples++;
+
+    if(is_saturated(delta_x) || is_saturated(delta_y)){
+        odo->saturations++;
+        return 2; // Error: Saturated, motion lost
+    }
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_odometry_read(ee_pmw3901mb_odometry_t* odo, ee_pmw3901mb_dev_t* dev, uint32_t time){
+    if(odo == NULL || dev == NULL) return 1;
+
+    ee_pmw3901mb_motion_burst_t burst;
+    uint8_t status_code = ee_pmw3901mb_dev_get_motion_burst(dev, &burst);
+    if(status_code != 0) return status_code;
+
+    return ee_pmw3901mb_odometry_update(odo, burst.delta_x, burst.delta_y, time);
+}
+
+uint8_t ee_pmw3901mb_odometry_get_total(const ee_pmw3901mb_odometry_t* odo, int64_t* x, int64_t* y){
+    if(odo == NULL || x == NULL || y == NULL) return 1;
+    *x = odo->x;
+    *y = odo->y;
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_odometry_get_since(const ee_pmw3901mb_odometry_t* odo, uint32_t time, int64_t* x, int64_t* y){
+    if(odo == NULL || x == NULL || y == NULL) return 1;
+
+    // Intervals back from the last sample, a time in the future wraps to far in the past
+    uint32_t back = odo->last_time - time;
+    uint32_t age = (back <= odo->phase) ? 0U : (back - odo->phase - 1U) / odo->interval + 1U;
+    if(age >= odo->checkpoints_n) return 2; // Error: Older than the history, or in the future
+
+    uint32_t slot = odo->slot - age;
+    const ee_pmw3901mb_odometry_checkpoint_t* cp = &odo->checkpoints[slot & CHECKPOINT_MASK];
+    if(cp->slot != slot) return 2;
+
+    *x = odo->x - cp->x;
+    *y = odo->y - cp->y;
+    return 0;
+}
@@ -23,6 +23,7 @@ SOFTWARE.
 */
 
 #include "ee_pmw3901mb_platform.h"
+#include "ee_pmw3901mb_driver.h"
 
 // R/W bit for PMW3901MB is in the MSB-bit of the 1st byte (SPI address) in the SPI Command Format
 #define SPI_RW_BIT_READ_MASK    0x7F
@@ -30,79 +31,518 @@ SOFTWARE.
 
 // Include platform dependent macros and variables here
 
-static SPIDriver* spi_driver = NULL;
-static SPIConfig* spi_config = NULL;
+// Realtime counter frequency, the core clock on Cortex-M (DWT cycle counter)
+#if !defined(EE_PMW3901MB_RT_COUNTER_HZ)
+#define EE_PMW3901MB_RT_COUNTER_HZ  STM32_SYSCLK
+#endif
+
+// Counts a refused transfer on a valid bus handle and evaluates to the status code
+#if (EE_PMW3901MB_USE_STATS == TRUE)
+#define BUS_ERROR(bus, code)    ((bus)->counters.errors++, (uint8_t) (code))
+#else
+#define BUS_ERROR(bus, code)    ((uint8_t) (code))
+#endif
+
+// Bus of the driver default device, so the functions without a bus handle share its
+// session depth and bus lock with the functions without a device handle
+#define DEFAULT_BUS             (&ee_pmw3901mb_get_default_dev()->bus)
+
+// SPI drivers with an asynchronous read in flight, looked up by the data callback
+static ee_pmw3901mb_spi_bus_t* volatile async_buses[EE_PMW3901MB_SPI_ASYNC_MAX_DRIVERS];
 
 // Include platform dependent function headers here
 
+// One chip select frame on the bus: txbuf (the command byte and the written bytes), then rx_n read bytes
+static uint8_t bus_frame(ee_pmw3901mb_spi_bus_t* bus, const uint8_t* txbuf, size_t tx_n, uint8_t* rx, size_t rx_n){
+    // The SPI driver is mid exchange, a frame would assert chip select over it
+    if(bus->async_busy) return 5; // Error: Asynchronous read in flight
+
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    if(bus->sched != NULL){
+        ee_pmw3901mb_spi_trans_t trans;
+        memset(&trans, 0, sizeof(trans));
+        trans.periph = &bus->periph;
+        trans.cmd = txbuf[0];
+        trans.tx = &txbuf[1];
+        trans.tx_n = tx_n - 1U;
+        trans.rx = rx;
+        trans.rx_n = rx_n;
+        trans.priority = bus->priority;
+        trans.deadline_us = bus->deadline_us;
+        uint8_t status_code = ee_pmw3901mb_spi_sched_transfer(bus->sched, &trans);
+        bus->cs_assert_us = trans.start_us;
+        bus->cs_deassert_us = trans.done_us;
+        return status_code;
+    }
+#endif
+
+    if(bus->session_depth == 0U) spiStart(bus->spi_driver, bus->spi_config);
+    bus->cs_assert_us = ee_pmw3901mb_time_us();
+    spiSelect(bus->spi_driver);
+
+    /* Sending the command (and data). The data coming back is ignored. */
+    spiSend(bus->spi_driver, tx_n, txbuf);
+    /* Reading back as many register as the value of rx_n. */
+    if(rx_n != 0U) spiReceive(bus->spi_driver, rx_n, rx);
+
+    spiUnselect(bus->spi_driver);
+    bus->cs_deassert_us = ee_pmw3901mb_time_us();
+    if(bus->session_depth == 0U) spiStop(bus->spi_driver);
+
+    return 0;
+}
+
 uint8_t ee_pmw3901mb_spi_init(SPIDriver* spid_p, SPIConfig* spic_p){
+    return ee_pmw3901mb_spi_bus_init(DEFAULT_BUS, spid_p, spic_p);
+}
+
+uint8_t ee_pmw3901mb_spi_deinit(void){
+    return ee_pmw3901mb_spi_bus_deinit(DEFAULT_BUS);
+}
+
+uint8_t ee_pmw3901mb_spi_read(uint8_t addr, uint8_t* data, size_t n){
+    return ee_pmw3901mb_spi_bus_read(DEFAULT_BUS, addr, data, n);
+}
+
+uint8_t ee_pmw3901mb_spi_write(uint8_t addr, uint8_t* data){
+    return ee_pmw3901mb_spi_bus_write(DEFAULT_BUS, addr, data);
+}
+
+uint8_t ee_pmw3901mb_spi_acquire(void){
+    return ee_pmw3901mb_spi_bus_acquire(DEFAULT_BUS);
+}
+
+uint8_t ee_pmw3901mb_spi_release(void){
+    return ee_pmw3901mb_spi_bus_release(DEFAULT_BUS);
+}
+
+uint8_t ee_pmw3901mb_spi_bus_init(ee_pmw3901mb_spi_bus_t* bus, SPIDriver* spid_p, SPIConfig* spic_p){
+    if(bus == NULL) return 3; // Error: NULL bus handle passed
     if(spid_p == NULL) return 1; // Error: NULL pointer passed
     if(spic_p == NULL) return 2; // Error: NULL pointer passed
 
-    spi_driver = spid_p;
-    spi_config = spic_p;
+    bus->spi_driver = spid_p;
+    bus->spi_config = spic_p;
+    bus->session_depth = 0U;
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    bus->sched = NULL;
+#endif
     return 0; // Success
 }
 
-uint8_t ee_pmw3901mb_spi_deinit(void){
-    if(spi_driver == NULL || spi_config == NULL) return 1; // Error: Not initialized / Already Deinitialized
+uint8_t ee_pmw3901mb_spi_bus_deinit(ee_pmw3901mb_spi_bus_t* bus){
+    if(bus == NULL) return 2; // Error: NULL bus handle passed
+    if(bus->spi_driver == NULL || bus->spi_config == NULL) return 1; // Error: Not initialized / Already Deinitialized
+    if(bus->session_depth != 0U) return 3; // Error: Bus session still acquired
 
-    spi_driver = NULL;
-    spi_config = NULL;
+    bus->spi_driver = NULL;
+    bus->spi_config = NULL;
 
     return 0;
 }
 
-uint8_t ee_pmw3901mb_spi_read(uint8_t addr, uint8_t* data, size_t n){
+uint8_t ee_pmw3901mb_spi_bus_read(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, uint8_t* data, size_t n){
     
-    if(spi_driver == NULL) return 1; // Error: SPI Driver is NULL
-    if(n < 1) return 2; // Error: Invalid size
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(n < 1) return BUS_ERROR(bus, 2); // Error: Invalid size
 
     uint8_t txbuf = 0;
     /* Preparing the transmission buffer with R/W bit to Read. */
     txbuf = (SPI_RW_BIT_READ_MASK & addr);
 
-    spiStart(spi_driver, spi_config);
-    spiSelect(spi_driver);
-    
-    /* Sending the command. The data coming back is ignored. */
-    spiSend(spi_driver, 1U, &txbuf);
-    /* Reading back as many register as the value of n. */
-    spiReceive(spi_driver, n, data);
+    uint8_t status_code = bus_frame(bus, &txbuf, 1U, data, n);
+    if(status_code != 0) return BUS_ERROR(bus, status_code);
 
-    spiUnselect(spi_driver);
-    spiStop(spi_driver);
+    EE_PMW3901MB_STATS_ADD(bus->counters.reads, 1U);
+    EE_PMW3901MB_STATS_ADD(bus->counters.bytes, n + 1U);
+    EE_PMW3901MB_TRACE_RECORD(0U, txbuf, data, n, bus->cs_assert_us);
 
     return 0; // Success
 }
 
-uint8_t ee_pmw3901mb_spi_write(uint8_t addr, uint8_t* data){
+uint8_t ee_pmw3901mb_spi_bus_write(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, uint8_t* data){
 
-    if(spi_driver == NULL) return 1; // Error: SPI Driver is NULL
-    if(data == NULL) return 2; // Error: Data pointer is NULL
-    if(spi_config == NULL) return 3; // Error: SPI Config is NULL
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(data == NULL) return BUS_ERROR(bus, 2); // Error: Data pointer is NULL
+    if(bus->spi_config == NULL) return BUS_ERROR(bus, 3); // Error: SPI Config is NULL
 
     uint8_t txbuf[2U];
 
     /* Preparing the transmission buffer with R/W bit to Write. */
     txbuf[0] = (SPI_RW_BIT_WRITE_MASK | addr);
-    
-    if(data != NULL) {
-        txbuf[1] = *data; // If data is not NULL, copy the first byte to txbuf
+    txbuf[1] = *data;
+
+    uint8_t status_code = bus_frame(bus, txbuf, 2U, NULL, 0U);
+    if(status_code != 0) return BUS_ERROR(bus, status_code);
+
+    EE_PMW3901MB_STATS_ADD(bus->counters.writes, 1U);
+    EE_PMW3901MB_STATS_ADD(bus->counters.bytes, 2U);
+    EE_PMW3901MB_TRACE_RECORD(EE_PMW3901MB_TRACE_WRITE, (uint8_t) (txbuf[0] & SPI_RW_BIT_READ_MASK), data, 1U, bus->cs_assert_us);
+
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_acquire(ee_pmw3901mb_spi_bus_t* bus){
+
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(bus->spi_config == NULL) return 3; // Error: SPI Config is NULL
+    if(bus->session_depth == UINT8_MAX) return 2; // Error: Too deeply nested
+
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    if(bus->sched != NULL){
+        // Each transaction is scheduled on its own, the session only nests
+        bus->session_depth++;
+        return 0;
     }
+#endif
+    if(bus->session_depth == 0U){
+#if SPI_USE_MUTUAL_EXCLUSION == TRUE
+        spiAcquireBus(bus->spi_driver);
+#endif
+        spiStart(bus->spi_driver, bus->spi_config);
+    }
+    bus->session_depth++;
 
-    spiStart(spi_driver, spi_config);
-    spiSelect(spi_driver);
-    
-    /* Sending the command. The data coming back is ignored. */
-    spiSend(spi_driver, 2U, &txbuf);
-    
-    spiUnselect(spi_driver);
-    spiStop(spi_driver);
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_release(ee_pmw3901mb_spi_bus_t* bus){
+
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(bus->session_depth == 0U) return 2; // Error: Bus session not acquired
+    if(bus->async_busy && bus->session_depth == 1U) return 3; // Error: Asynchronous read in flight
+
+    bus->session_depth--;
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    if(bus->sched != NULL) return 0;
+#endif
+    if(bus->session_depth == 0U){
+        spiStop(bus->spi_driver);
+#if SPI_USE_MUTUAL_EXCLUSION == TRUE
+        spiReleaseBus(bus->spi_driver);
+#endif
+    }
+
+    return 0; // Success
+}
+
+uint8_t ee_pmw3901mb_spi_bus_read_async(ee_pmw3901mb_spi_bus_t* bus, uint8_t addr, size_t n,
+                                        ee_pmw3901mb_spi_async_cb_t cb, void* arg){
+
+    if(bus == NULL || bus->spi_driver == NULL) return 1; // Error: SPI Driver is NULL
+    if(n < 1 || n > EE_PMW3901MB_SPI_ASYNC_MAX_SIZE) return BUS_ERROR(bus, 2); // Error: Invalid size
+    if(bus->spi_config == NULL || bus->spi_config->data_cb != ee_pmw3901mb_spi_data_cb) return BUS_ERROR(bus, 3); // Error: data_cb not set
+    if(bus->session_depth == 0U) return BUS_ERROR(bus, 4); // Error: Bus session not acquired
+    if(bus->async_busy) return BUS_ERROR(bus, 5); // Error: Asynchronous read in flight
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+    if(bus->sched != NULL) return BUS_ERROR(bus, 7); // Error: Not on a scheduled bus
+#endif
+
+    // Claim the slot of the SPI driver
+    size_t slot = EE_PMW3901MB_SPI_ASYNC_MAX_DRIVERS;
+    osalSysLock();
+    for(size_t i = 0; i < EE_PMW3901MB_SPI_ASYNC_MAX_DRIVERS; i++){
+        if(async_buses[i] == NULL){
+            async_buses[i] = bus;
+            slot = i;
+            break;
+        }
+    }
+    osalSysUnlock();
+    if(slot == EE_PMW3901MB_SPI_ASYNC_MAX_DRIVERS) return BUS_ERROR(bus, 6); // Error: Too many asynchronous reads in flight
+
+    /* Preparing the transmission buffer with R/W bit to Read, followed by dummy bytes. */
+    memset(bus->async_txbuf, 0, sizeof(bus->async_txbuf));
+    bus->async_txbuf[0] = (SPI_RW_BIT_READ_MASK & addr);
+    bus->async_n = n;
+    bus->async_cb = cb;
+    bus->async_arg = arg;
+    bus->async_busy = true;
+
+    EE_PMW3901MB_STATS_ADD(bus->counters.reads, 1U);
+    EE_PMW3901MB_STATS_ADD(bus->counters.bytes, n + 1U);
+
+    bus->cs_assert_us = ee_pmw3901mb_time_us();
+    spiSelect(bus->spi_driver);
+    /* Sending the command and reading back n registers in one transfer, completed in ee_pmw3901mb_spi_data_cb(). */
+    spiStartExchange(bus->spi_driver, n + 1U, bus->async_txbuf, bus->async_rxbuf);
 
     return 0; // Success
 }
 
+bool ee_pmw3901mb_spi_bus_async_busy(const ee_pmw3901mb_spi_bus_t* bus){
+    if(bus == NULL) return false;
+    return bus->async_busy;
+}
+
+void ee_pmw3901mb_spi_data_cb(SPIDriver* spip){
+    ee_pmw3901mb_spi_bus_t* bus = NULL;
+
+    osalSysLockFromISR();
+    for(size_t i = 0; i < EE_PMW3901MB_SPI_ASYNC_MAX_DRIVERS; i++){
+        if(async_buses[i] != NULL && async_buses[i]->spi_driver == spip){
+            bus = async_buses[i];
+            async_buses[i] = NULL;
+            break;
+        }
+    }
+    if(bus != NULL) spiUnselectI(spip);
+    osalSysUnlockFromISR();
+
+    if(bus != NULL) bus->cs_deassert_us = ee_pmw3901mb_time_us();
+
+    if(bus == NULL) return; // Completion of a blocking transfer
+
+    EE_PMW3901MB_TRACE_RECORD(EE_PMW3901MB_TRACE_ASYNC, bus->async_txbuf[0], &bus->async_rxbuf[1], bus->async_n, bus->cs_assert_us);
+
+    ee_pmw3901mb_spi_async_cb_t cb = bus->async_cb;
+    bus->async_busy = false;
+    if(cb != NULL) cb(bus, &bus->async_rxbuf[1], bus->async_n, bus->async_arg);
+}
+
+#if (EE_PMW3901MB_USE_SCHED == TRUE)
+// Run order: priority, then deadline (none last), then submit order
+static bool trans_before(const ee_pmw3901mb_spi_trans_t* a, const ee_pmw3901mb_spi_trans_t* b){
+    if(a->priority != b->priority) return a->priority > b->priority;
+    if(a->deadline_us != 0U && b->deadline_us != 0U){
+        int32_t d = (int32_t) ((a->submit_us + a->deadline_us) - (b->submit_us + b->deadline_us));
+        if(d != 0) return d < 0;
+    }else if(a->deadline_us != 0U || b->deadline_us != 0U){
+        return a->deadline_us != 0U;
+    }
+    return (int32_t) (a->seq - b->seq) < 0;
+}
+
+// Read of the registers following the regs registers read from the first transaction of a frame
+static bool trans_coalesces(const ee_pmw3901mb_spi_trans_t* first, const ee_pmw3901mb_spi_trans_t* next, size_t regs){
+    const ee_pmw3901mb_spi_periph_t* periph = first->periph;
+    if(next == NULL || next->periph != periph || periph->coalesce_max == 0U) return false;
+    if(first->tx_n != 0U || next->tx_n != 0U) return false;
+    if((first->cmd & (uint8_t) ~periph->addr_mask) != (next->cmd & (uint8_t) ~periph->addr_mask)) return false;
+    if((size_t) (first->cmd & periph->addr_mask) + regs != (size_t) (next->cmd & periph->addr_mask)) return false;
+    return regs + next->rx_n <= periph->coalesce_max;
+}
+
+// Takes the bus for a run, called with the system locked
+static bool sched_claim_s(ee_pmw3901mb_spi_sched_t* sched){
+    if(sched->running) return false;
+    sched->running = true;
+    return true;
+}
+
+// Gives the bus up after a run, waking a thread waiting on a pending transaction to run it
+static void sched_yield(ee_pmw3901mb_spi_sched_t* sched){
+#if SPI_USE_MUTUAL_EXCLUSION == TRUE
+    spiReleaseBus(sched->spi_driver);
+#endif
+    osalSysLock();
+    sched->running = false;
+    for(ee_pmw3901mb_spi_trans_t* t = sched->pending; t != NULL; t = t->next){
+        if(t->waiter != NULL){
+            osalThreadResumeS(&t->waiter, MSG_RESET);
+            break;
+        }
+    }
+    osalSysUnlock();
+}
+
+// Runs the next chip select frame, false when none is pending
+static bool sched_frame(ee_pmw3901mb_spi_sched_t* sched){
+    SPIDriver* spip = sched->spi_driver;
+
+    // The next transaction and the reads coalesced with it
+    osalSysLock();
+    ee_pmw3901mb_spi_trans_t* first = sched->pending;
+    if(first == NULL){
+        osalSysUnlock();
+        return false;
+    }
+    ee_pmw3901mb_spi_trans_t* last = first;
+    size_t regs = first->rx_n;
+    sched->pending = first->next;
+    while(trans_coalesces(first, sched->pending, regs)){
+        last->next = sched->pending;
+        last = last->next;
+        regs += last->rx_n;
+        sched->pending = last->next;
+        sched->coalesced++;
+    }
+    last->next = NULL;
+    osalSysUnlock();
+
+    uint32_t start_us = ee_pmw3901mb_time_us();
+    if(spip->config != first->periph->spi_config){
+        // Peripheral switch, or the driver was stopped or reconfigured by another user
+        spiStart(spip, first->periph->spi_config);
+        sched->switches++;
+    }
+    uint32_t cs_assert_us = ee_pmw3901mb_time_us();
+    spiSelect(spip);
+    spiSend(spip, 1U, &first->cmd);
+    if(first->tx_n != 0U) spiSend(spip, first->tx_n, first->tx);
+    for(ee_pmw3901mb_spi_trans_t* t = first; t != NULL; t = t->next){
+        if(t->rx_n != 0U) spiReceive(spip, t->rx_n, t->rx);
+    }
+    spiUnselect(spip);
+    uint32_t done_us = ee_pmw3901mb_time_us();
+    sched->frames++;
+    sched->busy_us += done_us - start_us;
+
+    ee_pmw3901mb_spi_trans_t* next = NULL;
+    for(ee_pmw3901mb_spi_trans_t* t = first; t != NULL; t = next){
+        next = t->next;
+        t->start_us = cs_assert_us;
+        t->done_us = done_us;
+        t->missed = t->deadline_us != 0U && done_us - t->submit_us > t->deadline_us;
+        sched->completed++;
+        if(t->missed) sched->missed++;
+        if(t->cb != NULL) t->cb(t, t->arg);
+
+        // The owner can reuse the transaction once done
+        osalSysLock();
+        t->done = true;
+        osalThreadResumeI(&t->waiter, MSG_OK);
+        osalOsRescheduleS();
+        osalSysUnlock();
+    }
+
+    return true;
+}
+
+uint8_t ee_pmw3901mb_spi_sched_init(ee_pmw3901mb_spi_sched_t* sched, SPIDriver* spid_p){
+    if(sched == NULL || spid_p == NULL) return 1;
+
+    memset(sched, 0, sizeof(ee_pmw3901mb_spi_sched_t));
+    sched->spi_driver = spid_p;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_spi_sched_stop(ee_pmw3901mb_spi_sched_t* sched){
+    if(sched == NULL || sched->spi_driver == NULL) return 1;
+
+    osalSysLock();
+    bool busy = sched->pending != NULL || !sched_claim_s(sched);
+    osalSysUnlock();
+    if(busy) return 2; // Error: Transactions pending or running
+
+#if SPI_USE_MUTUAL_EXCLUSION == TRUE
+    spiAcquireBus(sched->spi_driver);
+#endif
+    if(sched->spi_driver->config != NULL) spiStop(sched->spi_driver);
+    sched_yield(sched);
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_spi_sched_submit(ee_pmw3901mb_spi_sched_t* sched, ee_pmw3901mb_spi_trans_t* trans){
+    if(sched == NULL || sched->spi_driver == NULL || trans == NULL) return 1;
+    if(trans->periph == NULL || trans->periph->spi_config == NULL) return 2;
+    if((trans->tx_n != 0U && trans->tx == NULL) || (trans->rx_n != 0U && trans->rx == NULL)) return 3;
+
+    trans->done = false;
+    trans->missed = false;
+    trans->waiter = NULL;
+    trans->submit_us = ee_pmw3901mb_time_us();
+
+    osalSysLock();
+    trans->seq = sched->seq++;
+    ee_pmw3901mb_spi_trans_t** pos = &sched->pending;
+    while(*pos != NULL && !trans_before(trans, *pos)) pos = &(*pos)->next;
+    trans->next = *pos;
+    *pos = trans;
+    sched->submitted++;
+    osalSysUnlock();
+
+    return 0;
+}
+
+size_t ee_pmw3901mb_spi_sched_run(ee_pmw3901mb_spi_sched_t* sched, size_t max_frames){
+    if(sched == NULL || sched->spi_driver == NULL) return 0;
+
+    osalSysLock();
+    bool claimed = sched_claim_s(sched);
+    osalSysUnlock();
+    if(!claimed) return 0;
+
+#if SPI_USE_MUTUAL_EXCLUSION == TRUE
+    spiAcquireBus(sched->spi_driver);
+#endif
+    size_t frames = 0;
+    while((max_frames == 0U || frames < max_frames) && sched_frame(sched)) frames++;
+    sched_yield(sched);
+
+    return frames;
+}
+
+uint8_t ee_pmw3901mb_spi_sched_transfer(ee_pmw3901mb_spi_sched_t* sched, ee_pmw3901mb_spi_trans_t* trans){
+    uint8_t status_code = ee_pmw3901mb_spi_sched_submit(sched, trans);
+    if(status_code != 0) return status_code;
+
+    for(;;){
+        osalSysLock();
+        if(trans->done){
+            osalSysUnlock();
+            return 0;
+        }
+        if(!sched_claim_s(sched)){
+            // Woken when done, or to run the bus after the running thread
+            (void) osalThreadSuspendS(&trans->waiter);
+            osalSysUnlock();
+            continue;
+        }
+        osalSysUnlock();
+
+#if SPI_USE_MUTUAL_EXCLUSION == TRUE
+        spiAcquireBus(sched->spi_driver);
+#endif
+        while(!trans->done && sched_frame(sched)){}
+        sched_yield(sched);
+    }
+}
+
+uint8_t ee_pmw3901mb_spi_bus_set_sched(ee_pmw3901mb_spi_bus_t* bus, ee_pmw3901mb_spi_sched_t* sched,
+                                       uint8_t priority, uint32_t deadline_us){
+    if(bus == NULL || bus->spi_driver == NULL || bus->spi_config == NULL) return 1;
+    if(sched != NULL && sched->spi_driver != bus->spi_driver) return 2; // Error: Other SPI driver
+    if(bus->session_depth != 0U || bus->async_busy) return 3; // Error: Bus session acquired
+
+    bus->sched = sched;
+    bus->periph.spi_config = bus->spi_config;
+    bus->periph.addr_mask = SPI_RW_BIT_READ_MASK;
+    bus->periph.coalesce_max = 0U;
+    bus->priority = priority;
+    bus->deadline_us = deadline_us;
+
+    return 0;
+}
+#endif
+
+uint32_t ee_pmw3901mb_time_us(void){
+    uint32_t time_us = 0;
+
+    syssts_t sts = chSysGetStatusAndLockX();
+    systimestamp_t ts = chVTGetTimeStampI();
+#if PORT_SUPPORTS_RT == TRUE
+    // Realtime counter for sub-tick resolution, its wraps are bridged with the system time stamp
+    static systimestamp_t last_ts;
+    static rtcnt_t last_cnt;
+    static uint64_t cycles;
+    rtcnt_t cnt = chSysGetRealtimeCounterX();
+    uint64_t ts_cycles = (uint64_t) (ts - last_ts) * (EE_PMW3901MB_RT_COUNTER_HZ / CH_CFG_ST_FREQUENCY);
+    if(ts_cycles < 0x80000000U) cycles += (rtcnt_t) (cnt - last_cnt);
+    else cycles += ts_cycles;
+    last_ts = ts;
+    last_cnt = cnt;
+    time_us = (uint32_t) (cycles / (EE_PMW3901MB_RT_COUNTER_HZ / 1000000U));
+#else
+    time_us = (uint32_t) (((uint64_t) ts * 1000000U) / CH_CFG_ST_FREQUENCY);
+#endif
+    chSysRestoreStatusX(sts);
+
+    return time_us;
+}
+
 uint8_t ee_pmw3901mb_wait_ms(uint32_t wait_ms){
     chThdSleepMilliseconds(wait_ms);
     return 0;
@@ -0,0 +1,144 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_poll.h"
+
+
+static bool burst_has_motion(const ee_pmw3901mb_motion_burst_t* burst){
+    return (burst->motion & EE_PMW3901MB_MOTION_MOT) != 0U || burst->delta_x != 0 || burst->delta_y != 0;
+}
+
+
+uint8_t ee_pmw3901mb_poll_rate_init(ee_pmw3901mb_poll_rate_t* rate, uint32_t min_period_us,
+                                    uint32_t max_period_us, uint8_t idle_hold){
+    if(rate == NULL || min_period_us == 0U || max_period_us < min_period_us) return 1;
+
+    rate->min_period_us = min_period_us;
+    rate->max_period_us = max_period_us;
+    rate->period_us = min_period_us;
+    rate->idle_hold = idle_hold;
+    rate->idle_reads = 0;
+
+    return 0;
+}
+
+uint32_t ee_pmw3901mb_poll_rate_update(ee_pmw3901mb_poll_rate_t* rate, const ee_pmw3901mb_motion_burst_t* burst){
+    if(rate == NULL) return EE_PMW3901MB_POLL_MAX_PERIOD_US;
+
+    if(burst != NULL && burst_has_motion(burst)){
+        rate->idle_reads = 0;
+        rate->period_us = rate->min_period_us;
+        return rate->period_us;
+    }
+
+    // Hold the period for a few idle reads, so short pauses in the motion do not slow down the reads
+    if(rate->idle_reads < rate->idle_hold){
+        rate->idle_reads++;
+        return rate->period_us;
+    }
+
+    rate->period_us = (rate->period_us > rate->max_period_us / 2U) ? rate->max_period_us : rate->period_us * 2U;
+    return rate->period_us;
+}
+
+
+#if (EE_PMW3901MB_USE_POLL == TRUE)
+
+static void poll_read(ee_pmw3901mb_poll_t* poll, ee_pmw3901mb_motion_burst_t* burst){
+    poll->reads++;
+    if(ee_pmw3901mb_dev_get_motion_burst(poll->dev, burst) != 0){
+        poll->errors++;
+        memset(burst, 0, sizeof(ee_pmw3901mb_motion_burst_t)); // Counts as idle
+        return;
+    }
+    if(!burst_has_motion(burst)) return;
+
+    const ee_pmw3901mb_quality_cfg_t* quality = poll->quality;
+    if(quality != NULL && ee_pmw3901mb_quality_gate(quality, burst, NULL) == EE_PMW3901MB_QUALITY_DROP){
+        poll->rejected++;
+        return;
+    }
+
+    if(ee_pmw3901mb_ring_push_burst(poll->ring, burst, poll->dev->burst_assert_us) != 0){
+        poll->overruns++;
+    }else{
+        poll->samples++;
+    }
+}
+
+static THD_FUNCTION(poll_thread, arg){
+    ee_pmw3901mb_poll_t* poll = (ee_pmw3901mb_poll_t*) arg;
+    chRegSetThreadName("pmw3901mb_poll");
+
+    ee_pmw3901mb_motion_burst_t burst;
+    systime_t prev = chVTGetSystemTime();
+
+    while(!chThdShouldTerminateX()){
+        poll_read(poll, &burst);
+        uint32_t period_us = ee_pmw3901mb_poll_rate_update(&poll->rate, &burst);
+
+        // Windowed sleep keeps the period free of read time jitter
+        sysinterval_t period = TIME_US2I(period_us);
+        if(period == (sysinterval_t) 0) period = (sysinterval_t) 1;
+        prev = chThdSleepUntilWindowed(prev, chTimeAddX(prev, period));
+    }
+}
+
+
+uint8_t ee_pmw3901mb_poll_start(ee_pmw3901mb_poll_t* poll, ee_pmw3901mb_dev_t* dev, ee_pmw3901mb_ring_t* ring,
+                                uint32_t min_period_us, uint32_t max_period_us, void* wa, size_t wa_size, tprio_t prio){
+    if(poll == NULL || dev == NULL || ring == NULL || wa == NULL) return 1;
+    if(!dev->initialized) return 2; // Error: Device not initialized
+
+    memset(poll, 0, sizeof(ee_pmw3901mb_poll_t));
+    if(ee_pmw3901mb_poll_rate_init(&poll->rate, min_period_us, max_period_us, EE_PMW3901MB_POLL_IDLE_HOLD) != 0) return 1;
+    poll->dev = dev;
+    poll->ring = ring;
+
+    poll->thread = chThdCreateStatic(wa, wa_size, prio, poll_thread, poll);
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_poll_stop(ee_pmw3901mb_poll_t* poll){
+    if(poll == NULL) return 1;
+    if(poll->thread == NULL) return 2; // Error: Not started
+
+    chThdTerminate(poll->thread);
+    chThdWait(poll->thread);
+    poll->thread = NULL;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_poll_set_quality(ee_pmw3901mb_poll_t* poll, const ee_pmw3901mb_quality_cfg_t* cfg){
+    if(poll == NULL) return 1;
+
+    chSysLock();
+    poll->quality = cfg;
+    chSysUnlock();
+
+    return 0;
+}
+
+#endif /* EE_PMW3901MB_USE_POLL == TRUE */
@@ -0,0 +1,285 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_power.h"
+
+// Defaults
+#define DEF_IDLE_TIMEOUT_US     2000000U
+#define DEF_CHECK_PERIOD_US     250000U
+#define DEF_CHECK_WINDOW_US     25000U
+
+
+// Time left until a due time, 0 when due
+static uint32_t time_left_us(uint32_t due_us, uint32_t now_us){
+    int32_t left = (int32_t) (due_us - now_us);
+    return (left > 0) ? (uint32_t) left : 0U;
+}
+
+static void power_enter(ee_pmw3901mb_power_t* power, ee_pmw3901mb_power_state_t state, uint32_t now_us){
+    power->state_time_us[power->state] += now_us - power->state_us;
+    power->state = state;
+    power->state_us = now_us;
+}
+
+static void power_active(ee_pmw3901mb_power_t* power, uint32_t now_us){
+    power_enter(power, EE_PMW3901MB_POWER_ACTIVE, now_us);
+    power->motion_us = now_us;
+    power->wakes++;
+    power->last_wake_us = now_us - power->wake_us;
+}
+
+static uint8_t power_fail(ee_pmw3901mb_power_t* power, uint32_t now_us){
+    power_enter(power, EE_PMW3901MB_POWER_FAILED, now_us);
+    return 1;
+}
+
+static uint8_t power_sleep(ee_pmw3901mb_power_t* power, uint32_t now_us){
+    power->sleeps++;
+    power->motion_pending = false;
+    power->due_us = now_us + power->cfg.check_period_us;
+
+    if(power->cfg.sleep_mode == EE_PMW3901MB_SLEEP_SHUTDOWN){
+        if(ee_pmw3901mb_dev_shutdown(power->dev) != 0) return power_fail(power, now_us);
+        power->dev->initialized = false;
+        power->tuned = false; // Lost with the power up reset of the wake
+        power_enter(power, EE_PMW3901MB_POWER_SHUTDOWN, now_us);
+        return 0;
+    }
+    power_enter(power, EE_PMW3901MB_POWER_REST, now_us);
+    return 0;
+}
+
+// Wakes to active, through the performance optimization sequence when not tuned
+static uint8_t power_wake(ee_pmw3901mb_power_t* power, uint32_t now_us){
+    if(power->tuned){
+        power->dev->initialized = true;
+        power_active(power, now_us);
+        return 0;
+    }
+
+    uint8_t status_code = 0;
+    if(power->state == EE_PMW3901MB_POWER_SHUTDOWN) status_code = ee_pmw3901mb_dev_boot_start(power->dev);
+    if(status_code != 0) return power_fail(power, now_us);
+    power_enter(power, EE_PMW3901MB_POWER_WAKE, now_us);
+    return 0;
+}
+
+static bool burst_motion(const ee_pmw3901mb_motion_burst_t* burst){
+    return (burst->motion & EE_PMW3901MB_MOTION_MOT) != 0U;
+}
+
+
+uint8_t ee_pmw3901mb_power_default_cfg(ee_pmw3901mb_power_cfg_t* cfg){
+    if(cfg == NULL) return 1;
+
+    cfg->sleep_mode = EE_PMW3901MB_SLEEP_REST;
+    cfg->idle_timeout_us = DEF_IDLE_TIMEOUT_US;
+    cfg->check_period_us = DEF_CHECK_PERIOD_US;
+    cfg->check_window_us = DEF_CHECK_WINDOW_US;
+    cfg->wake_on_motion = true;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_power_init(ee_pmw3901mb_power_t* power, ee_pmw3901mb_dev_t* dev, const ee_pmw3901mb_power_cfg_t* cfg){
+    if(power == NULL || dev == NULL || !dev->initialized) return 1;
+
+    memset(power, 0, sizeof(ee_pmw3901mb_power_t));
+    power->dev = dev;
+    if(cfg != NULL) power->cfg = *cfg;
+    else ee_pmw3901mb_power_default_cfg(&power->cfg);
+
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    power->state = EE_PMW3901MB_POWER_ACTIVE;
+    power->state_us = now_us;
+    power->motion_us = now_us;
+    power->tuned = true;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_power_step(ee_pmw3901mb_power_t* power, uint32_t* wait_us){
+    if(power == NULL || power->dev == NULL) return 1;
+
+    ee_pmw3901mb_dev_t* dev = power->dev;
+    const ee_pmw3901mb_power_cfg_t* cfg = &power->cfg;
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    uint32_t left_us = UINT32_MAX;
+    uint8_t status_code = 0;
+
+    switch(power->state){
+    case EE_PMW3901MB_POWER_ACTIVE:
+        if(cfg->idle_timeout_us == 0U) break;
+        left_us = time_left_us(power->motion_us + cfg->idle_timeout_us, now_us);
+        if(left_us != 0U) break;
+        status_code = power_sleep(power, now_us);
+        left_us = (cfg->check_period_us != 0U) ? cfg->check_period_us : UINT32_MAX;
+        break;
+
+    case EE_PMW3901MB_POWER_REST: {
+        bool notified = cfg->wake_on_motion && power->motion_pending;
+        if(cfg->check_period_us != 0U) left_us = time_left_us(power->due_us, now_us);
+        if(!notified && left_us != 0U) break;
+
+        // The sensor kept counting while resting, the check burst holds the motion since the sleep
+        power->checks++;
+        power->motion_pending = false;
+        if(ee_pmw3901mb_dev_get_motion_burst(dev, &power->burst) != 0){
+            status_code = power_fail(power, now_us);
+        }else if(burst_motion(&power->burst)){
+            power->burst_pending = true;
+            power->wake_us = now_us;
+            status_code = power_wake(power, now_us);
+            left_us = 0;
+        }else if(cfg->check_period_us != 0U){
+            power->due_us = now_us + cfg->check_period_us;
+            left_us = cfg->check_period_us;
+        }
+        break;
+    }
+
+    case EE_PMW3901MB_POWER_SHUTDOWN:
+        if(cfg->check_period_us == 0U) break;
+        left_us = time_left_us(power->due_us, now_us);
+        if(left_us != 0U) break;
+
+        // Quick check: power up reset and boot, untuned frames over the check window
+        power->checks++;
+        power->wake_us = now_us;
+        if(ee_pmw3901mb_dev_boot_start(dev) != 0){
+            status_code = power_fail(power, now_us);
+            break;
+        }
+        power_enter(power, EE_PMW3901MB_POWER_CHECK, now_us);
+        power->due_us = UINT32_MAX;
+        left_us = 0;
+        break;
+
+    case EE_PMW3901MB_POWER_CHECK:
+        if(dev->startup.state != EE_PMW3901MB_STARTUP_BOOTED){
+            status_code = ee_pmw3901mb_dev_init_step(dev, &left_us);
+            if(status_code != 0){
+                status_code = power_fail(power, now_us);
+                break;
+            }
+            if(dev->startup.state != EE_PMW3901MB_STARTUP_BOOTED) break;
+            power->due_us = ee_pmw3901mb_time_us() + cfg->check_window_us;
+        }
+        left_us = time_left_us(power->due_us, ee_pmw3901mb_time_us());
+        if(left_us != 0U) break;
+
+        status_code = ee_pmw3901mb_dev_get_motion_burst(dev, &power->burst);
+        now_us = ee_pmw3901mb_time_us();
+        if(status_code != 0){
+            status_code = power_fail(power, now_us);
+        }else if(burst_motion(&power->burst)){
+            power->burst_pending = true;
+            status_code = power_wake(power, now_us);
+            left_us = 0;
+        }else{
+            // No motion, back to shutdown without the performance optimization sequence,
+            // the check period counted from the start of the check
+            status_code = ee_pmw3901mb_dev_shutdown(dev);
+            if(status_code != 0){
+                status_code = power_fail(power, now_us);
+                break;
+            }
+            power_enter(power, EE_PMW3901MB_POWER_SHUTDOWN, now_us);
+            power->due_us = power->wake_us + cfg->check_period_us;
+            if(time_left_us(power->due_us, now_us) == 0U) power->due_us = now_us + cfg->check_period_us;
+            left_us = time_left_us(power->due_us, now_us);
+        }
+        break;
+
+    case EE_PMW3901MB_POWER_WAKE:
+        if(dev->startup.state == EE_PMW3901MB_STARTUP_BOOTED) status_code = ee_pmw3901mb_dev_retune_start(dev);
+        if(status_code == 0) status_code = ee_pmw3901mb_dev_init_step(dev, &left_us);
+        now_us = ee_pmw3901mb_time_us();
+        if(status_code != 0){
+            status_code = power_fail(power, now_us);
+        }else if(ee_pmw3901mb_dev_init_done(dev)){
+            power->tuned = true;
+            power_active(power, now_us);
+            left_us = cfg->idle_timeout_us;
+        }
+        break;
+
+    default:
+        status_code = 1; // Error: Failed
+        break;
+    }
+
+    if(wait_us != NULL) *wait_us = left_us;
+    return status_code;
+}
+
+uint8_t ee_pmw3901mb_power_get_motion_burst(ee_pmw3901mb_power_t* power, ee_pmw3901mb_motion_burst_t* burst){
+    if(power == NULL || power->dev == NULL || burst == NULL) return 1;
+    if(power->state != EE_PMW3901MB_POWER_ACTIVE) return EE_PMW3901MB_POWER_ASLEEP;
+
+    if(power->burst_pending){
+        // Motion counted up to the check that woke the sensor
+        power->burst_pending = false;
+        *burst = power->burst;
+        return 0;
+    }
+
+    uint8_t status_code = ee_pmw3901mb_dev_get_motion_burst(power->dev, burst);
+    if(status_code != 0) return status_code;
+    if(burst_motion(burst)) power->motion_us = ee_pmw3901mb_time_us();
+
+    return 0;
+}
+
+void ee_pmw3901mb_power_notify_motion(ee_pmw3901mb_power_t* power){
+    if(power == NULL) return;
+    power->motion_pending = true;
+}
+
+uint8_t ee_pmw3901mb_power_wake(ee_pmw3901mb_power_t* power){
+    if(power == NULL || power->dev == NULL) return 1;
+
+    uint32_t now_us = ee_pmw3901mb_time_us();
+    switch(power->state){
+    case EE_PMW3901MB_POWER_ACTIVE:
+        power->motion_us = now_us; // Restarts the idle timeout
+        return 0;
+    case EE_PMW3901MB_POWER_REST:
+    case EE_PMW3901MB_POWER_SHUTDOWN:
+        power->wake_us = now_us;
+        return power_wake(power, now_us);
+    case EE_PMW3901MB_POWER_CHECK:
+        // The boot continues up to active
+        power_enter(power, EE_PMW3901MB_POWER_WAKE, now_us);
+        return 0;
+    case EE_PMW3901MB_POWER_WAKE:
+        return 0;
+    default:
+        return 1; // Error: Failed
+    }
+}
+
+bool ee_pmw3901mb_power_is_active(const ee_pmw3901mb_power_t* power){
+    return power != NULL && power->state == EE_PMW3901MB_POWER_ACTIVE;
+}
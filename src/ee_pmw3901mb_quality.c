@@ -0,0 +1,92 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_quality.h"
+
+// Defaults, SQUAL 0x19 scores 127 and is gated, 0x1A scores 132 and passes, and a raw data
+// sum of 0x10 (a surface too dark to expose) scores 127 and is gated
+#define DEF_SQUAL_FULL          0x32U
+#define DEF_SHUTTER_LOW         0x1000U
+#define DEF_SHUTTER_HIGH        0x1F00U
+#define DEF_CONTRAST_FULL       0x10U
+#define DEF_RAWDATA_SUM_FULL    0x20U
+#define DEF_MIN_SCORE           128U
+
+
+static uint8_t ramp_up(uint32_t value, uint32_t full){
+    if(full == 0U || value >= full) return EE_PMW3901MB_QUALITY_SCORE_MAX;
+    return (uint8_t) ((value * EE_PMW3901MB_QUALITY_SCORE_MAX) / full);
+}
+
+static uint8_t ramp_down(uint32_t value, uint32_t low, uint32_t high){
+    if(value <= low) return EE_PMW3901MB_QUALITY_SCORE_MAX;
+    if(value >= high) return 0U;
+    return (uint8_t) (((high - value) * EE_PMW3901MB_QUALITY_SCORE_MAX) / (high - low));
+}
+
+
+uint8_t ee_pmw3901mb_quality_default_cfg(ee_pmw3901mb_quality_cfg_t* cfg){
+    if(cfg == NULL) return 1;
+
+    cfg->squal_full = DEF_SQUAL_FULL;
+    cfg->shutter_low = DEF_SHUTTER_LOW;
+    cfg->shutter_high = DEF_SHUTTER_HIGH;
+    cfg->contrast_full = DEF_CONTRAST_FULL;
+    cfg->rawdata_sum_full = DEF_RAWDATA_SUM_FULL;
+    cfg->min_score = DEF_MIN_SCORE;
+    cfg->action = EE_PMW3901MB_QUALITY_DROP;
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_quality_score(const ee_pmw3901mb_quality_cfg_t* cfg, const ee_pmw3901mb_motion_burst_t* burst){
+    if(cfg == NULL || burst == NULL) return 0U;
+
+    uint8_t score = ramp_up(burst->squal, cfg->squal_full);
+
+    uint8_t term = ramp_down(burst->shutter, cfg->shutter_low, cfg->shutter_high);
+    if(term < score) score = term;
+
+    if(cfg->contrast_full != 0U){
+        uint32_t contrast = (burst->max_rawdata > burst->min_rawdata) ? (uint32_t) (burst->max_rawdata - burst->min_rawdata) : 0U;
+        term = ramp_up(contrast, cfg->contrast_full);
+        if(term < score) score = term;
+    }
+
+    if(cfg->rawdata_sum_full != 0U){
+        term = ramp_up(burst->rawdata_sum, cfg->rawdata_sum_full);
+        if(term < score) score = term;
+    }
+
+    return score;
+}
+
+ee_pmw3901mb_quality_action_t ee_pmw3901mb_quality_gate(const ee_pmw3901mb_quality_cfg_t* cfg,
+                                                        const ee_pmw3901mb_motion_burst_t* burst, uint8_t* score){
+    uint8_t s = ee_pmw3901mb_quality_score(cfg, burst);
+    if(score != NULL) *score = s;
+
+    if(cfg == NULL || s >= cfg->min_score) return EE_PMW3901MB_QUALITY_PASS;
+    return cfg->action;
+}
@@ -0,0 +1,96 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_ring.h"
+
+#define RING_MASK   (EE_PMW3901MB_RING_SIZE - 1U)
+
+// Index loads/stores with acquire/release ordering, so the sample copy is complete before
+// the index publishing it is seen by the other side
+#define RING_LOAD_ACQUIRE(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RING_LOAD_RELAXED(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#define RING_STORE_RELEASE(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+
+uint8_t ee_pmw3901mb_ring_init(ee_pmw3901mb_ring_t* ring){
+    if(ring == NULL) return 1;
+    memset(ring, 0, sizeof(ee_pmw3901mb_ring_t));
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_ring_push(ee_pmw3901mb_ring_t* ring, const ee_pmw3901mb_sample_t* sample){
+    if(ring == NULL || sample == NULL) return 1;
+
+    uint32_t head = RING_LOAD_RELAXED(&ring->head);
+    uint32_t tail = RING_LOAD_ACQUIRE(&ring->tail);
+
+    if((uint32_t) (head - tail) >= EE_PMW3901MB_RING_SIZE){
+        RING_STORE_RELEASE(&ring->overflows, RING_LOAD_RELAXED(&ring->overflows) + 1U);
+        return 2; // Error: Ring full
+    }
+
+    ring->samples[head & RING_MASK] = *sample;
+    RING_STORE_RELEASE(&ring->head, head + 1U);
+
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_ring_push_burst(ee_pmw3901mb_ring_t* ring, const ee_pmw3901mb_motion_burst_t* burst, uint32_t time){
+    if(burst == NULL) return 1;
+
+    ee_pmw3901mb_sample_t sample;
+    sample.delta_x = burst->delta_x;
+    sample.delta_y = burst->delta_y;
+    sample.squal = burst->squal;
+    sample.shutter = burst->shutter;
+    sample.time = time;
+
+    return ee_pmw3901mb_ring_push(ring, &sample);
+}
+
+uint8_t ee_pmw3901mb_ring_pop(ee_pmw3901mb_ring_t* ring, ee_pmw3901mb_sample_t* sample){
+    if(ring == NULL || sample == NULL) return 1;
+
+    uint32_t tail = RING_LOAD_RELAXED(&ring->tail);
+    uint32_t head = RING_LOAD_ACQUIRE(&ring->head);
+
+    if(head == tail) return 2; // Error: Ring empty
+
+    *sample = ring->samples[tail & RING_MASK];
+    RING_STORE_RELEASE(&ring->tail, tail + 1U);
+
+    return 0;
+}
+
+uint32_t ee_pmw3901mb_ring_count(const ee_pmw3901mb_ring_t* ring){
+    if(ring == NULL) return 0;
+    uint32_t tail = RING_LOAD_ACQUIRE(&ring->tail);
+    uint32_t head = RING_LOAD_ACQUIRE(&ring->head);
+    return head - tail;
+}
+
+uint32_t ee_pmw3901mb_ring_overflows(const ee_pmw3901mb_ring_t* ring){
+    if(ring == NULL) return 0;
+    return RING_LOAD_ACQUIRE(&ring->overflows);
+}
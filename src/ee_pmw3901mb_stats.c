@@ -0,0 +1,59 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_stats.h"
+
+
+void ee_pmw3901mb_hist_add(ee_pmw3901mb_hist_t* hist, uint32_t us){
+    if(hist == NULL) return;
+
+    uint32_t bucket = (us == 0U) ? 0U : (32U - (uint32_t) __builtin_clz(us));
+    if(bucket >= EE_PMW3901MB_STATS_BUCKETS) bucket = EE_PMW3901MB_STATS_BUCKETS - 1U;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sum_us += us;
+    if(us > hist->max_us) hist->max_us = us;
+}
+
+uint32_t ee_pmw3901mb_hist_percentile(const ee_pmw3901mb_hist_t* hist, uint32_t percent){
+    if(hist == NULL || hist->count == 0U) return 0;
+    if(percent > 100U) percent = 100U;
+
+    // Rank of the percentile sample, at least the first
+    uint64_t rank = ((uint64_t) hist->count * percent + 99U) / 100U;
+    if(rank == 0U) rank = 1U;
+
+    uint64_t seen = 0;
+    for(uint32_t k = 0; k < EE_PMW3901MB_STATS_BUCKETS; k++){
+        seen += hist->buckets[k];
+        if(seen >= rank){
+            if(k == 0U) return 0;
+            uint32_t upper = (k >= 32U) ? UINT32_MAX : ((1UL << k) - 1U);
+            return (upper < hist->max_us) ? upper : hist->max_us;
+        }
+    }
+
+    return hist->max_us;
+}
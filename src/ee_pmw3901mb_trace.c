@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_trace.h"
+
+#define TRACE_MASK      (EE_PMW3901MB_TRACE_SIZE - 1U)
+
+static const uint8_t trace_magic[4] = { 'P', 'M', 'W', 'T' };
+
+static uint32_t get_u32(const uint8_t* p){
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+
+uint8_t ee_pmw3901mb_trace_parse_header(const uint8_t* dump, size_t len, uint32_t* records, uint32_t* dropped){
+    if(dump == NULL) return 1;
+    if(len < EE_PMW3901MB_TRACE_FILE_HEADER_SIZE) return 2; // Error: Truncated header
+    if(memcmp(dump, trace_magic, sizeof(trace_magic)) != 0) return 3; // Error: Not a trace dump
+    if(dump[4] != EE_PMW3901MB_TRACE_VERSION) return 4; // Error: Unsupported version
+
+    if(records != NULL) *records = get_u32(&dump[8]);
+    if(dropped != NULL) *dropped = get_u32(&dump[12]);
+    return 0;
+}
+
+size_t ee_pmw3901mb_trace_parse(const uint8_t* dump, size_t len, size_t pos, ee_pmw3901mb_trace_record_t* rec){
+    if(dump == NULL || rec == NULL) return 0;
+    if(pos + EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE > len) return 0;
+
+    const uint8_t* p = &dump[pos];
+    size_t size = EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE + p[2];
+    if(pos + size > len) return 0;
+
+    rec->flags = p[0];
+    rec->addr = p[1];
+    rec->n = p[2];
+    rec->time_us = get_u32(&p[3]);
+    rec->data = &p[EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE];
+    return size;
+}
+
+
+#if (EE_PMW3901MB_USE_TRACE == TRUE)
+
+// Byte ring of records, head and tail are free running byte positions
+static uint8_t trace_buf[EE_PMW3901MB_TRACE_SIZE];
+static uint32_t trace_head;
+static uint32_t trace_tail;
+static uint32_t trace_records;
+static uint32_t trace_dropped;
+
+static void put_u32(uint8_t* p, uint32_t v){
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    p[2] = (uint8_t) (v >> 16);
+    p[3] = (uint8_t) (v >> 24);
+}
+
+static void ring_put(uint32_t pos, const uint8_t* src, size_t n){
+    for(size_t i = 0; i < n; i++) trace_buf[(pos + i) & TRACE_MASK] = src[i];
+}
+
+void ee_pmw3901mb_trace_record(uint8_t flags, uint8_t addr, const uint8_t* data, size_t n, uint32_t time_us){
+    size_t size = EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE + n;
+    if(n > 0xFFU || size > EE_PMW3901MB_TRACE_SIZE) return;
+
+    uint8_t header[EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE];
+    header[0] = flags;
+    header[1] = addr;
+    header[2] = (uint8_t) n;
+    put_u32(&header[3], time_us);
+
+    syssts_t sts = chSysGetStatusAndLockX();
+    // Overwrite the oldest records until the new one fits
+    while(EE_PMW3901MB_TRACE_SIZE - (trace_head - trace_tail) < size){
+        trace_tail += EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE + trace_buf[(trace_tail + 2U) & TRACE_MASK];
+        trace_records--;
+        trace_dropped++;
+    }
+    ring_put(trace_head, header, sizeof(header));
+    ring_put(trace_head + EE_PMW3901MB_TRACE_RECORD_HEADER_SIZE, data, n);
+    trace_head += (uint32_t) size;
+    trace_records++;
+    chSysRestoreStatusX(sts);
+}
+
+uint8_t ee_pmw3901mb_trace_dump(uint8_t* out, size_t size, size_t* len){
+    if(out == NULL || len == NULL) return 1;
+
+    syssts_t sts = chSysGetStatusAndLockX();
+    uint32_t used = trace_head - trace_tail;
+    if(size < EE_PMW3901MB_TRACE_FILE_HEADER_SIZE + used){
+        chSysRestoreStatusX(sts);
+        return 2; // Error: Buffer too small
+    }
+
+    memcpy(out, trace_magic, sizeof(trace_magic));
+    out[4] = EE_PMW3901MB_TRACE_VERSION;
+    out[5] = out[6] = out[7] = 0U;
+    put_u32(&out[8], trace_records);
+    put_u32(&out[12], trace_dropped);
+    for(uint32_t i = 0; i < used; i++){
+        out[EE_PMW3901MB_TRACE_FILE_HEADER_SIZE + i] = trace_buf[(trace_tail + i) & TRACE_MASK];
+    }
+    chSysRestoreStatusX(sts);
+
+    *len = EE_PMW3901MB_TRACE_FILE_HEADER_SIZE + used;
+    return 0;
+}
+
+void ee_pmw3901mb_trace_clear(void){
+    syssts_t sts = chSysGetStatusAndLockX();
+    trace_head = 0;
+    trace_tail = 0;
+    trace_records = 0;
+    trace_dropped = 0;
+    chSysRestoreStatusX(sts);
+}
+
+uint32_t ee_pmw3901mb_trace_dropped(void){
+    return trace_dropped;
+}
+
+#endif /* EE_PMW3901MB_USE_TRACE == TRUE */
@@ -0,0 +1,130 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "ee_pmw3901mb_velocity.h"
+
+#define PI_Q16                  205887U     // pi in Q16.16
+#define CORDIC_INV_GAIN_Q15     19898       // 1/K of the CORDIC in Q15, K = 1.64676
+#define CORDIC_ITERATIONS       20U
+#define CORDIC_INPUT_MAX        (1L << 29)
+#define CORDIC_NORM_MIN         (1UL << 28)
+#define CORDIC_ANGLE_PI         (1L << 28)  // Internal angle resolution, pi in Q28
+#define CORDIC_ANGLE_SHIFT      13U         // Internal to EE_PMW3901MB_ANGLE_PI units
+
+// atan(2^-i) in units of CORDIC_ANGLE_PI
+static const int32_t cordic_atan[CORDIC_ITERATIONS] = {
+    67108864, 39616676, 20932363, 10625595, 5333416, 2669308, 1334980, 667531, 333770, 166886,
+    83443, 41722, 20861, 10430, 5215, 2608, 1304, 652, 326, 163
+};
+
+
+static int32_t velocity_axis(const ee_pmw3901mb_velocity_t* vel, int16_t delta, uint32_t dt_us, uint16_t height_mm){
+    // v = delta * rad_per_count * height / dt, with rad_per_count * 1e6 in Q16
+    int64_t num = (int64_t) delta * (int64_t) height_mm * (int64_t) vel->k_q16;
+    int64_t den = (int64_t) dt_us << 16;
+    // Round half away from zero
+    int64_t v = (num >= 0) ? ((num + den / 2) / den) : ((num - den / 2) / den);
+    if(v > INT32_MAX) return INT32_MAX;
+    if(v < INT32_MIN) return INT32_MIN;
+    return (int32_t) v;
+}
+
+
+uint8_t ee_pmw3901mb_velocity_init(ee_pmw3901mb_velocity_t* vel, uint32_t fov_mdeg, uint32_t pixels){
+    if(vel == NULL) return 1;
+    if(fov_mdeg == 0U || pixels == 0U) return 2; // Error: Invalid field of view
+
+    // rad_per_count * 1e6 = fov_mdeg * pi / (180000 * pixels) * 1e6
+    vel->k_q16 = (uint32_t) (((uint64_t) fov_mdeg * PI_Q16 * 1000000U) / (180000U * (uint64_t) pixels));
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_velocity_compute(const ee_pmw3901mb_velocity_t* vel, int16_t delta_x, int16_t delta_y,
+                                      uint32_t dt_us, uint16_t height_mm, int32_t* vx_mm_s, int32_t* vy_mm_s){
+    if(vel == NULL || vx_mm_s == NULL || vy_mm_s == NULL) return 1;
+    if(dt_us == 0U) return 2; // Error: Invalid sample interval
+
+    *vx_mm_s = velocity_axis(vel, delta_x, dt_us, height_mm);
+    *vy_mm_s = velocity_axis(vel, delta_y, dt_us, height_mm);
+    return 0;
+}
+
+uint8_t ee_pmw3901mb_cordic_vector(int32_t x, int32_t y, uint32_t* magnitude, int32_t* angle){
+    if(x >= CORDIC_INPUT_MAX || x <= -CORDIC_INPUT_MAX) return 1;
+    if(y >= CORDIC_INPUT_MAX || y <= -CORDIC_INPUT_MAX) return 1;
+
+    int32_t z = 0;
+
+    // Normalize small vectors up, so the shifts of the iterations keep the precision
+    uint32_t shift = 0;
+    uint32_t m = (uint32_t) ((x < 0) ? -x : x) | (uint32_t) ((y < 0) ? -y : y);
+    if(m == 0U){
+        if(magnitude != NULL) *magnitude = 0;
+        if(angle != NULL) *angle = 0;
+        return 0;
+    }
+    while(m < CORDIC_NORM_MIN){
+        m <<= 1;
+        shift++;
+    }
+    x = (int32_t) ((uint32_t) x << shift);
+    y = (int32_t) ((uint32_t) y << shift);
+
+    // Rotate into the right half plane, the CORDIC converges for +-99 degrees
+    if(x < 0){
+        int32_t t = x;
+        if(y >= 0){
+            x = y;
+            y = -t;
+            z = CORDIC_ANGLE_PI / 2;
+        }else{
+            x = -y;
+            y = t;
+            z = -CORDIC_ANGLE_PI / 2;
+        }
+    }
+
+    // Vectoring mode, rotate (x, y) onto the X axis while accumulating the angle
+    for(uint32_t i = 0; i < CORDIC_ITERATIONS; i++){
+        int32_t xs = x >> i;
+        int32_t ys = y >> i;
+        if(y >= 0){
+            x += ys;
+            y -= xs;
+            z += cordic_atan[i];
+        }else{
+            x -= ys;
+            y += xs;
+            z -= cordic_atan[i];
+        }
+    }
+
+    if(magnitude != NULL){
+        int64_t mag = (int64_t) x * CORDIC_INV_GAIN_Q15;
+        uint32_t mag_shift = 15U + shift;
+        *magnitude = (uint32_t) ((mag + ((int64_t) 1 << (mag_shift - 1U))) >> mag_shift);
+    }
+    if(angle != NULL) *angle = (z + (1L << (CORDIC_ANGLE_SHIFT - 1U))) >> CORDIC_ANGLE_SHIFT;
+    return 0;
+}
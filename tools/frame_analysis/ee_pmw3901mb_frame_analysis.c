@@ -0,0 +1,325 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <string.h>
+#include "ee_pmw3901mb_frame_analysis.h"
+
+#define W       EE_PMW3901MB_FA_FRAME_WIDTH
+#define N       EE_PMW3901MB_FA_FRAME_SIZE
+#define M       EE_PMW3901MB_FA_FFT_SIZE
+#define M_LOG2  6U
+
+#define LANES   16U
+
+#define FA_PI   3.14159265358979f
+
+// GCC vector extensions, mapped to SSE/AVX or NEON by the compiler
+typedef uint8_t v16u8 __attribute__((vector_size(16)));
+typedef uint16_t v16u16 __attribute__((vector_size(32)));
+typedef uint32_t v16u32 __attribute__((vector_size(64)));
+
+// Keep the scalar reference scalar, also when the build enables auto-vectorization
+#if defined(__GNUC__) && !defined(__clang__)
+#define FA_SCALAR __attribute__((optimize("no-tree-vectorize")))
+#else
+#define FA_SCALAR
+#endif
+
+static float window[W];             // Hann window
+static float twiddle_re[M / 2U];    // exp(-2 pi i k / M)
+static float twiddle_im[M / 2U];
+static uint8_t bitrev[M];
+
+
+static v16u8 load16(const uint8_t* p){
+    v16u8 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Squares of 16 pixels widened to 32 bits, 255^2 still fits the 16 bit product
+#define WIDEN_SQ(v)     __builtin_convertvector(__builtin_convertvector((v), v16u16) * __builtin_convertvector((v), v16u16), v16u32)
+
+static v16u8 abs_diff(v16u8 a, v16u8 b){
+    v16u8 m = (v16u8) (a > b);
+    return ((a - b) & m) | ((b - a) & ~m);
+}
+
+static uint32_t hsum(const v16u32* v){
+    uint32_t s = 0;
+    for(uint32_t i = 0; i < LANES; i++) s += (*v)[i];
+    return s;
+}
+
+static uint32_t sq_diff(uint8_t a, uint8_t b){
+    uint32_t d = (a > b) ? (uint32_t) (a - b) : (uint32_t) (b - a);
+    return d * d;
+}
+
+
+void ee_pmw3901mb_frame_analysis_init(void){
+    for(uint32_t i = 0; i < W; i++){
+        window[i] = 0.5f - 0.5f * cosf(2.0f * FA_PI * ((float) i + 0.5f) / (float) W);
+    }
+    for(uint32_t k = 0; k < M / 2U; k++){
+        twiddle_re[k] = cosf(2.0f * FA_PI * (float) k / (float) M);
+        twiddle_im[k] = -sinf(2.0f * FA_PI * (float) k / (float) M);
+    }
+    for(uint32_t i = 0; i < M; i++){
+        uint32_t r = 0;
+        for(uint32_t b = 0; b < M_LOG2; b++) r |= ((i >> b) & 1U) << (M_LOG2 - 1U - b);
+        bitrev[i] = (uint8_t) r;
+    }
+}
+
+uint8_t ee_pmw3901mb_frame_stats(const uint8_t* frame, uint8_t sat_level, ee_pmw3901mb_frame_stats_t* stats){
+    if(frame == NULL || stats == NULL) return 1;
+
+    v16u32 sum = {0};
+    v16u32 sum_sq = {0};
+    v16u32 focus = {0};
+    v16u8 vmin = (v16u8) {0} + 0xFF;
+    v16u8 vmax = {0};
+    v16u8 sat = {0};        // Per lane counts, at most N / LANES < 256
+    v16u8 level = (v16u8) {0} + sat_level;
+
+    // The frame is processed as one linear array of N pixels
+    uint32_t i = 0;
+    for(i = 0; i + LANES <= N; i += LANES){
+        v16u8 p = load16(&frame[i]);
+        v16u8 m = (v16u8) (p < vmin);
+        vmin = (p & m) | (vmin & ~m);
+        m = (v16u8) (p > vmax);
+        vmax = (p & m) | (vmax & ~m);
+        sat -= (v16u8) (p >= level);
+        sum += __builtin_convertvector(p, v16u32);
+        sum_sq += WIDEN_SQ(p);
+    }
+
+    uint32_t s = hsum(&sum);
+    uint32_t s_sq = hsum(&sum_sq);
+    uint32_t n_sat = 0;
+    uint8_t min = 0xFF;
+    uint8_t max = 0x00;
+    for(uint32_t l = 0; l < LANES; l++){
+        n_sat += sat[l];
+        if(vmin[l] < min) min = vmin[l];
+        if(vmax[l] > max) max = vmax[l];
+    }
+    for(; i < N; i++){
+        uint8_t p = frame[i];
+        s += p;
+        s_sq += (uint32_t) p * p;
+        if(p >= sat_level) n_sat++;
+        if(p < min) min = p;
+        if(p > max) max = p;
+    }
+
+    // Vertical differences are a linear run over the first N - W pixels
+    for(i = 0; i + LANES <= N - W; i += LANES){
+        focus += WIDEN_SQ(abs_diff(load16(&frame[i + W]), load16(&frame[i])));
+    }
+    uint32_t f = hsum(&focus);
+    for(; i < N - W; i++) f += sq_diff(frame[i + W], frame[i]);
+
+    // Horizontal differences as a linear run over N - 1 pixels, minus the row wrap terms
+    focus = (v16u32) {0};
+    for(i = 0; i + LANES <= N - 1U; i += LANES){
+        focus += WIDEN_SQ(abs_diff(load16(&frame[i + 1U]), load16(&frame[i])));
+    }
+    f += hsum(&focus);
+    for(; i < N - 1U; i++) f += sq_diff(frame[i + 1U], frame[i]);
+    for(i = W - 1U; i < N - 1U; i += W) f -= sq_diff(frame[i + 1U], frame[i]);
+
+    stats->sum = s;
+    stats->sum_sq = s_sq;
+    stats->focus = f;
+    stats->saturated = (uint16_t) n_sat;
+    stats->min = min;
+    stats->max = max;
+
+    return 0;
+}
+
+FA_SCALAR uint8_t ee_pmw3901mb_frame_stats_scalar(const uint8_t* frame, uint8_t sat_level, ee_pmw3901mb_frame_stats_t* stats){
+    if(frame == NULL || stats == NULL) return 1;
+
+    uint32_t s = 0;
+    uint32_t s_sq = 0;
+    uint32_t f = 0;
+    uint32_t n_sat = 0;
+    uint8_t min = 0xFF;
+    uint8_t max = 0x00;
+
+    for(uint32_t y = 0; y < W; y++){
+        for(uint32_t x = 0; x < W; x++){
+            uint8_t p = frame[y * W + x];
+            s += p;
+            s_sq += (uint32_t) p * p;
+            if(p >= sat_level) n_sat++;
+            if(p < min) min = p;
+            if(p > max) max = p;
+            if(x + 1U < W) f += sq_diff(frame[y * W + x + 1U], p);
+            if(y + 1U < W) f += sq_diff(frame[(y + 1U) * W + x], p);
+        }
+    }
+
+    stats->sum = s;
+    stats->sum_sq = s_sq;
+    stats->focus = f;
+    stats->saturated = (uint16_t) n_sat;
+    stats->min = min;
+    stats->max = max;
+
+    return 0;
+}
+
+float ee_pmw3901mb_frame_contrast(const ee_pmw3901mb_frame_stats_t* stats){
+    if(stats == NULL || stats->sum == 0U) return 0.0f;
+    float mean = (float) stats->sum / (float) N;
+    float var = (float) stats->sum_sq / (float) N - mean * mean;
+    return (var > 0.0f) ? sqrtf(var) / mean : 0.0f;
+}
+
+uint8_t ee_pmw3901mb_frame_histogram(const uint8_t* frame, uint32_t* hist){
+    if(frame == NULL || hist == NULL) return 1;
+    for(uint32_t i = 0; i < N; i++) hist[frame[i]]++;
+    return 0;
+}
+
+
+// Radix-2 FFT of all M columns at once along the rows axis, the butterflies work on whole
+// rows so the inner loops run over M contiguous floats
+static void fft_rows(float* re, float* im){
+    for(uint32_t i = 0; i < M; i++){
+        uint32_t j = bitrev[i];
+        if(j <= i) continue;
+        for(uint32_t c = 0; c < M; c++){
+            float t = re[i * M + c]; re[i * M + c] = re[j * M + c]; re[j * M + c] = t;
+            t = im[i * M + c]; im[i * M + c] = im[j * M + c]; im[j * M + c] = t;
+        }
+    }
+    for(uint32_t len = 2U; len <= M; len <<= 1){
+        uint32_t half = len >> 1;
+        uint32_t step = M / len;
+        for(uint32_t start = 0; start < M; start += len){
+            for(uint32_t k = 0; k < half; k++){
+                float wr = twiddle_re[k * step];
+                float wi = twiddle_im[k * step];
+                float* restrict ar = &re[(start + k) * M];
+                float* restrict ai = &im[(start + k) * M];
+                float* restrict br = &re[(start + k + half) * M];
+                float* restrict bi = &im[(start + k + half) * M];
+                for(uint32_t c = 0; c < M; c++){
+                    float tr = br[c] * wr - bi[c] * wi;
+                    float ti = br[c] * wi + bi[c] * wr;
+                    br[c] = ar[c] - tr;
+                    bi[c] = ai[c] - ti;
+                    ar[c] += tr;
+                    ai[c] += ti;
+                }
+            }
+        }
+    }
+}
+
+static void transpose(float* a){
+    for(uint32_t r = 0; r < M; r++){
+        for(uint32_t c = r + 1U; c < M; c++){
+            float t = a[r * M + c];
+            a[r * M + c] = a[c * M + r];
+            a[c * M + r] = t;
+        }
+    }
+}
+
+static void fft_2d(float* re, float* im){
+    fft_rows(re, im);
+    transpose(re);
+    transpose(im);
+    fft_rows(re, im);
+}
+
+uint8_t ee_pmw3901mb_frame_spectrum(const uint8_t* frame, ee_pmw3901mb_frame_spectrum_t* spec){
+    if(frame == NULL || spec == NULL) return 1;
+
+    uint32_t s = 0;
+    for(uint32_t i = 0; i < N; i++) s += frame[i];
+    float mean = (float) s / (float) N;
+
+    memset(spec, 0, sizeof(ee_pmw3901mb_frame_spectrum_t));
+    for(uint32_t y = 0; y < W; y++){
+        for(uint32_t x = 0; x < W; x++){
+            spec->re[y * M + x] = ((float) frame[y * W + x] - mean) * window[y] * window[x];
+        }
+    }
+    fft_2d(spec->re, spec->im);
+
+    return 0;
+}
+
+static float parabolic_offset(float l, float c, float r){
+    float d = l - 2.0f * c + r;
+    if(d >= 0.0f) return 0.0f; // Not a peak
+    return 0.5f * (l - r) / d;
+}
+
+uint8_t ee_pmw3901mb_frame_phase_shift(const ee_pmw3901mb_frame_spectrum_t* prev, const ee_pmw3901mb_frame_spectrum_t* cur,
+                                       ee_pmw3901mb_frame_spectrum_t* work, ee_pmw3901mb_frame_shift_t* shift){
+    if(prev == NULL || cur == NULL || work == NULL || shift == NULL) return 1;
+
+    // Normalized cross power spectrum cur * conj(prev), conjugated so the forward FFT inverts it
+    const float* restrict ar = prev->re;
+    const float* restrict ai = prev->im;
+    const float* restrict br = cur->re;
+    const float* restrict bi = cur->im;
+    float* restrict wr = work->re;
+    float* restrict wi = work->im;
+    for(uint32_t i = 0; i < M * M; i++){
+        float r = br[i] * ar[i] + bi[i] * ai[i];
+        float q = bi[i] * ar[i] - br[i] * ai[i];
+        float mag = sqrtf(r * r + q * q) + 1e-20f;
+        wr[i] = r / mag;
+        wi[i] = -q / mag;
+    }
+    fft_2d(work->re, work->im);
+
+    uint32_t best = 0;
+    for(uint32_t i = 1; i < M * M; i++){
+        if(work->re[i] > work->re[best]) best = i;
+    }
+    uint32_t py = best / M;
+    uint32_t px = best % M;
+    const float* r = work->re;
+    float c = r[best];
+    float dx = parabolic_offset(r[py * M + ((px + M - 1U) % M)], c, r[py * M + ((px + 1U) % M)]);
+    float dy = parabolic_offset(r[((py + M - 1U) % M) * M + px], c, r[((py + 1U) % M) * M + px]);
+
+    shift->dx = (float) ((px >= M / 2U) ? (int32_t) px - (int32_t) M : (int32_t) px) + dx;
+    shift->dy = (float) ((py >= M / 2U) ? (int32_t) py - (int32_t) M : (int32_t) py) + dy;
+    shift->peak = c / (float) (M * M);
+
+    return 0;
+}
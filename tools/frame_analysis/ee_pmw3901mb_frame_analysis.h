@@ -0,0 +1,169 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+/**
+ * @file ee_pmw3901mb_frame_analysis.h
+ * 
+ * @brief EngEmil PMW3901MB Frame Analysis, host side.
+ * 
+ * Kernels for raw 35x35 8-bit frames grabbed with ee_pmw3901mb_frame_grab():
+ * - Pixel statistics: mean/contrast terms, focus (sum of squared neighbour differences),
+ *   min/max and saturated pixel count, in a vectorized and a scalar reference version
+ * - Histogram
+ * - Frame to frame shift by phase correlation on a 64x64 zero padded FFT
+ * 
+ * The kernels keep no state besides the tables set up by ee_pmw3901mb_frame_analysis_init(),
+ * so several threads can run them on different frames.
+ */
+
+#ifndef _EE_PMW3901MB_FRAME_ANALYSIS_
+#define _EE_PMW3901MB_FRAME_ANALYSIS_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/**
+ * @brief Frame width and height in pixels, as EE_PMW3901MB_FRAME_WIDTH of the driver.
+ */
+#define EE_PMW3901MB_FA_FRAME_WIDTH     35U
+
+/**
+ * @brief Frame size in bytes, as EE_PMW3901MB_FRAME_SIZE of the driver.
+ */
+#define EE_PMW3901MB_FA_FRAME_SIZE      (EE_PMW3901MB_FA_FRAME_WIDTH * EE_PMW3901MB_FA_FRAME_WIDTH)
+
+/**
+ * @brief FFT size of the phase correlation, frames are windowed and zero padded to it.
+ */
+#define EE_PMW3901MB_FA_FFT_SIZE        64U
+
+/**
+ * @brief Frame pixel statistics.
+ */
+typedef struct {
+    uint32_t sum;           /**< Sum of pixels */
+    uint32_t sum_sq;        /**< Sum of squared pixels */
+    uint32_t focus;         /**< Sum of squared horizontal and vertical neighbour differences */
+    uint16_t saturated;     /**< Pixels at or above the saturation level */
+    uint8_t min;            /**< Min pixel */
+    uint8_t max;            /**< Max pixel */
+} ee_pmw3901mb_frame_stats_t;
+
+/**
+ * @brief Frame spectrum, split real and imaginary planes (transposed, as used by the phase correlation).
+ */
+typedef struct {
+    float re[EE_PMW3901MB_FA_FFT_SIZE * EE_PMW3901MB_FA_FFT_SIZE] __attribute__((aligned(64)));
+    float im[EE_PMW3901MB_FA_FFT_SIZE * EE_PMW3901MB_FA_FFT_SIZE] __attribute__((aligned(64)));
+} ee_pmw3901mb_frame_spectrum_t;
+
+/**
+ * @brief Frame to frame shift.
+ */
+typedef struct {
+    float dx;       /**< Shift along X in pixels, content moving to larger X is positive */
+    float dy;       /**< Shift along Y in pixels */
+    float peak;     /**< Phase correlation peak, 1.0 for a pure shift, near 0 for unrelated frames */
+} ee_pmw3901mb_frame_shift_t;
+
+
+/**
+ * @brief Set up the FFT and window tables.
+ * @note Not thread safe, call once before the kernels are used.
+ */
+void ee_pmw3901mb_frame_analysis_init(void);
+
+/**
+ * @brief Compute frame pixel statistics, vectorized.
+ * 
+ * @param[in] frame pointer to EE_PMW3901MB_FA_FRAME_SIZE pixels
+ * @param[in] sat_level saturation level
+ * @param[out] stats pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_stats(const uint8_t* frame, uint8_t sat_level, ee_pmw3901mb_frame_stats_t* stats);
+
+/**
+ * @brief Compute frame pixel statistics, scalar reference of ee_pmw3901mb_frame_stats().
+ * 
+ * @param[in] frame pointer to EE_PMW3901MB_FA_FRAME_SIZE pixels
+ * @param[in] sat_level saturation level
+ * @param[out] stats pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_stats_scalar(const uint8_t* frame, uint8_t sat_level, ee_pmw3901mb_frame_stats_t* stats);
+
+/**
+ * @brief Get the RMS contrast (standard deviation over mean) of a frame.
+ * 
+ * @param[in] stats pointer to the frame statistics
+ * @return float RMS contrast, 0 for a black frame
+ */
+float ee_pmw3901mb_frame_contrast(const ee_pmw3901mb_frame_stats_t* stats);
+
+/**
+ * @brief Add the pixels of a frame to a histogram.
+ * 
+ * @param[in] frame pointer to EE_PMW3901MB_FA_FRAME_SIZE pixels
+ * @param[in,out] hist pointer to 256 bins, accumulated
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_histogram(const uint8_t* frame, uint32_t* hist);
+
+/**
+ * @brief Compute the spectrum of a frame for the phase correlation.
+ * @details The frame mean is removed and a Hann window applied before the zero padded FFT.
+ * 
+ * @param[in] frame pointer to EE_PMW3901MB_FA_FRAME_SIZE pixels
+ * @param[out] spec pointer to the return value
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_spectrum(const uint8_t* frame, ee_pmw3901mb_frame_spectrum_t* spec);
+
+/**
+ * @brief Estimate the shift from one frame to the next by phase correlation.
+ * 
+ * @param[in] prev pointer to the spectrum of the previous frame
+ * @param[in] cur pointer to the spectrum of the current frame
+ * @param[out] work pointer to a work spectrum, overwritten
+ * @param[out] shift pointer to the return value, sub-pixel by parabolic peak fit
+ * @return uint8_t status code, 0 success, nonzero on error
+ */
+uint8_t ee_pmw3901mb_frame_phase_shift(const ee_pmw3901mb_frame_spectrum_t* prev, const ee_pmw3901mb_frame_spectrum_t* cur,
+                                       ee_pmw3901mb_frame_spectrum_t* work, ee_pmw3901mb_frame_shift_t* shift);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* _EE_PMW3901MB_FRAME_ANALYSIS_ */
@@ -0,0 +1,378 @@
+/*
+MIT License
+
+Copyright (c) 2025 EngEmil
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+ * Frame analysis tool. Runs the frame analysis kernels over a capture file of raw frames
+ * (EE_PMW3901MB_FA_FRAME_SIZE bytes each, back to back, as read by ee_pmw3901mb_frame_grab())
+ * memory-mapped and split across threads.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ee_pmw3901mb_frame_analysis.h"
+
+#define DEF_SAT_LEVEL   0xFCU   // Top of the 8 bit range, the pixels are 6+2 bit reads
+#define TEXTURE_SIZE    256U    // Synthetic surface of generated captures
+
+/**
+ * @brief Per frame result.
+ */
+typedef struct {
+    ee_pmw3901mb_frame_stats_t stats;
+    ee_pmw3901mb_frame_shift_t shift;   // Shift from the previous frame, 0 for the first frame
+} frame_result_t;
+
+typedef struct {
+    pthread_t thread;
+    const uint8_t* frames;
+    size_t first;
+    size_t last;
+    uint8_t sat_level;
+    bool vectorized;
+    bool phase;
+    frame_result_t* results;
+    uint32_t hist[256];
+} worker_t;
+
+
+static double now_s(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+static void* worker_main(void* arg){
+    worker_t* wk = arg;
+    ee_pmw3901mb_frame_spectrum_t* spec = NULL;
+
+    if(wk->phase){
+        spec = aligned_alloc(64, 3U * sizeof(ee_pmw3901mb_frame_spectrum_t));
+        if(spec == NULL) return NULL;
+    }
+    ee_pmw3901mb_frame_spectrum_t* prev = &spec[0];
+    ee_pmw3901mb_frame_spectrum_t* cur = &spec[1];
+
+    // The first frame of the range is shifted against the last frame of the previous range
+    if(wk->phase && wk->first > 0U){
+        ee_pmw3901mb_frame_spectrum(&wk->frames[(wk->first - 1U) * EE_PMW3901MB_FA_FRAME_SIZE], prev);
+    }
+
+    for(size_t i = wk->first; i < wk->last; i++){
+        const uint8_t* frame = &wk->frames[i * EE_PMW3901MB_FA_FRAME_SIZE];
+        frame_result_t* res = &wk->results[i];
+
+        if(wk->vectorized) ee_pmw3901mb_frame_stats(frame, wk->sat_level, &res->stats);
+        else ee_pmw3901mb_frame_stats_scalar(frame, wk->sat_level, &res->stats);
+        ee_pmw3901mb_frame_histogram(frame, wk->hist);
+
+        memset(&res->shift, 0, sizeof(res->shift));
+        if(wk->phase){
+            ee_pmw3901mb_frame_spectrum(frame, cur);
+            if(i > 0U) ee_pmw3901mb_frame_phase_shift(prev, cur, &spec[2], &res->shift);
+            ee_pmw3901mb_frame_spectrum_t* t = prev;
+            prev = cur;
+            cur = t;
+        }
+    }
+
+    free(spec);
+    return NULL;
+}
+
+// Runs all frames on threads workers, returns the elapsed time in seconds or a negative value on error
+static double run(const uint8_t* frames, size_t n, uint32_t threads, uint8_t sat_level, bool vectorized, bool phase,
+                  frame_result_t* results, uint32_t* hist){
+    worker_t* wk = calloc(threads, sizeof(worker_t));
+    if(wk == NULL) return -1.0;
+
+    double t0 = now_s();
+    for(uint32_t t = 0; t < threads; t++){
+        wk[t].frames = frames;
+        wk[t].first = n * t / threads;
+        wk[t].last = n * (t + 1U) / threads;
+        wk[t].sat_level = sat_level;
+        wk[t].vectorized = vectorized;
+        wk[t].phase = phase;
+        wk[t].results = results;
+        if(pthread_create(&wk[t].thread, NULL, worker_main, &wk[t]) != 0){
+            threads = t;
+            break;
+        }
+    }
+    for(uint32_t t = 0; t < threads; t++) pthread_join(wk[t].thread, NULL);
+    double elapsed = now_s() - t0;
+
+    if(hist != NULL){
+        for(uint32_t t = 0; t < threads; t++){
+            for(uint32_t b = 0; b < 256U; b++) hist[b] += wk[t].hist[b];
+        }
+    }
+    free(wk);
+    return elapsed;
+}
+
+// Writes a capture of a smooth random surface moving (+1, +2) pixels per frame
+static int generate(const char* path, size_t n){
+    static uint8_t texture[TEXTURE_SIZE][TEXTURE_SIZE];
+    static uint16_t tmp[TEXTURE_SIZE][TEXTURE_SIZE];
+    uint32_t seed = 1U;
+
+    for(uint32_t y = 0; y < TEXTURE_SIZE; y++){
+        for(uint32_t x = 0; x < TEXTURE_SIZE; x++){
+            seed = seed * 1103515245U + 12345U;
+            tmp[y][x] = (uint16_t) ((seed >> 16) & 0xFFU);
+        }
+    }
+    for(uint32_t y = 0; y < TEXTURE_SIZE; y++){
+        for(uint32_t x = 0; x < TEXTURE_SIZE; x++){
+            uint32_t s = 0;
+            for(uint32_t k = 0; k < 9U; k++){
+                s += tmp[(y + k / 3U) % TEXTURE_SIZE][(x + k % 3U) % TEXTURE_SIZE];
+            }
+            texture[y][x] = (uint8_t) (s / 9U);
+        }
+    }
+
+    FILE* f = fopen(path, "wb");
+    if(f == NULL) return 1;
+    uint8_t frame[EE_PMW3901MB_FA_FRAME_SIZE];
+    for(size_t i = 0; i < n; i++){
+        for(uint32_t y = 0; y < EE_PMW3901MB_FA_FRAME_WIDTH; y++){
+            for(uint32_t x = 0; x < EE_PMW3901MB_FA_FRAME_WIDTH; x++){
+                frame[y * EE_PMW3901MB_FA_FRAME_WIDTH + x] =
+                    texture[(y + TEXTURE_SIZE * 8U - 2U * i) % TEXTURE_SIZE][(x + TEXTURE_SIZE * 8U - i) % TEXTURE_SIZE];
+            }
+        }
+        if(fwrite(frame, sizeof(frame), 1, f) != 1){
+            fclose(f);
+            return 1;
+        }
+    }
+    return fclose(f) != 0;
+}
+
+static void summary(const frame_result_t* results, size_t n, const uint32_t* hist){
+    double focus = 0.0;
+    double contrast = 0.0;
+    double saturated = 0.0;
+    double dx = 0.0;
+    double dy = 0.0;
+    for(size_t i = 0; i < n; i++){
+        focus += results[i].stats.focus;
+        contrast += ee_pmw3901mb_frame_contrast(&results[i].stats);
+        saturated += results[i].stats.saturated;
+        dx += results[i].shift.dx;
+        dy += results[i].shift.dy;
+    }
+
+    uint64_t total = 0;
+    for(uint32_t b = 0; b < 256U; b++) total += hist[b];
+    uint32_t pct[3] = { 5U, 50U, 95U };
+    uint32_t pct_value[3] = { 0 };
+    for(uint32_t k = 0; k < 3U; k++){
+        uint64_t acc = 0;
+        uint32_t b = 0;
+        for(b = 0; b < 255U; b++){
+            acc += hist[b];
+            if(acc * 100U >= total * pct[k]) break;
+        }
+        pct_value[k] = b;
+    }
+
+    printf("Frames: %zu\n", n);
+    printf("Mean focus: %.0f, mean contrast: %.3f, saturated: %.4f %%\n",
+        focus / (double) n, contrast / (double) n, 100.0 * saturated / ((double) n * EE_PMW3901MB_FA_FRAME_SIZE));
+    printf("Pixel 5/50/95 percentiles: %" PRIu32 " / %" PRIu32 " / %" PRIu32 "\n", pct_value[0], pct_value[1], pct_value[2]);
+    if(n > 1U){
+        printf("Mean shift per frame: dx %.3f, dy %.3f\n", dx / (double) (n - 1U), dy / (double) (n - 1U));
+    }
+}
+
+static int write_csv(const char* path, const frame_result_t* results, size_t n){
+    FILE* f = fopen(path, "w");
+    if(f == NULL) return 1;
+    fprintf(f, "frame,mean,contrast,focus,min,max,saturated,dx,dy,peak\n");
+    for(size_t i = 0; i < n; i++){
+        const frame_result_t* r = &results[i];
+        fprintf(f, "%zu,%.2f,%.4f,%" PRIu32 ",%u,%u,%u,%.3f,%.3f,%.3f\n", i,
+            (double) r->stats.sum / EE_PMW3901MB_FA_FRAME_SIZE, (double) ee_pmw3901mb_frame_contrast(&r->stats),
+            r->stats.focus, r->stats.min, r->stats.max, r->stats.saturated,
+            (double) r->shift.dx, (double) r->shift.dy, (double) r->shift.peak);
+    }
+    return fclose(f) != 0;
+}
+
+static bool stats_equal(const ee_pmw3901mb_frame_stats_t* a, const ee_pmw3901mb_frame_stats_t* b){
+    return a->sum == b->sum && a->sum_sq == b->sum_sq && a->focus == b->focus &&
+           a->saturated == b->saturated && a->min == b->min && a->max == b->max;
+}
+
+// Benchmarks the kernels, the statistics of every run are checked against the first scalar run.
+// Returns nonzero on a mismatch or error.
+static int bench(const uint8_t* frames, size_t n, uint32_t threads, uint8_t sat_level, frame_result_t* results){
+    static const struct {
+        const char* name;
+        bool vectorized;
+        bool phase;
+    } runs[] = {
+        { "stats+hist scalar",      false,  false },
+        { "stats+hist vectorized",  true,   false },
+        { "all vectorized",         true,   true },
+    };
+
+    ee_pmw3901mb_frame_stats_t* reference = malloc(n * sizeof(ee_pmw3901mb_frame_stats_t));
+    if(reference == NULL) return 1;
+
+    int status = 0;
+    printf("%-24s %8s %14s %14s %12s\n", "kernel", "threads", "frames/s", "frames/s/core", "mismatches");
+    for(size_t r = 0; r < sizeof(runs) / sizeof(runs[0]); r++){
+        uint32_t counts[2] = { 1U, threads };
+        for(uint32_t k = 0; k < ((threads > 1U) ? 2U : 1U); k++){
+            double t = run(frames, n, counts[k], sat_level, runs[r].vectorized, runs[r].phase, results, NULL);
+            if(t <= 0.0){
+                status = 1;
+                continue;
+            }
+            size_t mismatches = 0;
+            for(size_t i = 0; i < n; i++){
+                if(r == 0U && k == 0U) reference[i] = results[i].stats;
+                else if(!stats_equal(&results[i].stats, &reference[i])) mismatches++;
+            }
+            printf("%-24s %8" PRIu32 " %14.0f %14.0f %12zu\n", runs[r].name, counts[k], (double) n / t, (double) n / t / counts[k], mismatches);
+            if(mismatches > 0U) status = 1;
+        }
+    }
+
+    free(reference);
+    if(status != 0) fprintf(stderr, "Statistics differ from the scalar reference\n");
+    return status;
+}
+
+static void usage(const char* prog){
+    fprintf(stderr,
+        "Usage: %s [-t threads] [-s sat_level] [-o results.csv] [-b] [-g frames] capture.bin\n"
+        "  -t  worker threads, default the online cores\n"
+        "  -s  saturation level, default %u\n"
+        "  -o  write per frame results as CSV\n"
+        "  -b  benchmark scalar and vectorized kernels\n"
+        "  -g  generate a synthetic capture of the given number of frames and exit\n",
+        prog, DEF_SAT_LEVEL);
+}
+
+int main(int argc, char** argv){
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = (cores > 0) ? (uint32_t) cores : 1U;
+    uint8_t sat_level = DEF_SAT_LEVEL;
+    const char* csv = NULL;
+    bool do_bench = false;
+    size_t gen = 0;
+    int opt = 0;
+
+    while((opt = getopt(argc, argv, "t:s:o:bg:")) != -1){
+        switch(opt){
+            case 't': threads = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 's': sat_level = (uint8_t) strtoul(optarg, NULL, 0); break;
+            case 'o': csv = optarg; break;
+            case 'b': do_bench = true; break;
+            case 'g': gen = (size_t) strtoull(optarg, NULL, 0); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if(optind != argc - 1 || threads == 0U){
+        usage(argv[0]);
+        return 1;
+    }
+    const char* path = argv[optind];
+
+    if(gen > 0U){
+        if(generate(path, gen) != 0){
+            fprintf(stderr, "Failed to write %s\n", path);
+            return 1;
+        }
+        return 0;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0){
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    size_t n = (size_t) st.st_size / EE_PMW3901MB_FA_FRAME_SIZE;
+    if(n == 0U){
+        fprintf(stderr, "No frames in %s\n", path);
+        close(fd);
+        return 1;
+    }
+    if((size_t) st.st_size % EE_PMW3901MB_FA_FRAME_SIZE != 0U){
+        fprintf(stderr, "Ignoring %zu trailing bytes\n", (size_t) st.st_size % EE_PMW3901MB_FA_FRAME_SIZE);
+    }
+    const uint8_t* frames = mmap(NULL, n * EE_PMW3901MB_FA_FRAME_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(frames == MAP_FAILED){
+        fprintf(stderr, "Failed to map %s\n", path);
+        return 1;
+    }
+    madvise((void*) frames, n * EE_PMW3901MB_FA_FRAME_SIZE, MADV_SEQUENTIAL);
+
+    frame_result_t* results = calloc(n, sizeof(frame_result_t));
+    if(results == NULL){
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    ee_pmw3901mb_frame_analysis_init();
+
+    int status = 0;
+    if(do_bench){
+        status = bench(frames, n, threads, sat_level, results);
+    }else{
+        uint32_t hist[256] = { 0 };
+        double t = run(frames, n, threads, sat_level, true, true, results, hist);
+        if(t < 0.0){
+            fprintf(stderr, "Failed to start workers\n");
+            status = 1;
+        }else{
+            summary(results, n, hist);
+            printf("Analyzed in %.3f s on %" PRIu32 " threads (%.0f frames/s)\n", t, threads, (double) n / t);
+            if(csv != NULL && write_csv(csv, results, n) != 0){
+                fprintf(stderr, "Failed to write %s\n", csv);
+                status = 1;
+            }
+        }
+    }
+
+    free(results);
+    munmap((void*) frames, n * EE_PMW3901MB_FA_FRAME_SIZE);
+    return status;
+}